@@ -592,6 +592,93 @@ BfChassisManager::~BfChassisManager() = default;
   return ::util::OkStatus();
 }
 
+::util::Status BfChassisManager::PushChassisConfigDelta(
+    const ChassisConfig& config, const ChassisConfigDelta& delta) {
+  RET_CHECK(initialized_) << "Not initialized!";
+  RET_CHECK(delta.OnlyModifiesSingletonPorts())
+      << "The delta changes more than the existing singleton ports.";
+
+  // Check all the ports first, so that an invalid delta does not leave the
+  // ports half-configured.
+  for (const auto& singleton_port : delta.modified_singleton_ports) {
+    const uint32 port_id = singleton_port.id();
+    const uint64 node_id = singleton_port.node();
+    const PortKey* singleton_port_key = nullptr;
+    if (const auto* port_id_to_singleton_port_key = gtl::FindOrNull(
+            node_id_to_port_id_to_singleton_port_key_, node_id)) {
+      singleton_port_key =
+          gtl::FindOrNull(*port_id_to_singleton_port_key, port_id);
+    }
+    RET_CHECK(singleton_port_key != nullptr)
+        << "Unknown port " << port_id << " in node " << node_id << ".";
+    if (!(*singleton_port_key == PortKey(singleton_port.slot(),
+                                         singleton_port.port(),
+                                         singleton_port.channel()))) {
+      return MAKE_ERROR(ERR_REBOOT_REQUIRED)
+             << "The switch is already initialized, but we detected the newly "
+                "pushed config requires a change in the port layout. The stack "
+                "needs to be rebooted to finish config push.";
+    }
+    RET_CHECK(singleton_port.speed_bps() > 0)
+        << "No valid speed_bps in " << singleton_port.ShortDebugString() << ".";
+  }
+
+  // Ports whose configuration failed before are only retried by a full push,
+  // which also covers the failed ports not touched by this delta.
+  for (const auto& e : node_id_to_port_id_to_port_config_) {
+    for (const auto& f : e.second) {
+      if (f.second.admin_state == ADMIN_STATE_UNKNOWN) {
+        LOG(INFO) << "Port " << f.first << " in node " << e.first
+                  << " is in an unknown state, pushing the full chassis "
+                     "config.";
+        return PushChassisConfig(config);
+      }
+    }
+  }
+
+  for (const auto& singleton_port : delta.modified_singleton_ports) {
+    const uint32 port_id = singleton_port.id();
+    const uint64 node_id = singleton_port.node();
+    const int device = node_id_to_device_[node_id];
+    const uint32 sdk_port_id =
+        node_id_to_port_id_to_sdk_port_id_[node_id][port_id];
+    PortConfig* port_config =
+        &node_id_to_port_id_to_port_config_[node_id][port_id];
+    const PortConfig old_port_config = *port_config;
+
+    if (!old_port_config.speed_bps) {
+      return MAKE_ERROR(ERR_INTERNAL)
+             << "Invalid internal state in BfChassisManager, speed_bps field "
+                "should contain a value";
+    }
+    RETURN_IF_ERROR(UpdatePortHelper(node_id, device, sdk_port_id,
+                                     singleton_port, old_port_config,
+                                     port_config));
+
+    // The helpers disable port shaping, apply it again if configured.
+    if (config.has_vendor_config() &&
+        config.vendor_config().has_tofino_config()) {
+      const auto& node_id_to_port_shaping_config =
+          config.vendor_config()
+              .tofino_config()
+              .node_id_to_port_shaping_config();
+      const auto it = node_id_to_port_shaping_config.find(node_id);
+      if (it != node_id_to_port_shaping_config.end()) {
+        const auto& per_port_shaping_configs =
+            it->second.per_port_shaping_configs();
+        const auto jt = per_port_shaping_configs.find(port_id);
+        if (jt != per_port_shaping_configs.end()) {
+          RETURN_IF_ERROR(ApplyPortShapingConfig(node_id, device, sdk_port_id,
+                                                 jt->second));
+          port_config->shaping_config = jt->second;
+        }
+      }
+    }
+  }
+
+  return ::util::OkStatus();
+}
+
 ::util::Status BfChassisManager::ApplyPortShapingConfig(
     uint64 node_id, int device, uint32 sdk_port_id,
     const TofinoConfig::BfPortShapingConfig::BfPerPortShapingConfig&
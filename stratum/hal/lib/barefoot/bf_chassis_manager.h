@@ -14,6 +14,7 @@
 #include "absl/types/optional.h"
 #include "stratum/glue/integral_types.h"
 #include "stratum/hal/lib/barefoot/bf_sde_interface.h"
+#include "stratum/hal/lib/common/chassis_config_delta.h"
 #include "stratum/hal/lib/common/gnmi_events.h"
 #include "stratum/hal/lib/common/phal_interface.h"
 #include "stratum/hal/lib/common/utils.h"
@@ -45,6 +46,17 @@ class BfChassisManager {
   virtual ::util::Status PushChassisConfig(const ChassisConfig& config)
       EXCLUSIVE_LOCKS_REQUIRED(chassis_lock);
 
+  // Pushes a chassis config which differs from the last pushed one only in the
+  // existing singleton ports modified by delta. Only these ports are
+  // reconfigured, the state of all other ports and nodes is left untouched.
+  // Falls back to PushChassisConfig() if the configuration of any port failed
+  // before, so that such ports are added again.
+  // Returns ERR_REBOOT_REQUIRED if a port moved to another (slot, port,
+  // channel), like VerifyChassisConfig() does.
+  virtual ::util::Status PushChassisConfigDelta(const ChassisConfig& config,
+                                                const ChassisConfigDelta& delta)
+      EXCLUSIVE_LOCKS_REQUIRED(chassis_lock);
+
   virtual ::util::Status VerifyChassisConfig(const ChassisConfig& config)
       SHARED_LOCKS_REQUIRED(chassis_lock);
 
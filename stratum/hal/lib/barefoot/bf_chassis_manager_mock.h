@@ -18,6 +18,9 @@ namespace barefoot {
 class BfChassisManagerMock : public BfChassisManager {
  public:
   MOCK_METHOD1(PushChassisConfig, ::util::Status(const ChassisConfig& config));
+  MOCK_METHOD2(PushChassisConfigDelta,
+               ::util::Status(const ChassisConfig& config,
+                              const ChassisConfigDelta& delta));
   MOCK_METHOD1(VerifyChassisConfig,
                ::util::Status(const ChassisConfig& config));
   MOCK_METHOD0(Shutdown, ::util::Status());
@@ -17,6 +17,7 @@
 #include "stratum/glue/status/status_test_util.h"
 #include "stratum/glue/status/statusor.h"
 #include "stratum/hal/lib/barefoot/bf_sde_mock.h"
+#include "stratum/hal/lib/common/chassis_config_delta.h"
 #include "stratum/hal/lib/common/common.pb.h"
 #include "stratum/hal/lib/common/phal_mock.h"
 #include "stratum/hal/lib/common/writer_mock.h"
@@ -187,6 +188,13 @@ class BfChassisManagerTest : public ::testing::Test {
     return bf_chassis_manager_->PushChassisConfig(builder.Get());
   }
 
+  ::util::Status PushChassisConfigDelta(const ChassisConfig& old_config,
+                                        const ChassisConfig& config) {
+    absl::WriterMutexLock l(&chassis_lock);
+    return bf_chassis_manager_->PushChassisConfigDelta(
+        config, ComputeChassisConfigDelta(old_config, config));
+  }
+
   ::util::Status PushBaseChassisConfig(ChassisConfigBuilder* builder) {
     RET_CHECK(!Initialized())
         << "Can only call PushBaseChassisConfig() for first ChassisConfig!";
@@ -335,6 +343,101 @@ TEST_F(BfChassisManagerTest, SetPortLoopback) {
   ASSERT_OK(ShutdownAndTestCleanState());
 }
 
+TEST_F(BfChassisManagerTest, PushChassisConfigDeltaOnlyUpdatesModifiedPorts) {
+  ChassisConfigBuilder builder;
+  ASSERT_OK(PushBaseChassisConfig(&builder));
+
+  const uint32 port_id = kPortId + 1;
+  const uint32 sdk_port_id = port_id + kSdkPortOffset;
+  RegisterSdkPortId(builder.AddPort(port_id, kPort + 1, ADMIN_STATE_ENABLED));
+  EXPECT_CALL(*bf_sde_mock_, AddPort(kDevice, sdk_port_id, kDefaultSpeedBps,
+                                     kDefaultFecMode));
+  EXPECT_CALL(*bf_sde_mock_, EnablePort(kDevice, sdk_port_id));
+  ASSERT_OK(PushChassisConfig(builder));
+  const ChassisConfig old_config = builder.Get();
+
+  builder.GetPort(port_id)->mutable_config_params()->set_loopback_mode(
+      LOOPBACK_STATE_MAC);
+  EXPECT_CALL(*bf_sde_mock_, SetPortLoopbackMode(kDevice, sdk_port_id,
+                                                 LOOPBACK_STATE_MAC));
+  EXPECT_CALL(*bf_sde_mock_, DisablePort(kDevice, sdk_port_id));
+  EXPECT_CALL(*bf_sde_mock_, EnablePort(kDevice, sdk_port_id));
+  EXPECT_CALL(*bf_sde_mock_,
+              EnablePortShaping(kDevice, sdk_port_id, TRI_STATE_FALSE));
+  // The other port is left alone.
+  EXPECT_CALL(*bf_sde_mock_, IsValidPort(kDevice, kPortId + kSdkPortOffset))
+      .Times(0);
+  EXPECT_CALL(*bf_sde_mock_,
+              EnablePortShaping(kDevice, kPortId + kSdkPortOffset, _))
+      .Times(0);
+  ASSERT_OK(PushChassisConfigDelta(old_config, builder.Get()));
+
+  // The updated port config is used for later deltas, so an unchanged
+  // loopback mode is not set again.
+  const ChassisConfig loopback_config = builder.Get();
+  builder.GetPort(port_id)->mutable_config_params()->set_mtu(9000);
+  EXPECT_CALL(*bf_sde_mock_, SetPortLoopbackMode(_, _, _)).Times(0);
+  EXPECT_CALL(*bf_sde_mock_, SetPortMtu(kDevice, sdk_port_id, 9000));
+  EXPECT_CALL(*bf_sde_mock_, DisablePort(kDevice, sdk_port_id));
+  EXPECT_CALL(*bf_sde_mock_, EnablePort(kDevice, sdk_port_id));
+  EXPECT_CALL(*bf_sde_mock_,
+              EnablePortShaping(kDevice, sdk_port_id, TRI_STATE_FALSE));
+  ASSERT_OK(PushChassisConfigDelta(loopback_config, builder.Get()));
+
+  ASSERT_OK(ShutdownAndTestCleanState());
+}
+
+TEST_F(BfChassisManagerTest, PushChassisConfigDeltaRejectsLayoutChange) {
+  ChassisConfigBuilder builder;
+  ASSERT_OK(PushBaseChassisConfig(&builder));
+  const ChassisConfig old_config = builder.Get();
+
+  builder.GetPort(kPortId)->set_port(kPort + 1);
+  EXPECT_CALL(*bf_sde_mock_, AddPort(_, _, _, _)).Times(0);
+  EXPECT_CALL(*bf_sde_mock_, DeletePort(_, _)).Times(0);
+  ::util::Status status = PushChassisConfigDelta(old_config, builder.Get());
+  EXPECT_EQ(ERR_REBOOT_REQUIRED, status.error_code());
+
+  ASSERT_OK(ShutdownAndTestCleanState());
+}
+
+TEST_F(BfChassisManagerTest, PushChassisConfigDeltaRetriesFailedPorts) {
+  ChassisConfigBuilder builder;
+  ASSERT_OK(PushBaseChassisConfig(&builder));
+
+  const uint32 port_id = kPortId + 1;
+  const uint32 sdk_port_id = port_id + kSdkPortOffset;
+  RegisterSdkPortId(builder.AddPort(port_id, kPort + 1, ADMIN_STATE_ENABLED));
+  EXPECT_CALL(*bf_sde_mock_, AddPort(kDevice, sdk_port_id, kDefaultSpeedBps,
+                                     kDefaultFecMode));
+  EXPECT_CALL(*bf_sde_mock_, EnablePort(kDevice, sdk_port_id));
+  ASSERT_OK(PushChassisConfig(builder));
+  const ChassisConfig old_config = builder.Get();
+
+  // The port vanished from the SDE, which leaves it in an unknown state.
+  builder.GetPort(port_id)->mutable_config_params()->set_mtu(9000);
+  EXPECT_CALL(*bf_sde_mock_, IsValidPort(kDevice, sdk_port_id))
+      .WillOnce(Return(false))
+      .WillRepeatedly(Return(true));
+  EXPECT_FALSE(PushChassisConfigDelta(old_config, builder.Get()).ok());
+
+  // A delta which only touches the other port re-adds the failed one.
+  const ChassisConfig failed_config = builder.Get();
+  builder.GetPort(kPortId)->mutable_config_params()->set_mtu(9000);
+  EXPECT_CALL(*bf_sde_mock_, SetPortMtu(kDevice, kPortId + kSdkPortOffset,
+                                        9000));
+  EXPECT_CALL(*bf_sde_mock_, DisablePort(kDevice, kPortId + kSdkPortOffset));
+  EXPECT_CALL(*bf_sde_mock_, EnablePort(kDevice, kPortId + kSdkPortOffset));
+  EXPECT_CALL(*bf_sde_mock_, DeletePort(kDevice, sdk_port_id));
+  EXPECT_CALL(*bf_sde_mock_, AddPort(kDevice, sdk_port_id, kDefaultSpeedBps,
+                                     kDefaultFecMode));
+  EXPECT_CALL(*bf_sde_mock_, SetPortMtu(kDevice, sdk_port_id, 9000));
+  EXPECT_CALL(*bf_sde_mock_, EnablePort(kDevice, sdk_port_id));
+  ASSERT_OK(PushChassisConfigDelta(failed_config, builder.Get()));
+
+  ASSERT_OK(ShutdownAndTestCleanState());
+}
+
 TEST_F(BfChassisManagerTest, ApplyPortShaping) {
   const std::string kVendorConfigText = R"pb(
     tofino_config {
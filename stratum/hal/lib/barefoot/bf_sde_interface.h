@@ -13,6 +13,7 @@
 #include "stratum/glue/status/status.h"
 #include "stratum/glue/status/statusor.h"
 #include "stratum/hal/lib/barefoot/bf.pb.h"
+#include "stratum/hal/lib/barefoot/packet_buffer_pool.h"
 #include "stratum/hal/lib/common/common.pb.h"
 #include "stratum/hal/lib/common/utils.h"
 #include "stratum/lib/channel/channel.h"
@@ -251,21 +252,36 @@ class BfSdeInterface {
   virtual ::util::Status StopPacketIo(int device) = 0;
 
   // Registers a writer to be invoked when we receive a packet on the PCIe CPU
-  // port. There can only be one writer per device.
+  // port. There can only be one writer per device. If a buffer pool is given,
+  // received packets are copied into buffers taken from it, which the reader
+  // of the channel releases back into the pool once done with them.
   virtual ::util::Status RegisterPacketReceiveWriter(
-      int device, std::unique_ptr<ChannelWriter<std::string>> writer) = 0;
+      int device, std::unique_ptr<ChannelWriter<std::string>> writer,
+      std::shared_ptr<PacketBufferPool> buffer_pool) = 0;
 
   // Unregisters the writer registered to this device by
   // RegisterPacketReceiveWriter().
   virtual ::util::Status UnregisterPacketReceiveWriter(int device) = 0;
 
-  // Create a new multicast node with the given parameters. Returns the newly
-  // allocated node id.
-  virtual ::util::StatusOr<uint32> CreateMulticastNode(
+  // Inserts a multicast node with the given, caller allocated, ID.
+  virtual ::util::Status InsertMulticastNode(
       int device, std::shared_ptr<BfSdeInterface::SessionInterface> session,
-      int mc_replication_id, const std::vector<uint32>& mc_lag_ids,
+      uint32 mc_node_id, int mc_replication_id,
+      const std::vector<uint32>& mc_lag_ids,
       const std::vector<uint32>& ports) = 0;
 
+  // Modifies the replication ID, LAG IDs and ports of a multicast node.
+  virtual ::util::Status ModifyMulticastNode(
+      int device, std::shared_ptr<BfSdeInterface::SessionInterface> session,
+      uint32 mc_node_id, int mc_replication_id,
+      const std::vector<uint32>& mc_lag_ids,
+      const std::vector<uint32>& ports) = 0;
+
+  // Returns the IDs of all multicast nodes ($pre.node table).
+  virtual ::util::Status GetMulticastNodeIds(
+      int device, std::shared_ptr<BfSdeInterface::SessionInterface> session,
+      std::vector<uint32>* mc_node_ids) = 0;
+
   // Returns the node IDs linked to the given multicast group ID.
   // TODO(max): rename to GetMulticastNodeIdsInMulticastGroup
   virtual ::util::StatusOr<std::vector<uint32>> GetNodesInMulticastGroup(
@@ -476,6 +492,21 @@ class BfSdeInterface {
       std::vector<std::unique_ptr<TableKeyInterface>>* table_keys,
       std::vector<std::unique_ptr<TableDataInterface>>* table_datas) = 0;
 
+  // Fetches the next batch of at most 'batch_size' table entries in the given
+  // table. The batch starts with the first entry of the table if
+  // 'previous_key' is null, else with the entry following 'previous_key'. The
+  // key and data objects in 'table_keys' and 'table_datas' are reused across
+  // calls and only allocated if missing, so that paging through a large table
+  // does not allocate per entry. On return, the first 'num_entries' objects
+  // hold valid entries. A 'num_entries' below 'batch_size' marks the end of the
+  // table. 'previous_key' must not point into 'table_keys'.
+  virtual ::util::Status GetTableEntriesBatch(
+      int device, std::shared_ptr<BfSdeInterface::SessionInterface> session,
+      uint32 table_id, const TableKeyInterface* previous_key, size_t batch_size,
+      std::vector<std::unique_ptr<TableKeyInterface>>* table_keys,
+      std::vector<std::unique_ptr<TableDataInterface>>* table_datas,
+      size_t* num_entries) = 0;
+
   // Sets the default table entry (action) for a table.
   virtual ::util::Status SetDefaultTableEntry(
       int device, std::shared_ptr<BfSdeInterface::SessionInterface> session,
@@ -497,6 +528,17 @@ class BfSdeInterface {
       int device, std::shared_ptr<BfSdeInterface::SessionInterface> session,
       uint32 table_id, absl::Duration timeout) = 0;
 
+  // Synchronizes the driver cached counter values with the current hardware
+  // state for all given BfRt tables. The sync operations of all tables are
+  // issued at once and waited for together, so the total time is bounded by
+  // the slowest table instead of the sum of all tables. A table is not synced
+  // again if it was synced, or a sync was started, at most 'max_staleness' ago.
+  // This allows concurrent readers to share the same sync.
+  virtual ::util::Status SynchronizeCountersBatch(
+      int device, std::shared_ptr<BfSdeInterface::SessionInterface> session,
+      const std::vector<uint32>& table_ids, absl::Duration timeout,
+      absl::Duration max_staleness) = 0;
+
   // Returns the equivalent BfRt ID for the given P4RT ID.
   virtual ::util::StatusOr<uint32> GetBfRtId(uint32 p4info_id) const = 0;
 
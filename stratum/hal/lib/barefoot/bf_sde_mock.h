@@ -109,17 +109,31 @@ class BfSdeMock : public BfSdeInterface {
   MOCK_METHOD2(TxPacket, ::util::Status(int device, const std::string& packet));
   MOCK_METHOD1(StartPacketIo, ::util::Status(int device));
   MOCK_METHOD1(StopPacketIo, ::util::Status(int device));
-  MOCK_METHOD2(
+  MOCK_METHOD3(
       RegisterPacketReceiveWriter,
       ::util::Status(int device,
-                     std::unique_ptr<ChannelWriter<std::string>> writer));
+                     std::unique_ptr<ChannelWriter<std::string>> writer,
+                     std::shared_ptr<PacketBufferPool> buffer_pool));
   MOCK_METHOD1(UnregisterPacketReceiveWriter, ::util::Status(int device));
-  MOCK_METHOD5(CreateMulticastNode,
-               ::util::StatusOr<uint32>(
-                   int device,
-                   std::shared_ptr<BfSdeInterface::SessionInterface> session,
-                   int mc_replication_id, const std::vector<uint32>& mc_lag_ids,
-                   const std::vector<uint32>& ports));
+  MOCK_METHOD6(
+      InsertMulticastNode,
+      ::util::Status(int device,
+                     std::shared_ptr<BfSdeInterface::SessionInterface> session,
+                     uint32 mc_node_id, int mc_replication_id,
+                     const std::vector<uint32>& mc_lag_ids,
+                     const std::vector<uint32>& ports));
+  MOCK_METHOD6(
+      ModifyMulticastNode,
+      ::util::Status(int device,
+                     std::shared_ptr<BfSdeInterface::SessionInterface> session,
+                     uint32 mc_node_id, int mc_replication_id,
+                     const std::vector<uint32>& mc_lag_ids,
+                     const std::vector<uint32>& ports));
+  MOCK_METHOD3(
+      GetMulticastNodeIds,
+      ::util::Status(int device,
+                     std::shared_ptr<BfSdeInterface::SessionInterface> session,
+                     std::vector<uint32>* mc_node_ids));
   MOCK_METHOD3(
       DeleteMulticastNodes,
       ::util::Status(int device,
@@ -312,6 +326,15 @@ class BfSdeMock : public BfSdeInterface {
           uint32 table_id,
           std::vector<std::unique_ptr<TableKeyInterface>>* table_keys,
           std::vector<std::unique_ptr<TableDataInterface>>* table_datas));
+  MOCK_METHOD8(
+      GetTableEntriesBatch,
+      ::util::Status(
+          int device, std::shared_ptr<BfSdeInterface::SessionInterface> session,
+          uint32 table_id, const TableKeyInterface* previous_key,
+          size_t batch_size,
+          std::vector<std::unique_ptr<TableKeyInterface>>* table_keys,
+          std::vector<std::unique_ptr<TableDataInterface>>* table_datas,
+          size_t* num_entries));
   MOCK_METHOD4(
       SetDefaultTableEntry,
       ::util::Status(int device,
@@ -332,6 +355,12 @@ class BfSdeMock : public BfSdeInterface {
       ::util::Status(int device,
                      std::shared_ptr<BfSdeInterface::SessionInterface> session,
                      uint32 table_id, absl::Duration timeout));
+  MOCK_METHOD5(
+      SynchronizeCountersBatch,
+      ::util::Status(int device,
+                     std::shared_ptr<BfSdeInterface::SessionInterface> session,
+                     const std::vector<uint32>& table_ids,
+                     absl::Duration timeout, absl::Duration max_staleness));
   MOCK_CONST_METHOD1(GetBfRtId, ::util::StatusOr<uint32>(uint32 p4info_id));
   MOCK_CONST_METHOD1(GetP4InfoId, ::util::StatusOr<uint32>(uint32 bfrt_id));
   MOCK_CONST_METHOD1(GetActionSelectorBfRtId,
@@ -3,6 +3,7 @@
 
 #include "stratum/hal/lib/barefoot/bf_sde_wrapper.h"
 
+#include <algorithm>
 #include <memory>
 #include <set>
 #include <utility>
@@ -1770,6 +1771,18 @@ std::string BfSdeWrapper::GetSdeVersion() const {
 
   bfrt_device_manager_ = &bfrt::BfRtDevMgr::getInstance();
   bfrt_id_mapper_.reset();
+  // Table IDs can be reused by the new pipeline, forget all past counter syncs.
+  {
+    absl::MutexLock sync_lock(&counter_sync_lock_);
+    for (auto it = counter_sync_states_.begin();
+         it != counter_sync_states_.end();) {
+      if (it->first.first == device) {
+        counter_sync_states_.erase(it++);
+      } else {
+        ++it;
+      }
+    }
+  }
 
   RETURN_IF_BFRT_ERROR(bf_pal_device_warm_init_begin(
       device, BF_DEV_WARM_INIT_FAST_RECFG, BF_DEV_SERDES_UPD_NONE,
@@ -1937,15 +1950,22 @@ BfSdeWrapper::CreateTableData(int table_id, int action_id) {
 }
 
 ::util::Status BfSdeWrapper::RegisterPacketReceiveWriter(
-    int device, std::unique_ptr<ChannelWriter<std::string>> writer) {
+    int device, std::unique_ptr<ChannelWriter<std::string>> writer,
+    std::shared_ptr<PacketBufferPool> buffer_pool) {
   absl::WriterMutexLock l(&packet_rx_callback_lock_);
   device_to_packet_rx_writer_[device] = std::move(writer);
+  if (buffer_pool) {
+    device_to_packet_rx_buffer_pool_[device] = std::move(buffer_pool);
+  } else {
+    device_to_packet_rx_buffer_pool_.erase(device);
+  }
   return ::util::OkStatus();
 }
 
 ::util::Status BfSdeWrapper::UnregisterPacketReceiveWriter(int device) {
   absl::WriterMutexLock l(&packet_rx_callback_lock_);
   device_to_packet_rx_writer_.erase(device);
+  device_to_packet_rx_buffer_pool_.erase(device);
   return ::util::OkStatus();
 }
 
@@ -1956,13 +1976,19 @@ BfSdeWrapper::CreateTableData(int table_id, int action_id) {
   RET_CHECK(rx_writer) << "No Rx callback registered for device id " << device
                        << ".";
 
-  std::string buffer(reinterpret_cast<const char*>(bf_pkt_get_pkt_data(pkt)),
-                     bf_pkt_get_pkt_size(pkt));
-  ::util::Status status = (*rx_writer)->TryWrite(buffer);
-  LOG_IF_EVERY_N(INFO, !status.ok(), 500)
-      << "Dropped packet received from CPU: " << status;
+  // The packet is copied once out of the DMA buffer, which is freed after this
+  // callback returns. From here on the buffer is moved, never copied.
+  auto* buffer_pool = gtl::FindOrNull(device_to_packet_rx_buffer_pool_, device);
+  std::string buffer = buffer_pool ? (*buffer_pool)->Acquire() : std::string();
+  buffer.assign(reinterpret_cast<const char*>(bf_pkt_get_pkt_data(pkt)),
+                bf_pkt_get_pkt_size(pkt));
   VLOG(1) << "Received " << buffer.size() << " byte packet from CPU "
           << StringToHex(buffer);
+  ::util::Status status = (*rx_writer)->TryWrite(std::move(buffer));
+  LOG_IF_EVERY_N(INFO, !status.ok(), 500)
+      << "Dropped packet received from CPU: " << status;
+  // A failed write leaves the buffer with us, recycle it.
+  if (!status.ok() && buffer_pool) (*buffer_pool)->Release(std::move(buffer));
 
   return ::util::OkStatus();
 }
@@ -2089,58 +2115,16 @@ namespace {
   return ::util::OkStatus();
 }
 
-::util::StatusOr<uint32> BfSdeWrapper::GetFreeMulticastNodeId(
-    int device, std::shared_ptr<BfSdeInterface::SessionInterface> session) {
-  auto real_session = std::dynamic_pointer_cast<Session>(session);
-  RET_CHECK(real_session);
-
-  auto bf_dev_tgt = GetDeviceTarget(device);
-  const bfrt::BfRtTable* table;
-  RETURN_IF_BFRT_ERROR(bfrt_info_->bfrtTableFromNameGet(kPreNodeTable, &table));
-  size_t table_size;
-  RETURN_IF_BFRT_ERROR(table->tableSizeGet(*real_session->bfrt_session_,
-                                           bf_dev_tgt, &table_size));
-  uint32 usage;
-  RETURN_IF_BFRT_ERROR(table->tableUsageGet(
-      *real_session->bfrt_session_, bf_dev_tgt,
-      bfrt::BfRtTable::BfRtTableGetFlag::GET_FROM_SW, &usage));
-  std::unique_ptr<bfrt::BfRtTableKey> table_key;
-  std::unique_ptr<bfrt::BfRtTableData> table_data;
-  RETURN_IF_BFRT_ERROR(table->keyAllocate(&table_key));
-  RETURN_IF_BFRT_ERROR(table->dataAllocate(&table_data));
-  uint32 id = usage;
-  for (size_t _ = 0; _ < table_size; ++_) {
-    // Key: $MULTICAST_NODE_ID
-    RETURN_IF_ERROR(SetField(table_key.get(), kMcNodeId, id));
-    bf_status_t status = table->tableEntryGet(
-        *real_session->bfrt_session_, bf_dev_tgt, *table_key,
-        bfrt::BfRtTable::BfRtTableGetFlag::GET_FROM_SW, table_data.get());
-    if (status == BF_OBJECT_NOT_FOUND) {
-      return id;
-    } else if (status == BF_SUCCESS) {
-      id++;
-      continue;
-    } else {
-      RETURN_IF_BFRT_ERROR(status);
-    }
-  }
-
-  return MAKE_ERROR(ERR_TABLE_FULL) << "Could not find free multicast node id.";
-}
-
-::util::StatusOr<uint32> BfSdeWrapper::CreateMulticastNode(
+::util::Status BfSdeWrapper::WriteMulticastNode(
     int device, std::shared_ptr<BfSdeInterface::SessionInterface> session,
-    int mc_replication_id, const std::vector<uint32>& mc_lag_ids,
-    const std::vector<uint32>& ports) {
-  ::absl::ReaderMutexLock l(&data_lock_);
-
+    uint32 mc_node_id, int mc_replication_id,
+    const std::vector<uint32>& mc_lag_ids, const std::vector<uint32>& ports,
+    bool insert) {
   auto real_session = std::dynamic_pointer_cast<Session>(session);
   RET_CHECK(real_session);
 
   const bfrt::BfRtTable* table;  // PRE node table.
-  bf_rt_id_t table_id;
   RETURN_IF_BFRT_ERROR(bfrt_info_->bfrtTableFromNameGet(kPreNodeTable, &table));
-  RETURN_IF_BFRT_ERROR(table->tableIdGet(&table_id));
 
   std::unique_ptr<bfrt::BfRtTableKey> table_key;
   std::unique_ptr<bfrt::BfRtTableData> table_data;
@@ -2149,8 +2133,6 @@ namespace {
 
   auto bf_dev_tgt = GetDeviceTarget(device);
 
-  ASSIGN_OR_RETURN(uint64 mc_node_id, GetFreeMulticastNodeId(device, session));
-
   // Key: $MULTICAST_NODE_ID
   RETURN_IF_ERROR(SetField(table_key.get(), kMcNodeId, mc_node_id));
   // Data: $MULTICAST_RID (16 bit)
@@ -2161,10 +2143,60 @@ namespace {
   // Data: $DEV_PORT
   RETURN_IF_ERROR(SetField(table_data.get(), kMcNodeDevPort, ports));
 
-  RETURN_IF_BFRT_ERROR(table->tableEntryAdd(
-      *real_session->bfrt_session_, bf_dev_tgt, *table_key, *table_data));
+  if (insert) {
+    RETURN_IF_BFRT_ERROR(table->tableEntryAdd(
+        *real_session->bfrt_session_, bf_dev_tgt, *table_key, *table_data));
+  } else {
+    RETURN_IF_BFRT_ERROR(table->tableEntryMod(
+        *real_session->bfrt_session_, bf_dev_tgt, *table_key, *table_data));
+  }
+
+  return ::util::OkStatus();
+}
+
+::util::Status BfSdeWrapper::InsertMulticastNode(
+    int device, std::shared_ptr<BfSdeInterface::SessionInterface> session,
+    uint32 mc_node_id, int mc_replication_id,
+    const std::vector<uint32>& mc_lag_ids, const std::vector<uint32>& ports) {
+  ::absl::ReaderMutexLock l(&data_lock_);
+  return WriteMulticastNode(device, session, mc_node_id, mc_replication_id,
+                            mc_lag_ids, ports, true);
+}
+
+::util::Status BfSdeWrapper::ModifyMulticastNode(
+    int device, std::shared_ptr<BfSdeInterface::SessionInterface> session,
+    uint32 mc_node_id, int mc_replication_id,
+    const std::vector<uint32>& mc_lag_ids, const std::vector<uint32>& ports) {
+  ::absl::ReaderMutexLock l(&data_lock_);
+  return WriteMulticastNode(device, session, mc_node_id, mc_replication_id,
+                            mc_lag_ids, ports, false);
+}
+
+::util::Status BfSdeWrapper::GetMulticastNodeIds(
+    int device, std::shared_ptr<BfSdeInterface::SessionInterface> session,
+    std::vector<uint32>* mc_node_ids) {
+  RET_CHECK(mc_node_ids);
+  ::absl::ReaderMutexLock l(&data_lock_);
+  auto real_session = std::dynamic_pointer_cast<Session>(session);
+  RET_CHECK(real_session);
 
-  return mc_node_id;
+  auto bf_dev_tgt = GetDeviceTarget(device);
+  const bfrt::BfRtTable* table;  // PRE node table.
+  RETURN_IF_BFRT_ERROR(bfrt_info_->bfrtTableFromNameGet(kPreNodeTable, &table));
+  std::vector<std::unique_ptr<bfrt::BfRtTableKey>> keys;
+  std::vector<std::unique_ptr<bfrt::BfRtTableData>> datums;
+  RETURN_IF_ERROR(GetAllEntries(real_session->bfrt_session_, bf_dev_tgt, table,
+                                &keys, &datums));
+
+  mc_node_ids->resize(0);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    // Key: $MULTICAST_NODE_ID
+    uint64 mc_node_id;
+    RETURN_IF_ERROR(GetField(*keys[i], kMcNodeId, &mc_node_id));
+    mc_node_ids->push_back(mc_node_id);
+  }
+
+  return ::util::OkStatus();
 }
 
 ::util::StatusOr<std::vector<uint32>> BfSdeWrapper::GetNodesInMulticastGroup(
@@ -3474,6 +3506,88 @@ namespace {
   return ::util::OkStatus();
 }
 
+::util::Status BfSdeWrapper::GetTableEntriesBatch(
+    int device, std::shared_ptr<BfSdeInterface::SessionInterface> session,
+    uint32 table_id, const TableKeyInterface* previous_key, size_t batch_size,
+    std::vector<std::unique_ptr<TableKeyInterface>>* table_keys,
+    std::vector<std::unique_ptr<TableDataInterface>>* table_datas,
+    size_t* num_entries) {
+  ::absl::ReaderMutexLock l(&data_lock_);
+  RET_CHECK(table_keys) << "table_keys is null";
+  RET_CHECK(table_datas) << "table_datas is null";
+  RET_CHECK(num_entries) << "num_entries is null";
+  RET_CHECK(batch_size > 0) << "Batch size must be positive.";
+  auto real_session = std::dynamic_pointer_cast<Session>(session);
+  RET_CHECK(real_session);
+  const bfrt::BfRtTable* table;
+  RETURN_IF_BFRT_ERROR(bfrt_info_->bfrtTableFromIdGet(table_id, &table));
+  auto bf_dev_tgt = GetDeviceTarget(device);
+  *num_entries = 0;
+
+  // Prepare a full batch of key and data objects. Objects left over from a
+  // previous batch are reset and reused instead of being reallocated.
+  table_keys->resize(batch_size);
+  table_datas->resize(batch_size);
+  bfrt::BfRtTable::keyDataPairs pairs;
+  pairs.reserve(batch_size);
+  for (size_t i = 0; i < batch_size; ++i) {
+    auto* real_table_key = dynamic_cast<TableKey*>((*table_keys)[i].get());
+    if (real_table_key == nullptr) {
+      std::unique_ptr<bfrt::BfRtTableKey> table_key;
+      RETURN_IF_BFRT_ERROR(table->keyAllocate(&table_key));
+      auto tk = absl::make_unique<TableKey>(std::move(table_key));
+      real_table_key = tk.get();
+      (*table_keys)[i] = std::move(tk);
+    } else {
+      RETURN_IF_BFRT_ERROR(table->keyReset(real_table_key->table_key_.get()));
+    }
+    auto* real_table_data = dynamic_cast<TableData*>((*table_datas)[i].get());
+    if (real_table_data == nullptr) {
+      std::unique_ptr<bfrt::BfRtTableData> table_data;
+      RETURN_IF_BFRT_ERROR(table->dataAllocate(&table_data));
+      auto td = absl::make_unique<TableData>(std::move(table_data));
+      real_table_data = td.get();
+      (*table_datas)[i] = std::move(td);
+    } else {
+      RETURN_IF_BFRT_ERROR(
+          table->dataReset(real_table_data->table_data_.get()));
+    }
+    pairs.push_back(std::make_pair(real_table_key->table_key_.get(),
+                                   real_table_data->table_data_.get()));
+  }
+
+  // Find the key from where to continue. On the first batch, this is the first
+  // entry of the table, which then also becomes the first entry of the batch.
+  const bfrt::BfRtTableKey* start_key;
+  if (previous_key == nullptr) {
+    uint32 usage;
+    RETURN_IF_BFRT_ERROR(table->tableUsageGet(
+        *real_session->bfrt_session_, bf_dev_tgt,
+        bfrt::BfRtTable::BfRtTableGetFlag::GET_FROM_SW, &usage));
+    if (usage == 0) return ::util::OkStatus();
+    RETURN_IF_BFRT_ERROR(table->tableEntryGetFirst(
+        *real_session->bfrt_session_, bf_dev_tgt,
+        bfrt::BfRtTable::BfRtTableGetFlag::GET_FROM_SW, pairs[0].first,
+        pairs[0].second));
+    *num_entries = 1;
+    start_key = pairs[0].first;
+    pairs.erase(pairs.begin());
+  } else {
+    auto real_previous_key = dynamic_cast<const TableKey*>(previous_key);
+    RET_CHECK(real_previous_key);
+    start_key = real_previous_key->table_key_.get();
+  }
+  if (pairs.empty()) return ::util::OkStatus();
+
+  uint32 actual = 0;
+  RETURN_IF_BFRT_ERROR(table->tableEntryGetNext_n(
+      *real_session->bfrt_session_, bf_dev_tgt, *start_key, pairs.size(),
+      bfrt::BfRtTable::BfRtTableGetFlag::GET_FROM_SW, &pairs, &actual));
+  *num_entries += actual;
+
+  return ::util::OkStatus();
+}
+
 ::util::Status BfSdeWrapper::SetDefaultTableEntry(
     int device, std::shared_ptr<BfSdeInterface::SessionInterface> session,
     uint32 table_id, const TableDataInterface* table_data) {
@@ -3560,6 +3674,23 @@ namespace {
 ::util::Status BfSdeWrapper::DoSynchronizeCounters(
     int device, std::shared_ptr<BfSdeInterface::SessionInterface> session,
     uint32 table_id, absl::Duration timeout) {
+  auto sync = std::make_shared<CounterSync>();
+  sync->start_time = absl::Now();
+  ASSIGN_OR_RETURN(bool started,
+                   StartCounterSync(device, session, table_id, sync));
+  // Wait until sync done or timeout.
+  if (started && !sync->done.WaitForNotificationWithTimeout(timeout)) {
+    return MAKE_ERROR(ERR_OPER_TIMEOUT)
+           << "Timeout while syncing (indirect) table counters of table "
+           << table_id << ".";
+  }
+
+  return ::util::OkStatus();
+}
+
+::util::StatusOr<bool> BfSdeWrapper::StartCounterSync(
+    int device, std::shared_ptr<BfSdeInterface::SessionInterface> session,
+    uint32 table_id, std::shared_ptr<CounterSync> sync) {
   auto real_session = std::dynamic_pointer_cast<Session>(session);
   RET_CHECK(real_session);
 
@@ -3570,34 +3701,109 @@ namespace {
   // Sync table counter
   std::set<bfrt::TableOperationsType> supported_ops;
   RETURN_IF_BFRT_ERROR(table->tableOperationsSupported(&supported_ops));
-  if (supported_ops.count(bfrt::TableOperationsType::COUNTER_SYNC)) {
-    auto sync_notifier = std::make_shared<absl::Notification>();
-    std::weak_ptr<absl::Notification> weak_ref(sync_notifier);
-    std::unique_ptr<bfrt::BfRtTableOperations> table_op;
-    RETURN_IF_BFRT_ERROR(table->operationsAllocate(
-        bfrt::TableOperationsType::COUNTER_SYNC, &table_op));
-    RETURN_IF_BFRT_ERROR(table_op->counterSyncSet(
-        *real_session->bfrt_session_, bf_dev_tgt,
-        [table_id, weak_ref](const bf_rt_target_t& dev_tgt, void* cookie) {
-          if (auto notifier = weak_ref.lock()) {
-            VLOG(1) << "Table counter for table " << table_id << " synced.";
-            notifier->Notify();
-          } else {
-            VLOG(1) << "Notifier expired before table " << table_id
-                    << " could be synced.";
-          }
-        },
-        nullptr));
-    RETURN_IF_BFRT_ERROR(table->tableOperationsExecute(*table_op.get()));
-    // Wait until sync done or timeout.
-    if (!sync_notifier->WaitForNotificationWithTimeout(timeout)) {
-      return MAKE_ERROR(ERR_OPER_TIMEOUT)
-             << "Timeout while syncing (indirect) table counters of table "
-             << table_id << ".";
+  if (!supported_ops.count(bfrt::TableOperationsType::COUNTER_SYNC)) {
+    return false;
+  }
+  std::weak_ptr<CounterSync> weak_ref(sync);
+  std::unique_ptr<bfrt::BfRtTableOperations> table_op;
+  RETURN_IF_BFRT_ERROR(table->operationsAllocate(
+      bfrt::TableOperationsType::COUNTER_SYNC, &table_op));
+  RETURN_IF_BFRT_ERROR(table_op->counterSyncSet(
+      *real_session->bfrt_session_, bf_dev_tgt,
+      [table_id, weak_ref](const bf_rt_target_t& dev_tgt, void* cookie) {
+        if (auto sync = weak_ref.lock()) {
+          VLOG(1) << "Table counter for table " << table_id << " synced.";
+          sync->success = true;
+          sync->done.Notify();
+        } else {
+          VLOG(1) << "Notifier expired before table " << table_id
+                  << " could be synced.";
+        }
+      },
+      nullptr));
+  RETURN_IF_BFRT_ERROR(table->tableOperationsExecute(*table_op.get()));
+
+  return true;
+}
+
+::util::Status BfSdeWrapper::SynchronizeCountersBatch(
+    int device, std::shared_ptr<BfSdeInterface::SessionInterface> session,
+    const std::vector<uint32>& table_ids, absl::Duration timeout,
+    absl::Duration max_staleness) {
+  ::absl::ReaderMutexLock l(&data_lock_);
+  const absl::Time now = absl::Now();
+  const absl::Time deadline = now + timeout;
+
+  // Find the tables which need a new sync. Tables with a recent enough sync
+  // are skipped, tables with a recent enough sync in flight join that sync.
+  std::vector<std::pair<uint32, std::shared_ptr<CounterSync>>> own_syncs;
+  std::vector<std::pair<uint32, std::shared_ptr<CounterSync>>> waiting_syncs;
+  {
+    absl::MutexLock sync_lock(&counter_sync_lock_);
+    for (const uint32 table_id : table_ids) {
+      CounterSyncState& state =
+          counter_sync_states_[std::make_pair(device, table_id)];
+      if (now - state.last_sync_time <= max_staleness) continue;
+      if (state.in_flight &&
+          now - state.in_flight->start_time <= max_staleness) {
+        waiting_syncs.push_back(std::make_pair(table_id, state.in_flight));
+        continue;
+      }
+      auto sync = std::make_shared<CounterSync>();
+      sync->start_time = now;
+      state.in_flight = sync;
+      own_syncs.push_back(std::make_pair(table_id, sync));
     }
   }
 
-  return ::util::OkStatus();
+  // Issue all new syncs at once. Syncs that could not be issued are completed
+  // right away, so that other readers waiting for them do not block.
+  ::util::Status status = ::util::OkStatus();
+  for (const auto& e : own_syncs) {
+    auto ret = StartCounterSync(device, session, e.first, e.second);
+    if (!ret.ok()) {
+      APPEND_STATUS_IF_ERROR(status, ret.status());
+      e.second->done.Notify();
+    } else if (!ret.ValueOrDie()) {
+      e.second->success = true;
+      e.second->done.Notify();
+    } else {
+      waiting_syncs.push_back(e);
+    }
+  }
+
+  // Wait for all syncs together.
+  for (const auto& e : waiting_syncs) {
+    if (!e.second->done.WaitForNotificationWithDeadline(deadline)) {
+      ::util::Status error =
+          MAKE_ERROR(ERR_OPER_TIMEOUT)
+          << "Timeout while syncing (indirect) table counters of table "
+          << e.first << ".";
+      APPEND_STATUS_IF_ERROR(status, error);
+    } else if (!e.second->success) {
+      ::util::Status error =
+          MAKE_ERROR(ERR_INTERNAL)
+          << "Failed to sync (indirect) table counters of table " << e.first
+          << ".";
+      APPEND_STATUS_IF_ERROR(status, error);
+    }
+  }
+
+  // Record the completed syncs and release the ones issued by this call.
+  {
+    absl::MutexLock sync_lock(&counter_sync_lock_);
+    for (const auto& e : own_syncs) {
+      CounterSyncState& state =
+          counter_sync_states_[std::make_pair(device, e.first)];
+      if (e.second->done.HasBeenNotified() && e.second->success) {
+        state.last_sync_time =
+            std::max(state.last_sync_time, e.second->start_time);
+      }
+      if (state.in_flight == e.second) state.in_flight.reset();
+    }
+  }
+
+  return status;
 }
 
 ::util::Status BfSdeWrapper::SynchronizeRegisters(
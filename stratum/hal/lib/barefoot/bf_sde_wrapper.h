@@ -11,6 +11,8 @@
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/time.h"
 #include "bf_rt/bf_rt_init.hpp"
 #include "bf_rt/bf_rt_session.hpp"
 #include "bf_rt/bf_rt_table.hpp"
@@ -191,12 +193,22 @@ class BfSdeWrapper : public BfSdeInterface {
   ::util::Status StartPacketIo(int device) override;
   ::util::Status StopPacketIo(int device) override;
   ::util::Status RegisterPacketReceiveWriter(
-      int device, std::unique_ptr<ChannelWriter<std::string>> writer) override;
+      int device, std::unique_ptr<ChannelWriter<std::string>> writer,
+      std::shared_ptr<PacketBufferPool> buffer_pool) override;
   ::util::Status UnregisterPacketReceiveWriter(int device) override;
-  ::util::StatusOr<uint32> CreateMulticastNode(
+  ::util::Status InsertMulticastNode(
       int device, std::shared_ptr<BfSdeInterface::SessionInterface> session,
-      int mc_replication_id, const std::vector<uint32>& mc_lag_ids,
+      uint32 mc_node_id, int mc_replication_id,
+      const std::vector<uint32>& mc_lag_ids,
       const std::vector<uint32>& ports) override LOCKS_EXCLUDED(data_lock_);
+  ::util::Status ModifyMulticastNode(
+      int device, std::shared_ptr<BfSdeInterface::SessionInterface> session,
+      uint32 mc_node_id, int mc_replication_id,
+      const std::vector<uint32>& mc_lag_ids,
+      const std::vector<uint32>& ports) override LOCKS_EXCLUDED(data_lock_);
+  ::util::Status GetMulticastNodeIds(
+      int device, std::shared_ptr<BfSdeInterface::SessionInterface> session,
+      std::vector<uint32>* mc_node_ids) override LOCKS_EXCLUDED(data_lock_);
   ::util::StatusOr<std::vector<uint32>> GetNodesInMulticastGroup(
       int device, std::shared_ptr<BfSdeInterface::SessionInterface> session,
       uint32 group_id) override LOCKS_EXCLUDED(data_lock_);
@@ -337,6 +349,12 @@ class BfSdeWrapper : public BfSdeInterface {
       std::vector<std::unique_ptr<TableKeyInterface>>* table_keys,
       std::vector<std::unique_ptr<TableDataInterface>>* table_datas) override
       LOCKS_EXCLUDED(data_lock_);
+  ::util::Status GetTableEntriesBatch(
+      int device, std::shared_ptr<BfSdeInterface::SessionInterface> session,
+      uint32 table_id, const TableKeyInterface* previous_key, size_t batch_size,
+      std::vector<std::unique_ptr<TableKeyInterface>>* table_keys,
+      std::vector<std::unique_ptr<TableDataInterface>>* table_datas,
+      size_t* num_entries) override LOCKS_EXCLUDED(data_lock_);
   ::util::Status SetDefaultTableEntry(
       int device, std::shared_ptr<BfSdeInterface::SessionInterface> session,
       uint32 table_id, const TableDataInterface* table_data) override
@@ -349,6 +367,12 @@ class BfSdeWrapper : public BfSdeInterface {
       uint32 table_id, TableDataInterface* table_data) override
       LOCKS_EXCLUDED(data_lock_);
 
+  ::util::Status SynchronizeCountersBatch(
+      int device, std::shared_ptr<BfSdeInterface::SessionInterface> session,
+      const std::vector<uint32>& table_ids, absl::Duration timeout,
+      absl::Duration max_staleness) override
+      LOCKS_EXCLUDED(data_lock_, counter_sync_lock_);
+
   ::util::StatusOr<uint32> GetBfRtId(uint32 p4info_id) const override
       LOCKS_EXCLUDED(data_lock_);
   ::util::StatusOr<uint32> GetP4InfoId(uint32 bfrt_id) const override
@@ -405,6 +429,25 @@ class BfSdeWrapper : public BfSdeInterface {
   // Timeout for Write() operations on port status events.
   static constexpr absl::Duration kWriteTimeout = absl::InfiniteDuration();
 
+  // A counter sync operation on a single table. Shared by all readers waiting
+  // for the same sync.
+  struct CounterSync {
+    // Time at which the sync operation was issued.
+    absl::Time start_time;
+    // Set before 'done' is notified, if the sync completed successfully.
+    bool success = false;
+    // Notified when the sync completed, or could not be issued.
+    absl::Notification done;
+  };
+
+  // The counter sync state of a single table.
+  struct CounterSyncState {
+    // Issue time of the last successfully completed sync.
+    absl::Time last_sync_time = absl::InfinitePast();
+    // The sync operation currently in flight, if any.
+    std::shared_ptr<CounterSync> in_flight;
+  };
+
   // Private constructor, use CreateSingleton and GetSingleton().
   BfSdeWrapper();
 
@@ -417,6 +460,9 @@ class BfSdeWrapper : public BfSdeInterface {
   // RW mutex lock for protecting the pipeline state.
   mutable absl::Mutex data_lock_;
 
+  // Mutex protecting the counter sync states.
+  mutable absl::Mutex counter_sync_lock_;
+
   // Callback registed with the SDE for Tx notifications.
   static bf_status_t BfPktTxNotifyCallback(bf_dev_id_t device,
                                            bf_pkt_tx_ring_t tx_ring,
@@ -427,6 +473,13 @@ class BfSdeWrapper : public BfSdeInterface {
                                            void* cookie,
                                            bf_pkt_rx_ring_t rx_ring);
 
+  // Common code for multicast node handling.
+  ::util::Status WriteMulticastNode(
+      int device, std::shared_ptr<BfSdeInterface::SessionInterface> session,
+      uint32 mc_node_id, int mc_replication_id,
+      const std::vector<uint32>& mc_lag_ids, const std::vector<uint32>& ports,
+      bool insert) SHARED_LOCKS_REQUIRED(data_lock_);
+
   // Common code for multicast group handling.
   ::util::Status WriteMulticastGroup(
       int device, std::shared_ptr<BfSdeInterface::SessionInterface> session,
@@ -453,12 +506,6 @@ class BfSdeWrapper : public BfSdeInterface {
       const std::vector<bool>& member_status, bool insert)
       SHARED_LOCKS_REQUIRED(data_lock_);
 
-  // Helper function to find, but not allocate, at free multicast node id.
-  // This function is not optimized for speed yet.
-  ::util::StatusOr<uint32> GetFreeMulticastNodeId(
-      int device, std::shared_ptr<BfSdeInterface::SessionInterface> session)
-      SHARED_LOCKS_REQUIRED(data_lock_);
-
   // Helper to dump the entire PRE table state for debugging. Only runs at v=2.
   ::util::Status DumpPreState(
       int device, std::shared_ptr<BfSdeInterface::SessionInterface> session)
@@ -479,6 +526,15 @@ class BfSdeWrapper : public BfSdeInterface {
       uint32 table_id, absl::Duration timeout)
       SHARED_LOCKS_REQUIRED(data_lock_);
 
+  // Issues a counter sync operation on the given BfRt table without waiting
+  // for it. The 'done' notification of 'sync' is notified on completion, unless
+  // the sync object has expired by then. Returns false if the table does not
+  // support counter syncs, in which case nothing is issued.
+  ::util::StatusOr<bool> StartCounterSync(
+      int device, std::shared_ptr<BfSdeInterface::SessionInterface> session,
+      uint32 table_id, std::shared_ptr<CounterSync> sync)
+      SHARED_LOCKS_REQUIRED(data_lock_);
+
   // Writer to forward the port status change message to. It is registered
   // by chassis manager to receive SDE port status change events.
   std::unique_ptr<ChannelWriter<PortStatusEvent>> port_status_event_writer_
@@ -488,6 +544,15 @@ class BfSdeWrapper : public BfSdeInterface {
   absl::flat_hash_map<int, std::unique_ptr<ChannelWriter<std::string>>>
       device_to_packet_rx_writer_ GUARDED_BY(packet_rx_callback_lock_);
 
+  // Map from device ID to the pool received packets are copied into. Devices
+  // without a pool allocate a new buffer for every packet.
+  absl::flat_hash_map<int, std::shared_ptr<PacketBufferPool>>
+      device_to_packet_rx_buffer_pool_ GUARDED_BY(packet_rx_callback_lock_);
+
+  // Map from (device, BfRt table ID) to the counter sync state of the table.
+  absl::flat_hash_map<std::pair<int, uint32>, CounterSyncState>
+      counter_sync_states_ GUARDED_BY(counter_sync_lock_);
+
   // Map from device ID to vector of all allocated PPGs.
   absl::flat_hash_map<int, std::vector<bf_tm_ppg_hdl>> device_to_ppg_handles_
       GUARDED_BY(data_lock_);
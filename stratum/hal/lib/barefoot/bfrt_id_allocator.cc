@@ -0,0 +1,96 @@
+// Copyright 2020-present Open Networking Foundation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "stratum/hal/lib/barefoot/bfrt_id_allocator.h"
+
+#include <algorithm>
+
+#include "absl/numeric/bits.h"
+#include "stratum/glue/logging.h"
+#include "stratum/glue/status/status_macros.h"
+#include "stratum/public/lib/error.h"
+
+namespace stratum {
+namespace hal {
+namespace barefoot {
+
+constexpr int IdAllocator::kBitsPerWord;
+
+IdAllocator::IdAllocator(uint32 min_id, uint32 max_id)
+    : min_id_(min_id),
+      max_id_(std::max(min_id, max_id)),
+      words_(),
+      first_free_word_(0),
+      num_allocated_(0) {}
+
+::util::StatusOr<uint32> IdAllocator::Allocate() {
+  while (first_free_word_ < words_.size() &&
+         words_[first_free_word_] == ~uint64{0}) {
+    ++first_free_word_;
+  }
+  if (first_free_word_ == words_.size()) {
+    if (first_free_word_ * kBitsPerWord > max_id_ - min_id_) {
+      return MAKE_ERROR(ERR_TABLE_FULL).without_logging()
+             << "All IDs from " << min_id_ << " to " << max_id_
+             << " are in use.";
+    }
+    words_.push_back(0);
+  }
+  uint64& word = words_[first_free_word_];
+  const int bit = absl::countr_zero(~word);
+  const uint64 offset = first_free_word_ * kBitsPerWord + bit;
+  if (offset > max_id_ - min_id_) {
+    return MAKE_ERROR(ERR_TABLE_FULL).without_logging()
+           << "All IDs from " << min_id_ << " to " << max_id_ << " are in use.";
+  }
+  word |= uint64{1} << bit;
+  ++num_allocated_;
+
+  return static_cast<uint32>(min_id_ + offset);
+}
+
+::util::Status IdAllocator::Reserve(uint32 id) {
+  if (id < min_id_ || id > max_id_) {
+    return MAKE_ERROR(ERR_INVALID_PARAM)
+           << "ID " << id << " is not in the range from " << min_id_ << " to "
+           << max_id_ << ".";
+  }
+  const uint32 offset = id - min_id_;
+  const size_t index = offset / kBitsPerWord;
+  if (index >= words_.size()) words_.resize(index + 1, 0);
+  const uint64 mask = uint64{1} << (offset % kBitsPerWord);
+  if (words_[index] & mask) {
+    return MAKE_ERROR(ERR_ENTRY_EXISTS) << "ID " << id << " is in use.";
+  }
+  words_[index] |= mask;
+  ++num_allocated_;
+
+  return ::util::OkStatus();
+}
+
+void IdAllocator::Release(uint32 id) {
+  if (!IsAllocated(id)) return;
+  const uint32 offset = id - min_id_;
+  const size_t index = offset / kBitsPerWord;
+  words_[index] &= ~(uint64{1} << (offset % kBitsPerWord));
+  first_free_word_ = std::min(first_free_word_, index);
+  --num_allocated_;
+}
+
+bool IdAllocator::IsAllocated(uint32 id) const {
+  if (id < min_id_ || id > max_id_) return false;
+  const uint32 offset = id - min_id_;
+  const size_t index = offset / kBitsPerWord;
+  return index < words_.size() &&
+         (words_[index] & (uint64{1} << (offset % kBitsPerWord)));
+}
+
+void IdAllocator::Clear() {
+  words_.clear();
+  first_free_word_ = 0;
+  num_allocated_ = 0;
+}
+
+}  // namespace barefoot
+}  // namespace hal
+}  // namespace stratum
@@ -0,0 +1,64 @@
+// Copyright 2020-present Open Networking Foundation
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef STRATUM_HAL_LIB_BAREFOOT_BFRT_ID_ALLOCATOR_H_
+#define STRATUM_HAL_LIB_BAREFOOT_BFRT_ID_ALLOCATOR_H_
+
+#include <vector>
+
+#include "stratum/glue/integral_types.h"
+#include "stratum/glue/status/status.h"
+#include "stratum/glue/status/statusor.h"
+
+namespace stratum {
+namespace hal {
+namespace barefoot {
+
+// Allocates IDs of SDE resources, e.g. PRE multicast nodes, in memory instead
+// of probing the SDE tables for a free ID. The used IDs are kept in a bitmap
+// together with the index of the lowest word which may have a free bit, so
+// allocating the lowest free ID takes amortized constant time. The bitmap only
+// grows up to the highest ID used so far. Not thread-safe, the owner has to
+// serialize the calls.
+class IdAllocator {
+ public:
+  // Creates an allocator handing out IDs from [min_id, max_id].
+  IdAllocator(uint32 min_id, uint32 max_id);
+
+  // Returns the lowest free ID and marks it as used.
+  // Returns ERR_TABLE_FULL if all IDs are used.
+  ::util::StatusOr<uint32> Allocate();
+
+  // Marks the given ID as used, e.g. when rebuilding the allocator from the
+  // hardware state. Returns ERR_ENTRY_EXISTS if the ID is used already.
+  ::util::Status Reserve(uint32 id);
+
+  // Marks the given ID as free. Does nothing if the ID is not used.
+  void Release(uint32 id);
+
+  // Returns true if the given ID is used.
+  bool IsAllocated(uint32 id) const;
+
+  // Returns the number of used IDs.
+  size_t NumAllocated() const { return num_allocated_; }
+
+  // Marks all IDs as free.
+  void Clear();
+
+ private:
+  static constexpr int kBitsPerWord = 64;
+
+  const uint32 min_id_;
+  const uint32 max_id_;
+  // Bit i of word w is set if ID min_id_ + w * kBitsPerWord + i is used.
+  std::vector<uint64> words_;
+  // All words before this index are full.
+  size_t first_free_word_;
+  size_t num_allocated_;
+};
+
+}  // namespace barefoot
+}  // namespace hal
+}  // namespace stratum
+
+#endif  // STRATUM_HAL_LIB_BAREFOOT_BFRT_ID_ALLOCATOR_H_
@@ -0,0 +1,76 @@
+// Copyright 2020-present Open Networking Foundation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "stratum/hal/lib/barefoot/bfrt_id_allocator.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "stratum/glue/status/status_test_util.h"
+#include "stratum/public/lib/error.h"
+
+namespace stratum {
+namespace hal {
+namespace barefoot {
+namespace {
+
+TEST(IdAllocatorTest, AllocateReturnsLowestFreeId) {
+  IdAllocator allocator(10, 1000);
+  for (uint32 i = 0; i < 200; ++i) {
+    auto id = allocator.Allocate();
+    ASSERT_OK(id);
+    EXPECT_EQ(10 + i, id.ValueOrDie());
+  }
+  EXPECT_EQ(200, allocator.NumAllocated());
+
+  allocator.Release(15);
+  allocator.Release(150);
+  EXPECT_FALSE(allocator.IsAllocated(15));
+  EXPECT_EQ(15, allocator.Allocate().ValueOrDie());
+  EXPECT_EQ(150, allocator.Allocate().ValueOrDie());
+  EXPECT_EQ(210, allocator.Allocate().ValueOrDie());
+}
+
+TEST(IdAllocatorTest, AllocateFailsWhenExhausted) {
+  IdAllocator allocator(1, 70);
+  for (uint32 i = 1; i <= 70; ++i) {
+    ASSERT_OK(allocator.Allocate());
+  }
+  auto id = allocator.Allocate();
+  EXPECT_EQ(ERR_TABLE_FULL, id.status().error_code());
+
+  allocator.Release(42);
+  EXPECT_EQ(42, allocator.Allocate().ValueOrDie());
+  EXPECT_EQ(ERR_TABLE_FULL, allocator.Allocate().status().error_code());
+}
+
+TEST(IdAllocatorTest, ReserveMarksIdsAsUsed) {
+  IdAllocator allocator(0, 0xffffff);
+  EXPECT_OK(allocator.Reserve(0));
+  EXPECT_OK(allocator.Reserve(2));
+  EXPECT_OK(allocator.Reserve(5000));
+  EXPECT_EQ(ERR_ENTRY_EXISTS, allocator.Reserve(2).error_code());
+  EXPECT_EQ(ERR_INVALID_PARAM, allocator.Reserve(0x1000000).error_code());
+  EXPECT_TRUE(allocator.IsAllocated(5000));
+  EXPECT_EQ(3, allocator.NumAllocated());
+
+  EXPECT_EQ(1, allocator.Allocate().ValueOrDie());
+  EXPECT_EQ(3, allocator.Allocate().ValueOrDie());
+}
+
+TEST(IdAllocatorTest, ClearReleasesAllIds) {
+  IdAllocator allocator(0, 100);
+  ASSERT_OK(allocator.Reserve(7));
+  ASSERT_OK(allocator.Allocate());
+  allocator.Clear();
+  EXPECT_EQ(0, allocator.NumAllocated());
+  EXPECT_FALSE(allocator.IsAllocated(7));
+  EXPECT_EQ(0, allocator.Allocate().ValueOrDie());
+  // Releasing a free ID is a no-op.
+  allocator.Release(7);
+  EXPECT_EQ(1, allocator.NumAllocated());
+}
+
+}  // namespace
+}  // namespace barefoot
+}  // namespace hal
+}  // namespace stratum
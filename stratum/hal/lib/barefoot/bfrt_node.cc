@@ -5,11 +5,13 @@
 
 #include <unistd.h>
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <utility>
 
 #include "absl/memory/memory.h"
+#include "gflags/gflags.h"
 #include "stratum/glue/status/status_macros.h"
 #include "stratum/hal/lib/barefoot/bf_pipeline_utils.h"
 #include "stratum/hal/lib/barefoot/bf_sde_interface.h"
@@ -20,10 +22,75 @@
 #include "stratum/lib/utils.h"
 #include "stratum/public/proto/error.pb.h"
 
+DEFINE_int32(bfrt_write_prepare_threads, 4,
+             "Number of threads translating the table entries of large P4 "
+             "write requests and building their SDE keys and data, while "
+             "the prepared entries are programmed in order. 0 prepares all "
+             "updates on the thread serving the request.");
+DEFINE_int32(bfrt_write_parallel_prepare_min_updates, 64,
+             "Minimum number of updates in a P4 write request to prepare its "
+             "table entries on the write threads.");
+
 namespace stratum {
 namespace hal {
 namespace barefoot {
 
+namespace {
+
+// Holds a set of entity lock stripes for the lifetime of the object. The
+// stripes must be sorted to rule out lock order inversions between requests.
+class EntityStripeLock {
+ public:
+  EntityStripeLock(absl::Mutex* stripes, std::vector<int> indices,
+                   bool exclusive) NO_THREAD_SAFETY_ANALYSIS
+      : stripes_(stripes),
+        indices_(std::move(indices)),
+        exclusive_(exclusive) {
+    for (int i : indices_) {
+      if (exclusive_) {
+        stripes_[i].WriterLock();
+      } else {
+        stripes_[i].ReaderLock();
+      }
+    }
+  }
+
+  ~EntityStripeLock() NO_THREAD_SAFETY_ANALYSIS {
+    for (auto it = indices_.rbegin(); it != indices_.rend(); ++it) {
+      if (exclusive_) {
+        stripes_[*it].WriterUnlock();
+      } else {
+        stripes_[*it].ReaderUnlock();
+      }
+    }
+  }
+
+  // EntityStripeLock is neither copyable nor movable.
+  EntityStripeLock(const EntityStripeLock&) = delete;
+  EntityStripeLock& operator=(const EntityStripeLock&) = delete;
+
+ private:
+  absl::Mutex* const stripes_;
+  const std::vector<int> indices_;
+  const bool exclusive_;
+};
+
+// Sorts and deduplicates stripe indices. A negative index stands for a
+// wildcard and expands to all stripes.
+std::vector<int> NormalizeStripes(std::vector<int> stripes, int num_stripes) {
+  if (std::any_of(stripes.begin(), stripes.end(),
+                  [](int stripe) { return stripe < 0; })) {
+    stripes.resize(num_stripes);
+    for (int i = 0; i < num_stripes; ++i) stripes[i] = i;
+    return stripes;
+  }
+  std::sort(stripes.begin(), stripes.end());
+  stripes.erase(std::unique(stripes.begin(), stripes.end()), stripes.end());
+  return stripes;
+}
+
+}  // namespace
+
 BfrtNode::BfrtNode(BfrtTableManager* bfrt_table_manager,
                    BfrtPacketioManager* bfrt_packetio_manager,
                    BfrtPreManager* bfrt_pre_manager,
@@ -39,8 +106,15 @@ BfrtNode::BfrtNode(BfrtTableManager* bfrt_table_manager,
       bfrt_pre_manager_(ABSL_DIE_IF_NULL(bfrt_pre_manager)),
       bfrt_counter_manager_(ABSL_DIE_IF_NULL(bfrt_counter_manager)),
       bfrt_p4runtime_translator_(ABSL_DIE_IF_NULL(bfrt_p4runtime_translator)),
+      write_pool_(),
       node_id_(0),
-      device_id_(device_id) {}
+      device_id_(device_id) {
+  if (FLAGS_bfrt_write_prepare_threads > 0) {
+    write_pool_ = absl::make_unique<WorkStealingThreadpool>(
+        FLAGS_bfrt_write_prepare_threads);
+    write_pool_->Start();
+  }
+}
 
 BfrtNode::BfrtNode()
     : pipeline_initialized_(false),
@@ -52,6 +126,7 @@ BfrtNode::BfrtNode()
       bfrt_pre_manager_(nullptr),
       bfrt_counter_manager_(nullptr),
       bfrt_p4runtime_translator_(nullptr),
+      write_pool_(),
       node_id_(0),
       device_id_(-1) {}
 
@@ -185,7 +260,9 @@ std::unique_ptr<BfrtNode> BfrtNode::CreateInstance(
 
 ::util::Status BfrtNode::WriteForwardingEntries(
     const ::p4::v1::WriteRequest& req, std::vector<::util::Status>* results) {
-  absl::WriterMutexLock l(&lock_);
+  // Pipeline pushes are the only exclusive users of the node lock. Concurrent
+  // writes are serialized per P4 object by the entity lock stripes instead.
+  absl::ReaderMutexLock l(&lock_);
   RET_CHECK(req.device_id() == node_id_)
       << "Request device id must be same as id of this BfrtNode.";
   RET_CHECK(req.atomicity() == ::p4::v1::WriteRequest::CONTINUE_ON_ERROR)
@@ -196,15 +273,57 @@ std::unique_ptr<BfrtNode> BfrtNode::CreateInstance(
     return MAKE_ERROR(ERR_NOT_INITIALIZED) << "Not initialized!";
   }
 
+  EntityStripeLock stripe_lock(entity_locks_.data(), EntityLockStripes(req),
+                               /*exclusive=*/true);
   bool success = true;
   ASSIGN_OR_RETURN(auto session, bf_sde_interface_->CreateSession());
   RETURN_IF_ERROR(session->BeginBatch());
-  for (const auto& update : req.updates()) {
+
+  // The table entries of large requests are translated and converted into SDE
+  // keys and data in chunks on the write pool, while this thread programs the
+  // chunks already prepared in request order.
+  const int num_updates = req.updates_size();
+  std::vector<BfrtTableManager::PreparedTableEntryWrite> prepared;
+  std::vector<::util::Status> prepare_results;
+  std::vector<TaskId> chunk_tasks;
+  if (write_pool_ != nullptr &&
+      num_updates >= FLAGS_bfrt_write_parallel_prepare_min_updates) {
+    prepared.resize(num_updates);
+    prepare_results.resize(num_updates);
+    for (int begin = 0; begin < num_updates; begin += kWritePrepareChunkSize) {
+      const int end = std::min(begin + kWritePrepareChunkSize, num_updates);
+      chunk_tasks.push_back(write_pool_->Schedule(
+          [this, &req, &prepared, &prepare_results, begin, end]() {
+            for (int i = begin; i < end; ++i) {
+              const auto& update = req.updates(i);
+              if (!update.entity().has_table_entry()) continue;
+              prepare_results[i] = bfrt_table_manager_->PrepareTableEntryWrite(
+                  update.type(), update.entity().table_entry(), &prepared[i]);
+            }
+          }));
+    }
+  }
+
+  for (int i = 0; i < num_updates; ++i) {
+    const auto& update = req.updates(i);
+    if (!chunk_tasks.empty() && i % kWritePrepareChunkSize == 0) {
+      write_pool_->WaitAll({chunk_tasks[i / kWritePrepareChunkSize]});
+    }
     ::util::Status status = ::util::OkStatus();
     switch (update.entity().entity_case()) {
       case ::p4::v1::Entity::kTableEntry:
-        status = bfrt_table_manager_->WriteTableEntry(
-            session, update.type(), update.entity().table_entry());
+        if (chunk_tasks.empty()) {
+          status = bfrt_table_manager_->WriteTableEntry(
+              session, update.type(), update.entity().table_entry());
+          break;
+        }
+        status = prepare_results[i];
+        if (status.ok()) {
+          status =
+              bfrt_table_manager_->ApplyTableEntryWrite(session, prepared[i]);
+        }
+        // Releases the SDE key and data right away.
+        prepared[i] = BfrtTableManager::PreparedTableEntryWrite();
         break;
       case ::p4::v1::Entity::kExternEntry:
         status = WriteExternEntry(session, update.type(),
@@ -277,6 +396,8 @@ std::unique_ptr<BfrtNode> BfrtNode::CreateInstance(
   if (!initialized_ || !pipeline_initialized_) {
     return MAKE_ERROR(ERR_NOT_INITIALIZED) << "Not initialized!";
   }
+  EntityStripeLock stripe_lock(entity_locks_.data(), EntityLockStripes(req),
+                               /*exclusive=*/false);
   ::p4::v1::ReadResponse resp;
   bool success = true;
   ASSIGN_OR_RETURN(auto session, bf_sde_interface_->CreateSession());
@@ -464,6 +585,91 @@ std::unique_ptr<BfrtNode> BfrtNode::CreateInstance(
   }
 }
 
+int BfrtNode::EntityLockStripe(const ::p4::v1::Entity& entity) {
+  // Entities operating on the same P4 object share a key: direct resources
+  // use their table, and action profile externs their action profile.
+  int entity_type = entity.entity_case();
+  uint32 object_id = 0;
+  switch (entity.entity_case()) {
+    case ::p4::v1::Entity::kTableEntry:
+      object_id = entity.table_entry().table_id();
+      break;
+    case ::p4::v1::Entity::kDirectCounterEntry:
+      entity_type = ::p4::v1::Entity::kTableEntry;
+      object_id = entity.direct_counter_entry().table_entry().table_id();
+      break;
+    case ::p4::v1::Entity::kDirectMeterEntry:
+      entity_type = ::p4::v1::Entity::kTableEntry;
+      object_id = entity.direct_meter_entry().table_entry().table_id();
+      break;
+    case ::p4::v1::Entity::kActionProfileMember:
+      object_id = entity.action_profile_member().action_profile_id();
+      break;
+    case ::p4::v1::Entity::kActionProfileGroup:
+      entity_type = ::p4::v1::Entity::kActionProfileMember;
+      object_id = entity.action_profile_group().action_profile_id();
+      break;
+    case ::p4::v1::Entity::kExternEntry: {
+      const auto& extern_entry = entity.extern_entry();
+      ::p4::v1::ActionProfileMember act_prof_member;
+      ::p4::v1::ActionProfileGroup act_prof_group;
+      if (extern_entry.extern_type_id() == kTnaExternActionProfileId &&
+          extern_entry.entry().UnpackTo(&act_prof_member)) {
+        entity_type = ::p4::v1::Entity::kActionProfileMember;
+        object_id = act_prof_member.action_profile_id();
+      } else if (extern_entry.extern_type_id() == kTnaExternActionSelectorId &&
+                 extern_entry.entry().UnpackTo(&act_prof_group)) {
+        entity_type = ::p4::v1::Entity::kActionProfileMember;
+        object_id = act_prof_group.action_profile_id();
+      } else {
+        object_id = extern_entry.extern_id();
+      }
+      break;
+    }
+    case ::p4::v1::Entity::kCounterEntry:
+      object_id = entity.counter_entry().counter_id();
+      break;
+    case ::p4::v1::Entity::kMeterEntry:
+      object_id = entity.meter_entry().meter_id();
+      break;
+    case ::p4::v1::Entity::kRegisterEntry:
+      object_id = entity.register_entry().register_id();
+      break;
+    case ::p4::v1::Entity::kPacketReplicationEngineEntry:
+      // All PRE entries share a single stripe, the PRE manager serializes
+      // them internally anyway.
+      return kNumEntityLockStripes - 1;
+    default:
+      // Unsupported entities are rejected without touching the SDE.
+      return 0;
+  }
+  // A zero ID denotes a wildcard read of all objects of the type.
+  if (object_id == 0) return -1;
+  // Fibonacci hashing spreads the densely allocated P4 IDs over the stripes.
+  const uint64 key = (static_cast<uint64>(entity_type) << 32) | object_id;
+  return static_cast<int>(((key * 0x9E3779B97F4A7C15ULL) >> 32) %
+                          kNumEntityLockStripes);
+}
+
+std::vector<int> BfrtNode::EntityLockStripes(
+    const ::p4::v1::WriteRequest& req) {
+  std::vector<int> stripes;
+  stripes.reserve(req.updates_size());
+  for (const auto& update : req.updates()) {
+    stripes.push_back(EntityLockStripe(update.entity()));
+  }
+  return NormalizeStripes(std::move(stripes), kNumEntityLockStripes);
+}
+
+std::vector<int> BfrtNode::EntityLockStripes(const ::p4::v1::ReadRequest& req) {
+  std::vector<int> stripes;
+  stripes.reserve(req.entities_size());
+  for (const auto& entity : req.entities()) {
+    stripes.push_back(EntityLockStripe(entity));
+  }
+  return NormalizeStripes(std::move(stripes), kNumEntityLockStripes);
+}
+
 }  // namespace barefoot
 }  // namespace hal
 }  // namespace stratum
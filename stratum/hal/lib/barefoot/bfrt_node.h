@@ -4,6 +4,7 @@
 #ifndef STRATUM_HAL_LIB_BAREFOOT_BFRT_NODE_H_
 #define STRATUM_HAL_LIB_BAREFOOT_BFRT_NODE_H_
 
+#include <array>
 #include <memory>
 #include <vector>
 
@@ -20,6 +21,7 @@
 #include "stratum/hal/lib/barefoot/bfrt_table_manager.h"
 #include "stratum/hal/lib/common/common.pb.h"
 #include "stratum/hal/lib/common/writer_interface.h"
+#include "stratum/lib/work_stealing_threadpool.h"
 
 namespace stratum {
 namespace hal {
@@ -102,13 +104,39 @@ class BfrtNode {
       const ::p4::v1::ExternEntry& entry,
       WriterInterface<::p4::v1::ReadResponse>* writer);
 
+  // Number of consecutive updates of a write request prepared by a single task
+  // on the write pool.
+  static constexpr int kWritePrepareChunkSize = 32;
+
+  // Number of entity lock stripes.
+  static constexpr int kNumEntityLockStripes = 64;
+
+  // Returns the index of the entity lock stripe guarding the P4 object (table,
+  // action profile, counter, ...) the given entity belongs to, or -1 if the
+  // entity is a wildcard spanning all objects of its type.
+  static int EntityLockStripe(const ::p4::v1::Entity& entity);
+
+  // Return the sorted and deduplicated stripe indices guarding the entities of
+  // a request. Wildcard entities expand to all stripes.
+  static std::vector<int> EntityLockStripes(const ::p4::v1::WriteRequest& req);
+  static std::vector<int> EntityLockStripes(const ::p4::v1::ReadRequest& req);
+
   // Callback registered with DeviceMgr to receive stream messages.
   friend void StreamMessageCb(uint64 node_id,
                               p4::v1::StreamMessageResponse* msg, void* cookie);
 
-  // Reader-writer lock used to protect access to node-specific state.
+  // Reader-writer lock used to protect access to node-specific state. Held
+  // exclusively by pipeline and chassis config pushes, and in shared mode by
+  // P4Runtime reads and writes, which in turn serialize on entity_locks_.
   mutable absl::Mutex lock_;
 
+  // Striped reader-writer locks serializing access to individual P4 objects.
+  // Writes hold the stripes of all objects in the batch exclusively, reads in
+  // shared mode, so requests touching different tables, PRE entries, counters
+  // or registers run concurrently on their own SDE sessions. Always acquired
+  // after lock_ and in ascending stripe order.
+  mutable std::array<absl::Mutex, kNumEntityLockStripes> entity_locks_;
+
   // Mutex used for exclusive access to rx_writer_.
   mutable absl::Mutex rx_writer_lock_;
 
@@ -135,6 +163,10 @@ class BfrtNode {
   // translator logic. Not owned by this class.
   BfrtP4RuntimeTranslator* bfrt_p4runtime_translator_ = nullptr;
 
+  // Threadpool preparing the table entries of large write requests in
+  // parallel. Null if all updates are prepared on the calling thread.
+  std::unique_ptr<WorkStealingThreadpool> write_pool_;
+
   // Logical node ID corresponding to the node/ASIC managed by this class
   // instance. Assigned on PushChassisConfig() and might change during the
   // lifetime of the class.
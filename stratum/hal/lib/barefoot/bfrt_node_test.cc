@@ -4,10 +4,16 @@
 
 #include "stratum/hal/lib/barefoot/bfrt_node.h"
 
+#include <algorithm>
+#include <atomic>
 #include <string>
+#include <thread>  // NOLINT
 
 #include "absl/memory/memory.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "stratum/glue/status/canonical_errors.h"
@@ -37,6 +43,8 @@ using ::testing::WithArgs;
 
 MATCHER_P(EqualsProto, proto, "") { return ProtoEqual(arg, proto); }
 
+MATCHER_P(HasTableId, table_id, "") { return arg.table_id() == table_id; }
+
 MATCHER_P(DerivedFromStatus, status, "") {
   if (arg.error_code() != status.error_code()) {
     return false;
@@ -1410,6 +1418,170 @@ TEST_F(BfrtNodeTest, ReadForwardingEntriesSuccess_TableEntry) {
   EXPECT_EQ(1U, results.size());
 }
 
+// Writes to tables guarded by different entity lock stripes must not block each
+// other. The first write only completes once the second one went through.
+TEST_F(BfrtNodeTest, WriteForwardingEntries_DifferentTablesRunConcurrently) {
+  ASSERT_NO_FATAL_FAILURE(PushChassisConfigWithCheck());
+  ASSERT_NO_FATAL_FAILURE(PushForwardingPipelineConfigWithCheck());
+
+  constexpr uint32 kTableId1 = 33583783;
+  constexpr uint32 kTableId2 = 33592365;
+  ::p4::v1::WriteRequest req1;
+  SetupTableEntryToInsert(&req1, kNodeId)->set_table_id(kTableId1);
+  ::p4::v1::WriteRequest req2;
+  SetupTableEntryToInsert(&req2, kNodeId)->set_table_id(kTableId2);
+
+  std::shared_ptr<BfSdeInterface::SessionInterface> session_mock =
+      std::make_shared<SessionMock>();
+  EXPECT_CALL(*bf_sde_mock_, CreateSession())
+      .WillRepeatedly(Return(session_mock));
+  absl::Notification first_started;
+  absl::Notification second_done;
+  EXPECT_CALL(*bfrt_table_manager_mock_,
+              WriteTableEntry(_, _, HasTableId(kTableId1)))
+      .WillOnce(
+          Invoke([&](std::shared_ptr<BfSdeInterface::SessionInterface>,
+                     ::p4::v1::Update::Type, const ::p4::v1::TableEntry&) {
+            first_started.Notify();
+            EXPECT_TRUE(
+                second_done.WaitForNotificationWithTimeout(absl::Seconds(10)));
+            return ::util::OkStatus();
+          }));
+  EXPECT_CALL(*bfrt_table_manager_mock_,
+              WriteTableEntry(_, _, HasTableId(kTableId2)))
+      .WillOnce(
+          Invoke([&](std::shared_ptr<BfSdeInterface::SessionInterface>,
+                     ::p4::v1::Update::Type, const ::p4::v1::TableEntry&) {
+            second_done.Notify();
+            return ::util::OkStatus();
+          }));
+
+  std::thread first_writer([&]() {
+    std::vector<::util::Status> results = {};
+    EXPECT_OK(WriteForwardingEntries(req1, &results));
+  });
+  first_started.WaitForNotification();
+  std::vector<::util::Status> results = {};
+  EXPECT_OK(WriteForwardingEntries(req2, &results));
+  first_writer.join();
+}
+
+// Writes to the same table are still serialized.
+TEST_F(BfrtNodeTest, WriteForwardingEntries_SameTableIsSerialized) {
+  ASSERT_NO_FATAL_FAILURE(PushChassisConfigWithCheck());
+  ASSERT_NO_FATAL_FAILURE(PushForwardingPipelineConfigWithCheck());
+
+  constexpr uint32 kTableId = 33583783;
+  ::p4::v1::WriteRequest req;
+  SetupTableEntryToInsert(&req, kNodeId)->set_table_id(kTableId);
+
+  std::shared_ptr<BfSdeInterface::SessionInterface> session_mock =
+      std::make_shared<SessionMock>();
+  EXPECT_CALL(*bf_sde_mock_, CreateSession())
+      .WillRepeatedly(Return(session_mock));
+  absl::Notification first_started;
+  absl::Notification release_first;
+  std::atomic<int> num_running(0);
+  std::atomic<int> max_running(0);
+  EXPECT_CALL(*bfrt_table_manager_mock_,
+              WriteTableEntry(_, _, HasTableId(kTableId)))
+      .Times(2)
+      .WillRepeatedly(
+          Invoke([&](std::shared_ptr<BfSdeInterface::SessionInterface>,
+                     ::p4::v1::Update::Type, const ::p4::v1::TableEntry&) {
+            max_running = std::max(max_running.load(), ++num_running);
+            if (!first_started.HasBeenNotified()) {
+              first_started.Notify();
+              release_first.WaitForNotification();
+            }
+            --num_running;
+            return ::util::OkStatus();
+          }));
+
+  std::thread first_writer([&]() {
+    std::vector<::util::Status> results = {};
+    EXPECT_OK(WriteForwardingEntries(req, &results));
+  });
+  first_started.WaitForNotification();
+  std::thread second_writer([&]() {
+    std::vector<::util::Status> results = {};
+    EXPECT_OK(WriteForwardingEntries(req, &results));
+  });
+  // Give the second write a chance to (wrongly) enter the table manager.
+  absl::SleepFor(absl::Milliseconds(100));
+  release_first.Notify();
+  first_writer.join();
+  second_writer.join();
+  EXPECT_EQ(1, max_running);
+}
+
+// The table entries of large requests are prepared on the write pool, but
+// programmed and reported in request order.
+TEST_F(BfrtNodeTest, WriteForwardingEntries_LargeRequestIsPreparedInParallel) {
+  ASSERT_NO_FATAL_FAILURE(PushChassisConfigWithCheck());
+  ASSERT_NO_FATAL_FAILURE(PushForwardingPipelineConfigWithCheck());
+
+  constexpr int kNumUpdates = 200;
+  constexpr int kFailedUpdate = 42;
+  constexpr int kRegisterUpdate = 100;
+  ::p4::v1::WriteRequest req;
+  for (int i = 0; i < kNumUpdates; ++i) {
+    if (i == kRegisterUpdate) {
+      auto* update = req.add_updates();
+      update->set_type(::p4::v1::Update::MODIFY);
+      update->mutable_entity()->mutable_register_entry()->set_register_id(1);
+      continue;
+    }
+    SetupTableEntryToInsert(&req, kNodeId)->set_table_id(i);
+  }
+
+  std::shared_ptr<BfSdeInterface::SessionInterface> session_mock =
+      std::make_shared<SessionMock>();
+  EXPECT_CALL(*bf_sde_mock_, CreateSession()).WillOnce(Return(session_mock));
+  EXPECT_CALL(*bfrt_table_manager_mock_, WriteTableEntry(_, _, _)).Times(0);
+  EXPECT_CALL(*bfrt_table_manager_mock_,
+              PrepareTableEntryWrite(::p4::v1::Update::INSERT, _, _))
+      .Times(kNumUpdates - 1)
+      .WillRepeatedly(Invoke(
+          [](::p4::v1::Update::Type type,
+             const ::p4::v1::TableEntry& table_entry,
+             BfrtTableManager::PreparedTableEntryWrite* prepared) {
+            if (table_entry.table_id() == static_cast<uint32>(kFailedUpdate)) {
+              return ::util::Status(StratumErrorSpace(), ERR_INVALID_PARAM,
+                                    "Invalid entry.");
+            }
+            prepared->type = type;
+            prepared->table_id = table_entry.table_id();
+            return ::util::OkStatus();
+          }));
+  std::vector<uint32> applied_table_ids;
+  EXPECT_CALL(*bfrt_table_manager_mock_, ApplyTableEntryWrite(session_mock, _))
+      .Times(kNumUpdates - 2)
+      .WillRepeatedly(Invoke(
+          [&](std::shared_ptr<BfSdeInterface::SessionInterface>,
+              const BfrtTableManager::PreparedTableEntryWrite& prepared) {
+            applied_table_ids.push_back(prepared.table_id);
+            return ::util::OkStatus();
+          }));
+  EXPECT_CALL(*bfrt_table_manager_mock_,
+              WriteRegisterEntry(session_mock, ::p4::v1::Update::MODIFY, _))
+      .WillOnce(Return(::util::OkStatus()));
+
+  std::vector<::util::Status> results = {};
+  EXPECT_FALSE(WriteForwardingEntries(req, &results).ok());
+  ASSERT_EQ(static_cast<size_t>(kNumUpdates), results.size());
+  std::vector<uint32> expected_table_ids;
+  for (int i = 0; i < kNumUpdates; ++i) {
+    if (i == kFailedUpdate) {
+      EXPECT_EQ(ERR_INVALID_PARAM, results[i].error_code());
+      continue;
+    }
+    EXPECT_OK(results[i]);
+    if (i != kRegisterUpdate) expected_table_ids.push_back(i);
+  }
+  EXPECT_EQ(expected_table_ids, applied_table_ids);
+}
+
 // RegisterStreamMessageResponseWriter() should forward the call to
 // BfrtPacketioManager and return success or error based on the returned result.
 TEST_F(BfrtNodeTest, RegisterStreamMessageResponseWriter) {
@@ -3,6 +3,8 @@
 
 #include "stratum/hal/lib/barefoot/bfrt_p4runtime_translator.h"
 
+#include <utility>
+
 #include "gflags/gflags.h"
 #include "stratum/glue/gtl/map_util.h"
 #include "stratum/glue/gtl/stl_util.h"
@@ -18,23 +20,40 @@ namespace stratum {
 namespace hal {
 namespace barefoot {
 
+std::shared_ptr<const BfrtP4RuntimeTranslator::Snapshot>
+BfrtP4RuntimeTranslator::MakeEmptySnapshot() {
+  auto snapshot = std::make_shared<Snapshot>();
+  snapshot->ports = std::make_shared<const PortMaps>();
+  snapshot->pipeline = std::make_shared<const PipelineMaps>();
+  return snapshot;
+}
+
+std::shared_ptr<const BfrtP4RuntimeTranslator::Snapshot>
+BfrtP4RuntimeTranslator::GetSnapshot() const {
+  return std::atomic_load(&snapshot_);
+}
+
+void BfrtP4RuntimeTranslator::SetSnapshot(
+    std::shared_ptr<const Snapshot> snapshot) {
+  std::atomic_store(&snapshot_, std::move(snapshot));
+}
+
 ::util::Status BfrtP4RuntimeTranslator::PushChassisConfig(
     const ChassisConfig& config, uint64 node_id) {
-  ::absl::WriterMutexLock l(&lock_);
+  ::absl::MutexLock l(&lock_);
   // Port mapping for P4Runtime translation.
-  singleton_port_to_sdk_port_.clear();
-  sdk_port_to_singleton_port_.clear();
+  auto ports = std::make_shared<PortMaps>();
   // Initialize with special ports.
-  singleton_port_to_sdk_port_[kSdnUnspecifiedPortId] = 0;
+  ports->singleton_port_to_sdk_port[kSdnUnspecifiedPortId] = 0;
   ASSIGN_OR_RETURN(const auto& cpu_sdk_port,
                    bf_sde_interface_->GetPcieCpuPort(device_id_));
-  singleton_port_to_sdk_port_[kSdnCpuPortId] = cpu_sdk_port;
-  sdk_port_to_singleton_port_[cpu_sdk_port] = kSdnCpuPortId;
+  ports->singleton_port_to_sdk_port[kSdnCpuPortId] = cpu_sdk_port;
+  ports->sdk_port_to_singleton_port[cpu_sdk_port] = kSdnCpuPortId;
   for (int pipe = 0; pipe < kTnaMaxNumPipes; pipe++) {
     uint32 sdk_port = kTnaRecirculationPortBase | (pipe << 7);
     uint32 sdn_port = kSdnTnaRecirculationPortBase + pipe;
-    singleton_port_to_sdk_port_[sdn_port] = sdk_port;
-    sdk_port_to_singleton_port_[sdk_port] = sdn_port;
+    ports->singleton_port_to_sdk_port[sdn_port] = sdk_port;
+    ports->sdk_port_to_singleton_port[sdk_port] = sdn_port;
   }
 
   for (const auto& singleton_port : config.singleton_ports()) {
@@ -44,20 +63,27 @@ namespace barefoot {
     ASSIGN_OR_RETURN(uint32 sdk_port_id,
                      bf_sde_interface_->GetPortIdFromPortKey(
                          device_id_, singleton_port_key));
-    singleton_port_to_sdk_port_[singleton_port_id] = sdk_port_id;
-    sdk_port_to_singleton_port_[sdk_port_id] = singleton_port_id;
+    ports->singleton_port_to_sdk_port[singleton_port_id] = sdk_port_id;
+    ports->sdk_port_to_singleton_port[sdk_port_id] = singleton_port_id;
   }
 
+  auto snapshot = std::make_shared<Snapshot>(*GetSnapshot());
+  snapshot->ports = std::move(ports);
+  SetSnapshot(std::move(snapshot));
+
   return ::util::OkStatus();
 }
 
 ::util::Status BfrtP4RuntimeTranslator::PushForwardingPipelineConfig(
     const ::p4::config::v1::P4Info& p4info) {
-  ::absl::WriterMutexLock l(&lock_);
+  ::absl::MutexLock l(&lock_);
+  auto pipeline = std::make_shared<PipelineMaps>();
   // Enable P4Runtime translation when user define a new type with
   // p4runtime_translation and user enabled it when starting the Stratum.
   if (!translation_enabled_ || !p4info.has_type_info()) {
-    pipeline_require_translation_ = false;
+    auto snapshot = std::make_shared<Snapshot>(*GetSnapshot());
+    snapshot->pipeline = std::move(pipeline);
+    SetSnapshot(std::move(snapshot));
     return ::util::OkStatus();
   }
 
@@ -70,7 +96,6 @@ namespace barefoot {
     const auto& value = new_type.second;
     if (value.representation_case() ==
         ::p4::config::v1::P4NewTypeSpec::kTranslatedType) {
-      pipeline_require_translation_ = true;
       // TODO(Yi Tseng): Verify URI string
       type_name_to_uri[type_name] = value.translated_type().uri();
       if (value.translated_type().sdn_type_case() ==
@@ -90,22 +115,6 @@ namespace barefoot {
   // Types that support P4Runtime translation:
   // Table.MatchField, Action.Param, ControllerPacketMetadata.Metadata
   // Counter, Meter, Register (index)
-  absl::flat_hash_map<uint32, absl::flat_hash_map<uint32, std::string>>
-      table_to_field_to_type_uri;
-  absl::flat_hash_map<uint32, absl::flat_hash_map<uint32, std::string>>
-      action_to_param_to_type_uri;
-  absl::flat_hash_map<uint32, std::string> packet_in_meta_to_type_uri;
-  absl::flat_hash_map<uint32, std::string> packet_out_meta_to_type_uri;
-  absl::flat_hash_map<uint32, std::string> counter_to_type_uri;
-  absl::flat_hash_map<uint32, std::string> meter_to_type_uri;
-  absl::flat_hash_map<uint32, std::string> register_to_type_uri;
-  absl::flat_hash_map<uint32, absl::flat_hash_map<uint32, int32>>
-      table_to_field_to_bit_width;
-  absl::flat_hash_map<uint32, absl::flat_hash_map<uint32, int32>>
-      action_to_param_to_bit_width;
-  absl::flat_hash_map<uint32, int32> packet_in_meta_to_bit_width;
-  absl::flat_hash_map<uint32, int32> packet_out_meta_to_bit_width;
-
   for (const auto& table : p4info.tables()) {
     for (const auto& match_field : table.match_fields()) {
       if (match_field.has_type_name()) {
@@ -115,11 +124,13 @@ namespace barefoot {
         std::string* uri = gtl::FindOrNull(type_name_to_uri, type_name);
         if (uri) {
           RET_CHECK(kUriToBitWidth.contains(*uri));
-          table_to_field_to_type_uri[table_id][match_field_id] = *uri;
+          pipeline->table_to_field_to_type_uri[table_id][match_field_id] =
+              *uri;
         }
         int32* bit_width = gtl::FindOrNull(type_name_to_bit_width, type_name);
         if (bit_width) {
-          table_to_field_to_bit_width[table_id][match_field_id] = *bit_width;
+          pipeline->table_to_field_to_bit_width[table_id][match_field_id] =
+              *bit_width;
         }
       }
     }
@@ -132,11 +143,12 @@ namespace barefoot {
         const auto& param_id = param.id();
         std::string* uri = gtl::FindOrNull(type_name_to_uri, type_name);
         if (uri) {
-          action_to_param_to_type_uri[action_id][param_id] = *uri;
+          pipeline->action_to_param_to_type_uri[action_id][param_id] = *uri;
         }
         int32* bit_width = gtl::FindOrNull(type_name_to_bit_width, type_name);
         if (bit_width) {
-          action_to_param_to_bit_width[action_id][param_id] = *bit_width;
+          pipeline->action_to_param_to_bit_width[action_id][param_id] =
+              *bit_width;
         }
       }
     }
@@ -146,11 +158,11 @@ namespace barefoot {
     absl::flat_hash_map<uint32, std::string>* meta_to_type_uri;
     absl::flat_hash_map<uint32, int32>* meta_to_bit_width;
     if (ctrl_hdr_name == kIngressMetadataPreambleName) {
-      meta_to_type_uri = &packet_in_meta_to_type_uri;
-      meta_to_bit_width = &packet_in_meta_to_bit_width;
+      meta_to_type_uri = &pipeline->packet_in_meta_to_type_uri;
+      meta_to_bit_width = &pipeline->packet_in_meta_to_bit_width;
     } else if (ctrl_hdr_name == kEgressMetadataPreambleName) {
-      meta_to_type_uri = &packet_out_meta_to_type_uri;
-      meta_to_bit_width = &packet_out_meta_to_bit_width;
+      meta_to_type_uri = &pipeline->packet_out_meta_to_type_uri;
+      meta_to_bit_width = &pipeline->packet_out_meta_to_bit_width;
     } else {
       return MAKE_ERROR(ERR_UNIMPLEMENTED)
              << "Unsupported controller header " << ctrl_hdr_name;
@@ -176,7 +188,7 @@ namespace barefoot {
       const auto& counter_id = counter.preamble().id();
       std::string* uri = gtl::FindOrNull(type_name_to_uri, type_name);
       if (uri) {
-        counter_to_type_uri[counter_id] = *uri;
+        pipeline->counter_to_type_uri[counter_id] = *uri;
       }
     }
   }
@@ -186,7 +198,7 @@ namespace barefoot {
       const auto& meter_id = meter.preamble().id();
       std::string* uri = gtl::FindOrNull(type_name_to_uri, type_name);
       if (uri) {
-        meter_to_type_uri[meter_id] = *uri;
+        pipeline->meter_to_type_uri[meter_id] = *uri;
       }
     }
   }
@@ -197,69 +209,78 @@ namespace barefoot {
       const auto& register_id = reg.preamble().id();
       std::string* uri = gtl::FindOrNull(type_name_to_uri, type_name);
       if (uri) {
-        register_to_type_uri[register_id] = *uri;
+        pipeline->register_to_type_uri[register_id] = *uri;
       }
     }
   }
-  table_to_field_to_type_uri_ = table_to_field_to_type_uri;
-  action_to_param_to_type_uri_ = action_to_param_to_type_uri;
-  packet_in_meta_to_type_uri_ = packet_in_meta_to_type_uri;
-  packet_out_meta_to_type_uri_ = packet_out_meta_to_type_uri;
-  counter_to_type_uri_ = counter_to_type_uri;
-  meter_to_type_uri_ = meter_to_type_uri;
-  register_to_type_uri_ = register_to_type_uri;
-  table_to_field_to_bit_width_ = table_to_field_to_bit_width;
-  action_to_param_to_bit_width_ = action_to_param_to_bit_width;
-  packet_in_meta_to_bit_width_ = packet_in_meta_to_bit_width;
-  packet_out_meta_to_bit_width_ = packet_out_meta_to_bit_width;
-  pipeline_require_translation_ = true;
+  // Entries of a table need translation if any of its match fields or any of
+  // the parameters of its actions do.
+  for (const auto& table : p4info.tables()) {
+    bool translate = pipeline->table_to_field_to_type_uri.contains(
+        table.preamble().id());
+    for (const auto& action_ref : table.action_refs()) {
+      translate |=
+          pipeline->action_to_param_to_type_uri.contains(action_ref.id());
+    }
+    if (translate) pipeline->tables_to_translate.insert(table.preamble().id());
+  }
+  pipeline->require_translation = true;
+
+  auto snapshot = std::make_shared<Snapshot>(*GetSnapshot());
+  snapshot->pipeline = std::move(pipeline);
+  SetSnapshot(std::move(snapshot));
   return ::util::OkStatus();
 }
 
 ::util::StatusOr<::p4::v1::TableEntry>
 BfrtP4RuntimeTranslator::TranslateTableEntry(const ::p4::v1::TableEntry& entry,
                                              bool to_sdk) {
-  absl::ReaderMutexLock l(&lock_);
-  if (!pipeline_require_translation_) {
+  const auto snapshot = GetSnapshot();
+  if (!snapshot->pipeline->require_translation) {
     return entry;
   }
-  return TranslateTableEntryInternal(entry, to_sdk);
+  return TranslateTableEntryInternal(*snapshot, entry, to_sdk);
 }
 
 ::util::StatusOr<::p4::v1::TableEntry>
 BfrtP4RuntimeTranslator::TranslateTableEntryInternal(
-    const ::p4::v1::TableEntry& entry, bool to_sdk) {
+    const Snapshot& snapshot, const ::p4::v1::TableEntry& entry, bool to_sdk) {
+  const PipelineMaps& pipeline = *snapshot.pipeline;
+  const auto& table_id = entry.table_id();
+  if (!pipeline.tables_to_translate.contains(table_id)) {
+    return entry;
+  }
   ::p4::v1::TableEntry translated_entry(entry);
-  const auto& table_id = translated_entry.table_id();
-  if (table_to_field_to_type_uri_.contains(table_id) &&
-      table_to_field_to_bit_width_.contains(table_id)) {
+  const auto* field_to_type_uri =
+      gtl::FindOrNull(pipeline.table_to_field_to_type_uri, table_id);
+  const auto* field_to_bit_width =
+      gtl::FindOrNull(pipeline.table_to_field_to_bit_width, table_id);
+  if (field_to_type_uri && field_to_bit_width) {
     for (::p4::v1::FieldMatch& field_match :
          *translated_entry.mutable_match()) {
       const auto& field_id = field_match.field_id();
-      std::string* uri =
-          gtl::FindOrNull(table_to_field_to_type_uri_[table_id], field_id);
+      const std::string* uri = gtl::FindOrNull(*field_to_type_uri, field_id);
       if (!uri) {
         continue;
       }
       int32 from_bit_width = 0;
       int32 to_bit_width = 0;
       if (to_sdk) {
-        from_bit_width = gtl::FindWithDefault(
-            table_to_field_to_bit_width_[table_id], field_id, 0);
+        from_bit_width = gtl::FindWithDefault(*field_to_bit_width, field_id, 0);
         to_bit_width = gtl::FindWithDefault(kUriToBitWidth, *uri, 0);
       } else {
         from_bit_width = gtl::FindWithDefault(kUriToBitWidth, *uri, 0);
-        to_bit_width = gtl::FindWithDefault(
-            table_to_field_to_bit_width_[table_id], field_id, 0);
+        to_bit_width = gtl::FindWithDefault(*field_to_bit_width, field_id, 0);
       }
       if (!from_bit_width || !to_bit_width) {
         continue;
       }
       switch (field_match.field_match_type_case()) {
         case ::p4::v1::FieldMatch::kExact: {
-          ASSIGN_OR_RETURN(const std::string& new_val,
-                           TranslateValue(field_match.exact().value(), *uri,
-                                          to_sdk, to_bit_width));
+          ASSIGN_OR_RETURN(
+              const std::string& new_val,
+              TranslateValue(*snapshot.ports, field_match.exact().value(),
+                             *uri, to_sdk, to_bit_width));
           field_match.mutable_exact()->set_value(new_val);
           break;
         }
@@ -269,9 +290,10 @@ BfrtP4RuntimeTranslator::TranslateTableEntryInternal(
           RET_CHECK(field_match.ternary().mask() ==
                     AllOnesByteString(from_bit_width));
           // New mask with bit width.
-          ASSIGN_OR_RETURN(const std::string& new_val,
-                           TranslateValue(field_match.ternary().value(), *uri,
-                                          to_sdk, to_bit_width));
+          ASSIGN_OR_RETURN(
+              const std::string& new_val,
+              TranslateValue(*snapshot.ports, field_match.ternary().value(),
+                             *uri, to_sdk, to_bit_width));
           field_match.mutable_ternary()->set_value(new_val);
           field_match.mutable_ternary()->set_mask(
               AllOnesByteString(to_bit_width));
@@ -281,9 +303,10 @@ BfrtP4RuntimeTranslator::TranslateTableEntryInternal(
           // Only accept "exact match" LPM value, which means the prefix
           // length must same as the bit width of the field.
           RET_CHECK(field_match.lpm().prefix_len() == from_bit_width);
-          ASSIGN_OR_RETURN(const std::string& new_val,
-                           TranslateValue(field_match.lpm().value(), *uri,
-                                          to_sdk, to_bit_width));
+          ASSIGN_OR_RETURN(
+              const std::string& new_val,
+              TranslateValue(*snapshot.ports, field_match.lpm().value(), *uri,
+                             to_sdk, to_bit_width));
           field_match.mutable_lpm()->set_value(new_val);
           field_match.mutable_lpm()->set_prefix_len(to_bit_width);
           break;
@@ -292,17 +315,19 @@ BfrtP4RuntimeTranslator::TranslateTableEntryInternal(
           // Only accept "exact match" range value, which means both low
           // and high value must be the same.
           RET_CHECK(field_match.range().low() == field_match.range().high());
-          ASSIGN_OR_RETURN(const std::string& new_val,
-                           TranslateValue(field_match.range().low(), *uri,
-                                          to_sdk, to_bit_width));
+          ASSIGN_OR_RETURN(
+              const std::string& new_val,
+              TranslateValue(*snapshot.ports, field_match.range().low(), *uri,
+                             to_sdk, to_bit_width));
           field_match.mutable_range()->set_low(new_val);
           field_match.mutable_range()->set_high(new_val);
           break;
         }
         case ::p4::v1::FieldMatch::kOptional: {
-          ASSIGN_OR_RETURN(const std::string& new_val,
-                           TranslateValue(field_match.optional().value(), *uri,
-                                          to_sdk, to_bit_width));
+          ASSIGN_OR_RETURN(
+              const std::string& new_val,
+              TranslateValue(*snapshot.ports, field_match.optional().value(),
+                             *uri, to_sdk, to_bit_width));
           field_match.mutable_optional()->set_value(new_val);
           break;
         }
@@ -318,7 +343,8 @@ BfrtP4RuntimeTranslator::TranslateTableEntryInternal(
     case ::p4::v1::TableAction::kAction: {
       ASSIGN_OR_RETURN(
           *(translated_entry.mutable_action()->mutable_action()),
-          TranslateAction(translated_entry.action().action(), to_sdk));
+          TranslateAction(snapshot, translated_entry.action().action(),
+                          to_sdk));
       break;
     }
     case ::p4::v1::TableAction::kActionProfileActionSet: {
@@ -328,7 +354,7 @@ BfrtP4RuntimeTranslator::TranslateTableEntryInternal(
            *action_set->mutable_action_profile_actions()) {
         ASSIGN_OR_RETURN(
             *(action_profile_action.mutable_action()),
-            TranslateAction(action_profile_action.action(), to_sdk));
+            TranslateAction(snapshot, action_profile_action.action(), to_sdk));
       }
       break;
     }
@@ -341,31 +367,31 @@ BfrtP4RuntimeTranslator::TranslateTableEntryInternal(
 ::util::StatusOr<::p4::v1::ActionProfileMember>
 BfrtP4RuntimeTranslator::TranslateActionProfileMember(
     const ::p4::v1::ActionProfileMember& act_prof_mem, bool to_sdk) {
-  absl::ReaderMutexLock l(&lock_);
-  if (!pipeline_require_translation_) {
+  const auto snapshot = GetSnapshot();
+  if (!snapshot->pipeline->require_translation) {
     return act_prof_mem;
   }
   ::p4::v1::ActionProfileMember translated_apm;
   translated_apm.CopyFrom(act_prof_mem);
-  const auto& action_profile_id = act_prof_mem.action_profile_id();
-  const auto& member_id = act_prof_mem.member_id();
   ASSIGN_OR_RETURN(*(translated_apm.mutable_action()),
-                   TranslateAction(translated_apm.action(), to_sdk));
+                   TranslateAction(*snapshot, translated_apm.action(), to_sdk));
   return translated_apm;
 }
 
 ::util::StatusOr<::p4::v1::MeterEntry>
 BfrtP4RuntimeTranslator::TranslateMeterEntry(const ::p4::v1::MeterEntry& entry,
                                              bool to_sdk) {
-  absl::ReaderMutexLock l(&lock_);
-  if (!pipeline_require_translation_) {
+  const auto snapshot = GetSnapshot();
+  if (!snapshot->pipeline->require_translation) {
     return entry;
   }
   ::p4::v1::MeterEntry translated_entry(entry);
-  std::string* uri = gtl::FindOrNull(meter_to_type_uri_, entry.meter_id());
+  const std::string* uri = gtl::FindOrNull(
+      snapshot->pipeline->meter_to_type_uri, entry.meter_id());
   if (entry.has_index() && uri) {
     ASSIGN_OR_RETURN(*translated_entry.mutable_index(),
-                     TranslateIndex(translated_entry.index(), *uri, to_sdk))
+                     TranslateIndex(*snapshot->ports, translated_entry.index(),
+                                    *uri, to_sdk))
   }
   return translated_entry;
 }
@@ -373,35 +399,37 @@ BfrtP4RuntimeTranslator::TranslateMeterEntry(const ::p4::v1::MeterEntry& entry,
 ::util::StatusOr<::p4::v1::DirectMeterEntry>
 BfrtP4RuntimeTranslator::TranslateDirectMeterEntry(
     const ::p4::v1::DirectMeterEntry& entry, bool to_sdk) {
-  absl::ReaderMutexLock l(&lock_);
-  if (!pipeline_require_translation_) {
+  const auto snapshot = GetSnapshot();
+  if (!snapshot->pipeline->require_translation) {
     return entry;
   }
   ::p4::v1::DirectMeterEntry translated_entry(entry);
-  ASSIGN_OR_RETURN(*translated_entry.mutable_table_entry(),
-                   TranslateTableEntryInternal(entry.table_entry(), to_sdk));
+  ASSIGN_OR_RETURN(
+      *translated_entry.mutable_table_entry(),
+      TranslateTableEntryInternal(*snapshot, entry.table_entry(), to_sdk));
   return translated_entry;
 }
 
 ::util::StatusOr<::p4::v1::Index> BfrtP4RuntimeTranslator::TranslateIndex(
-    const ::p4::v1::Index& index, const std::string& uri, bool to_sdk) {
+    const PortMaps& ports, const ::p4::v1::Index& index, const std::string& uri,
+    bool to_sdk) {
   int64 index_value = index.index();
   if (uri == kUriTnaPortId) {
     ::p4::v1::Index translated_index;
     if (to_sdk) {
-      RET_CHECK(singleton_port_to_sdk_port_.contains(
-          static_cast<uint32>(index_value)))
+      const uint32* sdk_port = gtl::FindOrNull(
+          ports.singleton_port_to_sdk_port, static_cast<uint32>(index_value));
+      RET_CHECK(sdk_port != nullptr)
           << "Could not find SDK port for singleton port " << index_value
           << ".";
-      translated_index.set_index(
-          singleton_port_to_sdk_port_[static_cast<uint32>(index_value)]);
+      translated_index.set_index(*sdk_port);
     } else {
-      RET_CHECK(sdk_port_to_singleton_port_.contains(
-          static_cast<uint32>(index_value)))
+      const uint32* singleton_port = gtl::FindOrNull(
+          ports.sdk_port_to_singleton_port, static_cast<uint32>(index_value));
+      RET_CHECK(singleton_port != nullptr)
           << "Could not find singleton port for sdk port " << index_value
           << ".";
-      translated_index.set_index(
-          sdk_port_to_singleton_port_[static_cast<uint32>(index_value)]);
+      translated_index.set_index(*singleton_port);
     }
     return translated_index;
   } else {
@@ -412,15 +440,17 @@ BfrtP4RuntimeTranslator::TranslateDirectMeterEntry(
 ::util::StatusOr<::p4::v1::CounterEntry>
 BfrtP4RuntimeTranslator::TranslateCounterEntry(
     const ::p4::v1::CounterEntry& entry, bool to_sdk) {
-  absl::ReaderMutexLock l(&lock_);
-  if (!pipeline_require_translation_) {
+  const auto snapshot = GetSnapshot();
+  if (!snapshot->pipeline->require_translation) {
     return entry;
   }
   ::p4::v1::CounterEntry translated_entry(entry);
-  std::string* uri = gtl::FindOrNull(counter_to_type_uri_, entry.counter_id());
+  const std::string* uri = gtl::FindOrNull(
+      snapshot->pipeline->counter_to_type_uri, entry.counter_id());
   if (entry.has_index() && uri) {
     ASSIGN_OR_RETURN(*translated_entry.mutable_index(),
-                     TranslateIndex(translated_entry.index(), *uri, to_sdk))
+                     TranslateIndex(*snapshot->ports, translated_entry.index(),
+                                    *uri, to_sdk))
   }
   return translated_entry;
 }
@@ -428,50 +458,54 @@ BfrtP4RuntimeTranslator::TranslateCounterEntry(
 ::util::StatusOr<::p4::v1::DirectCounterEntry>
 BfrtP4RuntimeTranslator::TranslateDirectCounterEntry(
     const ::p4::v1::DirectCounterEntry& entry, bool to_sdk) {
-  absl::ReaderMutexLock l(&lock_);
-  if (!pipeline_require_translation_) {
+  const auto snapshot = GetSnapshot();
+  if (!snapshot->pipeline->require_translation) {
     return entry;
   }
   ::p4::v1::DirectCounterEntry translated_entry(entry);
-  ASSIGN_OR_RETURN(*translated_entry.mutable_table_entry(),
-                   TranslateTableEntryInternal(entry.table_entry(), to_sdk));
+  ASSIGN_OR_RETURN(
+      *translated_entry.mutable_table_entry(),
+      TranslateTableEntryInternal(*snapshot, entry.table_entry(), to_sdk));
   return translated_entry;
 }
 
 ::util::StatusOr<::p4::v1::RegisterEntry>
 BfrtP4RuntimeTranslator::TranslateRegisterEntry(
     const ::p4::v1::RegisterEntry& entry, bool to_sdk) {
-  absl::ReaderMutexLock l(&lock_);
-  if (!pipeline_require_translation_) {
+  const auto snapshot = GetSnapshot();
+  if (!snapshot->pipeline->require_translation) {
     return entry;
   }
   ::p4::v1::RegisterEntry translated_entry(entry);
-  std::string* uri =
-      gtl::FindOrNull(register_to_type_uri_, entry.register_id());
+  const std::string* uri = gtl::FindOrNull(
+      snapshot->pipeline->register_to_type_uri, entry.register_id());
   if (entry.has_index() && uri) {
     ASSIGN_OR_RETURN(*translated_entry.mutable_index(),
-                     TranslateIndex(translated_entry.index(), *uri, to_sdk))
+                     TranslateIndex(*snapshot->ports, translated_entry.index(),
+                                    *uri, to_sdk))
   }
   return translated_entry;
 }
 
 ::util::StatusOr<::p4::v1::Replica> BfrtP4RuntimeTranslator::TranslateReplica(
-    const ::p4::v1::Replica& replica, bool to_sdk) {
+    const PortMaps& ports, const ::p4::v1::Replica& replica, bool to_sdk) {
   ::p4::v1::Replica translated_replica(replica);
   // Since we know we are always translating the port number, we can simply
   // use the port map here.
   if (to_sdk) {
-    RET_CHECK(singleton_port_to_sdk_port_.contains(replica.egress_port()))
+    const uint32* sdk_port = gtl::FindOrNull(ports.singleton_port_to_sdk_port,
+                                             replica.egress_port());
+    RET_CHECK(sdk_port != nullptr)
         << "Could not find SDK port for singleton port "
         << replica.egress_port() << ".";
-    translated_replica.set_egress_port(
-        singleton_port_to_sdk_port_[replica.egress_port()]);
+    translated_replica.set_egress_port(*sdk_port);
   } else {
-    RET_CHECK(sdk_port_to_singleton_port_.contains(replica.egress_port()))
+    const uint32* singleton_port = gtl::FindOrNull(
+        ports.sdk_port_to_singleton_port, replica.egress_port());
+    RET_CHECK(singleton_port != nullptr)
         << "Could not find singleton port for sdk port "
         << replica.egress_port() << ".";
-    translated_replica.set_egress_port(
-        sdk_port_to_singleton_port_[replica.egress_port()]);
+    translated_replica.set_egress_port(*singleton_port);
   }
   return translated_replica;
 }
@@ -479,8 +513,8 @@ BfrtP4RuntimeTranslator::TranslateRegisterEntry(
 ::util::StatusOr<::p4::v1::PacketReplicationEngineEntry>
 BfrtP4RuntimeTranslator::TranslatePacketReplicationEngineEntry(
     const ::p4::v1::PacketReplicationEngineEntry& entry, bool to_sdk) {
-  absl::ReaderMutexLock l(&lock_);
-  if (!pipeline_require_translation_) {
+  const auto snapshot = GetSnapshot();
+  if (!snapshot->pipeline->require_translation) {
     return entry;
   }
   ::p4::v1::PacketReplicationEngineEntry translated_entry(entry);
@@ -490,7 +524,8 @@ BfrtP4RuntimeTranslator::TranslatePacketReplicationEngineEntry(
           translated_entry.mutable_multicast_group_entry();
       for (::p4::v1::Replica& replica :
            *multicast_group_entry->mutable_replicas()) {
-        ASSIGN_OR_RETURN(replica, TranslateReplica(replica, to_sdk));
+        ASSIGN_OR_RETURN(replica,
+                         TranslateReplica(*snapshot->ports, replica, to_sdk));
       }
       break;
     }
@@ -499,7 +534,8 @@ BfrtP4RuntimeTranslator::TranslatePacketReplicationEngineEntry(
           translated_entry.mutable_clone_session_entry();
       for (::p4::v1::Replica& replica :
            *clone_session_entry->mutable_replicas()) {
-        ASSIGN_OR_RETURN(replica, TranslateReplica(replica, to_sdk));
+        ASSIGN_OR_RETURN(replica,
+                         TranslateReplica(*snapshot->ports, replica, to_sdk));
       }
       break;
     }
@@ -511,53 +547,63 @@ BfrtP4RuntimeTranslator::TranslatePacketReplicationEngineEntry(
 
 ::util::StatusOr<::p4::v1::PacketMetadata>
 BfrtP4RuntimeTranslator::TranslatePacketMetadata(
-    const p4::v1::PacketMetadata& packet_metadata, const std::string& uri,
-    int32 bit_width, bool to_sdk) {
+    const PortMaps& ports, const p4::v1::PacketMetadata& packet_metadata,
+    const std::string& uri, int32 bit_width, bool to_sdk) {
   p4::v1::PacketMetadata translated_packet_metadata(packet_metadata);
   ASSIGN_OR_RETURN(*translated_packet_metadata.mutable_value(),
-                   TranslateValue(translated_packet_metadata.value(), uri,
-                                  to_sdk, bit_width));
+                   TranslateValue(ports, translated_packet_metadata.value(),
+                                  uri, to_sdk, bit_width));
   return translated_packet_metadata;
 }
 
 ::util::StatusOr<::p4::v1::PacketIn> BfrtP4RuntimeTranslator::TranslatePacketIn(
     const ::p4::v1::PacketIn& packet_in) {
-  absl::ReaderMutexLock l(&lock_);
-  if (!pipeline_require_translation_) {
-    return packet_in;
-  }
   ::p4::v1::PacketIn translated_packet_in(packet_in);
-  for (auto& md : *translated_packet_in.mutable_metadata()) {
+  RETURN_IF_ERROR(TranslatePacketInInPlace(&translated_packet_in));
+  return translated_packet_in;
+}
+
+::util::Status BfrtP4RuntimeTranslator::TranslatePacketInInPlace(
+    ::p4::v1::PacketIn* packet_in) {
+  const auto snapshot = GetSnapshot();
+  const PipelineMaps& pipeline = *snapshot->pipeline;
+  if (!pipeline.require_translation) {
+    return ::util::OkStatus();
+  }
+  for (auto& md : *packet_in->mutable_metadata()) {
     const std::string* uri =
-        gtl::FindOrNull(packet_in_meta_to_type_uri_, md.metadata_id());
+        gtl::FindOrNull(pipeline.packet_in_meta_to_type_uri, md.metadata_id());
     const int32* bit_width =
-        gtl::FindOrNull(packet_in_meta_to_bit_width_, md.metadata_id());
+        gtl::FindOrNull(pipeline.packet_in_meta_to_bit_width, md.metadata_id());
     if (uri && bit_width) {
-      ASSIGN_OR_RETURN(
-          md, TranslatePacketMetadata(md, *uri, *bit_width, /*to_sdk=*/false))
+      ASSIGN_OR_RETURN(md, TranslatePacketMetadata(*snapshot->ports, md, *uri,
+                                                   *bit_width,
+                                                   /*to_sdk=*/false))
     }
   }
-  return translated_packet_in;
+  return ::util::OkStatus();
 }
 
 ::util::StatusOr<::p4::v1::PacketOut>
 BfrtP4RuntimeTranslator::TranslatePacketOut(
     const ::p4::v1::PacketOut& packet_out) {
-  absl::ReaderMutexLock l(&lock_);
-  if (!pipeline_require_translation_) {
+  const auto snapshot = GetSnapshot();
+  const PipelineMaps& pipeline = *snapshot->pipeline;
+  if (!pipeline.require_translation) {
     return packet_out;
   }
   ::p4::v1::PacketOut translated_packet_out(packet_out);
   for (auto& md : *translated_packet_out.mutable_metadata()) {
     const std::string* uri =
-        gtl::FindOrNull(packet_out_meta_to_type_uri_, md.metadata_id());
+        gtl::FindOrNull(pipeline.packet_out_meta_to_type_uri, md.metadata_id());
     if (!uri) {
       continue;
     }
     const int32* bit_width = gtl::FindOrNull(kUriToBitWidth, *uri);
     if (bit_width) {
-      ASSIGN_OR_RETURN(
-          md, TranslatePacketMetadata(md, *uri, *bit_width, /*to_sdk=*/true))
+      ASSIGN_OR_RETURN(md, TranslatePacketMetadata(*snapshot->ports, md, *uri,
+                                                   *bit_width,
+                                                   /*to_sdk=*/true))
     }
   }
   return translated_packet_out;
@@ -638,27 +684,28 @@ BfrtP4RuntimeTranslator::TranslateP4Info(
 }
 
 ::util::StatusOr<::p4::v1::Action> BfrtP4RuntimeTranslator::TranslateAction(
-    const ::p4::v1::Action& action, bool to_sdk) {
+    const Snapshot& snapshot, const ::p4::v1::Action& action, bool to_sdk) {
   ::p4::v1::Action translated_action;
   translated_action.CopyFrom(action);
   const auto& action_id = action.action_id();
-  if (action_to_param_to_type_uri_.contains(action_id) &&
-      action_to_param_to_bit_width_.contains(action_id)) {
+  const auto* param_to_type_uri = gtl::FindOrNull(
+      snapshot.pipeline->action_to_param_to_type_uri, action_id);
+  const auto* param_to_bit_width = gtl::FindOrNull(
+      snapshot.pipeline->action_to_param_to_bit_width, action_id);
+  if (param_to_type_uri && param_to_bit_width) {
     for (::p4::v1::Action_Param& param : *translated_action.mutable_params()) {
       const auto& param_id = param.param_id();
-      std::string* uri =
-          gtl::FindOrNull(action_to_param_to_type_uri_[action_id], param_id);
+      const std::string* uri = gtl::FindOrNull(*param_to_type_uri, param_id);
       int32 to_bit_width = 0;
       if (to_sdk && uri) {
         to_bit_width = gtl::FindWithDefault(kUriToBitWidth, *uri, 0);
       } else {
-        to_bit_width = gtl::FindWithDefault(
-            action_to_param_to_bit_width_[action_id], param_id, 0);
+        to_bit_width = gtl::FindWithDefault(*param_to_bit_width, param_id, 0);
       }
       if (uri && to_bit_width) {
-        ASSIGN_OR_RETURN(
-            const std::string& new_val,
-            TranslateValue(param.value(), *uri, to_sdk, to_bit_width));
+        ASSIGN_OR_RETURN(const std::string& new_val,
+                         TranslateValue(*snapshot.ports, param.value(), *uri,
+                                        to_sdk, to_bit_width));
         param.set_value(new_val);
       }  // else, we don't modify the value if it doesn't need to be
          // translated.
@@ -668,24 +715,27 @@ BfrtP4RuntimeTranslator::TranslateP4Info(
 }
 
 ::util::StatusOr<std::string> BfrtP4RuntimeTranslator::TranslateValue(
-    const std::string& value, const std::string& uri, bool to_sdk,
-    int32 bit_width) {
+    const PortMaps& ports, const std::string& value, const std::string& uri,
+    bool to_sdk, int32 bit_width) {
   if (uri == kUriTnaPortId) {
-    return TranslateTnaPortId(value, to_sdk, bit_width);
+    return TranslateTnaPortId(ports, value, to_sdk, bit_width);
   }
   return MAKE_ERROR(ERR_UNIMPLEMENTED) << "Unknown URI: " << uri;
 }
 
 ::util::StatusOr<std::string> BfrtP4RuntimeTranslator::TranslateTnaPortId(
-    const std::string& value, bool to_sdk, int32 bit_width) {
+    const PortMaps& ports, const std::string& value, bool to_sdk,
+    int32 bit_width) {
   // Translate type "tna/PortId_t"
   if (to_sdk) {
     // singleton port id(N-byte) -> singleton port id(uint32) -> sdk port
     // id(uint32) -> sdk port id(1 or 2 bytes)
     const uint32 port_id = ByteStreamToUint<uint32>(value);
-    RET_CHECK(singleton_port_to_sdk_port_.contains(port_id))
+    const uint32* sdk_port_id =
+        gtl::FindOrNull(ports.singleton_port_to_sdk_port, port_id);
+    RET_CHECK(sdk_port_id != nullptr)
         << "Could not find SDK port for singleton port " << port_id << ".";
-    return Uint32ToByteStream(singleton_port_to_sdk_port_[port_id]);
+    return Uint32ToByteStream(*sdk_port_id);
   } else {
     // sdk port id(1 or 2 bytes) -> sdk port id(uint32) -> singleton port
     // id(uint32)
@@ -693,10 +743,11 @@ BfrtP4RuntimeTranslator::TranslateP4Info(
     RET_CHECK(value.size() <= NumBitsToNumBytes(kTnaPortIdBitWidth))
         << "Port value " << value << " exceeds maximum bit width";
     const uint32 sdk_port_id = ByteStreamToUint<uint32>(value);
-    RET_CHECK(sdk_port_to_singleton_port_.contains(sdk_port_id))
+    const uint32* port_id =
+        gtl::FindOrNull(ports.sdk_port_to_singleton_port, sdk_port_id);
+    RET_CHECK(port_id != nullptr)
         << "Could not find singleton port for sdk port " << sdk_port_id << ".";
-    const uint32 port_id = sdk_port_to_singleton_port_[sdk_port_id];
-    std::string port_id_bytes = Uint32ToByteStream(port_id);
+    std::string port_id_bytes = Uint32ToByteStream(*port_id);
 
     return port_id_bytes;
   }
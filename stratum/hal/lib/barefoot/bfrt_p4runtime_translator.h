@@ -8,6 +8,7 @@
 #include <string>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/memory/memory.h"
 #include "absl/synchronization/mutex.h"
 #include "p4/v1/p4runtime.pb.h"
@@ -41,30 +42,33 @@ class BfrtP4RuntimeTranslator {
   virtual ::util::Status PushForwardingPipelineConfig(
       const ::p4::config::v1::P4Info& p4info) LOCKS_EXCLUDED(lock_);
   virtual ::util::StatusOr<::p4::v1::TableEntry> TranslateTableEntry(
-      const ::p4::v1::TableEntry& entry, bool to_sdk) LOCKS_EXCLUDED(lock_);
+      const ::p4::v1::TableEntry& entry, bool to_sdk);
   virtual ::util::StatusOr<::p4::v1::ActionProfileMember>
   TranslateActionProfileMember(const ::p4::v1::ActionProfileMember& entry,
-                               bool to_sdk) LOCKS_EXCLUDED(lock_);
+                               bool to_sdk);
   virtual ::util::StatusOr<::p4::v1::MeterEntry> TranslateMeterEntry(
-      const ::p4::v1::MeterEntry& entry, bool to_sdk) LOCKS_EXCLUDED(lock_);
+      const ::p4::v1::MeterEntry& entry, bool to_sdk);
   virtual ::util::StatusOr<::p4::v1::DirectMeterEntry>
   TranslateDirectMeterEntry(const ::p4::v1::DirectMeterEntry& entry,
-                            bool to_sdk) LOCKS_EXCLUDED(lock_);
+                            bool to_sdk);
   virtual ::util::StatusOr<::p4::v1::CounterEntry> TranslateCounterEntry(
-      const ::p4::v1::CounterEntry& entry, bool to_sdk) LOCKS_EXCLUDED(lock_);
+      const ::p4::v1::CounterEntry& entry, bool to_sdk);
   virtual ::util::StatusOr<::p4::v1::DirectCounterEntry>
   TranslateDirectCounterEntry(const ::p4::v1::DirectCounterEntry& entry,
-                              bool to_sdk) LOCKS_EXCLUDED(lock_);
+                              bool to_sdk);
   virtual ::util::StatusOr<::p4::v1::RegisterEntry> TranslateRegisterEntry(
-      const ::p4::v1::RegisterEntry& entry, bool to_sdk) LOCKS_EXCLUDED(lock_);
+      const ::p4::v1::RegisterEntry& entry, bool to_sdk);
   virtual ::util::StatusOr<::p4::v1::PacketReplicationEngineEntry>
   TranslatePacketReplicationEngineEntry(
-      const ::p4::v1::PacketReplicationEngineEntry& entry, bool to_sdk)
-      LOCKS_EXCLUDED(lock_);
+      const ::p4::v1::PacketReplicationEngineEntry& entry, bool to_sdk);
   virtual ::util::StatusOr<::p4::v1::PacketIn> TranslatePacketIn(
-      const ::p4::v1::PacketIn& packet_in) LOCKS_EXCLUDED(lock_);
+      const ::p4::v1::PacketIn& packet_in);
+  // Same as TranslatePacketIn(), but modifies the given PacketIn in place,
+  // which avoids copying the payload on the packet receive path.
+  virtual ::util::Status TranslatePacketInInPlace(
+      ::p4::v1::PacketIn* packet_in);
   virtual ::util::StatusOr<::p4::v1::PacketOut> TranslatePacketOut(
-      const ::p4::v1::PacketOut& packet_out) LOCKS_EXCLUDED(lock_);
+      const ::p4::v1::PacketOut& packet_out);
   // A helper function which removes custom type from the P4Info.
   // Which is useful for some components that requires the original spec from
   // the P4 code.
@@ -84,47 +88,95 @@ class BfrtP4RuntimeTranslator {
   // Default constructor.
   BfrtP4RuntimeTranslator()
       : translation_enabled_(false),
-        pipeline_require_translation_(false),
         bf_sde_interface_(nullptr),
-        device_id_(0) {}
+        device_id_(0),
+        snapshot_(MakeEmptySnapshot()) {}
 
  private:
+  // Maps between singleton port and SDK port, vice versa. Rebuilt on every
+  // chassis config push.
+  struct PortMaps {
+    absl::flat_hash_map<uint32, uint32> singleton_port_to_sdk_port;
+    absl::flat_hash_map<uint32, uint32> sdk_port_to_singleton_port;
+  };
+
+  // P4Runtime translation information of a pipeline. Rebuilt on every
+  // forwarding pipeline config push.
+  struct PipelineMaps {
+    bool require_translation = false;
+    // IDs of the tables with match fields or actions to translate. Entries of
+    // other tables are passed through unchanged.
+    absl::flat_hash_set<uint32> tables_to_translate;
+    absl::flat_hash_map<uint32, absl::flat_hash_map<uint32, std::string>>
+        table_to_field_to_type_uri;
+    absl::flat_hash_map<uint32, absl::flat_hash_map<uint32, std::string>>
+        action_to_param_to_type_uri;
+    absl::flat_hash_map<uint32, std::string> packet_in_meta_to_type_uri;
+    absl::flat_hash_map<uint32, std::string> packet_out_meta_to_type_uri;
+    absl::flat_hash_map<uint32, std::string> counter_to_type_uri;
+    absl::flat_hash_map<uint32, std::string> meter_to_type_uri;
+    absl::flat_hash_map<uint32, std::string> register_to_type_uri;
+    absl::flat_hash_map<uint32, absl::flat_hash_map<uint32, int32>>
+        table_to_field_to_bit_width;
+    absl::flat_hash_map<uint32, absl::flat_hash_map<uint32, int32>>
+        action_to_param_to_bit_width;
+    absl::flat_hash_map<uint32, int32> packet_in_meta_to_bit_width;
+    absl::flat_hash_map<uint32, int32> packet_out_meta_to_bit_width;
+  };
+
+  // An immutable view of all translation state. Pushes build a new snapshot
+  // and publish it with an atomic pointer swap. Translations work on the
+  // snapshot current when they start, without taking any lock.
+  struct Snapshot {
+    std::shared_ptr<const PortMaps> ports;
+    std::shared_ptr<const PipelineMaps> pipeline;
+  };
+
   // Private constructor. Use CreateInstance() to create an instance of this
   // class.
   BfrtP4RuntimeTranslator(bool translation_enabled,
                           BfSdeInterface* bf_sde_interface, int device_id)
       : translation_enabled_(translation_enabled),
-        pipeline_require_translation_(false),
         bf_sde_interface_(bf_sde_interface),
-        device_id_(device_id) {}
+        device_id_(device_id),
+        snapshot_(MakeEmptySnapshot()) {}
+
+  static std::shared_ptr<const Snapshot> MakeEmptySnapshot();
+
+  // Returns the current snapshot.
+  std::shared_ptr<const Snapshot> GetSnapshot() const;
+
+  // Publishes a new snapshot.
+  void SetSnapshot(std::shared_ptr<const Snapshot> snapshot)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
   virtual ::util::StatusOr<::p4::v1::TableEntry> TranslateTableEntryInternal(
-      const ::p4::v1::TableEntry& entry, bool to_sdk)
-      SHARED_LOCKS_REQUIRED(lock_);
+      const Snapshot& snapshot, const ::p4::v1::TableEntry& entry,
+      bool to_sdk);
   virtual ::util::StatusOr<::p4::v1::PacketMetadata> TranslatePacketMetadata(
-      const p4::v1::PacketMetadata& packet_metadata, const std::string& uri,
-      int32 bit_width, bool to_sdk) SHARED_LOCKS_REQUIRED(lock_);
+      const PortMaps& ports, const p4::v1::PacketMetadata& packet_metadata,
+      const std::string& uri, int32 bit_width, bool to_sdk);
   virtual ::util::StatusOr<::p4::v1::Replica> TranslateReplica(
-      const ::p4::v1::Replica& replica, bool to_sdk)
-      SHARED_LOCKS_REQUIRED(lock_);
+      const PortMaps& ports, const ::p4::v1::Replica& replica, bool to_sdk);
   virtual ::util::StatusOr<::p4::v1::Action> TranslateAction(
-      const ::p4::v1::Action& action, bool to_sdk) SHARED_LOCKS_REQUIRED(lock_);
+      const Snapshot& snapshot, const ::p4::v1::Action& action, bool to_sdk);
   virtual ::util::StatusOr<::p4::v1::Index> TranslateIndex(
-      const ::p4::v1::Index& index, const std::string& uri, bool to_sdk)
-      SHARED_LOCKS_REQUIRED(lock_);
-  virtual ::util::StatusOr<std::string> TranslateValue(const std::string& value,
+      const PortMaps& ports, const ::p4::v1::Index& index,
+      const std::string& uri, bool to_sdk);
+  virtual ::util::StatusOr<std::string> TranslateValue(const PortMaps& ports,
+                                                       const std::string& value,
                                                        const std::string& uri,
                                                        bool to_sdk,
-                                                       int32 bit_width)
-      SHARED_LOCKS_REQUIRED(lock_);
+                                                       int32 bit_width);
   virtual ::util::StatusOr<std::string> TranslateTnaPortId(
-      const std::string& value, bool to_sdk, int32 bit_width)
-      SHARED_LOCKS_REQUIRED(lock_);
+      const PortMaps& ports, const std::string& value, bool to_sdk,
+      int32 bit_width);
 
-  // Reader-writer lock used to protect access to specific states.
+  // Mutex serializing chassis and pipeline config pushes. Never taken by
+  // translations.
   mutable absl::Mutex lock_;
 
   const bool translation_enabled_;
-  bool pipeline_require_translation_ GUARDED_BY(lock_);
 
   // Pointer to a BfSdeInterface implementation that wraps all the SDE calls.
   // Not owned by this class.
@@ -134,34 +186,9 @@ class BfrtP4RuntimeTranslator {
   // managed by this class instance. Assigned in the class constructor.
   const int device_id_;
 
-  // Maps between singleton port and SDK port, vice versa
-  absl::flat_hash_map<uint32, uint32> singleton_port_to_sdk_port_
-      GUARDED_BY(lock_);
-  absl::flat_hash_map<uint32, uint32> sdk_port_to_singleton_port_
-      GUARDED_BY(lock_);
-
-  // P4Runtime translation information
-  absl::flat_hash_map<uint32, absl::flat_hash_map<uint32, std::string>>
-      table_to_field_to_type_uri_ GUARDED_BY(lock_);
-  absl::flat_hash_map<uint32, absl::flat_hash_map<uint32, std::string>>
-      action_to_param_to_type_uri_ GUARDED_BY(lock_);
-  absl::flat_hash_map<uint32, std::string> packet_in_meta_to_type_uri_
-      GUARDED_BY(lock_);
-  absl::flat_hash_map<uint32, std::string> packet_out_meta_to_type_uri_
-      GUARDED_BY(lock_);
-  absl::flat_hash_map<uint32, std::string> counter_to_type_uri_
-      GUARDED_BY(lock_);
-  absl::flat_hash_map<uint32, std::string> meter_to_type_uri_ GUARDED_BY(lock_);
-  absl::flat_hash_map<uint32, std::string> register_to_type_uri_
-      GUARDED_BY(lock_);
-  absl::flat_hash_map<uint32, absl::flat_hash_map<uint32, int32>>
-      table_to_field_to_bit_width_ GUARDED_BY(lock_);
-  absl::flat_hash_map<uint32, absl::flat_hash_map<uint32, int32>>
-      action_to_param_to_bit_width_ GUARDED_BY(lock_);
-  absl::flat_hash_map<uint32, int32> packet_in_meta_to_bit_width_
-      GUARDED_BY(lock_);
-  absl::flat_hash_map<uint32, int32> packet_out_meta_to_bit_width_
-      GUARDED_BY(lock_);
+  // The current translation state, never null. Only accessed through
+  // std::atomic_load() and std::atomic_store().
+  std::shared_ptr<const Snapshot> snapshot_;
 
   friend class BfrtP4RuntimeTranslatorTest;
 };
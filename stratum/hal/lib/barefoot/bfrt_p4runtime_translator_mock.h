@@ -47,6 +47,8 @@ class BfrtP4RuntimeTranslatorMock : public BfrtP4RuntimeTranslator {
                    bool to_sdk));
   MOCK_METHOD1(TranslatePacketIn, ::util::StatusOr<::p4::v1::PacketIn>(
                                       const ::p4::v1::PacketIn& packet_in));
+  MOCK_METHOD1(TranslatePacketInInPlace,
+               ::util::Status(::p4::v1::PacketIn* packet_in));
   MOCK_METHOD1(TranslatePacketOut, ::util::StatusOr<::p4::v1::PacketOut>(
                                        const ::p4::v1::PacketOut& packet_out));
   MOCK_METHOD1(TranslateP4Info, ::util::StatusOr<::p4::config::v1::P4Info>(
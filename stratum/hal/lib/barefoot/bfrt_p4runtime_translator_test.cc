@@ -3,7 +3,10 @@
 
 #include "stratum/hal/lib/barefoot/bfrt_p4runtime_translator.h"
 
+#include <atomic>
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -76,9 +79,9 @@ class BfrtP4RuntimeTranslatorTest : public ::testing::Test {
   ::util::StatusOr<std::string> TranslateValue(const std::string& value,
                                                const std::string& uri,
                                                bool to_sdk, int32 bit_width) {
-    ::absl::ReaderMutexLock l(&bfrt_p4runtime_translator_->lock_);
-    return bfrt_p4runtime_translator_->TranslateValue(value, uri, to_sdk,
-                                                      bit_width);
+    const auto snapshot = bfrt_p4runtime_translator_->GetSnapshot();
+    return bfrt_p4runtime_translator_->TranslateValue(*snapshot->ports, value,
+                                                      uri, to_sdk, bit_width);
   }
 
   std::string Uint32ToBytes(uint32 value, int32 bit_width) {
@@ -555,9 +558,9 @@ TEST_F(BfrtP4RuntimeTranslatorTest, TranslateValue_MissingMappingToSdk) {
       TranslateValue(singleton_port_id, kUriTnaPortId, /*to_sdk=*/true,
                      kTnaPortIdBitWidth)
           .status(),
-      DerivedFromStatus(::util::Status(
-          StratumErrorSpace(), ERR_INVALID_PARAM,
-          "'singleton_port_to_sdk_port_.contains(port_id)' is false. ")));
+      DerivedFromStatus(
+          ::util::Status(StratumErrorSpace(), ERR_INVALID_PARAM,
+                         "Could not find SDK port for singleton port 10.")));
 }
 
 TEST_F(BfrtP4RuntimeTranslatorTest, TranslateValue_MissingMappingToPort) {
@@ -568,9 +571,9 @@ TEST_F(BfrtP4RuntimeTranslatorTest, TranslateValue_MissingMappingToPort) {
       TranslateValue(sdk_port_id, kUriTnaPortId, /*to_sdk=*/false,
                      kTnaPortIdBitWidth)
           .status(),
-      DerivedFromStatus(::util::Status(
-          StratumErrorSpace(), ERR_INVALID_PARAM,
-          "'sdk_port_to_singleton_port_.contains(sdk_port_id)' is false. ")));
+      DerivedFromStatus(
+          ::util::Status(StratumErrorSpace(), ERR_INVALID_PARAM,
+                         "Could not find singleton port for sdk port 10.")));
 }
 
 TEST_F(BfrtP4RuntimeTranslatorTest, TranslateValue_ToSdk) {
@@ -1188,9 +1191,9 @@ TEST_F(BfrtP4RuntimeTranslatorTest, WritePRE_InvalidPort) {
       bfrt_p4runtime_translator_
           ->TranslatePacketReplicationEngineEntry(pre_entry, true)
           .status(),
-      DerivedFromStatus(::util::Status(StratumErrorSpace(), ERR_INVALID_PARAM,
-                                       "'singleton_port_to_sdk_port_.contains("
-                                       "replica.egress_port())' is false.")));
+      DerivedFromStatus(
+          ::util::Status(StratumErrorSpace(), ERR_INVALID_PARAM,
+                         "Could not find SDK port for singleton port 3.")));
 }
 
 // PacketIO
@@ -1778,6 +1781,91 @@ TEST_F(BfrtP4RuntimeTranslatorTest, ReadRegisterEntry) {
                        &BfrtP4RuntimeTranslator::TranslateRegisterEntry);
 }
 
+// Entries of tables without translated match fields or actions are passed
+// through unchanged.
+TEST_F(BfrtP4RuntimeTranslatorTest, TableEntryWithoutTranslatedFields) {
+  constexpr uint32 kTableId = 33583784;
+  constexpr uint32 kActionId = 16794912;
+  EXPECT_OK(PushChassisConfig());
+  ::p4::config::v1::P4Info p4info;
+  ASSERT_OK(ParseProtoFromString(kP4InfoString, &p4info));
+  auto* table = p4info.add_tables();
+  table->mutable_preamble()->set_id(kTableId);
+  auto* match_field = table->add_match_fields();
+  match_field->set_id(1);
+  match_field->set_bitwidth(32);
+  match_field->set_match_type(::p4::config::v1::MatchField::EXACT);
+  table->add_action_refs()->set_id(kActionId);
+  auto* action = p4info.add_actions();
+  action->mutable_preamble()->set_id(kActionId);
+  auto* param = action->add_params();
+  param->set_id(1);
+  param->set_bitwidth(32);
+  ASSERT_OK(bfrt_p4runtime_translator_->PushForwardingPipelineConfig(p4info));
+
+  constexpr char table_entry_str[] = R"pb(
+    table_id: 33583784
+    match {
+      field_id: 1
+      exact { value: "\x0a" }
+    }
+    action {
+      action {
+        action_id: 16794912
+        params { param_id: 1 value: "\x0a" }
+      }
+    }
+  )pb";
+
+  TestEntryTranslation(table_entry_str, table_entry_str, true,
+                       &BfrtP4RuntimeTranslator::TranslateTableEntry);
+  TestEntryTranslation(table_entry_str, table_entry_str, false,
+                       &BfrtP4RuntimeTranslator::TranslateTableEntry);
+}
+
+// Translations see consistent snapshots while configs are pushed.
+TEST_F(BfrtP4RuntimeTranslatorTest, TranslateWhilePushingConfigs) {
+  EXPECT_OK(PushChassisConfig());
+  EXPECT_OK(PushForwardingPipelineConfig());
+  constexpr char table_entry_str[] = R"pb(
+    table_id: 33583783
+    match {
+      field_id: 1
+      exact { value: "\x01" }
+    }
+  )pb";
+  constexpr char expected_table_entry_str[] = R"pb(
+    table_id: 33583783
+    match {
+      field_id: 1
+      exact { value: "\x01\x2C" }
+    }
+  )pb";
+  ::p4::v1::TableEntry entry;
+  ::p4::v1::TableEntry expected_entry;
+  ASSERT_OK(ParseProtoFromString(table_entry_str, &entry));
+  ASSERT_OK(ParseProtoFromString(expected_table_entry_str, &expected_entry));
+
+  std::atomic<bool> done(false);
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; ++i) {
+    readers.emplace_back([&]() {
+      while (!done) {
+        auto result = bfrt_p4runtime_translator_->TranslateTableEntry(
+            entry, /*to_sdk=*/true);
+        ASSERT_OK(result.status());
+        EXPECT_THAT(result.ValueOrDie(), EqualsProto(expected_entry));
+      }
+    });
+  }
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_OK(PushForwardingPipelineConfig());
+    EXPECT_OK(PushChassisConfig());
+  }
+  done = true;
+  for (auto& reader : readers) reader.join();
+}
+
 // Translation disabled
 TEST_F(BfrtP4RuntimeTranslatorTest, TranslationDisabled) {
   bfrt_p4runtime_translator_ = BfrtP4RuntimeTranslator::CreateInstance(
@@ -9,6 +9,7 @@
 #include <sys/socket.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <deque>
 #include <string>
 
@@ -21,6 +22,23 @@ namespace stratum {
 namespace hal {
 namespace barefoot {
 
+namespace {
+
+// Depth of the channel between the SDE packet receive callback and the RX
+// thread.
+constexpr int kPacketReceiveChannelDepth = 128;
+
+// Maximum number of packets the RX thread takes from the channel at once.
+constexpr size_t kPacketReceiveBatchSize = 32;
+
+// The receive buffers cover a full channel plus the batch being handled and
+// the packets being filled. Each one fits a jumbo frame plus the CPU header.
+constexpr size_t kPacketReceiveBufferPoolSize =
+    kPacketReceiveChannelDepth + kPacketReceiveBatchSize + 4;
+constexpr size_t kPacketReceiveBufferSize = 10 * 1024;
+
+}  // namespace
+
 BfrtPacketioManager::BfrtPacketioManager(
     BfSdeInterface* bf_sde_interface,
     BfrtP4RuntimeTranslator* bfrt_p4runtime_translator, int device)
@@ -31,6 +49,7 @@ BfrtPacketioManager::BfrtPacketioManager(
       packetin_header_size_(),
       packetout_header_size_(),
       packet_receive_channel_(nullptr),
+      packet_receive_buffer_pool_(nullptr),
       sde_rx_thread_id_(),
       bf_sde_interface_(ABSL_DIE_IF_NULL(bf_sde_interface)),
       bfrt_p4runtime_translator_(ABSL_DIE_IF_NULL(bfrt_p4runtime_translator)),
@@ -44,6 +63,7 @@ BfrtPacketioManager::BfrtPacketioManager()
       packetin_header_size_(),
       packetout_header_size_(),
       packet_receive_channel_(nullptr),
+      packet_receive_buffer_pool_(nullptr),
       sde_rx_thread_id_(),
       bf_sde_interface_(nullptr),
       device_(-1) {}
@@ -74,7 +94,10 @@ std::unique_ptr<BfrtPacketioManager> BfrtPacketioManager::CreateInstance(
   // PushForwardingPipelineConfig resets the bf_pkt driver.
   RETURN_IF_ERROR(bf_sde_interface_->StartPacketIo(device_));
   if (!initialized_) {
-    packet_receive_channel_ = Channel<std::string>::Create(128);
+    packet_receive_channel_ =
+        Channel<std::string>::Create(kPacketReceiveChannelDepth);
+    packet_receive_buffer_pool_ = std::make_shared<PacketBufferPool>(
+        kPacketReceiveBufferPoolSize, kPacketReceiveBufferSize);
     if (sde_rx_thread_id_ == 0) {
       int ret = pthread_create(&sde_rx_thread_id_, nullptr,
                                &BfrtPacketioManager::SdeRxThreadFunc, this);
@@ -85,7 +108,8 @@ std::unique_ptr<BfrtPacketioManager> BfrtPacketioManager::CreateInstance(
       }
     }
     RETURN_IF_ERROR(bf_sde_interface_->RegisterPacketReceiveWriter(
-        device_, ChannelWriter<std::string>::Create(packet_receive_channel_)));
+        device_, ChannelWriter<std::string>::Create(packet_receive_channel_),
+        packet_receive_buffer_pool_));
     initialized_ = true;
   }
 
@@ -120,6 +144,7 @@ std::unique_ptr<BfrtPacketioManager> BfrtPacketioManager::CreateInstance(
     packetin_header_size_ = 0;
     packetout_header_size_ = 0;
     packet_receive_channel_.reset();
+    packet_receive_buffer_pool_.reset();
     initialized_ = false;
   }
   // TODO(max): we release the locks between closing the channel and joining the
@@ -232,6 +257,24 @@ class BitBuffer {
   const int kBitsPerByte = 8;
   std::deque<uint8> bits_;
 };
+
+// Extracts the bitwidth bits at bit_offset from the big-endian bit stream in
+// data into value, right-aligned and without leading zero bytes, the canonical
+// P4Runtime representation. Reuses the memory of value.
+void ExtractBitField(const char* data, size_t bit_offset, int bitwidth,
+                     std::string* value) {
+  const int num_bytes = (bitwidth + 7) / 8;
+  const size_t padding = num_bytes * 8 - bitwidth;
+  value->assign(num_bytes, '\0');
+  for (int i = 0; i < bitwidth; ++i) {
+    const size_t src = bit_offset + i;
+    if ((static_cast<uint8>(data[src / 8]) >> (7 - src % 8)) & 1u) {
+      const size_t dst = padding + i;
+      (*value)[dst / 8] |= static_cast<char>(1u << (7 - dst % 8));
+    }
+  }
+  value->erase(0, std::min(value->find_first_not_of('\0'), value->size() - 1));
+}
 }  // namespace
 
 ::util::Status BfrtPacketioManager::DeparsePacketOut(
@@ -267,17 +310,21 @@ class BitBuffer {
   RET_CHECK(buffer.size() >= packetin_header_size_)
       << "Received packet is too small.";
 
-  BitBuffer bit_buf;
-  RETURN_IF_ERROR(bit_buf.PushBack(buffer.substr(0, packetin_header_size_),
-                                   packetin_header_size_ * 8));
-  for (const auto& p : packetin_header_) {
-    auto metadata = packet->add_metadata();
-    metadata->set_metadata_id(p.first);
-    metadata->set_value(
-        ByteStringToP4RuntimeByteString(bit_buf.PopField(p.second)));
+  // Overwrite the metadata entries of the previous packet instead of
+  // allocating new ones. Cleared entries stay allocated for reuse.
+  auto* metadata = packet->mutable_metadata();
+  const int num_metadata = packetin_header_.size();
+  while (metadata->size() > num_metadata) metadata->RemoveLast();
+  size_t bit_offset = 0;
+  for (int i = 0; i < num_metadata; ++i) {
+    const auto& p = packetin_header_[i];
+    auto* md = i < metadata->size() ? metadata->Mutable(i) : metadata->Add();
+    md->set_metadata_id(p.first);
+    ExtractBitField(buffer.data(), bit_offset, p.second, md->mutable_value());
+    bit_offset += p.second;
     VLOG(1) << "Encoded PacketIn metadata field with id " << p.first
             << " bitwidth " << p.second << " value 0x"
-            << StringToHex(metadata->value());
+            << StringToHex(md->value());
   }
   packet->set_payload(buffer.data() + packetin_header_size_,
                       buffer.size() - packetin_header_size_);
@@ -304,39 +351,53 @@ class BitBuffer {
 
 ::util::Status BfrtPacketioManager::HandleSdePacketRx() {
   std::unique_ptr<ChannelReader<std::string>> reader;
+  std::shared_ptr<PacketBufferPool> buffer_pool;
   {
     absl::ReaderMutexLock l(&data_lock_);
     if (!initialized_)
       return MAKE_ERROR(ERR_NOT_INITIALIZED) << "Not initialized.";
     reader = ChannelReader<std::string>::Create(packet_receive_channel_);
+    buffer_pool = packet_receive_buffer_pool_;
   }
 
+  // Both are reused across packets, so that the steady state does not
+  // allocate. The PacketIn keeps the memory of its payload and metadata.
+  // Packet storms are drained in batches, taking the channel lock once per
+  // batch.
+  std::vector<std::string> buffers;
+  buffers.reserve(kPacketReceiveBatchSize);
+  ::p4::v1::PacketIn packet_in;
   while (true) {
-    std::string buffer;
-    int code = reader->Read(&buffer, absl::InfiniteDuration()).error_code();
+    int code = reader
+                   ->ReadBatch(&buffers, kPacketReceiveBatchSize,
+                               absl::InfiniteDuration())
+                   .error_code();
     if (code == ERR_CANCELLED) break;
     if (code == ERR_ENTRY_NOT_FOUND) {
       LOG(ERROR) << "Read with infinite timeout failed with ENTRY_NOT_FOUND.";
       continue;
     }
 
-    ::p4::v1::PacketIn packet_in;
-    ::util::Status status = ParsePacketIn(buffer, &packet_in);
-    if (!status.ok()) {
-      LOG(ERROR) << "ParsePacketIn failed: " << status;
-      continue;
-    }
-    const auto& translated_packet_in =
-        bfrt_p4runtime_translator_->TranslatePacketIn(packet_in);
-    if (!translated_packet_in.ok()) {
-      LOG(ERROR) << "TranslatePacketIn failed: " << status;
-      continue;
-    }
-    {
-      absl::WriterMutexLock l(&rx_writer_lock_);
-      rx_writer_->Write(translated_packet_in.ValueOrDie());
+    for (auto& buffer : buffers) {
+      ::util::Status status = ParsePacketIn(buffer, &packet_in);
+      // The payload has been copied into the PacketIn, recycle the buffer.
+      buffer_pool->Release(std::move(buffer));
+      if (!status.ok()) {
+        LOG(ERROR) << "ParsePacketIn failed: " << status;
+        continue;
+      }
+      status =
+          bfrt_p4runtime_translator_->TranslatePacketInInPlace(&packet_in);
+      if (!status.ok()) {
+        LOG(ERROR) << "TranslatePacketIn failed: " << status;
+        continue;
+      }
+      {
+        absl::WriterMutexLock l(&rx_writer_lock_);
+        if (rx_writer_) rx_writer_->Write(packet_in);
+      }
+      VLOG(1) << "Handled PacketIn: " << packet_in.ShortDebugString();
     }
-    VLOG(1) << "Handled PacketIn: " << packet_in.ShortDebugString();
   }
 
   return ::util::OkStatus();
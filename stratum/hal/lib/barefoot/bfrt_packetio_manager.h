@@ -18,6 +18,7 @@
 #include "stratum/hal/lib/barefoot/bf.pb.h"
 #include "stratum/hal/lib/barefoot/bf_sde_interface.h"
 #include "stratum/hal/lib/barefoot/bfrt_p4runtime_translator.h"
+#include "stratum/hal/lib/barefoot/packet_buffer_pool.h"
 #include "stratum/hal/lib/common/common.pb.h"
 #include "stratum/hal/lib/common/writer_interface.h"
 #include "stratum/lib/utils.h"
@@ -96,7 +97,9 @@ class BfrtPacketioManager {
                                   std::string* buffer)
       LOCKS_EXCLUDED(data_lock_);
 
-  // Parses a binary string into a PacketIn, filling the metadata fields.
+  // Parses a binary string into a PacketIn, filling the metadata fields. The
+  // metadata is extracted in place and the payload copied once. Any previous
+  // content of the PacketIn is overwritten, reusing its memory.
   ::util::Status ParsePacketIn(const std::string& buffer,
                                ::p4::v1::PacketIn* packet)
       LOCKS_EXCLUDED(data_lock_);
@@ -132,6 +135,11 @@ class BfrtPacketioManager {
   std::shared_ptr<Channel<std::string>> packet_receive_channel_
       GUARDED_BY(data_lock_);
 
+  // Pool of the buffers passed through packet_receive_channel_. The SDE fills
+  // them and the RX thread releases them once parsed.
+  std::shared_ptr<PacketBufferPool> packet_receive_buffer_pool_
+      GUARDED_BY(data_lock_);
+
   // The ID of the RX thread which handles receiving packets from the SDE.
   pthread_t sde_rx_thread_id_ GUARDED_BY(data_lock_);
 
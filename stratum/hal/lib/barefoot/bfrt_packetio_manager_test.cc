@@ -3,6 +3,8 @@
 
 #include "stratum/hal/lib/barefoot/bfrt_packetio_manager.h"
 
+#include <vector>
+
 #include "absl/memory/memory.h"
 #include "absl/synchronization/notification.h"
 #include "gmock/gmock.h"
@@ -26,8 +28,8 @@ using ::testing::DoAll;
 using ::testing::HasSubstr;
 using ::testing::Invoke;
 using ::testing::InvokeWithoutArgs;
+using ::testing::Pointee;
 using ::testing::Return;
-using ::testing::ReturnArg;
 
 class BfrtPacketioManagerTest : public ::testing::Test {
  protected:
@@ -54,7 +56,7 @@ class BfrtPacketioManagerTest : public ::testing::Test {
           .WillOnce(Return(util::OkStatus()));
       // - RegisterPacketReceiveWriter of SDE interface will be invoked
       EXPECT_CALL(*bf_sde_wrapper_mock_,
-                  RegisterPacketReceiveWriter(kDevice1, _))
+                  RegisterPacketReceiveWriter(kDevice1, _, _))
           .WillOnce(Invoke(
               this, &BfrtPacketioManagerTest::RegisterPacketReceiveWriter));
     }
@@ -82,15 +84,19 @@ class BfrtPacketioManagerTest : public ::testing::Test {
       }
     }
     packet_rx_writer.reset();
+    packet_rx_buffer_pool.reset();
     return bfrt_packetio_manager_->Shutdown();
   }
 
   // The mock method which help us to initialize a mock packet receive writer
   // so we can use it later.
   ::util::Status RegisterPacketReceiveWriter(
-      int device, std::unique_ptr<ChannelWriter<std::string>> writer) {
+      int device, std::unique_ptr<ChannelWriter<std::string>> writer,
+      std::shared_ptr<PacketBufferPool> buffer_pool) {
     EXPECT_EQ(device, kDevice1);
+    EXPECT_NE(nullptr, buffer_pool);
     packet_rx_writer = std::move(writer);
+    packet_rx_buffer_pool = std::move(buffer_pool);
     return ::util::OkStatus();
   }
 
@@ -149,6 +155,7 @@ class BfrtPacketioManagerTest : public ::testing::Test {
   std::unique_ptr<BfrtP4RuntimeTranslatorMock> bfrt_p4runtime_translator_mock_;
   std::unique_ptr<BfrtPacketioManager> bfrt_packetio_manager_;
   std::unique_ptr<ChannelWriter<std::string>> packet_rx_writer;
+  std::shared_ptr<PacketBufferPool> packet_rx_buffer_pool;
 };
 
 constexpr int BfrtPacketioManagerTest::kDevice1;
@@ -347,10 +354,10 @@ TEST_F(BfrtPacketioManagerTest, TestPacketIn) {
               return false;
             }
           }));
-  EXPECT_CALL(*bfrt_p4runtime_translator_mock_,
-              TranslatePacketIn(EqualsProto(expected_packet_in)))
-      .WillOnce(
-          Return(::util::StatusOr<::p4::v1::PacketIn>(expected_packet_in)));
+  EXPECT_CALL(
+      *bfrt_p4runtime_translator_mock_,
+      TranslatePacketInInPlace(Pointee(EqualsProto(expected_packet_in))))
+      .WillOnce(Return(::util::OkStatus()));
   EXPECT_OK(packet_rx_writer->Write(packet_from_asic, absl::Milliseconds(100)));
 
   // Here we need to wait until we receive and verify the packet from the mock
@@ -377,8 +384,8 @@ TEST_F(BfrtPacketioManagerTest, MalformedPacketInShouldNotStopRxThread) {
           return false;
         }
       }));
-  EXPECT_CALL(*bfrt_p4runtime_translator_mock_, TranslatePacketIn(_))
-      .WillRepeatedly(ReturnArg<0>());
+  EXPECT_CALL(*bfrt_p4runtime_translator_mock_, TranslatePacketInInPlace(_))
+      .WillRepeatedly(Return(::util::OkStatus()));
   const std::string malformed_packet_from_asic("\0",  // metadata too short
                                                1);
   const std::string valid_packet_from_asic(
@@ -401,6 +408,75 @@ TEST_F(BfrtPacketioManagerTest, MalformedPacketInShouldNotStopRxThread) {
   EXPECT_OK(Shutdown());
 }
 
+TEST_F(BfrtPacketioManagerTest, PacketInBuffersAreRecycled) {
+  EXPECT_OK(PushPipelineConfig());
+  auto writer = std::make_shared<WriterMock<::p4::v1::PacketIn>>();
+  EXPECT_OK(bfrt_packetio_manager_->RegisterPacketReceiveWriter(writer));
+  EXPECT_CALL(*bfrt_p4runtime_translator_mock_, TranslatePacketInInPlace(_))
+      .WillRepeatedly(Return(::util::OkStatus()));
+  std::vector<::p4::v1::PacketIn> received;
+  absl::Notification all_received;
+  EXPECT_CALL(*writer, Write(_))
+      .Times(3)
+      .WillRepeatedly(Invoke([&](::p4::v1::PacketIn actual) {
+        received.push_back(actual);
+        if (received.size() == 3) all_received.Notify();
+        return true;
+      }));
+
+  // The second packet has a wider ingress port value and payload than the
+  // others, which must not leak into the reused PacketIn.
+  const std::vector<std::string> packets_from_asic = {
+      std::string("\0\x80"
+                  "abcde",
+                  7),
+      std::string("\x81\0"
+                  "abcdefgh",
+                  10),
+      std::string("\0\x80"
+                  "xy",
+                  4),
+  };
+  for (const auto& packet : packets_from_asic) {
+    std::string buffer = packet_rx_buffer_pool->Acquire();
+    buffer.assign(packet);
+    EXPECT_OK(packet_rx_writer->Write(std::move(buffer),
+                                      absl::Milliseconds(100)));
+  }
+  ASSERT_TRUE(all_received.WaitForNotificationWithTimeout(absl::Seconds(1)));
+
+  const char expected_packet_ins[][256] = {
+      R"pb(
+        payload: "abcde"
+        metadata { metadata_id: 1 value: "\001" }
+        metadata { metadata_id: 2 value: "\000" }
+      )pb",
+      R"pb(
+        payload: "abcdefgh"
+        metadata { metadata_id: 1 value: "\001\002" }
+        metadata { metadata_id: 2 value: "\000" }
+      )pb",
+      R"pb(
+        payload: "xy"
+        metadata { metadata_id: 1 value: "\001" }
+        metadata { metadata_id: 2 value: "\000" }
+      )pb",
+  };
+  for (int i = 0; i < 3; ++i) {
+    ::p4::v1::PacketIn expected_packet_in;
+    EXPECT_OK(
+        ParseProtoFromString(expected_packet_ins[i], &expected_packet_in));
+    EXPECT_THAT(received[i], EqualsProto(expected_packet_in));
+  }
+  // All buffers came from and went back to the pool.
+  const auto stats = packet_rx_buffer_pool->GetStats();
+  EXPECT_EQ(3, stats.acquired);
+  EXPECT_EQ(0, stats.allocated);
+  EXPECT_EQ(0, stats.discarded);
+  EXPECT_OK(bfrt_packetio_manager_->UnregisterPacketReceiveWriter());
+  EXPECT_OK(Shutdown());
+}
+
 }  // namespace barefoot
 }  // namespace hal
 }  // namespace stratum
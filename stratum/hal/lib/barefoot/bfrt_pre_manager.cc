@@ -11,27 +11,58 @@
 #include "stratum/glue/gtl/map_util.h"
 #include "stratum/glue/status/status_macros.h"
 #include "stratum/hal/lib/barefoot/bfrt_constants.h"
+#include "stratum/lib/macros.h"
 #include "stratum/public/lib/error.h"
 
 namespace stratum {
 namespace hal {
 namespace barefoot {
 
+namespace {
+
+// Collects the sorted egress ports of every instance (rid) of the given
+// multicast group entry.
+::util::StatusOr<absl::flat_hash_map<uint32, std::vector<uint32>>>
+GetInstanceToEgressPorts(const ::p4::v1::MulticastGroupEntry& entry) {
+  RET_CHECK(entry.multicast_group_id() <= kMaxMulticastGroupId);
+  absl::flat_hash_map<uint32, std::vector<uint32>> instance_to_egress_ports;
+  for (const auto& replica : entry.replicas()) {
+    RET_CHECK(replica.instance() <= UINT16_MAX);
+    instance_to_egress_ports[replica.instance()].push_back(
+        replica.egress_port());
+  }
+  for (auto& e : instance_to_egress_ports) {
+    std::sort(e.second.begin(), e.second.end());
+  }
+
+  return instance_to_egress_ports;
+}
+
+}  // namespace
+
 BfrtPreManager::BfrtPreManager(
     BfSdeInterface* bf_sde_interface,
     BfrtP4RuntimeTranslator* bfrt_p4runtime_translator, int device)
     : bf_sde_interface_(ABSL_DIE_IF_NULL(bf_sde_interface)),
       bfrt_p4runtime_translator_(ABSL_DIE_IF_NULL(bfrt_p4runtime_translator)),
+      mc_node_id_allocator_(0, kMaxMulticastNodeId - 1),
+      mc_node_ids_synced_(false),
       device_(device) {}
 
 BfrtPreManager::BfrtPreManager()
     : bf_sde_interface_(nullptr),
       bfrt_p4runtime_translator_(nullptr),
+      mc_node_id_allocator_(0, kMaxMulticastNodeId - 1),
+      mc_node_ids_synced_(false),
       device_(-1) {}
 
 ::util::Status BfrtPreManager::PushForwardingPipelineConfig(
     const BfrtDeviceConfig& config) {
   absl::WriterMutexLock l(&lock_);
+  // The PRE state may have changed with the new pipeline, rebuild the
+  // allocator and the group shadows from the hardware on the next write.
+  mc_node_ids_synced_ = false;
+  multicast_groups_.clear();
   return ::util::OkStatus();
 }
 
@@ -94,84 +125,247 @@ std::unique_ptr<BfrtPreManager> BfrtPreManager::CreateInstance(
       new BfrtPreManager(bf_sde_interface, bfrt_p4runtime_translator, device));
 }
 
-::util::StatusOr<std::vector<uint32>> BfrtPreManager::InsertMulticastNodes(
+::util::Status BfrtPreManager::InsertMulticastNodes(
+    std::shared_ptr<BfSdeInterface::SessionInterface> session,
+    const absl::flat_hash_map<uint32, std::vector<uint32>>&
+        instance_to_egress_ports,
+    MulticastGroupNodes* nodes) {
+  MulticastGroupNodes new_nodes;
+  std::vector<uint32> new_node_ids;
+  ::util::Status status;
+  for (const auto& replica : instance_to_egress_ports) {
+    const uint32 instance = replica.first;
+    const std::vector<uint32>& egress_ports = replica.second;
+    std::vector<uint32> mc_lag_ids;
+    auto mc_node_id = mc_node_id_allocator_.Allocate();
+    if (!mc_node_id.ok()) {
+      status = mc_node_id.status();
+      break;
+    }
+    status = bf_sde_interface_->InsertMulticastNode(
+        device_, session, mc_node_id.ValueOrDie(), instance, mc_lag_ids,
+        egress_ports);
+    if (!status.ok()) {
+      mc_node_id_allocator_.Release(mc_node_id.ValueOrDie());
+      break;
+    }
+    new_node_ids.push_back(mc_node_id.ValueOrDie());
+    new_nodes[instance] = MulticastNode{mc_node_id.ValueOrDie(), egress_ports};
+  }
+  if (!status.ok()) {
+    // Revert the partial insertion.
+    APPEND_STATUS_IF_ERROR(status, DeleteMulticastNodes(session, new_node_ids));
+    return status;
+  }
+  nodes->insert(new_nodes.begin(), new_nodes.end());
+
+  return ::util::OkStatus();
+}
+
+::util::Status BfrtPreManager::DeleteMulticastNodes(
+    std::shared_ptr<BfSdeInterface::SessionInterface> session,
+    const std::vector<uint32>& mc_node_ids) {
+  if (mc_node_ids.empty()) return ::util::OkStatus();
+  ::util::Status status =
+      bf_sde_interface_->DeleteMulticastNodes(device_, session, mc_node_ids);
+  if (!status.ok()) {
+    // We don't know which nodes are left, rebuild the allocator on next use.
+    mc_node_ids_synced_ = false;
+    return status;
+  }
+  for (const auto& mc_node_id : mc_node_ids) {
+    mc_node_id_allocator_.Release(mc_node_id);
+  }
+
+  return ::util::OkStatus();
+}
+
+::util::Status BfrtPreManager::SyncMulticastNodeIds(
+    std::shared_ptr<BfSdeInterface::SessionInterface> session) {
+  if (mc_node_ids_synced_) return ::util::OkStatus();
+  std::vector<uint32> mc_node_ids;
+  RETURN_IF_ERROR(
+      bf_sde_interface_->GetMulticastNodeIds(device_, session, &mc_node_ids));
+  mc_node_id_allocator_.Clear();
+  for (const auto& mc_node_id : mc_node_ids) {
+    RETURN_IF_ERROR(mc_node_id_allocator_.Reserve(mc_node_id));
+  }
+  mc_node_ids_synced_ = true;
+  VLOG(1) << "Synced " << mc_node_ids.size() << " multicast node IDs.";
+
+  return ::util::OkStatus();
+}
+
+::util::Status BfrtPreManager::GetMulticastGroupNodes(
+    std::shared_ptr<BfSdeInterface::SessionInterface> session,
+    uint32 group_id, MulticastGroupNodes* nodes,
+    std::vector<uint32>* other_node_ids) {
+  const MulticastGroupNodes* shadow =
+      gtl::FindOrNull(multicast_groups_, group_id);
+  if (shadow != nullptr) {
+    *nodes = *shadow;
+    return ::util::OkStatus();
+  }
+  ASSIGN_OR_RETURN(
+      auto mc_node_ids,
+      bf_sde_interface_->GetNodesInMulticastGroup(device_, session, group_id));
+  for (const auto& mc_node_id : mc_node_ids) {
+    int replication_id;
+    std::vector<uint32> lag_ids;
+    std::vector<uint32> ports;
+    RETURN_IF_ERROR(bf_sde_interface_->GetMulticastNode(
+        device_, session, mc_node_id, &replication_id, &lag_ids, &ports));
+    std::sort(ports.begin(), ports.end());
+    if (!lag_ids.empty() ||
+        !nodes->emplace(replication_id, MulticastNode{mc_node_id, ports})
+             .second) {
+      other_node_ids->push_back(mc_node_id);
+    }
+  }
+
+  return ::util::OkStatus();
+}
+
+::util::Status BfrtPreManager::ModifyMulticastGroup(
     std::shared_ptr<BfSdeInterface::SessionInterface> session,
     const ::p4::v1::MulticastGroupEntry& entry) {
   const uint32 group_id = entry.multicast_group_id();
-  RET_CHECK(group_id <= kMaxMulticastGroupId);
+  ASSIGN_OR_RETURN(auto instance_to_egress_ports,
+                   GetInstanceToEgressPorts(entry));
+  MulticastGroupNodes current_nodes;
+  std::vector<uint32> removed_node_ids;
+  RETURN_IF_ERROR(GetMulticastGroupNodes(session, group_id, &current_nodes,
+                                         &removed_node_ids));
 
-  // Collect instance (rid) -> egress ports mapping
-  absl::flat_hash_map<uint32, std::vector<uint32>> instance_to_egress_ports;
-  for (const auto& replica : entry.replicas()) {
-    RET_CHECK(replica.instance() <= UINT16_MAX);
-    instance_to_egress_ports[replica.instance()].push_back(
-        replica.egress_port());
-  }
-  std::vector<uint32> new_nodes = {};
-  // FIXME: We need to revert partial modifications in case of failures.
+  // Compute the minimal set of node changes.
+  MulticastGroupNodes new_nodes;
+  absl::flat_hash_map<uint32, std::vector<uint32>> added_instances;
+  std::vector<uint32> modified_instances;
   for (const auto& replica : instance_to_egress_ports) {
-    const uint32 instance = replica.first;
-    const std::vector<uint32>& egress_ports = replica.second;
+    const MulticastNode* node = gtl::FindOrNull(current_nodes, replica.first);
+    if (node == nullptr) {
+      added_instances.emplace(replica.first, replica.second);
+      continue;
+    }
+    new_nodes[replica.first] = MulticastNode{node->mc_node_id, replica.second};
+    if (node->ports != replica.second) {
+      modified_instances.push_back(replica.first);
+    }
+  }
+  for (const auto& e : current_nodes) {
+    if (!instance_to_egress_ports.contains(e.first)) {
+      removed_node_ids.push_back(e.second.mc_node_id);
+    }
+  }
+  VLOG(1) << "Modifying multicast group " << group_id << ": "
+          << added_instances.size() << " new, " << modified_instances.size()
+          << " updated, " << removed_node_ids.size() << " removed nodes.";
+
+  RETURN_IF_ERROR(InsertMulticastNodes(session, added_instances, &new_nodes));
+  ::util::Status status;
+  std::vector<uint32> updated_instances;
+  for (const auto& instance : modified_instances) {
+    const MulticastNode& node = new_nodes[instance];
     std::vector<uint32> mc_lag_ids;
-    ASSIGN_OR_RETURN(uint32 mc_node_id,
-                     bf_sde_interface_->CreateMulticastNode(
-                         device_, session, instance, mc_lag_ids, egress_ports));
-    new_nodes.push_back(mc_node_id);
+    status = bf_sde_interface_->ModifyMulticastNode(
+        device_, session, node.mc_node_id, instance, mc_lag_ids, node.ports);
+    if (!status.ok()) break;
+    updated_instances.push_back(instance);
+  }
+  // The group only has to be rewritten if nodes were added or removed.
+  if (status.ok() && (!added_instances.empty() || !removed_node_ids.empty())) {
+    std::vector<uint32> mc_node_ids;
+    for (const auto& e : new_nodes) mc_node_ids.push_back(e.second.mc_node_id);
+    status = bf_sde_interface_->ModifyMulticastGroup(device_, session,
+                                                     group_id, mc_node_ids);
+  }
+  if (!status.ok()) {
+    // Revert the partial modification: restore the ports of updated nodes
+    // and delete the new nodes, which are not linked to the group yet.
+    ::util::Status revert_status;
+    for (const auto& instance : updated_instances) {
+      const MulticastNode& node = current_nodes[instance];
+      std::vector<uint32> mc_lag_ids;
+      APPEND_STATUS_IF_ERROR(revert_status,
+                             bf_sde_interface_->ModifyMulticastNode(
+                                 device_, session, node.mc_node_id, instance,
+                                 mc_lag_ids, node.ports));
+    }
+    std::vector<uint32> new_node_ids;
+    for (const auto& e : added_instances) {
+      new_node_ids.push_back(new_nodes[e.first].mc_node_id);
+    }
+    APPEND_STATUS_IF_ERROR(revert_status,
+                           DeleteMulticastNodes(session, new_node_ids));
+    if (!revert_status.ok()) {
+      LOG(ERROR) << "Failed to revert modification of multicast group "
+                 << group_id << ": " << revert_status.error_message();
+      // The shadow no longer matches the hardware, read it back next time.
+      multicast_groups_.erase(group_id);
+    }
+    return APPEND_ERROR(status).with_logging()
+           << " Failed to write multicast group for request "
+           << entry.ShortDebugString() << ".";
   }
+  multicast_groups_[group_id] = std::move(new_nodes);
+  RETURN_IF_ERROR_WITH_APPEND(DeleteMulticastNodes(session, removed_node_ids))
+          .with_logging()
+      << "Failed to delete multicast nodes for request "
+      << entry.ShortDebugString() << ".";
 
-  return new_nodes;
+  return ::util::OkStatus();
 }
 
-// FIXME: We need to revert partial modifications in case of failures.
 ::util::Status BfrtPreManager::WriteMulticastGroupEntry(
     std::shared_ptr<BfSdeInterface::SessionInterface> session,
     const ::p4::v1::Update::Type& type,
     const ::p4::v1::MulticastGroupEntry& entry) {
   VLOG(1) << ::p4::v1::Update_Type_Name(type) << " "
           << entry.ShortDebugString();
-  ::util::Status status;
+  const uint32 group_id = entry.multicast_group_id();
+  RETURN_IF_ERROR(SyncMulticastNodeIds(session));
   switch (type) {
     case ::p4::v1::Update::INSERT: {
-      ASSIGN_OR_RETURN(std::vector<uint32> mc_node_ids,
-                       InsertMulticastNodes(session, entry));
-      RETURN_IF_ERROR(bf_sde_interface_->InsertMulticastGroup(
-          device_, session, entry.multicast_group_id(), mc_node_ids));
-      break;
-    }
-    case ::p4::v1::Update::MODIFY: {
-      ASSIGN_OR_RETURN(auto current_node_ids,
-                       bf_sde_interface_->GetNodesInMulticastGroup(
-                           device_, session, entry.multicast_group_id()));
-      ASSIGN_OR_RETURN(std::vector<uint32> new_node_ids,
-                       InsertMulticastNodes(session, entry));
-      RETURN_IF_ERROR_WITH_APPEND(
-          bf_sde_interface_->ModifyMulticastGroup(
-              device_, session, entry.multicast_group_id(), new_node_ids))
-              .with_logging()
-          << "Failed to write multicast group for request "
-          << entry.ShortDebugString() << ".";
-      RETURN_IF_ERROR_WITH_APPEND(bf_sde_interface_->DeleteMulticastNodes(
-                                      device_, session, current_node_ids))
-              .with_logging()
-          << "Failed to delete multicast nodes for request "
-          << entry.ShortDebugString() << ".";
+      ASSIGN_OR_RETURN(auto instance_to_egress_ports,
+                       GetInstanceToEgressPorts(entry));
+      MulticastGroupNodes nodes;
+      RETURN_IF_ERROR(
+          InsertMulticastNodes(session, instance_to_egress_ports, &nodes));
+      std::vector<uint32> mc_node_ids;
+      for (const auto& e : nodes) mc_node_ids.push_back(e.second.mc_node_id);
+      ::util::Status status = bf_sde_interface_->InsertMulticastGroup(
+          device_, session, group_id, mc_node_ids);
+      if (!status.ok()) {
+        // Revert the node insertion.
+        APPEND_STATUS_IF_ERROR(status,
+                               DeleteMulticastNodes(session, mc_node_ids));
+        return status;
+      }
+      multicast_groups_[group_id] = std::move(nodes);
       break;
     }
+    case ::p4::v1::Update::MODIFY:
+      return ModifyMulticastGroup(session, entry);
     case ::p4::v1::Update::DELETE: {
       LOG_IF(WARNING, entry.replicas_size() != 0)
           << "Replicas are ignored on MulticastGroupEntry delete requests: "
           << entry.ShortDebugString() << ".";
-      ASSIGN_OR_RETURN(auto node_ids,
-                       bf_sde_interface_->GetNodesInMulticastGroup(
-                           device_, session, entry.multicast_group_id()));
+      std::vector<uint32> node_ids;
+      const MulticastGroupNodes* nodes =
+          gtl::FindOrNull(multicast_groups_, group_id);
+      if (nodes != nullptr) {
+        for (const auto& e : *nodes) node_ids.push_back(e.second.mc_node_id);
+      } else {
+        ASSIGN_OR_RETURN(node_ids, bf_sde_interface_->GetNodesInMulticastGroup(
+                                       device_, session, group_id));
+      }
       RETURN_IF_ERROR_WITH_APPEND(
-          bf_sde_interface_->DeleteMulticastGroup(device_, session,
-                                                  entry.multicast_group_id()))
+          bf_sde_interface_->DeleteMulticastGroup(device_, session, group_id))
               .with_logging()
           << "Failed to delete multicast group for request "
           << entry.ShortDebugString() << ".";
-      RETURN_IF_ERROR_WITH_APPEND(
-          bf_sde_interface_->DeleteMulticastNodes(device_, session, node_ids))
+      multicast_groups_.erase(group_id);
+      RETURN_IF_ERROR_WITH_APPEND(DeleteMulticastNodes(session, node_ids))
               .with_logging()
           << "Failed to delete multicast nodes for request "
           << entry.ShortDebugString() << ".";
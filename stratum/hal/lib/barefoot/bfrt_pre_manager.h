@@ -6,6 +6,7 @@
 #include <memory>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/synchronization/mutex.h"
 #include "p4/v1/p4runtime.grpc.pb.h"
@@ -15,6 +16,7 @@
 #include "stratum/glue/status/statusor.h"
 #include "stratum/hal/lib/barefoot/bf.pb.h"
 #include "stratum/hal/lib/barefoot/bf_sde_interface.h"
+#include "stratum/hal/lib/barefoot/bfrt_id_allocator.h"
 #include "stratum/hal/lib/barefoot/bfrt_p4runtime_translator.h"
 #include "stratum/hal/lib/common/common.pb.h"
 #include "stratum/hal/lib/common/writer_interface.h"
@@ -54,6 +56,16 @@ class BfrtPreManager {
   BfrtPreManager();
 
  private:
+  // A multicast node of a group, as written to the $pre.node table.
+  struct MulticastNode {
+    uint32 mc_node_id;
+    // Egress ports of the node, sorted.
+    std::vector<uint32> ports;
+  };
+
+  // Multicast nodes of a group, keyed by replication ID (replica instance).
+  using MulticastGroupNodes = absl::flat_hash_map<uint32, MulticastNode>;
+
   // Private constructor, we can create the instance by using `CreateInstance`
   // function only.
   explicit BfrtPreManager(BfSdeInterface* bf_sde_interface,
@@ -89,12 +101,42 @@ class BfrtPreManager {
       WriterInterface<::p4::v1::ReadResponse>* writer)
       SHARED_LOCKS_REQUIRED(lock_);
 
-  // Insert new multicast nodes of a given multicast group.
-  ::util::StatusOr<std::vector<uint32>> InsertMulticastNodes(
+  // Modifies a multicast group by creating, updating and deleting only the
+  // multicast nodes whose replicas changed. Partial modifications are reverted
+  // on failure.
+  ::util::Status ModifyMulticastGroup(
       std::shared_ptr<BfSdeInterface::SessionInterface> session,
       const ::p4::v1::MulticastGroupEntry& entry)
       EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
+  // Insert one new multicast node per instance and add them to nodes. Nodes
+  // inserted by this call are deleted again on failure.
+  ::util::Status InsertMulticastNodes(
+      std::shared_ptr<BfSdeInterface::SessionInterface> session,
+      const absl::flat_hash_map<uint32, std::vector<uint32>>&
+          instance_to_egress_ports,
+      MulticastGroupNodes* nodes) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Returns the multicast nodes of the given group, from the shadow state or
+  // read from the hardware if the group is not known. Nodes which can not be
+  // represented in MulticastGroupNodes, i.e. a second node with the same
+  // replication ID, are returned in other_node_ids.
+  ::util::Status GetMulticastGroupNodes(
+      std::shared_ptr<BfSdeInterface::SessionInterface> session,
+      uint32 group_id, MulticastGroupNodes* nodes,
+      std::vector<uint32>* other_node_ids) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Delete the given multicast nodes and return their IDs to the allocator.
+  ::util::Status DeleteMulticastNodes(
+      std::shared_ptr<BfSdeInterface::SessionInterface> session,
+      const std::vector<uint32>& mc_node_ids) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Rebuilds the multicast node ID allocator from the $pre.node table, if it
+  // is not in sync with the hardware, e.g. after a pipeline push.
+  ::util::Status SyncMulticastNodeIds(
+      std::shared_ptr<BfSdeInterface::SessionInterface> session)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
   // Reader-writer lock used to protect access to pipeline state.
   mutable absl::Mutex lock_;
 
@@ -105,6 +147,17 @@ class BfrtPreManager {
   // entities, not owned by this class.
   BfrtP4RuntimeTranslator* bfrt_p4runtime_translator_ = nullptr;
 
+  // Allocator for the IDs of the multicast nodes in the $pre.node table.
+  IdAllocator mc_node_id_allocator_ GUARDED_BY(lock_);
+
+  // True if mc_node_id_allocator_ reflects the IDs used in the hardware.
+  bool mc_node_ids_synced_ GUARDED_BY(lock_);
+
+  // Shadow of the multicast nodes of every group written by this class,
+  // keyed by multicast group ID.
+  absl::flat_hash_map<uint32, MulticastGroupNodes> multicast_groups_
+      GUARDED_BY(lock_);
+
   // Fixed zero-based Tofino device number corresponding to the node/ASIC
   // managed by this class instance. Assigned in the class constructor.
   const int device_;
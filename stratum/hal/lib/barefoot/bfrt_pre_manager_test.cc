@@ -14,6 +14,7 @@
 #include "stratum/hal/lib/common/writer_mock.h"
 #include "stratum/lib/test_utils/matchers.h"
 #include "stratum/lib/utils.h"
+#include "stratum/public/lib/error.h"
 
 namespace stratum {
 namespace hal {
@@ -26,6 +27,7 @@ using ::testing::HasSubstr;
 using ::testing::Invoke;
 using ::testing::InvokeWithoutArgs;
 using ::testing::Return;
+using ::testing::SaveArg;
 using ::testing::SetArgPointee;
 using ::testing::StrictMock;
 using ::testing::UnorderedElementsAreArray;
@@ -79,19 +81,24 @@ TEST_F(BfrtPreManagerTest, InsertMulticastGroupSuccess) {
   const std::vector<uint32> egress_ports_group1 = {1, 2};
   const std::vector<uint32> egress_ports_group2 = {3};
   const std::vector<uint32> instances = {789, 654};
-  const std::vector<uint32> mc_node_ids = {9864, 1234};
+  const std::vector<uint32> existing_mc_node_ids = {0, 1};
+  // The lowest free node IDs are used for the new nodes.
+  const std::vector<uint32> mc_node_ids = {2, 3};
   auto session_mock = std::make_shared<SessionMock>();
 
+  EXPECT_CALL(*bf_sde_wrapper_mock_, GetMulticastNodeIds(kDevice1, _, _))
+      .WillOnce(DoAll(SetArgPointee<2>(existing_mc_node_ids),
+                      Return(::util::OkStatus())));
   EXPECT_CALL(
       *bf_sde_wrapper_mock_,
-      CreateMulticastNode(kDevice1, _, instances[0], _,
+      InsertMulticastNode(kDevice1, _, _, instances[0], _,
                           UnorderedElementsAreArray(egress_ports_group1)))
-      .WillOnce(Return(mc_node_ids[0]));
+      .WillOnce(Return(::util::OkStatus()));
   EXPECT_CALL(
       *bf_sde_wrapper_mock_,
-      CreateMulticastNode(kDevice1, _, instances[1], _,
+      InsertMulticastNode(kDevice1, _, _, instances[1], _,
                           UnorderedElementsAreArray(egress_ports_group2)))
-      .WillOnce(Return(mc_node_ids[1]));
+      .WillOnce(Return(::util::OkStatus()));
   EXPECT_CALL(*bf_sde_wrapper_mock_,
               InsertMulticastGroup(kDevice1, _, kGroupId,
                                    UnorderedElementsAreArray(mc_node_ids)))
@@ -126,34 +133,43 @@ TEST_F(BfrtPreManagerTest, ModifyMulticastGroupSuccess) {
     }
   )pb";
   constexpr int kGroupId = 55;
-  const std::vector<uint32> egress_ports_group1 = {5, 6};
-  const std::vector<uint32> egress_ports_group2 = {7};
-  const std::vector<uint32> instances = {432, 987};
   const std::vector<uint32> old_mc_node_ids = {1234, 9864};
-  const std::vector<uint32> new_mc_node_ids = {6543, 3210};
+  const std::vector<uint32> new_mc_node_ids = {1234, 0};
   auto session_mock = std::make_shared<SessionMock>();
 
+  // The group is not known yet, its nodes are read from the hardware.
+  EXPECT_CALL(*bf_sde_wrapper_mock_, GetMulticastNodeIds(kDevice1, _, _))
+      .WillOnce(DoAll(SetArgPointee<2>(old_mc_node_ids),
+                      Return(::util::OkStatus())));
   EXPECT_CALL(*bf_sde_wrapper_mock_,
               GetNodesInMulticastGroup(kDevice1, _, kGroupId))
       .WillOnce(Return(old_mc_node_ids));
   EXPECT_CALL(*bf_sde_wrapper_mock_,
-              DeleteMulticastNodes(kDevice1, _,
-                                   UnorderedElementsAreArray(old_mc_node_ids)))
+              GetMulticastNode(kDevice1, _, 1234, _, _, _))
+      .WillOnce(DoAll(SetArgPointee<3>(432),
+                      SetArgPointee<5>(std::vector<uint32>{5}),
+                      Return(::util::OkStatus())));
+  EXPECT_CALL(*bf_sde_wrapper_mock_,
+              GetMulticastNode(kDevice1, _, 9864, _, _, _))
+      .WillOnce(DoAll(SetArgPointee<3>(111),
+                      SetArgPointee<5>(std::vector<uint32>{9}),
+                      Return(::util::OkStatus())));
+  // Instance 432 is updated in place, 987 is new and 111 is removed.
+  EXPECT_CALL(*bf_sde_wrapper_mock_,
+              ModifyMulticastNode(kDevice1, _, 1234, 432, _,
+                                  std::vector<uint32>{5, 6}))
+      .WillOnce(Return(::util::OkStatus()));
+  EXPECT_CALL(*bf_sde_wrapper_mock_,
+              InsertMulticastNode(kDevice1, _, 0, 987, _,
+                                  std::vector<uint32>{7}))
       .WillOnce(Return(::util::OkStatus()));
-  EXPECT_CALL(
-      *bf_sde_wrapper_mock_,
-      CreateMulticastNode(kDevice1, _, instances[0], _,
-                          UnorderedElementsAreArray(egress_ports_group1)))
-      .WillOnce(Return(new_mc_node_ids[0]));
-  EXPECT_CALL(
-      *bf_sde_wrapper_mock_,
-      CreateMulticastNode(kDevice1, _, instances[1], _,
-                          UnorderedElementsAreArray(egress_ports_group2)))
-      .WillOnce(Return(new_mc_node_ids[1]));
   EXPECT_CALL(*bf_sde_wrapper_mock_,
               ModifyMulticastGroup(kDevice1, _, kGroupId,
                                    UnorderedElementsAreArray(new_mc_node_ids)))
       .WillOnce(Return(::util::OkStatus()));
+  EXPECT_CALL(*bf_sde_wrapper_mock_,
+              DeleteMulticastNodes(kDevice1, _, std::vector<uint32>{9864}))
+      .WillOnce(Return(::util::OkStatus()));
 
   ::p4::v1::PacketReplicationEngineEntry entry;
   ASSERT_OK(ParseProtoFromString(kMulticastGroupEntryText, &entry));
@@ -165,6 +181,148 @@ TEST_F(BfrtPreManagerTest, ModifyMulticastGroupSuccess) {
                                              ::p4::v1::Update::MODIFY, entry));
 }
 
+TEST_F(BfrtPreManagerTest, ModifyMulticastGroupOnlyUpdatesChangedNodes) {
+  const std::string kInsertEntryText = R"pb(
+    multicast_group_entry {
+      multicast_group_id: 55
+      replicas {
+        egress_port: 1
+        instance: 1
+      }
+      replicas {
+        egress_port: 2
+        instance: 2
+      }
+    }
+  )pb";
+  const std::string kModifyEntryText = R"pb(
+    multicast_group_entry {
+      multicast_group_id: 55
+      replicas {
+        egress_port: 1
+        instance: 1
+      }
+      replicas {
+        egress_port: 3
+        instance: 2
+      }
+      replicas {
+        egress_port: 2
+        instance: 2
+      }
+    }
+  )pb";
+  constexpr int kGroupId = 55;
+  auto session_mock = std::make_shared<SessionMock>();
+
+  EXPECT_CALL(*bf_sde_wrapper_mock_, GetMulticastNodeIds(kDevice1, _, _))
+      .WillOnce(Return(::util::OkStatus()));
+  uint32 instance_2_node_id = 0;
+  uint32 modified_node_id = 1;
+  EXPECT_CALL(*bf_sde_wrapper_mock_,
+              InsertMulticastNode(kDevice1, _, _, 1, _, _))
+      .WillOnce(Return(::util::OkStatus()));
+  EXPECT_CALL(*bf_sde_wrapper_mock_,
+              InsertMulticastNode(kDevice1, _, _, 2, _, _))
+      .WillOnce(DoAll(SaveArg<2>(&instance_2_node_id),
+                      Return(::util::OkStatus())));
+  EXPECT_CALL(*bf_sde_wrapper_mock_,
+              InsertMulticastGroup(kDevice1, _, kGroupId, _))
+      .WillOnce(Return(::util::OkStatus()));
+  // Only the ports of the node of instance 2 change, the group itself and the
+  // node of instance 1 are not touched and nothing is read from the hardware.
+  EXPECT_CALL(*bf_sde_wrapper_mock_,
+              ModifyMulticastNode(kDevice1, _, _, 2, _,
+                                  std::vector<uint32>{2, 3}))
+      .WillOnce(DoAll(SaveArg<2>(&modified_node_id),
+                      Return(::util::OkStatus())));
+
+  ::p4::v1::PacketReplicationEngineEntry insert_entry;
+  ASSERT_OK(ParseProtoFromString(kInsertEntryText, &insert_entry));
+  ::p4::v1::PacketReplicationEngineEntry modify_entry;
+  ASSERT_OK(ParseProtoFromString(kModifyEntryText, &modify_entry));
+  EXPECT_CALL(*bfrt_p4runtime_translator_mock_,
+              TranslatePacketReplicationEngineEntry(_, true))
+      .WillOnce(Return(
+          ::util::StatusOr<::p4::v1::PacketReplicationEngineEntry>(
+              insert_entry)))
+      .WillOnce(Return(
+          ::util::StatusOr<::p4::v1::PacketReplicationEngineEntry>(
+              modify_entry)));
+
+  EXPECT_OK(bfrt_pre_manager_->WritePreEntry(
+      session_mock, ::p4::v1::Update::INSERT, insert_entry));
+  EXPECT_OK(bfrt_pre_manager_->WritePreEntry(
+      session_mock, ::p4::v1::Update::MODIFY, modify_entry));
+  EXPECT_EQ(instance_2_node_id, modified_node_id);
+}
+
+TEST_F(BfrtPreManagerTest, ModifyMulticastGroupRevertsOnFailure) {
+  const std::string kMulticastGroupEntryText = R"pb(
+    multicast_group_entry {
+      multicast_group_id: 55
+      replicas {
+        egress_port: 5
+        instance: 432
+      }
+      replicas {
+        egress_port: 6
+        instance: 432
+      }
+      replicas {
+        egress_port: 7
+        instance: 987
+      }
+    }
+  )pb";
+  constexpr int kGroupId = 55;
+  const std::vector<uint32> old_mc_node_ids = {1234};
+  auto session_mock = std::make_shared<SessionMock>();
+
+  EXPECT_CALL(*bf_sde_wrapper_mock_, GetMulticastNodeIds(kDevice1, _, _))
+      .WillOnce(DoAll(SetArgPointee<2>(old_mc_node_ids),
+                      Return(::util::OkStatus())));
+  EXPECT_CALL(*bf_sde_wrapper_mock_,
+              GetNodesInMulticastGroup(kDevice1, _, kGroupId))
+      .WillOnce(Return(old_mc_node_ids));
+  EXPECT_CALL(*bf_sde_wrapper_mock_,
+              GetMulticastNode(kDevice1, _, 1234, _, _, _))
+      .WillOnce(DoAll(SetArgPointee<3>(432),
+                      SetArgPointee<5>(std::vector<uint32>{5}),
+                      Return(::util::OkStatus())));
+  EXPECT_CALL(*bf_sde_wrapper_mock_,
+              InsertMulticastNode(kDevice1, _, 0, 987, _,
+                                  std::vector<uint32>{7}))
+      .WillOnce(Return(::util::OkStatus()));
+  EXPECT_CALL(*bf_sde_wrapper_mock_,
+              ModifyMulticastNode(kDevice1, _, 1234, 432, _,
+                                  std::vector<uint32>{5, 6}))
+      .WillOnce(Return(::util::OkStatus()));
+  EXPECT_CALL(*bf_sde_wrapper_mock_,
+              ModifyMulticastGroup(kDevice1, _, kGroupId, _))
+      .WillOnce(
+          Return(::util::Status(StratumErrorSpace(), ERR_INTERNAL, "Error.")));
+  // The updated node is restored and the new node is deleted again.
+  EXPECT_CALL(*bf_sde_wrapper_mock_,
+              ModifyMulticastNode(kDevice1, _, 1234, 432, _,
+                                  std::vector<uint32>{5}))
+      .WillOnce(Return(::util::OkStatus()));
+  EXPECT_CALL(*bf_sde_wrapper_mock_,
+              DeleteMulticastNodes(kDevice1, _, std::vector<uint32>{0}))
+      .WillOnce(Return(::util::OkStatus()));
+
+  ::p4::v1::PacketReplicationEngineEntry entry;
+  ASSERT_OK(ParseProtoFromString(kMulticastGroupEntryText, &entry));
+  EXPECT_CALL(*bfrt_p4runtime_translator_mock_,
+              TranslatePacketReplicationEngineEntry(EqualsProto(entry), true))
+      .WillOnce(Return(
+          ::util::StatusOr<::p4::v1::PacketReplicationEngineEntry>(entry)));
+  ::util::Status status = bfrt_pre_manager_->WritePreEntry(
+      session_mock, ::p4::v1::Update::MODIFY, entry);
+  EXPECT_FALSE(status.ok());
+  EXPECT_THAT(status.error_message(), HasSubstr("Error."));
+}
+
 TEST_F(BfrtPreManagerTest, DeleteMulticastGroupSuccess) {
   const std::string kMulticastGroupEntryText = R"pb(
     multicast_group_entry {
@@ -175,6 +333,8 @@ TEST_F(BfrtPreManagerTest, DeleteMulticastGroupSuccess) {
   const std::vector<uint32> nodes = {1, 2, 3};
   auto session_mock = std::make_shared<SessionMock>();
 
+  EXPECT_CALL(*bf_sde_wrapper_mock_, GetMulticastNodeIds(kDevice1, _, _))
+      .WillOnce(DoAll(SetArgPointee<2>(nodes), Return(::util::OkStatus())));
   EXPECT_CALL(*bf_sde_wrapper_mock_,
               GetNodesInMulticastGroup(kDevice1, _, kGroupId))
       .WillOnce(Return(nodes));
@@ -196,6 +356,63 @@ TEST_F(BfrtPreManagerTest, DeleteMulticastGroupSuccess) {
                                              ::p4::v1::Update::DELETE, entry));
 }
 
+TEST_F(BfrtPreManagerTest, MulticastNodeIdsAreReusedAfterDelete) {
+  const std::string kDeleteEntryText = R"pb(
+    multicast_group_entry {
+      multicast_group_id: 55
+    }
+  )pb";
+  const std::string kInsertEntryText = R"pb(
+    multicast_group_entry {
+      multicast_group_id: 66
+      replicas {
+        egress_port: 1
+        instance: 1
+      }
+    }
+  )pb";
+  const std::vector<uint32> existing_nodes = {0, 1, 2, 3};
+  const std::vector<uint32> deleted_nodes = {1, 2};
+  auto session_mock = std::make_shared<SessionMock>();
+
+  // The node IDs are read from the hardware on the first write only.
+  EXPECT_CALL(*bf_sde_wrapper_mock_, GetMulticastNodeIds(kDevice1, _, _))
+      .WillOnce(DoAll(SetArgPointee<2>(existing_nodes),
+                      Return(::util::OkStatus())));
+  EXPECT_CALL(*bf_sde_wrapper_mock_, GetNodesInMulticastGroup(kDevice1, _, 55))
+      .WillOnce(Return(deleted_nodes));
+  EXPECT_CALL(*bf_sde_wrapper_mock_, DeleteMulticastGroup(kDevice1, _, 55))
+      .WillOnce(Return(::util::OkStatus()));
+  EXPECT_CALL(*bf_sde_wrapper_mock_,
+              DeleteMulticastNodes(kDevice1, _, deleted_nodes))
+      .WillOnce(Return(::util::OkStatus()));
+  EXPECT_CALL(*bf_sde_wrapper_mock_,
+              InsertMulticastNode(kDevice1, _, 1, 1, _,
+                                  std::vector<uint32>{1}))
+      .WillOnce(Return(::util::OkStatus()));
+  EXPECT_CALL(*bf_sde_wrapper_mock_,
+              InsertMulticastGroup(kDevice1, _, 66, std::vector<uint32>{1}))
+      .WillOnce(Return(::util::OkStatus()));
+
+  ::p4::v1::PacketReplicationEngineEntry delete_entry;
+  ASSERT_OK(ParseProtoFromString(kDeleteEntryText, &delete_entry));
+  ::p4::v1::PacketReplicationEngineEntry insert_entry;
+  ASSERT_OK(ParseProtoFromString(kInsertEntryText, &insert_entry));
+  EXPECT_CALL(*bfrt_p4runtime_translator_mock_,
+              TranslatePacketReplicationEngineEntry(_, true))
+      .WillOnce(Return(
+          ::util::StatusOr<::p4::v1::PacketReplicationEngineEntry>(
+              delete_entry)))
+      .WillOnce(Return(
+          ::util::StatusOr<::p4::v1::PacketReplicationEngineEntry>(
+              insert_entry)));
+
+  EXPECT_OK(bfrt_pre_manager_->WritePreEntry(
+      session_mock, ::p4::v1::Update::DELETE, delete_entry));
+  EXPECT_OK(bfrt_pre_manager_->WritePreEntry(
+      session_mock, ::p4::v1::Update::INSERT, insert_entry));
+}
+
 TEST_F(BfrtPreManagerTest, ReadMulticastGroupSuccess) {
   auto session_mock = std::make_shared<SessionMock>();
   WriterMock<::p4::v1::ReadResponse> writer_mock;
@@ -62,6 +62,27 @@ BfrtSwitch::~BfrtSwitch() {}
   return ::util::OkStatus();
 }
 
+::util::Status BfrtSwitch::PushChassisConfigDelta(
+    const ChassisConfig& config, const ChassisConfigDelta& delta) {
+  {
+    absl::WriterMutexLock l(&chassis_lock);
+    // Changes to existing singleton ports only concern BfChassisManager, as
+    // the port layout seen by the nodes cannot change at runtime. Anything
+    // else, or a switch which has not been configured yet, needs a full push.
+    if (delta.OnlyModifiesSingletonPorts() && !node_id_to_bfrt_node_.empty()) {
+      RETURN_IF_ERROR(DoVerifyChassisConfig(config));
+      RETURN_IF_ERROR(
+          bf_chassis_manager_->PushChassisConfigDelta(config, delta));
+      LOG(INFO) << "Chassis config pushed successfully ("
+                << delta.modified_singleton_ports.size()
+                << " singleton ports changed).";
+      return ::util::OkStatus();
+    }
+  }
+
+  return PushChassisConfig(config);
+}
+
 ::util::Status BfrtSwitch::VerifyChassisConfig(const ChassisConfig& config) {
   absl::ReaderMutexLock l(&chassis_lock);
   return DoVerifyChassisConfig(config);
@@ -27,6 +27,9 @@ class BfrtSwitch : public SwitchInterface {
   // SwitchInterface public methods.
   ::util::Status PushChassisConfig(const ChassisConfig& config) override
       LOCKS_EXCLUDED(chassis_lock);
+  ::util::Status PushChassisConfigDelta(
+      const ChassisConfig& config, const ChassisConfigDelta& delta) override
+      LOCKS_EXCLUDED(chassis_lock);
   ::util::Status VerifyChassisConfig(const ChassisConfig& config) override
       LOCKS_EXCLUDED(chassis_lock);
   ::util::Status PushForwardingPipelineConfig(
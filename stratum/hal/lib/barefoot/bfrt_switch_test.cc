@@ -115,6 +115,90 @@ class BfrtSwitchTest : public ::testing::Test {
 
 TEST_F(BfrtSwitchTest, PushChassisConfigSuccess) { PushChassisConfigSuccess(); }
 
+TEST_F(BfrtSwitchTest, PushChassisConfigDeltaOnlyUpdatesModifiedPorts) {
+  PushChassisConfigSuccess();
+
+  ChassisConfig config;
+  config.add_nodes()->set_id(kNodeId);
+  ChassisConfigDelta delta;
+  SingletonPort* singleton_port = config.add_singleton_ports();
+  singleton_port->set_id(kPortId);
+  singleton_port->set_node(kNodeId);
+  delta.modified_singleton_ports.push_back(*singleton_port);
+  delta.changed_node_ids.insert(kNodeId);
+
+  EXPECT_CALL(*phal_mock_, PushChassisConfig(_)).Times(0);
+  EXPECT_CALL(*bf_chassis_manager_mock_, PushChassisConfig(_)).Times(0);
+  EXPECT_CALL(*bfrt_node_mock_, PushChassisConfig(_, _)).Times(0);
+  {
+    InSequence sequence;
+    EXPECT_CALL(*phal_mock_, VerifyChassisConfig(EqualsProto(config)))
+        .WillOnce(Return(::util::OkStatus()));
+    EXPECT_CALL(*bf_chassis_manager_mock_,
+                VerifyChassisConfig(EqualsProto(config)))
+        .WillOnce(Return(::util::OkStatus()));
+    EXPECT_CALL(*bfrt_node_mock_,
+                VerifyChassisConfig(EqualsProto(config), kNodeId))
+        .WillOnce(Return(::util::OkStatus()));
+    EXPECT_CALL(*bf_chassis_manager_mock_,
+                PushChassisConfigDelta(EqualsProto(config), _))
+        .WillOnce(Return(::util::OkStatus()));
+  }
+  EXPECT_OK(bfrt_switch_->PushChassisConfigDelta(config, delta));
+}
+
+TEST_F(BfrtSwitchTest, PushChassisConfigDeltaFailureWhenVerifyFails) {
+  PushChassisConfigSuccess();
+
+  ChassisConfig config;
+  config.add_nodes()->set_id(kNodeId);
+  ChassisConfigDelta delta;
+  SingletonPort* singleton_port = config.add_singleton_ports();
+  singleton_port->set_id(kPortId);
+  singleton_port->set_node(kNodeId);
+  delta.modified_singleton_ports.push_back(*singleton_port);
+  delta.changed_node_ids.insert(kNodeId);
+
+  EXPECT_CALL(*phal_mock_, VerifyChassisConfig(EqualsProto(config)))
+      .WillOnce(Return(::util::OkStatus()));
+  EXPECT_CALL(*bf_chassis_manager_mock_,
+              VerifyChassisConfig(EqualsProto(config)))
+      .WillOnce(Return(DefaultError()));
+  EXPECT_CALL(*bfrt_node_mock_,
+              VerifyChassisConfig(EqualsProto(config), kNodeId))
+      .WillOnce(Return(::util::OkStatus()));
+  EXPECT_CALL(*bf_chassis_manager_mock_, PushChassisConfigDelta(_, _))
+      .Times(0);
+  ::util::Status status = bfrt_switch_->PushChassisConfigDelta(config, delta);
+  ASSERT_FALSE(status.ok());
+  EXPECT_THAT(status.error_message(), HasSubstr(kErrorMsg));
+}
+
+TEST_F(BfrtSwitchTest, PushChassisConfigDeltaFallsBackToFullPush) {
+  ChassisConfig config;
+  config.add_nodes()->set_id(kNodeId);
+  ChassisConfigDelta delta;
+  delta.other_changed = true;
+
+  EXPECT_CALL(*bf_chassis_manager_mock_, PushChassisConfigDelta(_, _))
+      .Times(0);
+  EXPECT_CALL(*phal_mock_, VerifyChassisConfig(EqualsProto(config)))
+      .WillOnce(Return(::util::OkStatus()));
+  EXPECT_CALL(*bf_chassis_manager_mock_,
+              VerifyChassisConfig(EqualsProto(config)))
+      .WillOnce(Return(::util::OkStatus()));
+  EXPECT_CALL(*bfrt_node_mock_,
+              VerifyChassisConfig(EqualsProto(config), kNodeId))
+      .WillOnce(Return(::util::OkStatus()));
+  EXPECT_CALL(*phal_mock_, PushChassisConfig(EqualsProto(config)))
+      .WillOnce(Return(::util::OkStatus()));
+  EXPECT_CALL(*bf_chassis_manager_mock_, PushChassisConfig(EqualsProto(config)))
+      .WillOnce(Return(::util::OkStatus()));
+  EXPECT_CALL(*bfrt_node_mock_, PushChassisConfig(EqualsProto(config), kNodeId))
+      .WillOnce(Return(::util::OkStatus()));
+  EXPECT_OK(bfrt_switch_->PushChassisConfigDelta(config, delta));
+}
+
 TEST_F(BfrtSwitchTest, PushChassisConfigFailureWhenPhalVerifyFails) {
   ChassisConfig config;
   config.add_nodes()->set_id(kNodeId);
@@ -22,6 +22,19 @@ DEFINE_uint32(
     bfrt_table_sync_timeout_ms,
     stratum::hal::barefoot::kDefaultSyncTimeout / absl::Milliseconds(1),
     "The timeout for table sync operation like counters and registers.");
+DEFINE_uint32(bfrt_counter_sync_max_staleness_ms, 0,
+              "The max age of a table counter sync which can be reused by "
+              "wildcard table reads with counter data, instead of syncing the "
+              "table counters again. Concurrent readers share in-flight "
+              "syncs within this age. 0 always requires a fresh sync.");
+DEFINE_uint32(bfrt_table_read_batch_size, 1000,
+              "The max number of table entries fetched from the SDE at once "
+              "during wildcard table reads. Each batch is sent to the client "
+              "in its own ReadResponse.");
+DEFINE_uint32(bfrt_table_read_max_response_bytes, 1024 * 1024,
+              "The size in bytes after which a ReadResponse is sent to the "
+              "client during wildcard table reads, even if the current batch "
+              "of table entries is not complete yet.");
 
 namespace stratum {
 namespace hal {
@@ -77,10 +90,10 @@ std::unique_ptr<BfrtTableManager> BfrtTableManager::CreateInstance(
     BfSdeInterface::TableKeyInterface* table_key) {
   RET_CHECK(table_key);
   bool needs_priority = false;
-  ASSIGN_OR_RETURN(auto table,
-                   p4_info_manager_->FindTableByID(table_entry.table_id()));
+  ASSIGN_OR_RETURN(const auto* table,
+                   p4_info_manager_->FindTablePtrByID(table_entry.table_id()));
 
-  for (const auto& expected_match_field : table.match_fields()) {
+  for (const auto& expected_match_field : table->match_fields()) {
     needs_priority = needs_priority ||
                      expected_match_field.match_type() ==
                          ::p4::config::v1::MatchField::TERNARY ||
@@ -244,6 +257,15 @@ std::unique_ptr<BfrtTableManager> BfrtTableManager::CreateInstance(
     std::shared_ptr<BfSdeInterface::SessionInterface> session,
     const ::p4::v1::Update::Type type,
     const ::p4::v1::TableEntry& table_entry) {
+  PreparedTableEntryWrite prepared;
+  RETURN_IF_ERROR(PrepareTableEntryWrite(type, table_entry, &prepared));
+
+  return ApplyTableEntryWrite(session, prepared);
+}
+
+::util::Status BfrtTableManager::PrepareTableEntryWrite(
+    const ::p4::v1::Update::Type type, const ::p4::v1::TableEntry& table_entry,
+    PreparedTableEntryWrite* prepared) {
   RET_CHECK(type != ::p4::v1::Update::UNSPECIFIED)
       << "Invalid update type " << type;
   absl::ReaderMutexLock l(&lock_);
@@ -251,46 +273,38 @@ std::unique_ptr<BfrtTableManager> BfrtTableManager::CreateInstance(
                    bfrt_p4runtime_translator_->TranslateTableEntry(
                        table_entry, /*to_sdk=*/true));
 
-  ASSIGN_OR_RETURN(auto table, p4_info_manager_->FindTableByID(
-                                   translated_table_entry.table_id()));
+  ASSIGN_OR_RETURN(const auto* table, p4_info_manager_->FindTablePtrByID(
+                                          translated_table_entry.table_id()));
   ASSIGN_OR_RETURN(uint32 table_id, bf_sde_interface_->GetBfRtId(
                                         translated_table_entry.table_id()));
+  prepared->type = type;
+  prepared->table_id = table_id;
+  prepared->is_default_action = translated_table_entry.is_default_action();
 
   if (!translated_table_entry.is_default_action()) {
-    if (table.is_const_table()) {
+    if (table->is_const_table()) {
       return MAKE_ERROR(ERR_PERMISSION_DENIED)
-             << "Can't write to table " << table.preamble().name()
+             << "Can't write to table " << table->preamble().name()
              << " because it has const entries.";
     }
-    ASSIGN_OR_RETURN(auto table_key,
+    if (type != ::p4::v1::Update::INSERT && type != ::p4::v1::Update::MODIFY &&
+        type != ::p4::v1::Update::DELETE) {
+      return MAKE_ERROR(ERR_INTERNAL)
+             << "Unsupported update type: " << type << " in table entry "
+             << translated_table_entry.ShortDebugString() << ".";
+    }
+    ASSIGN_OR_RETURN(prepared->table_key,
                      bf_sde_interface_->CreateTableKey(table_id));
-    RETURN_IF_ERROR(BuildTableKey(translated_table_entry, table_key.get()));
+    RETURN_IF_ERROR(
+        BuildTableKey(translated_table_entry, prepared->table_key.get()));
 
     ASSIGN_OR_RETURN(
-        auto table_data,
+        prepared->table_data,
         bf_sde_interface_->CreateTableData(
             table_id, translated_table_entry.action().action().action_id()));
     if (type == ::p4::v1::Update::INSERT || type == ::p4::v1::Update::MODIFY) {
-      RETURN_IF_ERROR(BuildTableData(translated_table_entry, table_data.get()));
-    }
-
-    switch (type) {
-      case ::p4::v1::Update::INSERT:
-        RETURN_IF_ERROR(bf_sde_interface_->InsertTableEntry(
-            device_, session, table_id, table_key.get(), table_data.get()));
-        break;
-      case ::p4::v1::Update::MODIFY:
-        RETURN_IF_ERROR(bf_sde_interface_->ModifyTableEntry(
-            device_, session, table_id, table_key.get(), table_data.get()));
-        break;
-      case ::p4::v1::Update::DELETE:
-        RETURN_IF_ERROR(bf_sde_interface_->DeleteTableEntry(
-            device_, session, table_id, table_key.get()));
-        break;
-      default:
-        return MAKE_ERROR(ERR_INTERNAL)
-               << "Unsupported update type: " << type << " in table entry "
-               << translated_table_entry.ShortDebugString() << ".";
+      RETURN_IF_ERROR(
+          BuildTableData(translated_table_entry, prepared->table_data.get()));
     }
   } else {
     RET_CHECK(type == ::p4::v1::Update::MODIFY)
@@ -302,16 +316,48 @@ std::unique_ptr<BfrtTableManager> BfrtTableManager::CreateInstance(
 
     if (translated_table_entry.has_action()) {
       ASSIGN_OR_RETURN(
-          auto table_data,
+          prepared->table_data,
           bf_sde_interface_->CreateTableData(
               table_id, translated_table_entry.action().action().action_id()));
-      RETURN_IF_ERROR(BuildTableData(translated_table_entry, table_data.get()));
-      RETURN_IF_ERROR(bf_sde_interface_->SetDefaultTableEntry(
-          device_, session, table_id, table_data.get()));
-    } else {
-      RETURN_IF_ERROR(bf_sde_interface_->ResetDefaultTableEntry(
-          device_, session, table_id));
+      RETURN_IF_ERROR(
+          BuildTableData(translated_table_entry, prepared->table_data.get()));
+    }
+  }
+
+  return ::util::OkStatus();
+}
+
+::util::Status BfrtTableManager::ApplyTableEntryWrite(
+    std::shared_ptr<BfSdeInterface::SessionInterface> session,
+    const PreparedTableEntryWrite& prepared) {
+  if (prepared.is_default_action) {
+    if (prepared.table_data) {
+      return bf_sde_interface_->SetDefaultTableEntry(
+          device_, session, prepared.table_id, prepared.table_data.get());
     }
+    return bf_sde_interface_->ResetDefaultTableEntry(device_, session,
+                                                     prepared.table_id);
+  }
+
+  RET_CHECK(prepared.table_key) << "Table entry write was not prepared.";
+  switch (prepared.type) {
+    case ::p4::v1::Update::INSERT:
+      RETURN_IF_ERROR(bf_sde_interface_->InsertTableEntry(
+          device_, session, prepared.table_id, prepared.table_key.get(),
+          prepared.table_data.get()));
+      break;
+    case ::p4::v1::Update::MODIFY:
+      RETURN_IF_ERROR(bf_sde_interface_->ModifyTableEntry(
+          device_, session, prepared.table_id, prepared.table_key.get(),
+          prepared.table_data.get()));
+      break;
+    case ::p4::v1::Update::DELETE:
+      RETURN_IF_ERROR(bf_sde_interface_->DeleteTableEntry(
+          device_, session, prepared.table_id, prepared.table_key.get()));
+      break;
+    default:
+      return MAKE_ERROR(ERR_INTERNAL)
+             << "Unsupported update type: " << prepared.type << ".";
   }
 
   return ::util::OkStatus();
@@ -325,13 +371,13 @@ std::unique_ptr<BfrtTableManager> BfrtTableManager::CreateInstance(
     const BfSdeInterface::TableDataInterface* table_data) {
   ::p4::v1::TableEntry result;
 
-  ASSIGN_OR_RETURN(auto table,
-                   p4_info_manager_->FindTableByID(request.table_id()));
+  ASSIGN_OR_RETURN(const auto* table,
+                   p4_info_manager_->FindTablePtrByID(request.table_id()));
   result.set_table_id(request.table_id());
 
   bool has_priority_field = false;
   // Match keys
-  for (const auto& expected_match_field : table.match_fields()) {
+  for (const auto& expected_match_field : table->match_fields()) {
     ::p4::v1::FieldMatch match;  // Added to the entry later.
     match.set_field_id(expected_match_field.id());
     switch (expected_match_field.match_type()) {
@@ -408,9 +454,10 @@ std::unique_ptr<BfrtTableManager> BfrtTableManager::CreateInstance(
   RETURN_IF_ERROR(table_data->GetActionId(&action_id));
   // TODO(max): perform check if action id is valid for this table.
   if (action_id) {
-    ASSIGN_OR_RETURN(auto action, p4_info_manager_->FindActionByID(action_id));
+    ASSIGN_OR_RETURN(const auto* action,
+                     p4_info_manager_->FindActionPtrByID(action_id));
     result.mutable_action()->mutable_action()->set_action_id(action_id);
-    for (const auto& expected_param : action.params()) {
+    for (const auto& expected_param : action->params()) {
       std::string value;
       RETURN_IF_ERROR(table_data->GetParam(expected_param.id(), &value));
       auto* param = result.mutable_action()->mutable_action()->add_params();
@@ -522,27 +569,52 @@ std::unique_ptr<BfrtTableManager> BfrtTableManager::CreateInstance(
 
   ASSIGN_OR_RETURN(uint32 table_id,
                    bf_sde_interface_->GetBfRtId(table_entry.table_id()));
+
+  // Page through the table in batches, so that memory usage is bounded by the
+  // batch size and not by the table size. The key and data objects are reused
+  // for all batches.
+  const size_t batch_size = std::max(FLAGS_bfrt_table_read_batch_size, 1u);
   std::vector<std::unique_ptr<BfSdeInterface::TableKeyInterface>> keys;
   std::vector<std::unique_ptr<BfSdeInterface::TableDataInterface>> datas;
-  RETURN_IF_ERROR(bf_sde_interface_->GetAllTableEntries(
-      device_, session, table_id, &keys, &datas));
+  // Key of the last entry of the previous batch, the next batch starts after
+  // it. Null for the first batch.
+  std::unique_ptr<BfSdeInterface::TableKeyInterface> last_key;
   ::p4::v1::ReadResponse resp;
-  for (size_t i = 0; i < keys.size(); ++i) {
-    const std::unique_ptr<BfSdeInterface::TableKeyInterface>& table_key =
-        keys[i];
-    const std::unique_ptr<BfSdeInterface::TableDataInterface>& table_data =
-        datas[i];
-    ASSIGN_OR_RETURN(
-        auto result,
-        BuildP4TableEntry(table_entry, table_key.get(), table_data.get()));
-    ASSIGN_OR_RETURN(*resp.add_entities()->mutable_table_entry(),
-                     bfrt_p4runtime_translator_->TranslateTableEntry(
-                         result, /*to_sdk=*/false));
-  }
-
-  VLOG(1) << "ReadAllTableEntries resp " << resp.DebugString();
-  if (!writer->Write(resp)) {
-    return MAKE_ERROR(ERR_INTERNAL) << "Write to stream for failed.";
+  size_t resp_bytes = 0;
+  auto flush = [&]() -> ::util::Status {
+    if (resp.entities_size() == 0) return ::util::OkStatus();
+    VLOG(1) << "ReadAllTableEntries resp " << resp.DebugString();
+    if (!writer->Write(resp)) {
+      return MAKE_ERROR(ERR_INTERNAL) << "Write to stream for failed.";
+    }
+    resp.Clear();
+    resp_bytes = 0;
+    return ::util::OkStatus();
+  };
+  while (true) {
+    size_t num_entries = 0;
+    RETURN_IF_ERROR(bf_sde_interface_->GetTableEntriesBatch(
+        device_, session, table_id, last_key.get(), batch_size, &keys, &datas,
+        &num_entries));
+    RET_CHECK(num_entries <= keys.size() && num_entries <= datas.size());
+    for (size_t i = 0; i < num_entries; ++i) {
+      ASSIGN_OR_RETURN(
+          auto result,
+          BuildP4TableEntry(table_entry, keys[i].get(), datas[i].get()));
+      auto* entity = resp.add_entities();
+      ASSIGN_OR_RETURN(*entity->mutable_table_entry(),
+                       bfrt_p4runtime_translator_->TranslateTableEntry(
+                           result, /*to_sdk=*/false));
+      resp_bytes += entity->ByteSizeLong();
+      if (resp_bytes >= FLAGS_bfrt_table_read_max_response_bytes) {
+        RETURN_IF_ERROR(flush());
+      }
+    }
+    RETURN_IF_ERROR(flush());
+    if (num_entries < batch_size) break;
+    // Swap instead of copy, the previous start key object is reused in the
+    // next batch.
+    std::swap(last_key, keys[num_entries - 1]);
   }
 
   return ::util::OkStatus();
@@ -584,11 +656,16 @@ std::unique_ptr<BfrtTableManager> BfrtTableManager::CreateInstance(
     }
     // TODO(max): can wildcard reads request counter_data?
     if (translated_table_entry.has_counter_data()) {
+      // Sync the counters of all tables in parallel.
+      std::vector<uint32> table_ids;
+      table_ids.reserve(wanted_tables.size());
       for (const auto& wanted_table_entry : wanted_tables) {
-        RETURN_IF_ERROR(bf_sde_interface_->SynchronizeCounters(
-            device_, session, wanted_table_entry.table_id(),
-            absl::Milliseconds(FLAGS_bfrt_table_sync_timeout_ms)));
+        table_ids.push_back(wanted_table_entry.table_id());
       }
+      RETURN_IF_ERROR(bf_sde_interface_->SynchronizeCountersBatch(
+          device_, session, table_ids,
+          absl::Milliseconds(FLAGS_bfrt_table_sync_timeout_ms),
+          absl::Milliseconds(FLAGS_bfrt_counter_sync_max_staleness_ms)));
     }
     for (const auto& wanted_table_entry : wanted_tables) {
       RETURN_IF_ERROR_WITH_APPEND(
@@ -804,9 +881,10 @@ BfrtTableManager::ReadDirectCounterEntry(
   bool meter_units_in_bits;  // or packets
   {
     absl::ReaderMutexLock l(&lock_);
-    ASSIGN_OR_RETURN(auto meter, p4_info_manager_->FindMeterByID(
-                                     translated_meter_entry.meter_id()));
-    switch (meter.spec().unit()) {
+    ASSIGN_OR_RETURN(const auto* meter,
+                     p4_info_manager_->FindMeterPtrByID(
+                         translated_meter_entry.meter_id()));
+    switch (meter->spec().unit()) {
       case ::p4::config::v1::MeterSpec::BYTES:
         meter_units_in_bits = true;
         break;
@@ -815,8 +893,8 @@ BfrtTableManager::ReadDirectCounterEntry(
         break;
       default:
         return MAKE_ERROR(ERR_INVALID_PARAM)
-               << "Unsupported meter spec on meter " << meter.ShortDebugString()
-               << ".";
+               << "Unsupported meter spec on meter "
+               << meter->ShortDebugString() << ".";
     }
   }
   // Index 0 is a valid value and not a wildcard.
@@ -883,9 +961,10 @@ BfrtTableManager::ReadDirectCounterEntry(
   bool meter_units_in_packets;  // or bytes
   {
     absl::ReaderMutexLock l(&lock_);
-    ASSIGN_OR_RETURN(auto meter, p4_info_manager_->FindMeterByID(
-                                     translated_meter_entry.meter_id()));
-    switch (meter.spec().unit()) {
+    ASSIGN_OR_RETURN(const auto* meter,
+                     p4_info_manager_->FindMeterPtrByID(
+                         translated_meter_entry.meter_id()));
+    switch (meter->spec().unit()) {
       case ::p4::config::v1::MeterSpec::BYTES:
         meter_units_in_packets = false;
         break;
@@ -894,8 +973,8 @@ BfrtTableManager::ReadDirectCounterEntry(
         break;
       default:
         return MAKE_ERROR(ERR_INVALID_PARAM)
-               << "Unsupported meter spec on meter " << meter.ShortDebugString()
-               << ".";
+               << "Unsupported meter spec on meter "
+               << meter->ShortDebugString() << ".";
     }
   }
 
@@ -1014,8 +1093,9 @@ BfrtTableManager::ReadDirectCounterEntry(
 
     // Action data
     // TODO(max): perform check if action id is valid for this table.
-    ASSIGN_OR_RETURN(auto action, p4_info_manager_->FindActionByID(action_id));
-    for (const auto& expected_param : action.params()) {
+    ASSIGN_OR_RETURN(const auto* action,
+                     p4_info_manager_->FindActionPtrByID(action_id));
+    for (const auto& expected_param : action->params()) {
       std::string value;
       RETURN_IF_ERROR(table_data->GetParam(expected_param.id(), &value));
       auto* param = result.mutable_action()->add_params();
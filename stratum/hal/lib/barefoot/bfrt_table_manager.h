@@ -44,6 +44,32 @@ class BfrtTableManager {
       const ::p4::v1::Update::Type type,
       const ::p4::v1::TableEntry& table_entry) LOCKS_EXCLUDED(lock_);
 
+  // A table entry write translated to the SDK and converted into SDE table key
+  // and data objects, ready to be programmed by ApplyTableEntryWrite().
+  struct PreparedTableEntryWrite {
+    ::p4::v1::Update::Type type = ::p4::v1::Update::UNSPECIFIED;
+    // BfRt ID of the table.
+    uint32 table_id = 0;
+    // True for writes of the table default entry, which have no key.
+    bool is_default_action = false;
+    std::unique_ptr<BfSdeInterface::TableKeyInterface> table_key;
+    // Null if the default entry is reset.
+    std::unique_ptr<BfSdeInterface::TableDataInterface> table_data;
+  };
+
+  // Validates and translates a table entry write and builds its SDE table key
+  // and data, without programming anything. Can be called concurrently, e.g.
+  // to prepare the updates of a large write request in parallel.
+  virtual ::util::Status PrepareTableEntryWrite(
+      const ::p4::v1::Update::Type type,
+      const ::p4::v1::TableEntry& table_entry,
+      PreparedTableEntryWrite* prepared) LOCKS_EXCLUDED(lock_);
+
+  // Programs a table entry write prepared by PrepareTableEntryWrite().
+  virtual ::util::Status ApplyTableEntryWrite(
+      std::shared_ptr<BfSdeInterface::SessionInterface> session,
+      const PreparedTableEntryWrite& prepared) LOCKS_EXCLUDED(lock_);
+
   // Reads the P4 TableEntry(s) matched by the given table entry.
   virtual ::util::Status ReadTableEntry(
       std::shared_ptr<BfSdeInterface::SessionInterface> session,
@@ -30,6 +30,14 @@ class BfrtTableManagerMock : public BfrtTableManager {
       ::util::Status(std::shared_ptr<BfSdeInterface::SessionInterface> session,
                      const ::p4::v1::Update::Type type,
                      const ::p4::v1::TableEntry& table_entry));
+  MOCK_METHOD3(PrepareTableEntryWrite,
+               ::util::Status(const ::p4::v1::Update::Type type,
+                              const ::p4::v1::TableEntry& table_entry,
+                              PreparedTableEntryWrite* prepared));
+  MOCK_METHOD2(
+      ApplyTableEntryWrite,
+      ::util::Status(std::shared_ptr<BfSdeInterface::SessionInterface> session,
+                     const PreparedTableEntryWrite& prepared));
   MOCK_METHOD3(
       ReadTableEntry,
       ::util::Status(std::shared_ptr<BfSdeInterface::SessionInterface> session,
@@ -7,6 +7,7 @@
 #include <utility>
 
 #include "absl/memory/memory.h"
+#include "gflags/gflags.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "stratum/glue/status/status_test_util.h"
@@ -17,6 +18,8 @@
 #include "stratum/lib/test_utils/matchers.h"
 #include "stratum/lib/utils.h"
 
+DECLARE_uint32(bfrt_table_read_batch_size);
+
 // FIXME
 DEFINE_string(bfrt_sde_config_dir, "/var/run/stratum/bfrt_config",
               "The dir used by the SDE to load the device configuration.");
@@ -25,16 +28,22 @@ namespace stratum {
 namespace hal {
 namespace barefoot {
 
+using ::gflags::FlagSaver;
 using test_utils::EqualsProto;
 using ::testing::_;
 using ::testing::ByMove;
 using ::testing::DoAll;
+using ::testing::ElementsAre;
 using ::testing::HasSubstr;
 using ::testing::Invoke;
 using ::testing::InvokeWithoutArgs;
+using ::testing::IsNull;
+using ::testing::NiceMock;
+using ::testing::NotNull;
 using ::testing::Optional;
 using ::testing::Return;
 using ::testing::SetArgPointee;
+using ::testing::Truly;
 
 class BfrtTableManagerTest : public ::testing::Test {
  protected:
@@ -157,6 +166,7 @@ class BfrtTableManagerTest : public ::testing::Test {
   std::unique_ptr<BfSdeMock> bf_sde_wrapper_mock_;
   std::unique_ptr<BfrtP4RuntimeTranslatorMock> bfrt_p4runtime_translator_mock_;
   std::unique_ptr<BfrtTableManager> bfrt_table_manager_;
+  FlagSaver flag_saver_;  // Reverts FLAGS_bfrt_table_read_batch_size.
 };
 
 constexpr int BfrtTableManagerTest::kDevice1;
@@ -583,6 +593,133 @@ TEST_F(BfrtTableManagerTest, DeleteTableEntryTest) {
       session_mock, ::p4::v1::Update::DELETE, entry));
 }
 
+TEST_F(BfrtTableManagerTest, ReadAllTableEntriesInBatchesTest) {
+  ASSERT_OK(PushTestConfig());
+  constexpr int kP4TableId = 33583783;
+  constexpr int kBfRtTableId = 20;
+  constexpr size_t kBatchSize = 2;
+  auto session_mock = std::make_shared<SessionMock>();
+  WriterMock<::p4::v1::ReadResponse> writer_mock;
+  FLAGS_bfrt_table_read_batch_size = kBatchSize;
+
+  // Returns a fake SDE batch read with the given number of entries. Key and
+  // data objects are only allocated if not present from a previous batch.
+  // Checks that the batch continues from 'last_key' and updates it to the last
+  // key of this batch.
+  const BfSdeInterface::TableKeyInterface* last_key = nullptr;
+  auto fake_batch = [&last_key](size_t num_entries) {
+    return [&last_key, num_entries](
+               int device,
+               std::shared_ptr<BfSdeInterface::SessionInterface> session,
+               uint32 table_id,
+               const BfSdeInterface::TableKeyInterface* previous_key,
+               size_t batch_size,
+               std::vector<std::unique_ptr<BfSdeInterface::TableKeyInterface>>*
+                   table_keys,
+               std::vector<std::unique_ptr<BfSdeInterface::TableDataInterface>>*
+                   table_datas,
+               size_t* actual) {
+      EXPECT_EQ(last_key, previous_key);
+      table_keys->resize(batch_size);
+      table_datas->resize(batch_size);
+      for (size_t i = 0; i < batch_size; ++i) {
+        if (!(*table_keys)[i]) {
+          auto table_key_mock = absl::make_unique<NiceMock<TableKeyMock>>();
+          ON_CALL(*table_key_mock, GetPriority(_))
+              .WillByDefault(
+                  DoAll(SetArgPointee<0>(1), Return(::util::OkStatus())));
+          (*table_keys)[i] = std::move(table_key_mock);
+        }
+        if (!(*table_datas)[i]) {
+          auto table_data_mock = absl::make_unique<NiceMock<TableDataMock>>();
+          ON_CALL(*table_data_mock, GetActionId(_))
+              .WillByDefault(
+                  DoAll(SetArgPointee<0>(0), Return(::util::OkStatus())));
+          ON_CALL(*table_data_mock, GetActionMemberId(_))
+              .WillByDefault(Return(::util::Status(
+                  StratumErrorSpace(), ERR_INVALID_PARAM, "not set")));
+          ON_CALL(*table_data_mock, GetSelectorGroupId(_))
+              .WillByDefault(Return(::util::Status(
+                  StratumErrorSpace(), ERR_INVALID_PARAM, "not set")));
+          (*table_datas)[i] = std::move(table_data_mock);
+        }
+      }
+      last_key = (*table_keys)[num_entries - 1].get();
+      *actual = num_entries;
+      return ::util::OkStatus();
+    };
+  };
+
+  // The table holds 3 entries, which are read in one full and one partial
+  // batch. The second batch must start after the last key of the first.
+  EXPECT_CALL(*bf_sde_wrapper_mock_, GetBfRtId(kP4TableId))
+      .WillOnce(Return(kBfRtTableId));
+  EXPECT_CALL(*bf_sde_wrapper_mock_,
+              GetTableEntriesBatch(kDevice1, _, kBfRtTableId, IsNull(),
+                                   kBatchSize, _, _, _))
+      .WillOnce(Invoke(fake_batch(2)));
+  EXPECT_CALL(*bf_sde_wrapper_mock_,
+              GetTableEntriesBatch(kDevice1, _, kBfRtTableId, NotNull(),
+                                   kBatchSize, _, _, _))
+      .WillOnce(Invoke(fake_batch(1)));
+  EXPECT_CALL(*bfrt_p4runtime_translator_mock_,
+              TranslateTableEntry(_, false))
+      .Times(3)
+      .WillRepeatedly(Invoke([](const ::p4::v1::TableEntry& entry, bool) {
+        return ::util::StatusOr<::p4::v1::TableEntry>(entry);
+      }));
+  // One response per batch.
+  EXPECT_CALL(writer_mock,
+              Write(Truly([](const ::p4::v1::ReadResponse& resp) {
+                return resp.entities_size() == 2;
+              })))
+      .WillOnce(Return(true));
+  EXPECT_CALL(writer_mock,
+              Write(Truly([](const ::p4::v1::ReadResponse& resp) {
+                return resp.entities_size() == 1;
+              })))
+      .WillOnce(Return(true));
+
+  ::p4::v1::TableEntry entry;
+  entry.set_table_id(kP4TableId);
+  EXPECT_CALL(*bfrt_p4runtime_translator_mock_,
+              TranslateTableEntry(EqualsProto(entry), true))
+      .WillOnce(Return(::util::StatusOr<::p4::v1::TableEntry>(entry)));
+  EXPECT_OK(
+      bfrt_table_manager_->ReadTableEntry(session_mock, entry, &writer_mock));
+}
+
+TEST_F(BfrtTableManagerTest, ReadAllTablesWithCounterDataSyncsAllAtOnceTest) {
+  ASSERT_OK(PushTestConfig());
+  constexpr int kP4TableId = 33583783;
+  constexpr int kBfRtTableId = 20;
+  auto session_mock = std::make_shared<SessionMock>();
+  WriterMock<::p4::v1::ReadResponse> writer_mock;
+
+  ::p4::v1::TableEntry entry;
+  entry.mutable_counter_data();
+  EXPECT_CALL(*bfrt_p4runtime_translator_mock_,
+              TranslateTableEntry(EqualsProto(entry), true))
+      .WillOnce(Return(::util::StatusOr<::p4::v1::TableEntry>(entry)));
+  // All tables are synced with a single batched call.
+  EXPECT_CALL(*bf_sde_wrapper_mock_, SynchronizeCounters(_, _, _, _)).Times(0);
+  EXPECT_CALL(*bf_sde_wrapper_mock_,
+              SynchronizeCountersBatch(kDevice1, _, ElementsAre(kP4TableId), _,
+                                       _))
+      .WillOnce(Return(::util::OkStatus()));
+  EXPECT_CALL(*bf_sde_wrapper_mock_, GetBfRtId(kP4TableId))
+      .WillOnce(Return(kBfRtTableId));
+  EXPECT_CALL(*bf_sde_wrapper_mock_,
+              GetTableEntriesBatch(kDevice1, _, kBfRtTableId, IsNull(), _, _, _,
+                                   _))
+      .WillOnce(DoAll(SetArgPointee<7>(0), Return(::util::OkStatus())));
+  // Empty tables do not produce a response.
+  EXPECT_CALL(writer_mock, Write(_)).Times(0);
+
+  EXPECT_OK(
+      bfrt_table_manager_->ReadTableEntry(session_mock, entry, &writer_mock));
+}
+
 TEST_F(BfrtTableManagerTest, RejectWriteTableUnspecifiedTypeTest) {
   ASSERT_OK(PushTestConfig());
   auto session_mock = std::make_shared<SessionMock>();
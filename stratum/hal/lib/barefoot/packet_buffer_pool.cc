@@ -0,0 +1,59 @@
+// Copyright 2020-present Open Networking Foundation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "stratum/hal/lib/barefoot/packet_buffer_pool.h"
+
+#include <utility>
+
+namespace stratum {
+namespace hal {
+namespace barefoot {
+
+PacketBufferPool::PacketBufferPool(size_t max_buffers, size_t buffer_size)
+    : max_buffers_(max_buffers), buffer_size_(buffer_size) {
+  absl::MutexLock l(&lock_);
+  free_buffers_.reserve(max_buffers_);
+  for (size_t i = 0; i < max_buffers_; ++i) {
+    free_buffers_.emplace_back();
+    free_buffers_.back().reserve(buffer_size_);
+  }
+}
+
+std::string PacketBufferPool::Acquire() {
+  std::string buffer;
+  {
+    absl::MutexLock l(&lock_);
+    ++stats_.acquired;
+    if (free_buffers_.empty()) {
+      ++stats_.allocated;
+    } else {
+      buffer = std::move(free_buffers_.back());
+      free_buffers_.pop_back();
+    }
+  }
+  buffer.clear();
+  // No-op for pooled buffers, allocates outside the lock otherwise.
+  buffer.reserve(buffer_size_);
+  return buffer;
+}
+
+void PacketBufferPool::Release(std::string buffer) {
+  {
+    absl::MutexLock l(&lock_);
+    if (free_buffers_.size() < max_buffers_) {
+      free_buffers_.push_back(std::move(buffer));
+      return;
+    }
+    ++stats_.discarded;
+  }
+  // The buffer is freed here, outside the lock.
+}
+
+PacketBufferPool::Stats PacketBufferPool::GetStats() const {
+  absl::MutexLock l(&lock_);
+  return stats_;
+}
+
+}  // namespace barefoot
+}  // namespace hal
+}  // namespace stratum
@@ -0,0 +1,70 @@
+// Copyright 2020-present Open Networking Foundation
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef STRATUM_HAL_LIB_BAREFOOT_PACKET_BUFFER_POOL_H_
+#define STRATUM_HAL_LIB_BAREFOOT_PACKET_BUFFER_POOL_H_
+
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "stratum/glue/integral_types.h"
+
+namespace stratum {
+namespace hal {
+namespace barefoot {
+
+// A thread-safe pool of pre-sized packet buffers. Buffers are strings whose
+// capacity survives being moved through a Channel<std::string>, so a producer
+// can fill a buffer taken from the pool, hand it to a consumer, which releases
+// it back into the pool, without any heap allocation in the steady state.
+class PacketBufferPool {
+ public:
+  // Buffer usage statistics.
+  struct Stats {
+    // Number of Acquire() calls.
+    uint64 acquired = 0;
+    // Number of buffers allocated because the pool was empty.
+    uint64 allocated = 0;
+    // Number of Release() calls which freed the buffer as the pool was full.
+    uint64 discarded = 0;
+  };
+
+  // Creates a pool holding up to max_buffers buffers with at least
+  // buffer_size bytes of capacity each. All buffers are allocated upfront.
+  PacketBufferPool(size_t max_buffers, size_t buffer_size);
+
+  // Returns an empty buffer with at least buffer_size bytes of capacity.
+  // Allocates a new buffer if the pool is exhausted.
+  std::string Acquire() LOCKS_EXCLUDED(lock_);
+
+  // Returns a buffer to the pool. The buffer is freed if the pool is full.
+  void Release(std::string buffer) LOCKS_EXCLUDED(lock_);
+
+  // Returns a copy of the usage statistics.
+  Stats GetStats() const LOCKS_EXCLUDED(lock_);
+
+  size_t buffer_size() const { return buffer_size_; }
+
+  // PacketBufferPool is neither copyable nor movable.
+  PacketBufferPool(const PacketBufferPool&) = delete;
+  PacketBufferPool& operator=(const PacketBufferPool&) = delete;
+
+ private:
+  const size_t max_buffers_;
+  const size_t buffer_size_;
+
+  mutable absl::Mutex lock_;
+
+  // Idle buffers, reserved to max_buffers_ entries.
+  std::vector<std::string> free_buffers_ GUARDED_BY(lock_);
+
+  Stats stats_ GUARDED_BY(lock_);
+};
+
+}  // namespace barefoot
+}  // namespace hal
+}  // namespace stratum
+
+#endif  // STRATUM_HAL_LIB_BAREFOOT_PACKET_BUFFER_POOL_H_
@@ -0,0 +1,57 @@
+// Copyright 2020-present Open Networking Foundation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "stratum/hal/lib/barefoot/packet_buffer_pool.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace stratum {
+namespace hal {
+namespace barefoot {
+namespace {
+
+constexpr size_t kNumBuffers = 4;
+constexpr size_t kBufferSize = 2048;
+
+TEST(PacketBufferPoolTest, AcquireReturnsPreSizedBuffers) {
+  PacketBufferPool pool(kNumBuffers, kBufferSize);
+  for (int i = 0; i < 100; ++i) {
+    std::string buffer = pool.Acquire();
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_GE(buffer.capacity(), kBufferSize);
+    const char* data = buffer.data();
+    buffer.assign(kBufferSize, 'x');
+    // Filling the buffer up to its size must not reallocate.
+    EXPECT_EQ(data, buffer.data());
+    pool.Release(std::move(buffer));
+  }
+  const auto stats = pool.GetStats();
+  EXPECT_EQ(100, stats.acquired);
+  EXPECT_EQ(0, stats.allocated);
+  EXPECT_EQ(0, stats.discarded);
+}
+
+TEST(PacketBufferPoolTest, AllocatesWhenExhaustedAndDiscardsWhenFull) {
+  PacketBufferPool pool(kNumBuffers, kBufferSize);
+  std::vector<std::string> buffers;
+  for (size_t i = 0; i < kNumBuffers + 2; ++i) {
+    buffers.push_back(pool.Acquire());
+    EXPECT_GE(buffers.back().capacity(), kBufferSize);
+  }
+  EXPECT_EQ(2, pool.GetStats().allocated);
+
+  for (auto& buffer : buffers) pool.Release(std::move(buffer));
+  const auto stats = pool.GetStats();
+  EXPECT_EQ(kNumBuffers + 2, stats.acquired);
+  EXPECT_EQ(2, stats.discarded);
+}
+
+}  // namespace
+}  // namespace barefoot
+}  // namespace hal
+}  // namespace stratum
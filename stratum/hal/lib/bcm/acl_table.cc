@@ -51,7 +51,8 @@ BcmAclStage AclTable::P4PipelineToBcmAclStage(
 ::util::StatusOr<int> AclTable::BcmAclId(
     const ::p4::v1::TableEntry& entry) const {
   // Search for the entry.
-  const auto iter = bcm_acl_id_map_.find(entry);
+  const auto iter =
+      bcm_acl_id_map_.find(BcmTableEntryStore::Key(entry).bytes());
   if (iter != bcm_acl_id_map_.end()) {
     return iter->second;
   }
@@ -70,13 +71,13 @@ BcmAclStage AclTable::P4PipelineToBcmAclStage(
 
 ::util::Status AclTable::DryRunInsertEntry(
     const ::p4::v1::TableEntry& entry) const {
-  const auto result = entries_.find(entry);
+  ::p4::v1::TableEntry existing;
   // Duplicate entry check.
-  if (result != entries_.end()) {
+  if (entries_.Find(entry, &existing)) {
     return MAKE_ERROR(ERR_ENTRY_EXISTS)
            << TableStr()
            << " contains duplicate of TableEntry: " << entry.ShortDebugString()
-           << ". Matching TableEntry: " << result->ShortDebugString() << ".";
+           << ". Matching TableEntry: " << existing.ShortDebugString() << ".";
   }
   // Table capacity check.
   if (EntryCount() == max_entries_) {
@@ -113,14 +114,15 @@ BcmAclStage AclTable::P4PipelineToBcmAclStage(
            << " does not contain TableEntry: " << entry.ShortDebugString()
            << ".";
   }
-  auto iter = bcm_acl_id_map_.find(entry);
+  const BcmTableEntryStore::Key key(entry);
+  auto iter = bcm_acl_id_map_.find(key.bytes());
   if (iter != bcm_acl_id_map_.end()) {
     return MAKE_ERROR(ERR_INTERNAL)
            << "Unexpected scenario in " << TableStr()
            << ": Leftover Bcm ACL ID <" << iter->second
            << "> found for TableEntry: " << entry.ShortDebugString() << ".";
   }
-  bcm_acl_id_map_[entry] = bcm_acl_id;
+  bcm_acl_id_map_.emplace(std::string(key.bytes()), bcm_acl_id);
   return ::util::OkStatus();
 }
 
@@ -5,6 +5,7 @@
 #ifndef STRATUM_HAL_LIB_BCM_ACL_TABLE_H_
 #define STRATUM_HAL_LIB_BCM_ACL_TABLE_H_
 
+#include <string>
 #include <utility>
 
 #include "absl/container/flat_hash_map.h"
@@ -152,7 +153,7 @@ class AclTable : public BcmFlowTable {
     // Remove the entry, but don't remove the record in bcm_acl_id_map_.
     ASSIGN_OR_RETURN(p4::v1::TableEntry old_entry,
                      BcmFlowTable::DeleteEntry(entry));
-    entries_.insert(entry);
+    entries_.Insert(entry);
     return old_entry;
   }
 
@@ -166,7 +167,7 @@ class AclTable : public BcmFlowTable {
       const ::p4::v1::TableEntry& entry) override {
     // We aren't interested in the return for erase since it's possible nobody
     // ever set the associated Bcm ACL ID.
-    bcm_acl_id_map_.erase(entry);
+    bcm_acl_id_map_.erase(BcmTableEntryStore::Key(entry).bytes());
     return BcmFlowTable::DeleteEntry(entry);
   }
 
@@ -192,10 +193,10 @@ class AclTable : public BcmFlowTable {
   // The set of match field IDs in this table that use UDFs. This is a subset of
   // match_fields_.
   absl::flat_hash_set<uint32> udf_match_fields_;
-  // Mapping from entries to their respective Bcm ACL IDs.
-  absl::flat_hash_map<::p4::v1::TableEntry, uint32, TableEntryHash,
-                      TableEntryEqual>
-      bcm_acl_id_map_;
+  // Mapping from the packed keys of the entries (see BcmTableEntryStore::Key)
+  // to their respective Bcm ACL IDs. Lookups by string_view do not copy the
+  // key.
+  absl::flat_hash_map<std::string, uint32> bcm_acl_id_map_;
   // Stores const conditions
   absl::flat_hash_map<P4HeaderType, bool, EnumHash<P4HeaderType>>
       const_conditions_;
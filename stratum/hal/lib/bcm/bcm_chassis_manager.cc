@@ -13,6 +13,8 @@
 #include "absl/container/flat_hash_map.h"
 #include "absl/memory/memory.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "gflags/gflags.h"
 #include "google/protobuf/message.h"
 #include "stratum/glue/gtl/map_util.h"
@@ -43,6 +45,10 @@ DEFINE_string(bcm_sdk_shell_log_file, "/var/log/stratum/bcm.log",
 DEFINE_string(bcm_sdk_checkpoint_dir, "",
               "The dir used by SDK to save checkpoints. Default is empty and "
               "it is expected to be explicitly given by flags.");
+DEFINE_int32(bcm_port_counters_collection_interval_ms, 0,
+             "If positive, the counters of all ports are read in the "
+             "background every this many milliseconds, and port counter "
+             "requests are served from the last sweep. Disabled by default.");
 
 namespace stratum {
 namespace hal {
@@ -95,6 +101,10 @@ BcmChassisManager::BcmChassisManager(OperationMode mode,
       xcvr_event_channel_(nullptr),
       linkscan_event_channel_(nullptr),
       gnmi_event_writer_(nullptr),
+      active_port_counters_table_(0),
+      port_counters_collector_tid_(),
+      port_counters_collector_running_(false),
+      port_counters_collector_stop_(false),
       phal_interface_(ABSL_DIE_IF_NULL(phal_interface)),
       bcm_sdk_interface_(ABSL_DIE_IF_NULL(bcm_sdk_interface)),
       bcm_serdes_db_manager_(ABSL_DIE_IF_NULL(bcm_serdes_db_manager)),
@@ -131,6 +141,10 @@ BcmChassisManager::BcmChassisManager()
       node_id_to_port_id_to_loopback_state_(),
       xcvr_event_channel_(nullptr),
       linkscan_event_channel_(nullptr),
+      active_port_counters_table_(0),
+      port_counters_collector_tid_(),
+      port_counters_collector_running_(false),
+      port_counters_collector_stop_(false),
       phal_interface_(nullptr),
       bcm_sdk_interface_(nullptr),
       bcm_serdes_db_manager_(nullptr) {}
@@ -166,6 +180,7 @@ BcmChassisManager::~BcmChassisManager() {
     RETURN_IF_ERROR(SyncInternalState(config));
     RETURN_IF_ERROR(ConfigurePortGroups());
     RETURN_IF_ERROR(RegisterEventWriters());
+    RETURN_IF_ERROR(StartPortCountersCollector());
     initialized_ = true;
   } else {
     // If already initialized, sync the internal state and (re-)configure the
@@ -217,6 +232,7 @@ BcmChassisManager::~BcmChassisManager() {
 
 ::util::Status BcmChassisManager::Shutdown() {
   ::util::Status status = ::util::OkStatus();
+  APPEND_STATUS_IF_ERROR(status, StopPortCountersCollector());
   APPEND_STATUS_IF_ERROR(status, UnregisterEventWriters());
   APPEND_STATUS_IF_ERROR(status, bcm_sdk_interface_->ShutdownAllUnits());
   initialized_ = false;  // Set to false even if there is an error
@@ -455,6 +471,10 @@ BcmChassisManager::GetTrunkIdToSdkTrunkMap(uint64 node_id) const {
   if (!initialized_) {
     return MAKE_ERROR(ERR_NOT_INITIALIZED) << "Not initialized!";
   }
+  RET_CHECK(pc != nullptr);
+  if (FindCollectedPortCounters(node_id, port_id, pc)) {
+    return ::util::OkStatus();
+  }
   ASSIGN_OR_RETURN(auto unit, GetUnitFromNodeId(node_id));
   ASSIGN_OR_RETURN(auto bcm_port, GetBcmPort(node_id, port_id));
   return bcm_sdk_interface_->GetPortCounters(unit, bcm_port.logical_port(), pc);
@@ -1979,6 +1999,142 @@ void BcmChassisManager::TransceiverEventHandler(int slot, int port,
   }
 }
 
+::util::Status BcmChassisManager::StartPortCountersCollector() {
+  if (FLAGS_bcm_port_counters_collection_interval_ms <= 0) {
+    return ::util::OkStatus();
+  }
+  absl::MutexLock l(&port_counters_lock_);
+  if (port_counters_collector_running_) return ::util::OkStatus();
+  port_counters_collector_stop_ = false;
+  // Forget the counters of a previous run.
+  for (auto& table : port_counters_tables_) table = PortCountersTable();
+  active_port_counters_table_ = 0;
+  int ret = pthread_create(&port_counters_collector_tid_, nullptr,
+                           PortCountersCollectorThreadFunc, this);
+  if (ret != 0) {
+    return MAKE_ERROR(ERR_INTERNAL)
+           << "Failed to create port counters collector thread. Err: " << ret
+           << ".";
+  }
+  port_counters_collector_running_ = true;
+
+  return ::util::OkStatus();
+}
+
+::util::Status BcmChassisManager::StopPortCountersCollector() {
+  {
+    absl::MutexLock l(&port_counters_lock_);
+    if (!port_counters_collector_running_) return ::util::OkStatus();
+    port_counters_collector_stop_ = true;
+    port_counters_collector_running_ = false;
+  }
+  int ret = pthread_join(port_counters_collector_tid_, nullptr);
+  if (ret != 0) {
+    return MAKE_ERROR(ERR_INTERNAL)
+           << "Failed to join port counters collector thread. Err: " << ret
+           << ".";
+  }
+
+  return ::util::OkStatus();
+}
+
+void* BcmChassisManager::PortCountersCollectorThreadFunc(void* arg) {
+  CHECK(arg != nullptr);
+  auto* manager = static_cast<BcmChassisManager*>(arg);
+  return manager->CollectPortCounters();
+}
+
+void* BcmChassisManager::CollectPortCounters() {
+  const absl::Duration interval =
+      absl::Milliseconds(FLAGS_bcm_port_counters_collection_interval_ms);
+  int inactive = 1;
+  do {
+    // The inactive table is only accessed by this thread.
+    PortCountersTable* table = &port_counters_tables_[inactive];
+    table->counters.clear();
+    table->timestamp = absl::Now();
+    {
+      absl::ReaderMutexLock l(&chassis_lock);
+      // Check switch shutdown.
+      if (shutdown) break;
+      ::util::Status status = ReadAllPortCounters(table);
+      if (!status.ok()) {
+        LOG(ERROR) << "Failed to collect port counters: " << status;
+      }
+    }
+    absl::MutexLock l(&port_counters_lock_);
+    active_port_counters_table_ = inactive;
+    inactive = 1 - inactive;
+    // Wait for the next sweep, unless asked to stop.
+    if (port_counters_lock_.AwaitWithTimeout(
+            absl::Condition(&port_counters_collector_stop_), interval)) {
+      break;
+    }
+  } while (true);
+
+  return nullptr;
+}
+
+::util::Status BcmChassisManager::ReadAllPortCounters(
+    PortCountersTable* table) const {
+  if (!initialized_) return ::util::OkStatus();
+  // Map from unit to the logical ports to read and the (node ID, port ID) of
+  // every logical port.
+  std::map<int, std::vector<int>> unit_to_logical_ports;
+  std::map<int, std::vector<std::pair<uint64, uint32>>> unit_to_port_ids;
+  for (const auto& e : node_id_to_port_id_to_sdk_port_) {
+    for (const auto& p : e.second) {
+      unit_to_logical_ports[p.second.unit].push_back(p.second.logical_port);
+      unit_to_port_ids[p.second.unit].emplace_back(e.first, p.first);
+    }
+  }
+  ::util::Status status = ::util::OkStatus();
+  for (const auto& e : unit_to_logical_ports) {
+    const int unit = e.first;
+    std::vector<PortCounters> counters;
+    ::util::Status unit_status =
+        bcm_sdk_interface_->GetPortCountersBulk(unit, e.second, &counters);
+    if (unit_status.ok() && counters.size() != e.second.size()) {
+      unit_status = MAKE_ERROR(ERR_INTERNAL)
+                    << "Expected the counters of " << e.second.size()
+                    << " ports on unit " << unit << ", got " << counters.size()
+                    << ".";
+    }
+    if (!unit_status.ok()) {
+      APPEND_STATUS_IF_ERROR(status, unit_status);
+      continue;
+    }
+    const auto& port_ids = unit_to_port_ids[unit];
+    for (size_t i = 0; i < counters.size(); ++i) {
+      table->counters[port_ids[i].first][port_ids[i].second] =
+          std::move(counters[i]);
+    }
+  }
+
+  return status;
+}
+
+bool BcmChassisManager::FindCollectedPortCounters(uint64 node_id,
+                                                  uint32 port_id,
+                                                  PortCounters* pc) const {
+  absl::MutexLock l(&port_counters_lock_);
+  if (!port_counters_collector_running_) return false;
+  const PortCountersTable& table =
+      port_counters_tables_[active_port_counters_table_];
+  // Fall back to reading the port directly if the collector fell behind.
+  const absl::Duration max_age =
+      2 * absl::Milliseconds(FLAGS_bcm_port_counters_collection_interval_ms);
+  if (absl::Now() - table.timestamp > max_age) return false;
+  const auto* port_id_to_counters = gtl::FindOrNull(table.counters, node_id);
+  if (port_id_to_counters == nullptr) return false;
+  const PortCounters* counters =
+      gtl::FindOrNull(*port_id_to_counters, port_id);
+  if (counters == nullptr) return false;
+  *pc = *counters;
+
+  return true;
+}
+
 ::util::StatusOr<bool> BcmChassisManager::SetSpeedForFlexPortGroup(
     const PortKey& port_group_key) const {
   // First check to see if this is a flex port group.
@@ -5,6 +5,8 @@
 #ifndef STRATUM_HAL_LIB_BCM_BCM_CHASSIS_MANAGER_H_
 #define STRATUM_HAL_LIB_BCM_BCM_CHASSIS_MANAGER_H_
 
+#include <pthread.h>
+
 #include <functional>
 #include <map>
 #include <memory>
@@ -16,6 +18,7 @@
 
 #include "absl/base/thread_annotations.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #include "stratum/glue/integral_types.h"
 #include "stratum/glue/status/status.h"
 #include "stratum/glue/status/statusor.h"
@@ -230,6 +233,16 @@ class BcmChassisManager : public BcmChassisRoInterface {
   // Maximum depth of linkscan event channel.
   static constexpr int kMaxLinkscanEventDepth = 256;
 
+  // The counters of all the singleton ports, as read by the port counters
+  // collector thread in one sweep.
+  struct PortCountersTable {
+    // Map from node ID to another map from port ID to the port counters.
+    std::map<uint64, std::map<uint32, PortCounters>> counters;
+    // Time the sweep started.
+    absl::Time timestamp;
+    PortCountersTable() : counters(), timestamp(absl::InfinitePast()) {}
+  };
+
   // Private constructor. Use CreateInstance() to create an instance of this
   // class.
   BcmChassisManager(OperationMode mode, PhalInterface* phal_interface,
@@ -355,6 +368,37 @@ class BcmChassisManager : public BcmChassisRoInterface {
       const std::unique_ptr<ChannelReader<BcmSdkInterface::LinkscanEvent>>&
           reader) LOCKS_EXCLUDED(chassis_lock);
 
+  // Starts/stops the port counters collector thread, which refreshes the
+  // counters of all the singleton ports every
+  // FLAGS_bcm_port_counters_collection_interval_ms. Noop if the interval is
+  // not positive.
+  ::util::Status StartPortCountersCollector()
+      LOCKS_EXCLUDED(port_counters_lock_);
+  ::util::Status StopPortCountersCollector()
+      LOCKS_EXCLUDED(port_counters_lock_);
+
+  // Thread function for the port counters collector. Invoked with "this" as
+  // the argument in pthread_create.
+  static void* PortCountersCollectorThreadFunc(void* arg);
+
+  // Periodically reads the counters of all the singleton ports into the
+  // inactive port counters table and makes it the active one, until
+  // StopPortCountersCollector() is called. Called by
+  // PortCountersCollectorThreadFunc.
+  void* CollectPortCounters()
+      LOCKS_EXCLUDED(chassis_lock, port_counters_lock_);
+
+  // Reads the counters of all the singleton ports into the given table, with a
+  // single BcmSdkInterface::GetPortCountersBulk() call per unit.
+  ::util::Status ReadAllPortCounters(PortCountersTable* table) const
+      SHARED_LOCKS_REQUIRED(chassis_lock);
+
+  // Looks up the counters of the given port in the active port counters table.
+  // Returns false if the collector is not running or the table is stale.
+  bool FindCollectedPortCounters(uint64 node_id, uint32 port_id,
+                                 PortCounters* pc) const
+      LOCKS_EXCLUDED(port_counters_lock_);
+
   // Forward PortStatus changed events through the appropriate node's registered
   // ChannelWriter<GnmiEventPtr> object. Called by LinkscanEventHandler and
   // expects chassis_lock to be held.
@@ -593,6 +637,20 @@ class BcmChassisManager : public BcmChassisRoInterface {
   std::shared_ptr<WriterInterface<GnmiEventPtr>> gnmi_event_writer_
       GUARDED_BY(gnmi_event_lock_);
 
+  // Double buffered port counters tables, filled by the port counters
+  // collector thread. Readers only access the active table, under
+  // port_counters_lock_. The collector fills the inactive one without holding
+  // the lock and then flips active_port_counters_table_.
+  mutable absl::Mutex port_counters_lock_;
+  PortCountersTable port_counters_tables_[2];
+  int active_port_counters_table_ GUARDED_BY(port_counters_lock_);
+
+  // The port counters collector thread, if running.
+  pthread_t port_counters_collector_tid_;
+  bool port_counters_collector_running_ GUARDED_BY(port_counters_lock_);
+  // Set to make the port counters collector thread exit.
+  bool port_counters_collector_stop_ GUARDED_BY(port_counters_lock_);
+
   // Pointer to a PhalInterface implementation.
   PhalInterface* phal_interface_;  // not owned by this class.
 
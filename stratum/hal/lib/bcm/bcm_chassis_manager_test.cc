@@ -15,6 +15,8 @@
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "gflags/gflags.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -38,6 +40,7 @@ DECLARE_string(bcm_sdk_config_flush_file);
 DECLARE_string(bcm_sdk_shell_log_file);
 DECLARE_string(bcm_sdk_checkpoint_dir);
 DECLARE_string(test_tmpdir);
+DECLARE_int32(bcm_port_counters_collection_interval_ms);
 
 namespace stratum {
 namespace hal {
@@ -45,6 +48,7 @@ namespace bcm {
 
 using ::testing::_;
 using ::testing::DoAll;
+using ::testing::ElementsAre;
 using ::testing::HasSubstr;
 using ::testing::Invoke;
 using ::testing::Matcher;
@@ -249,6 +253,12 @@ class BcmChassisManagerTest : public ::testing::TestWithParam<OperationMode> {
     return bcm_chassis_manager_->GetPortAdminState(node_id, port_id);
   }
 
+  ::util::Status GetPortCounters(uint64 node_id, uint32 port_id,
+                                 PortCounters* pc) const {
+    absl::ReaderMutexLock l(&chassis_lock);
+    return bcm_chassis_manager_->GetPortCounters(node_id, port_id, pc);
+  }
+
   ::util::StatusOr<LoopbackState> GetPortLoopbackState(uint64 node_id,
                                                        uint32 port_id) const {
     absl::ReaderMutexLock l(&chassis_lock);
@@ -5200,6 +5210,31 @@ TEST_P(BcmChassisManagerTest, TestSendTransceiverGnmiEvent) {
   ASSERT_OK(ShutdownAndTestCleanState());
 }
 
+TEST_P(BcmChassisManagerTest, TestPortCountersCollector) {
+  FLAGS_bcm_port_counters_collection_interval_ms = 1;
+  PortCounters collected;
+  collected.set_in_octets(100);
+  // Logical port 34 on unit 0 is the only singleton port in the test config.
+  EXPECT_CALL(*bcm_sdk_mock_, GetPortCountersBulk(0, ElementsAre(34), _))
+      .WillRepeatedly(
+          DoAll(SetArgPointee<2>(std::vector<PortCounters>{collected}),
+                Return(::util::OkStatus())));
+  // Used until the first sweep completes.
+  EXPECT_CALL(*bcm_sdk_mock_, GetPortCounters(0, 34, _))
+      .WillRepeatedly(Return(::util::OkStatus()));
+  ASSERT_OK(PushTestConfig());
+
+  PortCounters pc;
+  for (int i = 0; i < 1000 && pc.in_octets() != 100; ++i) {
+    ASSERT_OK(GetPortCounters(kNodeId, kPortId, &pc));
+    absl::SleepFor(absl::Milliseconds(5));
+  }
+  EXPECT_EQ(100, pc.in_octets());
+
+  ASSERT_OK(ShutdownAndTestCleanState());
+  FLAGS_bcm_port_counters_collection_interval_ms = 0;
+}
+
 TEST_P(BcmChassisManagerTest, TestSetTrunkMemberBlockStateByController) {
   ASSERT_OK(PushTestConfig());
 
@@ -5,11 +5,9 @@
 #ifndef STRATUM_HAL_LIB_BCM_BCM_FLOW_TABLE_H_
 #define STRATUM_HAL_LIB_BCM_BCM_FLOW_TABLE_H_
 
-#include <algorithm>
 #include <string>
 #include <utility>
 
-#include "absl/container/node_hash_set.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "p4/v1/p4runtime.pb.h"
@@ -17,6 +15,7 @@
 #include "stratum/glue/status/status.h"
 #include "stratum/glue/status/status_macros.h"
 #include "stratum/glue/status/statusor.h"
+#include "stratum/hal/lib/bcm/bcm_table_entry_store.h"
 #include "stratum/lib/utils.h"
 #include "stratum/public/lib/error.h"
 
@@ -24,69 +23,13 @@ namespace stratum {
 namespace hal {
 namespace bcm {
 
-// Custom hash and equal function for P4 TableEntry protos. We need a way
-// to differeniate flows in the following way: If we have 2 flows f1 and f2
-// with f2 being the modified version of f1 as intended by the controller, f1
-// = f2. In any other case they should not.
-struct TableEntryHash {
-  size_t operator()(const ::p4::v1::TableEntry& x) const {
-    // Save a copy of the input proto, clear actions/metadata/counter/meter,
-    // and hash the rest.
-    ::p4::v1::TableEntry a = x;
-    a.clear_table_id();
-    a.clear_action();
-    a.clear_controller_metadata();
-    a.clear_meter_config();
-    a.clear_counter_data();
-    // Hash on match field combination, not on permutation.
-    std::sort(a.mutable_match()->begin(), a.mutable_match()->end(),
-              [](const ::p4::v1::FieldMatch& l, const ::p4::v1::FieldMatch& r) {
-                return ProtoSerialize(l) < ProtoSerialize(r);
-              });
-    return std::hash<std::string>()(ProtoSerialize(a));
-  }
-};
-
-struct TableEntryEqual {
-  bool operator()(const ::p4::v1::TableEntry& x,
-                  const ::p4::v1::TableEntry& y) const {
-    // Save copies of the input protos, clear actions/metadata/counter/meter
-    // and compare the rest.
-    ::p4::v1::TableEntry a = x, b = y;
-    a.clear_table_id();
-    a.clear_action();
-    a.clear_controller_metadata();
-    a.clear_meter_config();
-    a.clear_counter_data();
-    b.clear_table_id();
-    b.clear_action();
-    b.clear_controller_metadata();
-    b.clear_meter_config();
-    b.clear_counter_data();
-    // The order of the match fields are not important.
-    if (a.match_size() != b.match_size() ||
-        !std::is_permutation(
-            a.match().begin(), a.match().end(), b.match().begin(),
-            [](const ::p4::v1::FieldMatch& l, const ::p4::v1::FieldMatch& r) {
-              return ProtoSerialize(l) == ProtoSerialize(r);
-            })) {
-      return false;
-    }
-    a.clear_match();
-    b.clear_match();
-    return ProtoSerialize(a) == ProtoSerialize(b);
-  }
-};
-
-using TableEntrySet =
-    absl::node_hash_set<::p4::v1::TableEntry, TableEntryHash, TableEntryEqual>;
-
 // Class for managing a BCM table.
 class BcmFlowTable {
  public:
-  // STL-style types that allow table traversal.
-  using const_iterator = TableEntrySet::const_iterator;
-  using value_type = TableEntrySet::value_type;
+  // STL-style types that allow table traversal. The entries are rebuilt from
+  // the compact shadow when dereferenced.
+  using const_iterator = BcmTableEntryStore::const_iterator;
+  using value_type = BcmTableEntryStore::const_iterator::value_type;
 
   // Constructors.
   explicit BcmFlowTable(uint32 p4_table_id)
@@ -133,7 +76,7 @@ class BcmFlowTable {
 
   // Returns true if this table already has this entry.
   virtual bool HasEntry(const ::p4::v1::TableEntry& entry) const {
-    return entries_.count(entry) > 0;
+    return entries_.Contains(entry);
   }
 
   // Returns the number of entries in this table.
@@ -146,17 +89,20 @@ class BcmFlowTable {
   // Returns ERR_ENTRY_NOT_FOUND if a matching entry is not found.
   virtual ::util::StatusOr<::p4::v1::TableEntry> Lookup(
       const ::p4::v1::TableEntry& key) const {
-    auto lookup = entries_.find(key);
-    if (lookup == entries_.end()) {
+    ::p4::v1::TableEntry entry;
+    if (!entries_.Find(key, &entry)) {
       return MAKE_ERROR(ERR_ENTRY_NOT_FOUND)
              << TableStr()
              << " does not contain TableEntry: " << key.ShortDebugString();
     }
-    return *lookup;
+    return entry;
   }
 
-  TableEntrySet::const_iterator begin() const { return entries_.begin(); }
-  TableEntrySet::const_iterator end() const { return entries_.end(); }
+  const_iterator begin() const { return entries_.begin(); }
+  const_iterator end() const { return entries_.end(); }
+
+  // Returns the number of heap bytes used by the shadow of the entries.
+  size_t EntryMemoryUsage() const { return entries_.MemoryUsage(); }
 
   // Returns true if this is a const table.
   virtual bool IsConst() const { return is_const_; }
@@ -174,15 +120,15 @@ class BcmFlowTable {
   // 2) TableEntry.priority
   // 3) is_default_action
   //
-  // See TableEntryEqual below.
+  // See BcmTableEntryStore::Key.
   virtual ::util::Status InsertEntry(const ::p4::v1::TableEntry& entry) {
-    auto result = entries_.insert(entry);
-    if (!result.second) {
+    if (!entries_.Insert(entry)) {
+      ::p4::v1::TableEntry existing;
+      entries_.Find(entry, &existing);
       return MAKE_ERROR(ERR_ENTRY_EXISTS)
              << TableStr() << " contains duplicate of TableEntry: "
              << entry.ShortDebugString()
-             << ". Matching TableEntry: " << result.first->ShortDebugString()
-             << ".";
+             << ". Matching TableEntry: " << existing.ShortDebugString() << ".";
     }
     return ::util::OkStatus();
   }
@@ -191,12 +137,12 @@ class BcmFlowTable {
   // inserted. If the entry can be inserted, returns ::util::OkStatus().
   virtual ::util::Status DryRunInsertEntry(
       const ::p4::v1::TableEntry& entry) const {
-    const auto result = entries_.find(entry);
-    if (result != entries_.end()) {
+    ::p4::v1::TableEntry existing;
+    if (entries_.Find(entry, &existing)) {
       return MAKE_ERROR(ERR_ENTRY_EXISTS)
              << TableStr() << " contains duplicate of TableEntry: "
              << entry.ShortDebugString()
-             << ". Matching TableEntry: " << result->ShortDebugString() << ".";
+             << ". Matching TableEntry: " << existing.ShortDebugString() << ".";
     }
     return ::util::OkStatus();
   }
@@ -208,7 +154,7 @@ class BcmFlowTable {
   virtual ::util::StatusOr<::p4::v1::TableEntry> ModifyEntry(
       const ::p4::v1::TableEntry& entry) {
     ASSIGN_OR_RETURN(::p4::v1::TableEntry old_entry, DeleteEntry(entry));
-    entries_.insert(entry);
+    entries_.Insert(entry);
     return old_entry;
   }
 
@@ -217,15 +163,13 @@ class BcmFlowTable {
   // Returns ERR_ENTRY_NOT_FOUND if a matching entry does not already exist.
   virtual ::util::StatusOr<::p4::v1::TableEntry> DeleteEntry(
       const ::p4::v1::TableEntry& key) {
-    const auto lookup = entries_.find(key);
-    if (lookup == entries_.end()) {
+    ::p4::v1::TableEntry entry;
+    if (!entries_.Erase(key, &entry)) {
       return MAKE_ERROR(ERR_ENTRY_NOT_FOUND)
              << TableStr()
              << " does not contain TableEntry: " << key.ShortDebugString()
              << ".";
     }
-    ::p4::v1::TableEntry entry = *lookup;
-    entries_.erase(lookup);
     return entry;
   }
 
@@ -241,7 +185,7 @@ class BcmFlowTable {
   uint32 id_;
   std::string name_;
   // Keeps track of all entries currently in the table.
-  TableEntrySet entries_;
+  BcmTableEntryStore entries_;
   // True is this is a const table. Const tables can only be modified during
   // SetForwardingPipelineConfig().
   bool is_const_;
@@ -425,6 +425,114 @@ BcmL3Manager::~BcmL3Manager() {}
   return ::util::OkStatus();
 }
 
+::util::Status BcmL3Manager::WriteTableEntries(
+    const std::vector<LpmOrHostUpdate>& updates,
+    std::vector<::util::Status>* results) {
+  RET_CHECK(results != nullptr);
+  results->assign(updates.size(), ::util::OkStatus());
+  // Index in 'updates' of every write given to the SDK.
+  std::vector<size_t> indices;
+  std::vector<BcmSdkInterface::L3RouteWrite> writes;
+  for (size_t i = 0; i < updates.size(); ++i) {
+    BcmSdkInterface::L3RouteWrite write;
+    (*results)[i] = FillL3RouteWrite(updates[i], &write);
+    if ((*results)[i].ok()) {
+      indices.push_back(i);
+      writes.push_back(write);
+    }
+  }
+  if (writes.empty()) return ::util::OkStatus();
+
+  std::vector<::util::Status> write_results;
+  RETURN_IF_ERROR(
+      bcm_sdk_interface_->WriteL3Routes(unit_, writes, &write_results));
+  RET_CHECK(write_results.size() == writes.size())
+      << "Expected " << writes.size() << " results from the SDK, got "
+      << write_results.size() << ".";
+  // Update the internal records in BcmTableManager for the successful writes.
+  for (size_t i = 0; i < indices.size(); ++i) {
+    const LpmOrHostUpdate& update = updates[indices[i]];
+    ::util::Status status = write_results[i];
+    if (status.ok()) {
+      switch (update.type) {
+        case ::p4::v1::Update::INSERT:
+          status = bcm_table_manager_->AddTableEntry(*update.entry);
+          break;
+        case ::p4::v1::Update::MODIFY:
+          status = bcm_table_manager_->UpdateTableEntry(*update.entry);
+          break;
+        case ::p4::v1::Update::DELETE:
+          status = bcm_table_manager_->DeleteTableEntry(*update.entry);
+          break;
+        default:
+          break;
+      }
+    }
+    (*results)[indices[i]] = status;
+  }
+
+  return ::util::OkStatus();
+}
+
+::util::Status BcmL3Manager::FillL3RouteWrite(
+    const LpmOrHostUpdate& update, BcmSdkInterface::L3RouteWrite* write) {
+  RET_CHECK(update.entry != nullptr);
+  switch (update.type) {
+    case ::p4::v1::Update::INSERT:
+      write->type = BcmSdkInterface::L3RouteWrite::Type::ADD;
+      break;
+    case ::p4::v1::Update::MODIFY:
+      write->type = BcmSdkInterface::L3RouteWrite::Type::MODIFY;
+      break;
+    case ::p4::v1::Update::DELETE:
+      write->type = BcmSdkInterface::L3RouteWrite::Type::DELETE;
+      break;
+    default:
+      return MAKE_ERROR(ERR_INVALID_PARAM)
+             << "Invalid update type " << update.type << " for "
+             << update.entry->ShortDebugString() << ".";
+  }
+  const BcmFlowEntry& bcm_flow_entry = update.bcm_flow_entry;
+  RET_CHECK(bcm_flow_entry.unit() == unit_)
+      << "Received L3 flow for unit " << bcm_flow_entry.unit() << " on unit "
+      << unit_ << ".";
+  const auto bcm_table_type = bcm_flow_entry.bcm_table_type();
+  switch (bcm_table_type) {
+    case BcmFlowEntry::BCM_TABLE_IPV4_LPM:
+    case BcmFlowEntry::BCM_TABLE_IPV6_LPM:
+      write->host = false;
+      break;
+    case BcmFlowEntry::BCM_TABLE_IPV4_HOST:
+    case BcmFlowEntry::BCM_TABLE_IPV6_HOST:
+      write->host = true;
+      break;
+    default:
+      return MAKE_ERROR(ERR_INVALID_PARAM)
+             << "Invalid bcm_table_type: "
+             << BcmFlowEntry::BcmTableType_Name(bcm_table_type) << ", found in "
+             << bcm_flow_entry.ShortDebugString() << ".";
+  }
+  write->ipv6 = bcm_table_type == BcmFlowEntry::BCM_TABLE_IPV6_LPM ||
+                bcm_table_type == BcmFlowEntry::BCM_TABLE_IPV6_HOST;
+  LpmOrHostKey key;
+  RETURN_IF_ERROR(ExtractLpmOrHostKey(bcm_flow_entry, &key));
+  write->vrf = key.vrf;
+  write->subnet_ipv4 = key.subnet_ipv4;
+  write->mask_ipv4 = key.mask_ipv4;
+  write->subnet_ipv6 = key.subnet_ipv6;
+  write->mask_ipv6 = key.mask_ipv6;
+  if (update.type != ::p4::v1::Update::DELETE) {
+    LpmOrHostActionParams action_params;
+    RETURN_IF_ERROR(
+        ExtractLpmOrHostActionParams(bcm_flow_entry, &action_params));
+    write->class_id = action_params.class_id;
+    write->egress_intf_id = action_params.egress_intf_id;
+    write->is_intf_multipath = action_params.is_intf_multipath;
+  }
+
+  return ::util::OkStatus();
+}
+
 ::util::Status BcmL3Manager::UpdateMultipathGroupsForPort(uint32 port_id) {
   // Generate map from BCM multipath group id to data for all groups which
   // reference the given port.
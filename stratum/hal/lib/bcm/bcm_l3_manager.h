@@ -56,6 +56,20 @@ struct LpmOrHostActionParams {
       : class_id(-1), egress_intf_id(-1), is_intf_multipath(false) {}
 };
 
+// This struct encapsulates an insert, modify or delete of an IPv4/IPv6 L3
+// LPM/Host flow, given as part of a batch to BcmL3Manager::WriteTableEntries().
+struct LpmOrHostUpdate {
+  ::p4::v1::Update::Type type;
+  const ::p4::v1::TableEntry* entry;  // Not owned by this struct.
+  // The flow populated from 'entry' by BcmTableManager::FillBcmFlowEntry().
+  BcmFlowEntry bcm_flow_entry;
+  LpmOrHostUpdate() : type(::p4::v1::Update::UNSPECIFIED), entry(nullptr) {}
+  LpmOrHostUpdate(::p4::v1::Update::Type _type,
+                  const ::p4::v1::TableEntry* _entry,
+                  const BcmFlowEntry& _bcm_flow_entry)
+      : type(_type), entry(_entry), bcm_flow_entry(_bcm_flow_entry) {}
+};
+
 // The "BcmL3Manager" class implements the L3 routing functionality.
 class BcmL3Manager {
  public:
@@ -125,6 +139,15 @@ class BcmL3Manager {
   // not needed).
   virtual ::util::Status DeleteTableEntry(const ::p4::v1::TableEntry& entry);
 
+  // Inserts, modifies and deletes a batch of IPv4/IPv6 L3 LPM/Host flows with
+  // a single BcmSdkInterface::WriteL3Routes() call, so that the SDK can commit
+  // them together. The updates are independent of each other and have the same
+  // semantics as the Insert/Modify/DeleteTableEntry() calls above. The status
+  // of every update is stored in 'results', in the order of 'updates'.
+  virtual ::util::Status WriteTableEntries(
+      const std::vector<LpmOrHostUpdate>& updates,
+      std::vector<::util::Status>* results);
+
   // Updates any ECMP/WCMP groups which include a member pointing to the given
   // singleton port. Adds or removes the port to or from all groups referencing
   // it based on whether the port is UP or not, respectively. In the case that
@@ -165,6 +188,11 @@ class BcmL3Manager {
   // define the key for the flow (the egress_intf_id or class_id not needed).
   ::util::Status DeleteLpmOrHostFlow(const BcmFlowEntry& bcm_flow_entry);
 
+  // Translates an IPv4/IPv6 L3 LPM/Host flow update to the corresponding
+  // write of BcmSdkInterface::WriteL3Routes().
+  ::util::Status FillL3RouteWrite(const LpmOrHostUpdate& update,
+                                  BcmSdkInterface::L3RouteWrite* write);
+
   // Helper to extract IPv4/IPv6 L3 LPM/Host flow keys given BcmFlowEntry.
   ::util::Status ExtractLpmOrHostKey(const BcmFlowEntry& bcm_flow_entry,
                                      LpmOrHostKey* key);
@@ -5,6 +5,8 @@
 #ifndef STRATUM_HAL_LIB_BCM_BCM_L3_MANAGER_MOCK_H_
 #define STRATUM_HAL_LIB_BCM_BCM_L3_MANAGER_MOCK_H_
 
+#include <vector>
+
 #include "gmock/gmock.h"
 #include "stratum/hal/lib/bcm/bcm_l3_manager.h"
 
@@ -37,6 +39,9 @@ class BcmL3ManagerMock : public BcmL3Manager {
                ::util::Status(const ::p4::v1::TableEntry& entry));
   MOCK_METHOD1(DeleteTableEntry,
                ::util::Status(const ::p4::v1::TableEntry& entry));
+  MOCK_METHOD2(WriteTableEntries,
+               ::util::Status(const std::vector<LpmOrHostUpdate>& updates,
+                              std::vector<::util::Status>* results));
   MOCK_METHOD1(UpdateMultipathGroupsForPort, ::util::Status(uint32 port_id));
 };
 
@@ -25,6 +25,7 @@ using ::testing::_;
 using ::testing::DoAll;
 using ::testing::HasSubstr;
 using ::testing::Return;
+using ::testing::SaveArg;
 using ::testing::SetArgPointee;
 using ::testing::StrictMock;
 
@@ -1886,6 +1887,141 @@ TEST_F(BcmL3ManagerTest, DeleteLpmOrHostFlowSuccessForIpv6HostFlow) {
   ASSERT_OK(bcm_l3_manager_->DeleteTableEntry(p4_table_entry));
 }
 
+TEST_F(BcmL3ManagerTest, WriteTableEntriesWritesBatchWithSingleSdkCall) {
+  const std::string kInsertBcmFlowEntryText = R"(
+      unit: 3
+      bcm_table_type: BCM_TABLE_IPV4_LPM
+      fields: {
+        type: IPV4_DST
+        value {
+          u32: 0xc0a00100
+        }
+        mask {
+          u32: 0xffffff00
+        }
+      }
+      actions: {
+        type: OUTPUT_L3
+        params {
+          type: EGRESS_INTF_ID
+          value {
+            u32: 200256
+          }
+        }
+      }
+  )";
+  const std::string kDeleteBcmFlowEntryText = R"(
+      unit: 3
+      bcm_table_type: BCM_TABLE_IPV4_HOST
+      fields: {
+        type: IPV4_DST
+        value {
+          u32: 0xc0a00101
+        }
+      }
+  )";
+
+  // Test BcmFlowEntries.
+  BcmFlowEntry insert_flow_entry;
+  ASSERT_OK(ParseProtoFromString(kInsertBcmFlowEntryText, &insert_flow_entry));
+  BcmFlowEntry delete_flow_entry;
+  ASSERT_OK(ParseProtoFromString(kDeleteBcmFlowEntryText, &delete_flow_entry));
+  ::p4::v1::TableEntry insert_entry;
+  insert_entry.set_table_id(1);
+  ::p4::v1::TableEntry delete_entry;
+  delete_entry.set_table_id(2);
+
+  // Expectations for the mock objects. The delete fails in the SDK, so only
+  // the insert is recorded in BcmTableManager.
+  std::vector<BcmSdkInterface::L3RouteWrite> writes;
+  std::vector<::util::Status> sdk_results = {
+      ::util::OkStatus(),
+      ::util::Status(StratumErrorSpace(), ERR_ENTRY_NOT_FOUND, "Blah")};
+  EXPECT_CALL(*bcm_sdk_mock_, WriteL3Routes(kUnit, _, _))
+      .WillOnce(DoAll(SaveArg<1>(&writes), SetArgPointee<2>(sdk_results),
+                      Return(::util::OkStatus())));
+  EXPECT_CALL(*bcm_table_manager_mock_,
+              AddTableEntry(EqualsProto(insert_entry)))
+      .WillOnce(Return(::util::OkStatus()));
+
+  std::vector<::util::Status> results;
+  ASSERT_OK(bcm_l3_manager_->WriteTableEntries(
+      {LpmOrHostUpdate(::p4::v1::Update::INSERT, &insert_entry,
+                       insert_flow_entry),
+       LpmOrHostUpdate(::p4::v1::Update::DELETE, &delete_entry,
+                       delete_flow_entry)},
+      &results));
+  ASSERT_EQ(2U, results.size());
+  EXPECT_OK(results[0]);
+  EXPECT_EQ(ERR_ENTRY_NOT_FOUND, results[1].error_code());
+  ASSERT_EQ(2U, writes.size());
+  EXPECT_EQ(BcmSdkInterface::L3RouteWrite::Type::ADD, writes[0].type);
+  EXPECT_FALSE(writes[0].host);
+  EXPECT_EQ(0xc0a00100, writes[0].subnet_ipv4);
+  EXPECT_EQ(0xffffff00, writes[0].mask_ipv4);
+  EXPECT_EQ(200256, writes[0].egress_intf_id);
+  EXPECT_TRUE(writes[0].is_intf_multipath);
+  EXPECT_EQ(BcmSdkInterface::L3RouteWrite::Type::DELETE, writes[1].type);
+  EXPECT_TRUE(writes[1].host);
+  EXPECT_EQ(0xc0a00101, writes[1].subnet_ipv4);
+}
+
+TEST_F(BcmL3ManagerTest, WriteTableEntriesSdkFailure) {
+  const std::string kInsertBcmFlowEntryText = R"(
+      unit: 3
+      bcm_table_type: BCM_TABLE_IPV4_HOST
+      fields: {
+        type: IPV4_DST
+        value {
+          u32: 0xc0a00101
+        }
+      }
+      actions: {
+        type: OUTPUT_L3
+        params {
+          type: EGRESS_INTF_ID
+          value {
+            u32: 100002
+          }
+        }
+      }
+  )";
+  BcmFlowEntry insert_flow_entry;
+  ASSERT_OK(ParseProtoFromString(kInsertBcmFlowEntryText, &insert_flow_entry));
+  ::p4::v1::TableEntry insert_entry;
+  insert_entry.set_table_id(1);
+
+  // None of the writes has been executed, nothing is recorded.
+  EXPECT_CALL(*bcm_sdk_mock_, WriteL3Routes(kUnit, _, _))
+      .WillOnce(
+          Return(::util::Status(StratumErrorSpace(), ERR_INTERNAL, "Blah")));
+  EXPECT_CALL(*bcm_table_manager_mock_, AddTableEntry(_)).Times(0);
+
+  std::vector<::util::Status> results;
+  ::util::Status status = bcm_l3_manager_->WriteTableEntries(
+      {LpmOrHostUpdate(::p4::v1::Update::INSERT, &insert_entry,
+                       insert_flow_entry),
+       LpmOrHostUpdate(::p4::v1::Update::INSERT, &insert_entry,
+                       insert_flow_entry)},
+      &results);
+  EXPECT_EQ(ERR_INTERNAL, status.error_code());
+}
+
+TEST_F(BcmL3ManagerTest, WriteTableEntriesInvalidTableType) {
+  BcmFlowEntry bcm_flow_entry;
+  bcm_flow_entry.set_unit(kUnit);
+  bcm_flow_entry.set_bcm_table_type(BcmFlowEntry::BCM_TABLE_ACL);
+  ::p4::v1::TableEntry p4_table_entry;
+  std::vector<::util::Status> results;
+  // Nothing is left to write, the SDK is not called.
+  ASSERT_OK(bcm_l3_manager_->WriteTableEntries(
+      {LpmOrHostUpdate(::p4::v1::Update::INSERT, &p4_table_entry,
+                       bcm_flow_entry)},
+      &results));
+  ASSERT_EQ(1U, results.size());
+  EXPECT_EQ(ERR_INVALID_PARAM, results[0].error_code());
+}
+
 TEST_F(BcmL3ManagerTest, DeleteLpmOrHostFlowP4ConversionFailure) {
   EXPECT_CALL(*bcm_table_manager_mock_, FillBcmFlowEntry(_, _, _))
       .WillOnce(
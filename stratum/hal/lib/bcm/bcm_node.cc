@@ -11,6 +11,7 @@
 #include "absl/synchronization/mutex.h"
 #include "gflags/gflags.h"
 #include "stratum/hal/lib/common/proto_oneof_writer_wrapper.h"
+#include "stratum/hal/lib/common/write_audit_log.h"
 #include "stratum/hal/lib/common/writer_interface.h"
 #include "stratum/lib/macros.h"
 
@@ -19,11 +20,33 @@
 DEFINE_bool(enable_static_table_writes, true,
             "Enables writes of static table "
             "entries from the P4 pipeline config to the hardware tables");
+DEFINE_bool(bcm_batch_l3_route_writes, true,
+            "Writes runs of consecutive L3 LPM/host table entries of a P4 "
+            "write request as a single batch, which the SDK can commit in a "
+            "few transactions instead of one per entry.");
 
 namespace stratum {
 namespace hal {
 namespace bcm {
 
+namespace {
+
+// Returns true if the flows of the given BCM table are managed as L3 LPM/Host
+// flows by BcmL3Manager.
+bool IsLpmOrHostTable(BcmFlowEntry::BcmTableType bcm_table_type) {
+  switch (bcm_table_type) {
+    case BcmFlowEntry::BCM_TABLE_IPV4_LPM:
+    case BcmFlowEntry::BCM_TABLE_IPV4_HOST:
+    case BcmFlowEntry::BCM_TABLE_IPV6_LPM:
+    case BcmFlowEntry::BCM_TABLE_IPV6_HOST:
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
 BcmNode::BcmNode(BcmAclManager* bcm_acl_manager, BcmL2Manager* bcm_l2_manager,
                  BcmL3Manager* bcm_l3_manager,
                  BcmPacketioManager* bcm_packetio_manager,
@@ -431,18 +454,47 @@ std::unique_ptr<BcmNode> BcmNode::CreateInstance(
 
 ::util::Status BcmNode::DoWriteForwardingEntries(
     const ::p4::v1::WriteRequest& req, std::vector<::util::Status>* results) {
-  bool success = true;
+  // Runs of consecutive L3 LPM/Host table entries are written as a batch. The
+  // batch is flushed before any other update to keep the order of the writes.
+  const bool batch_l3_writes =
+      FLAGS_bcm_batch_l3_route_writes && req.updates_size() > 1;
+  LpmOrHostBatch l3_batch;
+  const size_t first_result = results->size();
   for (const auto& update : req.updates()) {
     ::util::Status status = ::util::OkStatus();
+    if (update.entity().entity_case() != ::p4::v1::Entity::kTableEntry) {
+      FlushLpmOrHostBatch(&l3_batch, results);
+    }
     switch (update.entity().entity_case()) {
       case ::p4::v1::Entity::kExternEntry:
         // TODO(unknown): Implement this.
         status = MAKE_ERROR(ERR_OPER_NOT_SUPPORTED)
                  << "Extern entries are not currently supported.";
         break;
-      case ::p4::v1::Entity::kTableEntry:
-        status = TableWrite(update.entity().table_entry(), update.type());
+      case ::p4::v1::Entity::kTableEntry: {
+        if (!batch_l3_writes) {
+          status = TableWrite(update.entity().table_entry(), update.type());
+          break;
+        }
+        BcmFlowEntry bcm_flow_entry;
+        status = bcm_table_manager_->FillBcmFlowEntry(
+            update.entity().table_entry(), update.type(), &bcm_flow_entry);
+        if (status.ok() &&
+            IsLpmOrHostTable(bcm_flow_entry.bcm_table_type())) {
+          l3_batch.updates.emplace_back(
+              update.type(), &update.entity().table_entry(), bcm_flow_entry);
+          // The result is filled in when the batch is flushed.
+          l3_batch.result_indices.push_back(results->size());
+          results->push_back(::util::OkStatus());
+          continue;
+        }
+        FlushLpmOrHostBatch(&l3_batch, results);
+        if (status.ok()) {
+          status = TableWrite(update.entity().table_entry(), update.type(),
+                              bcm_flow_entry);
+        }
         break;
+      }
       case ::p4::v1::Entity::kActionProfileMember:
         status = ActionProfileMemberWrite(
             update.entity().action_profile_member(), update.type());
@@ -494,18 +546,23 @@ std::unique_ptr<BcmNode> BcmNode::CreateInstance(
                  << " with no plan of support: " << update.ShortDebugString()
                  << ".";
     }
-    success &= status.ok();
     results->push_back(status);
   }
+  FlushLpmOrHostBatch(&l3_batch, results);
 
-  if (!success) {
+  int num_failed = 0;
+  for (size_t i = first_result; i < results->size(); ++i) {
+    if (!(*results)[i].ok()) ++num_failed;
+  }
+  // Logged as a rate-limited summary in the background, to keep the log I/O
+  // off the write path.
+  WriteAuditLog::GetSingleton()->AppendWriteSummary(
+      node_id_, req.updates_size(), num_failed);
+  if (num_failed > 0) {
     return MAKE_ERROR(ERR_AT_LEAST_ONE_OPER_FAILED)
            << "One or more write operations failed.";
   }
 
-  LOG(INFO) << "P4-based forwarding entities written successfully to node with "
-            << "ID " << node_id_ << ".";
-
   return ::util::OkStatus();
 }
 
@@ -518,6 +575,15 @@ std::unique_ptr<BcmNode> BcmNode::CreateInstance(
   BcmFlowEntry bcm_flow_entry;
   RETURN_IF_ERROR(
       bcm_table_manager_->FillBcmFlowEntry(entry, type, &bcm_flow_entry));
+
+  return TableWrite(entry, type, bcm_flow_entry);
+}
+
+::util::Status BcmNode::TableWrite(const ::p4::v1::TableEntry& entry,
+                                   ::p4::v1::Update::Type type,
+                                   const BcmFlowEntry& bcm_flow_entry) {
+  RET_CHECK(type != ::p4::v1::Update::UNSPECIFIED);
+
   BcmFlowEntry::BcmTableType bcm_table_type = bcm_flow_entry.bcm_table_type();
   // Try to program the flow.
   bool consumed = false;  // will be set to true if we know what to do
@@ -655,6 +721,33 @@ std::unique_ptr<BcmNode> BcmNode::CreateInstance(
   return ::util::OkStatus();
 }
 
+void BcmNode::FlushLpmOrHostBatch(LpmOrHostBatch* batch,
+                                  std::vector<::util::Status>* results) {
+  if (batch->updates.empty()) return;
+  if (batch->updates.size() == 1) {
+    // Nothing to gain from a batch of one.
+    const LpmOrHostUpdate& update = batch->updates[0];
+    (*results)[batch->result_indices[0]] =
+        TableWrite(*update.entry, update.type, update.bcm_flow_entry);
+  } else {
+    std::vector<::util::Status> batch_results;
+    ::util::Status status =
+        bcm_l3_manager_->WriteTableEntries(batch->updates, &batch_results);
+    if (status.ok() && batch_results.size() != batch->updates.size()) {
+      status = MAKE_ERROR(ERR_INTERNAL)
+               << "Expected " << batch->updates.size()
+               << " results for L3 table entries, got " << batch_results.size()
+               << ".";
+    }
+    for (size_t i = 0; i < batch->result_indices.size(); ++i) {
+      (*results)[batch->result_indices[i]] =
+          status.ok() ? batch_results[i] : status;
+    }
+  }
+  batch->updates.clear();
+  batch->result_indices.clear();
+}
+
 ::util::Status BcmNode::ActionProfileMemberWrite(
     const ::p4::v1::ActionProfileMember& member, ::p4::v1::Update::Type type) {
   bool consumed = false;  // will be set to true if we know what to do
@@ -144,10 +144,28 @@ class BcmNode {
       const ::p4::v1::WriteRequest& req, std::vector<::util::Status>* results)
       EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
+  // A run of consecutive IPv4/IPv6 L3 LPM/Host table entry updates of a write
+  // request, pending to be written to BcmL3Manager as a single batch.
+  struct LpmOrHostBatch {
+    std::vector<LpmOrHostUpdate> updates;
+    // The index in the write results of every update.
+    std::vector<size_t> result_indices;
+  };
+
   // Write a single P4 TableEntry.
   ::util::Status TableWrite(const ::p4::v1::TableEntry& entry,
                             ::p4::v1::Update::Type type);
 
+  // Same as above, for a TableEntry whose BcmFlowEntry is already populated.
+  ::util::Status TableWrite(const ::p4::v1::TableEntry& entry,
+                            ::p4::v1::Update::Type type,
+                            const BcmFlowEntry& bcm_flow_entry);
+
+  // Writes the pending L3 LPM/Host updates of the given batch, stores their
+  // status in 'results' and clears the batch.
+  void FlushLpmOrHostBatch(LpmOrHostBatch* batch,
+                           std::vector<::util::Status>* results);
+
   // Write a single P4 ActionProfileMember.
   ::util::Status ActionProfileMemberWrite(
       const ::p4::v1::ActionProfileMember& member, ::p4::v1::Update::Type type);
@@ -33,6 +33,7 @@ using ::testing::HasSubstr;
 using ::testing::InSequence;
 using ::testing::Invoke;
 using ::testing::Return;
+using ::testing::SizeIs;
 using ::testing::WithArgs;
 
 MATCHER_P(EqualsProto, proto, "") { return ProtoEqual(arg, proto); }
@@ -1343,6 +1344,64 @@ TEST_F(BcmNodeTest, WriteForwardingEntriesSuccess_DeleteTableEntry_Tunnel) {
   EXPECT_EQ(1U, results.size());
 }
 
+TEST_F(BcmNodeTest, WriteForwardingEntriesBatchesLpmOrHostTableEntries) {
+  ASSERT_NO_FATAL_FAILURE(PushChassisConfigWithCheck());
+
+  // Two L3 entries, followed by an ACL entry and another L3 entry.
+  const std::vector<BcmFlowEntry::BcmTableType> kTableTypes = {
+      BcmFlowEntry::BCM_TABLE_IPV4_LPM, BcmFlowEntry::BCM_TABLE_IPV6_HOST,
+      BcmFlowEntry::BCM_TABLE_ACL, BcmFlowEntry::BCM_TABLE_IPV4_HOST};
+  ::p4::v1::WriteRequest req;
+  for (size_t i = 0; i < kTableTypes.size(); ++i) {
+    SetupTableEntryToInsert(&req, kNodeId)->set_table_id(i + 1);
+  }
+
+  InSequence sequence;
+  for (size_t i = 0; i < 3; ++i) {
+    const BcmFlowEntry::BcmTableType table_type = kTableTypes[i];
+    const auto& table_entry = req.updates(i).entity().table_entry();
+    EXPECT_CALL(
+        *bcm_table_manager_mock_,
+        FillBcmFlowEntry(EqualsProto(table_entry), ::p4::v1::Update::INSERT, _))
+        .WillOnce(DoAll(WithArgs<2>(Invoke([table_type](BcmFlowEntry* x) {
+                          x->set_bcm_table_type(table_type);
+                        })),
+                        Return(::util::OkStatus())));
+  }
+  // The first two entries are written as a batch before the ACL entry, the
+  // second one fails.
+  EXPECT_CALL(*bcm_l3_manager_mock_, WriteTableEntries(SizeIs(2), _))
+      .WillOnce(WithArgs<1>(Invoke([](std::vector<::util::Status>* results) {
+        *results = {::util::OkStatus(),
+                    ::util::Status(StratumErrorSpace(), ERR_ENTRY_EXISTS,
+                                   "Blah")};
+        return ::util::OkStatus();
+      })));
+  EXPECT_CALL(*bcm_acl_manager_mock_, InsertTableEntry(_))
+      .WillOnce(Return(::util::OkStatus()));
+  const auto& last_table_entry = req.updates(3).entity().table_entry();
+  EXPECT_CALL(*bcm_table_manager_mock_,
+              FillBcmFlowEntry(EqualsProto(last_table_entry),
+                               ::p4::v1::Update::INSERT, _))
+      .WillOnce(DoAll(WithArgs<2>(Invoke([](BcmFlowEntry* x) {
+                        x->set_bcm_table_type(
+                            BcmFlowEntry::BCM_TABLE_IPV4_HOST);
+                      })),
+                      Return(::util::OkStatus())));
+  // A single trailing L3 entry is written on its own.
+  EXPECT_CALL(*bcm_l3_manager_mock_, InsertTableEntry(_))
+      .WillOnce(Return(::util::OkStatus()));
+
+  std::vector<::util::Status> results = {};
+  ::util::Status status = WriteForwardingEntries(req, &results);
+  EXPECT_EQ(ERR_AT_LEAST_ONE_OPER_FAILED, status.error_code());
+  ASSERT_EQ(4U, results.size());
+  EXPECT_OK(results[0]);
+  EXPECT_EQ(ERR_ENTRY_EXISTS, results[1].error_code());
+  EXPECT_OK(results[2]);
+  EXPECT_OK(results[3]);
+}
+
 TEST_F(BcmNodeTest, WriteForwardingEntriesSuccess_InsertActionProfileMember) {
   ASSERT_NO_FATAL_FAILURE(PushChassisConfigWithCheck());
 
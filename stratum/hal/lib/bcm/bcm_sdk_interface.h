@@ -160,6 +160,46 @@ class BcmSdkInterface {
     BoolFlag stats_read_through_enable;
   };
 
+  // L3RouteWrite encapsulates an add, modify or delete of an IPv4/IPv6 L3 LPM
+  // route or host entry. This is used as part of the batch given to
+  // WriteL3Routes() API.
+  struct L3RouteWrite {
+    enum class Type {
+      ADD,
+      MODIFY,
+      DELETE,
+    };
+    Type type;
+    // True for IPv6 entries, false for IPv4 entries.
+    bool ipv6;
+    // True for host entries, false for LPM routes.
+    bool host;
+    int vrf;
+    // The key of IPv4 entries. The mask is ignored for host entries.
+    uint32 subnet_ipv4;
+    uint32 mask_ipv4;
+    // The key of IPv6 entries. The mask is ignored for host entries.
+    std::string subnet_ipv6;
+    std::string mask_ipv6;
+    // The data of the entry, ignored for deletes. is_intf_multipath is
+    // ignored for host entries.
+    int class_id;
+    int egress_intf_id;
+    bool is_intf_multipath;
+    L3RouteWrite()
+        : type(Type::ADD),
+          ipv6(false),
+          host(false),
+          vrf(0),
+          subnet_ipv4(0),
+          mask_ipv4(0),
+          subnet_ipv6(),
+          mask_ipv6(),
+          class_id(0),
+          egress_intf_id(0),
+          is_intf_multipath(false) {}
+  };
+
   // LinkscanEvent encapsulates the information received on a linkscan event.
   struct LinkscanEvent {
     int unit;
@@ -224,6 +264,14 @@ class BcmSdkInterface {
   virtual ::util::Status GetPortCounters(int unit, int port,
                                          PortCounters* pc) = 0;
 
+  // Gets the counters of all the given logical ports of a unit in one sweep.
+  // The counters of ports[i] are stored in (*counters)[i]. This is cheaper than
+  // calling GetPortCounters() for each port, as all the counters of a port (or
+  // of all the ports) are read with a single SDK call where possible.
+  virtual ::util::Status GetPortCountersBulk(
+      int unit, const std::vector<int>& ports,
+      std::vector<PortCounters>* counters) = 0;
+
   // Starts the diag shell server for listening to client telnet connections.
   virtual ::util::Status StartDiagShellServer() = 0;
 
@@ -446,6 +494,17 @@ class BcmSdkInterface {
   virtual ::util::Status DeleteL3HostIpv6(int unit, int vrf,
                                           const std::string& ipv6) = 0;
 
+  // Adds, modifies and deletes a batch of IPv4/IPv6 L3 LPM routes and host
+  // entries. The writes are independent of each other and are executed in the
+  // given order, with the same semantics as the Add/Modify/Delete calls above.
+  // SDKs which support it commit the batch in a few transactions instead of
+  // one round trip per entry. The status of every write is stored in 'results',
+  // in the order of 'writes'. An error is returned only if the batch could not
+  // be executed at all, in which case none of the writes has been executed.
+  virtual ::util::Status WriteL3Routes(
+      int unit, const std::vector<L3RouteWrite>& writes,
+      std::vector<::util::Status>* results) = 0;
+
   // Adds an entry to match the given (vlan, vlan_mask, dst_mac, dst_mac_mask)
   // to the my station TCAM, with the given priority. NOOP if the entry already
   // exists. All the IPv4/IPv6 packets, independent of the src port, will be
@@ -40,6 +40,9 @@ class BcmSdkMock : public BcmSdkInterface {
                ::util::Status(int unit, int port, BcmPortOptions* options));
   MOCK_METHOD3(GetPortCounters,
                ::util::Status(int unit, int port, PortCounters* pc));
+  MOCK_METHOD3(GetPortCountersBulk,
+               ::util::Status(int unit, const std::vector<int>& ports,
+                              std::vector<PortCounters>* counters));
   MOCK_METHOD0(StartDiagShellServer, ::util::Status());
   MOCK_METHOD1(StartLinkscan, ::util::Status(int unit));
   MOCK_METHOD1(StopLinkscan, ::util::Status(int unit));
@@ -121,6 +124,9 @@ class BcmSdkMock : public BcmSdkInterface {
                ::util::Status(int unit, int vrf, uint32 ipv4));
   MOCK_METHOD3(DeleteL3HostIpv6,
                ::util::Status(int unit, int vrf, const std::string& ipv6));
+  MOCK_METHOD3(WriteL3Routes,
+               ::util::Status(int unit, const std::vector<L3RouteWrite>& writes,
+                              std::vector<::util::Status>* results));
   MOCK_METHOD6(AddMyStationEntry,
                ::util::StatusOr<int>(int unit, int priority, int vlan,
                                      int vlan_mask, uint64 dst_mac,
@@ -0,0 +1,394 @@
+// Copyright 2018-present Open Networking Foundation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "stratum/hal/lib/bcm/bcm_table_entry_store.h"
+
+#include <algorithm>
+
+#include "absl/hash/hash.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/wire_format_lite.h"
+#include "stratum/glue/logging.h"
+
+namespace stratum {
+namespace hal {
+namespace bcm {
+
+constexpr uint32 BcmTableEntryStore::Pool::kNotFound;
+constexpr uint32 BcmTableEntryStore::Pool::kFree;
+constexpr uint32 BcmTableEntryStore::Pool::kEmptySlot;
+constexpr uint32 BcmTableEntryStore::Pool::kDeletedSlot;
+constexpr uint32 BcmTableEntryStore::Pool::kFirstId;
+
+namespace {
+
+// Wire format tag of a TableEntry match field, i.e. its field number and the
+// length-delimited wire type. Packed match fields with this tag are parsed
+// back as match fields of the TableEntry.
+constexpr uint32 kMatchTag = (::p4::v1::TableEntry::kMatchFieldNumber << 3) | 2;
+
+// Wire format tag of the field ID of a FieldMatch.
+constexpr uint32 kFieldIdTag = ::p4::v1::FieldMatch::kFieldIdFieldNumber << 3;
+
+// Entries up to this size are serialized into inline storage while building
+// their key.
+constexpr size_t kInlineEntrySize = 512;
+
+// Arenas with less dead bytes are not compacted.
+constexpr size_t kMinCompactionBytes = 4096;
+
+void AppendVarint(uint32 value, std::string* out) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<char>(value | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<char>(value));
+}
+
+// Returns true for the fields which do not identify an entry.
+bool IsNonKeyField(uint32 field_number) {
+  switch (field_number) {
+    case ::p4::v1::TableEntry::kTableIdFieldNumber:
+    case ::p4::v1::TableEntry::kActionFieldNumber:
+    case ::p4::v1::TableEntry::kControllerMetadataFieldNumber:
+    case ::p4::v1::TableEntry::kMeterConfigFieldNumber:
+    case ::p4::v1::TableEntry::kCounterDataFieldNumber:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Returns the field ID of the serialized FieldMatch, 0 if it has none.
+uint32 MatchFieldId(const uint8* data, int size) {
+  ::google::protobuf::io::CodedInputStream input(data, size);
+  uint32 tag;
+  while ((tag = input.ReadTag()) != 0) {
+    if (tag == kFieldIdTag) {
+      uint32 field_id = 0;
+      input.ReadVarint32(&field_id);
+      return field_id;
+    }
+    if (!::google::protobuf::internal::WireFormatLite::SkipField(&input, tag)) {
+      break;
+    }
+  }
+  return 0;
+}
+
+// The bytes of a field of a serialized entry, including its tag.
+struct FieldSpan {
+  uint32 begin;
+  uint32 end;
+  // Only set for match fields.
+  uint32 field_id;
+};
+
+}  // namespace
+
+BcmTableEntryStore::Key::Key(const ::p4::v1::TableEntry& entry,
+                             std::string* value) {
+  using ::google::protobuf::internal::WireFormatLite;
+
+  // Serialize the entry once and split its wire format into the key fields,
+  // which are copied right away, the match fields and the non-key fields.
+  // Unknown fields are part of the key.
+  const size_t size = entry.ByteSizeLong();
+  absl::InlinedVector<char, kInlineEntrySize> serialized(size);
+  const uint8* data = reinterpret_cast<const uint8*>(serialized.data());
+  entry.SerializeWithCachedSizesToArray(
+      reinterpret_cast<uint8*>(serialized.data()));
+  absl::InlinedVector<FieldSpan, 8> matches;
+  absl::InlinedVector<FieldSpan, 4> non_key_fields;
+  ::google::protobuf::io::CodedInputStream input(data, size);
+  while (true) {
+    const uint32 begin = input.CurrentPosition();
+    const uint32 tag = input.ReadTag();
+    if (tag == 0) break;
+    if (tag == kMatchTag) {
+      uint32 length = 0;
+      input.ReadVarint32(&length);
+      const uint32 payload = input.CurrentPosition();
+      input.Skip(length);
+      FieldSpan match = {begin, payload + length,
+                         MatchFieldId(data + payload, length)};
+      matches.push_back(match);
+      continue;
+    }
+    // Only fails if the serialization is corrupted.
+    bool ok = WireFormatLite::SkipField(&input, tag);
+    DCHECK(ok) << "Failed to split the serialized entry "
+               << entry.ShortDebugString() << ".";
+    FieldSpan field = {begin, static_cast<uint32>(input.CurrentPosition()),
+                       0};
+    if (IsNonKeyField(WireFormatLite::GetTagFieldNumber(tag))) {
+      non_key_fields.push_back(field);
+    } else {
+      bytes_.insert(bytes_.end(), data + field.begin, data + field.end);
+    }
+  }
+
+  // The canonical order of the match fields is by field ID. Match fields
+  // with the same ID, which are invalid, are ordered by their serialization.
+  const int num_matches = matches.size();
+  absl::InlinedVector<int, 8> order(num_matches);
+  for (int i = 0; i < num_matches; ++i) order[i] = i;
+  std::stable_sort(
+      order.begin(), order.end(), [&matches, data](int l, int r) {
+        if (matches[l].field_id != matches[r].field_id) {
+          return matches[l].field_id < matches[r].field_id;
+        }
+        return absl::string_view(
+                   reinterpret_cast<const char*>(data) + matches[l].begin,
+                   matches[l].end - matches[l].begin) <
+               absl::string_view(
+                   reinterpret_cast<const char*>(data) + matches[r].begin,
+                   matches[r].end - matches[r].begin);
+      });
+  for (int i : order) {
+    bytes_.insert(bytes_.end(), data + matches[i].begin, data + matches[i].end);
+  }
+  hash_ = Hash(bytes());
+  if (value == nullptr) return;
+
+  // The value starts with the canonical position of each match field, or just
+  // a zero if the match fields are in canonical order already.
+  value->clear();
+  bool canonical = true;
+  for (int i = 0; i < num_matches; ++i) canonical &= (order[i] == i);
+  if (canonical) {
+    AppendVarint(0, value);
+  } else {
+    absl::InlinedVector<int, 8> position(num_matches);
+    for (int i = 0; i < num_matches; ++i) position[order[i]] = i;
+    AppendVarint(num_matches, value);
+    for (int p : position) AppendVarint(p, value);
+  }
+  for (const auto& field : non_key_fields) {
+    value->append(reinterpret_cast<const char*>(data) + field.begin,
+                  field.end - field.begin);
+  }
+}
+
+uint32 BcmTableEntryStore::Pool::Find(absl::string_view bytes,
+                                      uint32 hash) const {
+  if (slots_.empty()) return kNotFound;
+  const size_t mask = slots_.size() - 1;
+  // The load factor is kept below 1, so there is always an empty slot.
+  for (size_t i = hash & mask;; i = (i + 1) & mask) {
+    const uint32 slot = slots_[i];
+    if (slot == kEmptySlot) return kNotFound;
+    if (slot == kDeletedSlot) continue;
+    const uint32 id = slot - kFirstId;
+    const Record& record = records_[id];
+    if (record.hash == hash && record.size == bytes.size() &&
+        Bytes(id) == bytes) {
+      return id;
+    }
+  }
+}
+
+uint32 BcmTableEntryStore::Pool::Add(absl::string_view bytes, uint32 hash) {
+  // Keep the index at most 3/4 full, including deleted slots. Rehashing drops
+  // the deleted slots, so the index only grows if needed for the live IDs.
+  if ((size_ + tombstones_ + 1) * 4 > slots_.size() * 3) {
+    size_t num_slots = 16;
+    while (num_slots < (size_ + 1) * 2) num_slots <<= 1;
+    Rehash(num_slots);
+  }
+  uint32 id;
+  if (!free_ids_.empty()) {
+    id = free_ids_.back();
+    free_ids_.pop_back();
+  } else {
+    id = records_.size();
+    records_.push_back(Record());
+  }
+  Record& record = records_[id];
+  record.offset = arena_.size();
+  record.size = bytes.size();
+  record.hash = hash;
+  arena_.insert(arena_.end(), bytes.begin(), bytes.end());
+  const size_t mask = slots_.size() - 1;
+  size_t i = hash & mask;
+  while (slots_[i] >= kFirstId) i = (i + 1) & mask;
+  if (slots_[i] == kDeletedSlot) --tombstones_;
+  slots_[i] = kFirstId + id;
+  ++size_;
+
+  return id;
+}
+
+void BcmTableEntryStore::Pool::Remove(uint32 id) {
+  Record& record = records_[id];
+  const size_t mask = slots_.size() - 1;
+  size_t i = record.hash & mask;
+  while (slots_[i] != kFirstId + id) i = (i + 1) & mask;
+  // A slot followed by an empty slot ends all probe sequences through it, so
+  // it can be emptied instead of being marked deleted.
+  if (slots_[(i + 1) & mask] == kEmptySlot) {
+    slots_[i] = kEmptySlot;
+  } else {
+    slots_[i] = kDeletedSlot;
+    ++tombstones_;
+  }
+  --size_;
+  dead_bytes_ += record.size;
+  record.offset = kFree;
+  record.size = 0;
+  free_ids_.push_back(id);
+  MaybeCompact();
+}
+
+size_t BcmTableEntryStore::Pool::MemoryUsage() const {
+  return arena_.capacity() + records_.capacity() * sizeof(Record) +
+         (free_ids_.capacity() + slots_.capacity()) * sizeof(uint32);
+}
+
+void BcmTableEntryStore::Pool::Clear() {
+  // Swapping with empty vectors releases the memory, unlike clear().
+  std::vector<char>().swap(arena_);
+  std::vector<Record>().swap(records_);
+  std::vector<uint32>().swap(free_ids_);
+  std::vector<uint32>().swap(slots_);
+  dead_bytes_ = 0;
+  size_ = 0;
+  tombstones_ = 0;
+}
+
+void BcmTableEntryStore::Pool::Rehash(size_t num_slots) {
+  std::vector<uint32> slots(num_slots, kEmptySlot);
+  const size_t mask = num_slots - 1;
+  for (uint32 id = 0; id < records_.size(); ++id) {
+    if (!IsLive(id)) continue;
+    size_t i = records_[id].hash & mask;
+    while (slots[i] != kEmptySlot) i = (i + 1) & mask;
+    slots[i] = kFirstId + id;
+  }
+  slots_.swap(slots);
+  tombstones_ = 0;
+}
+
+void BcmTableEntryStore::Pool::MaybeCompact() {
+  if (dead_bytes_ < kMinCompactionBytes || dead_bytes_ * 2 < arena_.size()) {
+    return;
+  }
+  std::vector<char> arena;
+  arena.reserve(arena_.size() - dead_bytes_);
+  for (auto& record : records_) {
+    if (record.offset == kFree) continue;
+    const uint32 offset = arena.size();
+    arena.insert(arena.end(), arena_.begin() + record.offset,
+                 arena_.begin() + record.offset + record.size);
+    record.offset = offset;
+  }
+  arena_.swap(arena);
+  dead_bytes_ = 0;
+}
+
+BcmTableEntryStore::const_iterator::const_iterator(
+    const BcmTableEntryStore* store, uint32 id)
+    : store_(store), id_(id) {
+  SkipFree();
+}
+
+::p4::v1::TableEntry BcmTableEntryStore::const_iterator::operator*() const {
+  ::p4::v1::TableEntry entry;
+  store_->Decode(id_, &entry);
+  return entry;
+}
+
+BcmTableEntryStore::const_iterator&
+BcmTableEntryStore::const_iterator::operator++() {
+  ++id_;
+  SkipFree();
+  return *this;
+}
+
+void BcmTableEntryStore::const_iterator::SkipFree() {
+  while (id_ < store_->keys_.NumIds() && !store_->keys_.IsLive(id_)) ++id_;
+}
+
+bool BcmTableEntryStore::Contains(const ::p4::v1::TableEntry& key) const {
+  return FindKeyId(Key(key)) != Pool::kNotFound;
+}
+
+bool BcmTableEntryStore::Find(const ::p4::v1::TableEntry& key,
+                              ::p4::v1::TableEntry* entry) const {
+  const uint32 key_id = FindKeyId(Key(key));
+  if (key_id == Pool::kNotFound) return false;
+  if (entry != nullptr) Decode(key_id, entry);
+  return true;
+}
+
+bool BcmTableEntryStore::Insert(const ::p4::v1::TableEntry& entry) {
+  std::string value;
+  const Key key(entry, &value);
+  if (FindKeyId(key) != Pool::kNotFound) return false;
+  const uint32 value_hash = Hash(value);
+  uint32 value_id = values_.Find(value, value_hash);
+  if (value_id == Pool::kNotFound) {
+    value_id = values_.Add(value, value_hash);
+    if (value_id >= value_refs_.size()) value_refs_.resize(value_id + 1, 0);
+  }
+  ++value_refs_[value_id];
+  const uint32 key_id = keys_.Add(key.bytes(), key.hash());
+  if (key_id >= key_values_.size()) key_values_.resize(key_id + 1);
+  key_values_[key_id] = value_id;
+
+  return true;
+}
+
+bool BcmTableEntryStore::Erase(const ::p4::v1::TableEntry& key,
+                               ::p4::v1::TableEntry* entry) {
+  const uint32 key_id = FindKeyId(Key(key));
+  if (key_id == Pool::kNotFound) return false;
+  if (entry != nullptr) Decode(key_id, entry);
+  const uint32 value_id = key_values_[key_id];
+  keys_.Remove(key_id);
+  if (--value_refs_[value_id] == 0) values_.Remove(value_id);
+
+  return true;
+}
+
+void BcmTableEntryStore::Clear() {
+  keys_.Clear();
+  values_.Clear();
+  std::vector<uint32>().swap(key_values_);
+  std::vector<uint32>().swap(value_refs_);
+}
+
+size_t BcmTableEntryStore::MemoryUsage() const {
+  return keys_.MemoryUsage() + values_.MemoryUsage() +
+         (key_values_.capacity() + value_refs_.capacity()) * sizeof(uint32);
+}
+
+uint32 BcmTableEntryStore::Hash(absl::string_view bytes) {
+  const uint64 hash = absl::Hash<absl::string_view>()(bytes);
+  return static_cast<uint32>(hash ^ (hash >> 32));
+}
+
+void BcmTableEntryStore::Decode(uint32 key_id,
+                                ::p4::v1::TableEntry* entry) const {
+  const absl::string_view key = keys_.Bytes(key_id);
+  bool ok = entry->ParseFromArray(key.data(), key.size());
+  const absl::string_view value = values_.Bytes(key_values_[key_id]);
+  ::google::protobuf::io::CodedInputStream input(
+      reinterpret_cast<const uint8*>(value.data()), value.size());
+  uint32 num_positions = 0;
+  ok &= input.ReadVarint32(&num_positions);
+  std::vector<uint32> positions(num_positions);
+  for (uint32& p : positions) ok &= input.ReadVarint32(&p);
+  ok &= entry->MergeFromCodedStream(&input);
+  // Only fails if the store is corrupted.
+  DCHECK(ok) << "Failed to decode the entry with key ID " << key_id << ".";
+  if (num_positions == 0) return;
+
+  ::google::protobuf::RepeatedPtrField<::p4::v1::FieldMatch> matches;
+  matches.Swap(entry->mutable_match());
+  for (uint32 p : positions) entry->add_match()->Swap(matches.Mutable(p));
+}
+
+}  // namespace bcm
+}  // namespace hal
+}  // namespace stratum
@@ -0,0 +1,214 @@
+// Copyright 2018-present Open Networking Foundation
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef STRATUM_HAL_LIB_BCM_BCM_TABLE_ENTRY_STORE_H_
+#define STRATUM_HAL_LIB_BCM_BCM_TABLE_ENTRY_STORE_H_
+
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "absl/container/inlined_vector.h"
+#include "absl/strings/string_view.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "stratum/glue/integral_types.h"
+
+namespace stratum {
+namespace hal {
+namespace bcm {
+
+// BcmTableEntryStore is a compact set of P4 TableEntry protos, used as the
+// shadow of the flows programmed into a BCM table. Two entries are equivalent
+// if they have the same match fields (in any order), priority and other key
+// fields, regardless of their action, controller metadata, meter config and
+// counter data. Instead of keeping a proto per entry, each entry is stored as:
+//  - A packed key (see Key), appended to a byte arena.
+//  - The ID of an interned value holding the serialized non-key fields. Many
+//    entries usually share the same action (e.g. the routes towards a nexthop
+//    group), so the value is stored once for all of them.
+// Keys and values are indexed by open addressing hash tables of 32-bit IDs.
+// The TableEntry protos are rebuilt on demand, e.g. for Read RPCs. Arenas are
+// compacted once half of their bytes belong to deleted entries.
+class BcmTableEntryStore {
+ public:
+  // Iterates over the entries in an unspecified order. The entries are
+  // rebuilt when dereferenced, hence returned by value. Any change to the
+  // store invalidates the iterators.
+  class const_iterator {
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = ::p4::v1::TableEntry;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const ::p4::v1::TableEntry*;
+    using reference = ::p4::v1::TableEntry;
+
+    ::p4::v1::TableEntry operator*() const;
+    const_iterator& operator++();
+    bool operator==(const const_iterator& other) const {
+      return id_ == other.id_;
+    }
+    bool operator!=(const const_iterator& other) const {
+      return id_ != other.id_;
+    }
+
+   private:
+    friend class BcmTableEntryStore;
+    const_iterator(const BcmTableEntryStore* store, uint32 id);
+    // Advances id_ to the next live entry, if id_ is not live.
+    void SkipFree();
+
+    const BcmTableEntryStore* store_;
+    uint32 id_;
+  };
+
+  // The canonical packed key of an entry and its hash. The key holds the
+  // serialized key fields followed by the serialized match fields ordered by
+  // field ID, so that it does not depend on the order of the match fields.
+  // Two entries are equivalent iff their keys are equal. The entry is
+  // serialized once and split on the wire format, into inline storage, so
+  // building the key of a typical entry does not allocate.
+  class Key {
+   public:
+    explicit Key(const ::p4::v1::TableEntry& entry) : Key(entry, nullptr) {}
+
+    absl::string_view bytes() const {
+      return absl::string_view(bytes_.data(), bytes_.size());
+    }
+    uint32 hash() const { return hash_; }
+
+    bool operator==(const Key& other) const {
+      return hash_ == other.hash_ && bytes() == other.bytes();
+    }
+    bool operator!=(const Key& other) const { return !(*this == other); }
+
+   private:
+    friend class BcmTableEntryStore;
+
+    // Also encodes the non-key fields and the order of the match fields into
+    // value, if not null.
+    Key(const ::p4::v1::TableEntry& entry, std::string* value);
+
+    absl::InlinedVector<char, 128> bytes_;
+    uint32 hash_;
+  };
+
+  BcmTableEntryStore() : keys_(), values_(), key_values_(), value_refs_() {}
+
+  // Returns true if the store contains an entry equivalent to key.
+  bool Contains(const ::p4::v1::TableEntry& key) const;
+
+  // Looks up the entry equivalent to key and copies it to entry, if not null.
+  // Returns false if there is no such entry.
+  bool Find(const ::p4::v1::TableEntry& key, ::p4::v1::TableEntry* entry) const;
+
+  // Adds the entry. Returns false if an equivalent entry exists already.
+  bool Insert(const ::p4::v1::TableEntry& entry);
+
+  // Removes the entry equivalent to key and moves it to entry, if not null.
+  // Returns false if there is no such entry.
+  bool Erase(const ::p4::v1::TableEntry& key, ::p4::v1::TableEntry* entry);
+
+  // Removes all entries.
+  void Clear();
+
+  // Returns the number of entries.
+  size_t size() const { return keys_.size(); }
+  bool empty() const { return keys_.size() == 0; }
+
+  // Returns the number of distinct values shared by the entries.
+  size_t NumValues() const { return values_.size(); }
+
+  // Returns the number of heap bytes allocated by the store.
+  size_t MemoryUsage() const;
+
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, keys_.NumIds()); }
+
+ private:
+  // A set of byte strings stored in an arena and identified by dense IDs,
+  // indexed by an open addressing hash table with linear probing.
+  class Pool {
+   public:
+    static constexpr uint32 kNotFound = 0xFFFFFFFF;
+
+    Pool()
+        : arena_(),
+          dead_bytes_(0),
+          records_(),
+          free_ids_(),
+          slots_(),
+          size_(0),
+          tombstones_(0) {}
+
+    // Returns the ID of the given bytes or kNotFound.
+    uint32 Find(absl::string_view bytes, uint32 hash) const;
+    // Adds bytes, which must not be in the pool yet, and returns their ID.
+    // IDs of removed bytes are reused.
+    uint32 Add(absl::string_view bytes, uint32 hash);
+    // Removes the bytes with the given live ID.
+    void Remove(uint32 id);
+    absl::string_view Bytes(uint32 id) const {
+      return absl::string_view(arena_.data() + records_[id].offset,
+                               records_[id].size);
+    }
+    bool IsLive(uint32 id) const { return records_[id].offset != kFree; }
+    // Returns one past the largest ID ever handed out.
+    uint32 NumIds() const { return records_.size(); }
+    size_t size() const { return size_; }
+    size_t MemoryUsage() const;
+    void Clear();
+
+   private:
+    static constexpr uint32 kFree = 0xFFFFFFFF;
+    // Slot values below kFirstId are not IDs.
+    static constexpr uint32 kEmptySlot = 0;
+    static constexpr uint32 kDeletedSlot = 1;
+    static constexpr uint32 kFirstId = 2;
+
+    struct Record {
+      uint32 offset;  // kFree if the ID is free.
+      uint32 size;
+      uint32 hash;
+    };
+
+    // Rebuilds the index with the given number of slots, a power of 2.
+    void Rehash(size_t num_slots);
+    // Rewrites the arena without the bytes of removed records, once they
+    // make up half of it.
+    void MaybeCompact();
+
+    // Offsets into the arena are 32 bits, which limits the live bytes of a pool
+    // to 4GB.
+    std::vector<char> arena_;
+    size_t dead_bytes_;
+    std::vector<Record> records_;
+    std::vector<uint32> free_ids_;
+    // kEmptySlot, kDeletedSlot or kFirstId + ID.
+    std::vector<uint32> slots_;
+    size_t size_;
+    size_t tombstones_;
+  };
+
+  static uint32 Hash(absl::string_view bytes);
+
+  // Rebuilds the entry with the given key ID.
+  void Decode(uint32 key_id, ::p4::v1::TableEntry* entry) const;
+
+  // Returns the ID of the key or Pool::kNotFound.
+  uint32 FindKeyId(const Key& key) const {
+    return keys_.Find(key.bytes(), key.hash());
+  }
+
+  Pool keys_;
+  Pool values_;
+  // Map from key ID to the ID of its value.
+  std::vector<uint32> key_values_;
+  // Map from value ID to the number of keys sharing it.
+  std::vector<uint32> value_refs_;
+};
+
+}  // namespace bcm
+}  // namespace hal
+}  // namespace stratum
+
+#endif  // STRATUM_HAL_LIB_BCM_BCM_TABLE_ENTRY_STORE_H_
@@ -0,0 +1,200 @@
+// Copyright 2018-present Open Networking Foundation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "stratum/hal/lib/bcm/bcm_table_entry_store.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "stratum/glue/status/status_test_util.h"
+#include "stratum/lib/test_utils/matchers.h"
+#include "stratum/lib/utils.h"
+
+namespace stratum {
+namespace hal {
+namespace bcm {
+namespace {
+
+using test_utils::EqualsProto;
+
+constexpr char kRouteEntry[] = R"pb(
+    table_id: 1
+    match {
+      field_id: 2
+      lpm {
+        value: "\x0a\x00\x00\x00"
+        prefix_len: 24
+      }
+    }
+    match {
+      field_id: 1
+      exact { value: "\x01" }
+    }
+    action {
+      action_profile_group_id: 100
+    })pb";
+
+// Returns a route entry towards one of num_groups groups. Routes with
+// consecutive IDs point to different groups.
+::p4::v1::TableEntry RouteEntry(uint32 route_id, uint32 num_groups) {
+  ::p4::v1::TableEntry entry;
+  CHECK_OK(ParseProtoFromString(kRouteEntry, &entry));
+  std::string prefix(4, '\0');
+  prefix[0] = static_cast<char>(route_id >> 16);
+  prefix[1] = static_cast<char>(route_id >> 8);
+  prefix[2] = static_cast<char>(route_id);
+  entry.mutable_match(0)->mutable_lpm()->set_value(prefix);
+  entry.mutable_action()->set_action_profile_group_id(route_id % num_groups);
+  return entry;
+}
+
+TEST(BcmTableEntryStoreTest, EntriesAreRebuiltExactly) {
+  BcmTableEntryStore store;
+  ::p4::v1::TableEntry entry = RouteEntry(1, 1);
+  entry.set_priority(10);
+  entry.set_controller_metadata(42);
+  entry.mutable_counter_data()->set_packet_count(7);
+  ASSERT_TRUE(store.Insert(entry));
+  EXPECT_EQ(1, store.size());
+
+  // The match fields keep their original, non-canonical order.
+  ::p4::v1::TableEntry found;
+  ASSERT_TRUE(store.Find(entry, &found));
+  EXPECT_THAT(found, EqualsProto(entry));
+  std::vector<::p4::v1::TableEntry> entries(store.begin(), store.end());
+  ASSERT_EQ(1, entries.size());
+  EXPECT_THAT(entries[0], EqualsProto(entry));
+}
+
+TEST(BcmTableEntryStoreTest, EquivalentEntriesShareTheKey) {
+  BcmTableEntryStore store;
+  ::p4::v1::TableEntry entry = RouteEntry(1, 1);
+  ASSERT_TRUE(store.Insert(entry));
+
+  // Permuted match fields and a different action match the same entry.
+  ::p4::v1::TableEntry equivalent = entry;
+  equivalent.mutable_match()->SwapElements(0, 1);
+  equivalent.mutable_action()->set_action_profile_member_id(5);
+  equivalent.set_table_id(2);
+  EXPECT_TRUE(store.Contains(equivalent));
+  EXPECT_FALSE(store.Insert(equivalent));
+
+  // Any other key field makes a difference.
+  ::p4::v1::TableEntry other = entry;
+  other.set_priority(1);
+  EXPECT_FALSE(store.Contains(other));
+  other = entry;
+  other.set_is_default_action(true);
+  EXPECT_FALSE(store.Contains(other));
+  other = entry;
+  *other.add_match() = entry.match(0);
+  EXPECT_FALSE(store.Contains(other));
+
+  ::p4::v1::TableEntry erased;
+  ASSERT_TRUE(store.Erase(equivalent, &erased));
+  EXPECT_THAT(erased, EqualsProto(entry));
+  EXPECT_TRUE(store.empty());
+  EXPECT_FALSE(store.Erase(entry, nullptr));
+}
+
+TEST(BcmTableEntryStoreTest, KeysAreCanonical) {
+  const ::p4::v1::TableEntry entry = RouteEntry(1, 1);
+  const BcmTableEntryStore::Key key(entry);
+
+  // Only the key fields matter, in any order.
+  ::p4::v1::TableEntry equivalent = entry;
+  equivalent.mutable_match()->SwapElements(0, 1);
+  equivalent.set_table_id(2);
+  equivalent.mutable_action()->set_action_profile_member_id(5);
+  equivalent.set_controller_metadata(42);
+  equivalent.mutable_counter_data()->set_byte_count(100);
+  EXPECT_EQ(key, BcmTableEntryStore::Key(equivalent));
+  EXPECT_EQ(key.hash(), BcmTableEntryStore::Key(equivalent).hash());
+
+  // The match fields are ordered by field ID.
+  ::p4::v1::TableEntry expected;
+  ASSERT_TRUE(expected.ParseFromArray(key.bytes().data(), key.bytes().size()));
+  ASSERT_EQ(2, expected.match_size());
+  EXPECT_EQ(1, expected.match(0).field_id());
+  EXPECT_EQ(2, expected.match(1).field_id());
+  EXPECT_FALSE(expected.has_action());
+  EXPECT_EQ(0, expected.table_id());
+
+  ::p4::v1::TableEntry other = entry;
+  other.set_priority(1);
+  EXPECT_NE(key, BcmTableEntryStore::Key(other));
+  other = entry;
+  other.mutable_match(1)->set_field_id(3);
+  EXPECT_NE(key, BcmTableEntryStore::Key(other));
+  other = entry;
+  other.mutable_match(0)->mutable_lpm()->set_prefix_len(16);
+  EXPECT_NE(key, BcmTableEntryStore::Key(other));
+}
+
+TEST(BcmTableEntryStoreTest, ValuesAreShared) {
+  constexpr int kNumRoutes = 1000;
+  constexpr int kNumGroups = 4;
+  BcmTableEntryStore store;
+  for (int i = 0; i < kNumRoutes; ++i) {
+    ASSERT_TRUE(store.Insert(RouteEntry(i, kNumGroups)));
+  }
+  EXPECT_EQ(kNumRoutes, store.size());
+  EXPECT_EQ(kNumGroups, store.NumValues());
+  for (int i = 0; i < kNumRoutes; ++i) {
+    ASSERT_TRUE(store.Erase(RouteEntry(i, kNumGroups), nullptr));
+  }
+  EXPECT_EQ(0, store.NumValues());
+}
+
+TEST(BcmTableEntryStoreTest, ManyInsertsAndErases) {
+  constexpr int kNumRoutes = 20000;
+  BcmTableEntryStore store;
+  for (int i = 0; i < kNumRoutes; ++i) {
+    ASSERT_TRUE(store.Insert(RouteEntry(i, 16)));
+  }
+  const size_t full_memory_usage = store.MemoryUsage();
+  // Erase most entries, which compacts the arenas and leaves tombstones in the
+  // index behind.
+  for (int i = 0; i < kNumRoutes; ++i) {
+    if (i % 10 != 0) ASSERT_TRUE(store.Erase(RouteEntry(i, 16), nullptr));
+  }
+  EXPECT_EQ(kNumRoutes / 10, store.size());
+  EXPECT_LT(store.MemoryUsage(), full_memory_usage);
+
+  // Reinsert with other actions, reusing the freed IDs.
+  for (int i = 0; i < kNumRoutes; ++i) {
+    if (i % 10 != 0) ASSERT_TRUE(store.Insert(RouteEntry(i, 7)));
+  }
+  std::vector<::p4::v1::TableEntry> expected;
+  for (int i = 0; i < kNumRoutes; ++i) {
+    expected.push_back(RouteEntry(i, i % 10 == 0 ? 16 : 7));
+    ::p4::v1::TableEntry found;
+    ASSERT_TRUE(store.Find(expected.back(), &found));
+    ASSERT_THAT(found, EqualsProto(expected.back()));
+  }
+  std::vector<::p4::v1::TableEntry> entries(store.begin(), store.end());
+  ASSERT_EQ(kNumRoutes, entries.size());
+  std::vector<std::string> serialized, expected_serialized;
+  for (const auto& e : entries) serialized.push_back(ProtoSerialize(e));
+  for (const auto& e : expected) {
+    expected_serialized.push_back(ProtoSerialize(e));
+  }
+  std::sort(serialized.begin(), serialized.end());
+  std::sort(expected_serialized.begin(), expected_serialized.end());
+  EXPECT_EQ(expected_serialized, serialized);
+
+  // Copies are independent.
+  BcmTableEntryStore copy = store;
+  store.Clear();
+  EXPECT_TRUE(store.empty());
+  EXPECT_EQ(kNumRoutes, copy.size());
+  EXPECT_TRUE(copy.Contains(RouteEntry(kNumRoutes - 1, 7)));
+}
+
+}  // namespace
+}  // namespace bcm
+}  // namespace hal
+}  // namespace stratum
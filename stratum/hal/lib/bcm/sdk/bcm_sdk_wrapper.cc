@@ -1463,6 +1463,51 @@ BcmSdkWrapper::~BcmSdkWrapper() { ShutdownAllUnits().IgnoreError(); }
   return ::util::OkStatus();
 }
 
+::util::Status BcmSdkWrapper::GetPortCountersBulk(
+    int unit, const std::vector<int>& ports,
+    std::vector<PortCounters>* counters) {
+  RET_CHECK(counters);
+  // All the counters of a port are read with a single bcm_stat_multi_get()
+  // call, in the order given here.
+  bcm_stat_val_t stats[] = {
+      snmpIfInOctets,         snmpIfInUcastPkts,      snmpIfInMulticastPkts,
+      snmpIfInBroadcastPkts,  snmpIfInDiscards,       snmpIfInErrors,
+      snmpIfInUnknownProtos,  snmpIfOutOctets,        snmpIfOutUcastPkts,
+      snmpIfOutMulticastPkts, snmpIfOutBroadcastPkts, snmpIfOutDiscards,
+      snmpIfOutErrors,
+  };
+  constexpr int kNumStats = ABSL_ARRAYSIZE(stats);
+  uint64 values[kNumStats];
+  counters->clear();
+  counters->reserve(ports.size());
+  for (int port : ports) {
+    RETURN_IF_BCM_ERROR(
+        bcm_stat_multi_get(unit, port, kNumStats, stats, values))
+        << "Failed to get the counters of port " << port << " on unit " << unit
+        << ".";
+    counters->emplace_back();
+    PortCounters* pc = &counters->back();
+    pc->set_in_octets(values[0]);
+    pc->set_in_unicast_pkts(values[1]);
+    pc->set_in_multicast_pkts(values[2]);
+    pc->set_in_broadcast_pkts(values[3]);
+    pc->set_in_discards(values[4]);
+    pc->set_in_errors(values[5]);
+    pc->set_in_unknown_protos(values[6]);
+    pc->set_out_octets(values[7]);
+    pc->set_out_unicast_pkts(values[8]);
+    pc->set_out_multicast_pkts(values[9]);
+    pc->set_out_broadcast_pkts(values[10]);
+    pc->set_out_discards(values[11]);
+    pc->set_out_errors(values[12]);
+  }
+
+  VLOG(2) << "Read the counters of " << ports.size() << " ports on unit "
+          << unit << ".";
+
+  return ::util::OkStatus();
+}
+
 ::util::Status BcmSdkWrapper::StartDiagShellServer() {
   if (bcm_diag_shell_ == nullptr) return ::util::OkStatus();  // sim mode
 
@@ -2070,6 +2115,75 @@ void PopulateL3HostAction(int class_id, int egress_intf_id,
   return ::util::OkStatus();
 }
 
+::util::Status BcmSdkWrapper::WriteL3Routes(
+    int unit, const std::vector<L3RouteWrite>& writes,
+    std::vector<::util::Status>* results) {
+  RET_CHECK(results != nullptr);
+  // This SDK has no transactions, the writes are executed one by one.
+  results->clear();
+  results->reserve(writes.size());
+  for (const auto& write : writes) {
+    ::util::Status status;
+    switch (write.type) {
+      case L3RouteWrite::Type::ADD:
+        if (write.host) {
+          status = write.ipv6
+                       ? AddL3HostIpv6(unit, write.vrf, write.subnet_ipv6,
+                                       write.class_id, write.egress_intf_id)
+                       : AddL3HostIpv4(unit, write.vrf, write.subnet_ipv4,
+                                       write.class_id, write.egress_intf_id);
+        } else {
+          status = write.ipv6
+                       ? AddL3RouteIpv6(unit, write.vrf, write.subnet_ipv6,
+                                        write.mask_ipv6, write.class_id,
+                                        write.egress_intf_id,
+                                        write.is_intf_multipath)
+                       : AddL3RouteIpv4(unit, write.vrf, write.subnet_ipv4,
+                                        write.mask_ipv4, write.class_id,
+                                        write.egress_intf_id,
+                                        write.is_intf_multipath);
+        }
+        break;
+      case L3RouteWrite::Type::MODIFY:
+        if (write.host) {
+          status = write.ipv6
+                       ? ModifyL3HostIpv6(unit, write.vrf, write.subnet_ipv6,
+                                          write.class_id, write.egress_intf_id)
+                       : ModifyL3HostIpv4(unit, write.vrf, write.subnet_ipv4,
+                                          write.class_id, write.egress_intf_id);
+        } else {
+          status = write.ipv6
+                       ? ModifyL3RouteIpv6(unit, write.vrf, write.subnet_ipv6,
+                                           write.mask_ipv6, write.class_id,
+                                           write.egress_intf_id,
+                                           write.is_intf_multipath)
+                       : ModifyL3RouteIpv4(unit, write.vrf, write.subnet_ipv4,
+                                           write.mask_ipv4, write.class_id,
+                                           write.egress_intf_id,
+                                           write.is_intf_multipath);
+        }
+        break;
+      case L3RouteWrite::Type::DELETE:
+        if (write.host) {
+          status = write.ipv6
+                       ? DeleteL3HostIpv6(unit, write.vrf, write.subnet_ipv6)
+                       : DeleteL3HostIpv4(unit, write.vrf, write.subnet_ipv4);
+        } else {
+          status = write.ipv6 ? DeleteL3RouteIpv6(unit, write.vrf,
+                                                  write.subnet_ipv6,
+                                                  write.mask_ipv6)
+                              : DeleteL3RouteIpv4(unit, write.vrf,
+                                                  write.subnet_ipv4,
+                                                  write.mask_ipv4);
+        }
+        break;
+    }
+    results->push_back(status);
+  }
+
+  return ::util::OkStatus();
+}
+
 ::util::StatusOr<int> BcmSdkWrapper::AddMyStationEntry(int unit, int priority,
                                                        int vlan, int vlan_mask,
                                                        uint64 dst_mac,
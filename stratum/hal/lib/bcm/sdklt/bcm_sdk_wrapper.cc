@@ -17,6 +17,7 @@
 
 #include <algorithm>
 #include <csignal>
+#include <deque>
 #include <iomanip>
 #include <sstream>  // IWYU pragma: keep
 #include <string>
@@ -27,11 +28,13 @@
 #include "absl/cleanup/cleanup.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_split.h"
 #include "absl/strings/substitute.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
 #include "gflags/gflags.h"
 #include "stratum/glue/gtl/map_util.h"
 #include "stratum/glue/gtl/stl_util.h"
@@ -118,6 +121,9 @@ DEFINE_int64(port_counters_interval_in_usec, 100 * 1000,
              "Port counter interval in usecs.");
 DEFINE_int32(max_num_linkscan_writers, 10,
              "Max number of linkscan event Writers supported.");
+DEFINE_int32(max_l3_route_writes_per_transaction, 256,
+             "Max number of L3 route and host writes committed together in a "
+             "single logical table transaction.");
 DECLARE_string(bcm_sdk_checkpoint_dir);
 
 // TODO: There are many RET_CHECK in this file which will
@@ -707,6 +713,196 @@ int bcmlt_custom_entry_commit(bcmlt_entry_handle_t entry_hdl, bcmlt_opcode_t op,
   return entry_info.status;
 }
 
+// Caches the value ranges of logical table fields, so that a batch of writes
+// looks up the field definitions of every table only once.
+class FieldRangeCache {
+ public:
+  explicit FieldRangeCache(int unit) : unit_(unit) {}
+
+  // Returns an error if the given value is outside the range of the field.
+  ::util::Status CheckRange(const char* table, const char* field,
+                            const std::string& name, int value) {
+    auto key = std::make_pair(std::string(table), std::string(field));
+    auto it = ranges_.find(key);
+    if (it == ranges_.end()) {
+      uint64_t min;
+      uint64_t max;
+      RETURN_IF_BCM_ERROR(GetFieldMinMaxValue(unit_, table, field, &min, &max));
+      it = ranges_
+               .emplace(key, std::make_pair(static_cast<int>(min),
+                                            static_cast<int>(max)))
+               .first;
+    }
+    const int min = it->second.first;
+    const int max = it->second.second;
+    if ((value > max) || (value < min)) {
+      return MAKE_ERROR(ERR_INVALID_PARAM)
+             << "Invalid " << name << " (" << value << "), valid " << name
+             << " range is " << min << " - " << max << ".";
+    }
+    return ::util::OkStatus();
+  }
+
+ private:
+  const int unit_;
+  std::map<std::pair<std::string, std::string>, std::pair<int, int>> ranges_;
+};
+
+// Returns the logical table of the given L3 route or host write.
+const char* L3RouteWriteTable(const BcmSdkInterface::L3RouteWrite& write) {
+  if (write.host) return write.ipv6 ? L3_IPV6_UC_HOSTs : L3_IPV4_UC_HOSTs;
+  return write.ipv6 ? L3_IPV6_UC_ROUTE_VRFs : L3_IPV4_UC_ROUTE_VRFs;
+}
+
+// Checks the parameters of the given L3 route or host write the same way the
+// single entry Add/Modify/Delete calls do.
+::util::Status ValidateL3RouteWrite(const BcmSdkInterface::L3RouteWrite& write,
+                                    const std::map<int, bool>& l3_egress_intf,
+                                    FieldRangeCache* ranges) {
+  const char* table = L3RouteWriteTable(write);
+  if (write.ipv6) {
+    RET_CHECK(write.subnet_ipv6.size() == 16);
+    if (!write.host) {
+      RET_CHECK(write.mask_ipv6.size() == 16);
+    }
+  }
+  RETURN_IF_ERROR(ranges->CheckRange(table, VRF_IDs, "vrf", write.vrf));
+  if (write.type == BcmSdkInterface::L3RouteWrite::Type::DELETE) {
+    return ::util::OkStatus();
+  }
+  RET_CHECK(write.egress_intf_id > 0);
+  if (write.host) {
+    return ranges->CheckRange(table, NHOP_IDs, "egress interface",
+                              write.egress_intf_id);
+  }
+  if (write.class_id > 0) {
+    RETURN_IF_ERROR(
+        ranges->CheckRange(table, CLASS_IDs, "class_id", write.class_id));
+  }
+  auto it = l3_egress_intf.find(write.egress_intf_id);
+  if (it == l3_egress_intf.end()) {
+    return MAKE_ERROR(ERR_INVALID_PARAM)
+           << "Invalid L3 Egress interface " << write.egress_intf_id << ".";
+  }
+  if (!it->second) {
+    return MAKE_ERROR(ERR_INVALID_PARAM) << "L3 Egress interface "
+                                         << write.egress_intf_id
+                                         << " is not created.";
+  }
+  return ::util::OkStatus();
+}
+
+// Allocates the logical table entry of a validated L3 route or host write, with
+// the key and, unless it is a delete, the data fields set.
+::util::Status AllocateL3RouteEntry(int unit,
+                                    const BcmSdkInterface::L3RouteWrite& write,
+                                    bcmlt_entry_handle_t* entry_hdl) {
+  RETURN_IF_BCM_ERROR(
+      bcmlt_entry_allocate(unit, L3RouteWriteTable(write), entry_hdl));
+  auto cleanup = absl::MakeCleanup([entry_hdl] {
+    // Only reached on errors, the entry is owned by the caller otherwise.
+    bcmlt_entry_free(*entry_hdl);
+  });
+  RETURN_IF_BCM_ERROR(bcmlt_entry_field_add(*entry_hdl, VRF_IDs, write.vrf));
+  if (write.ipv6) {
+    RETURN_IF_BCM_ERROR(bcmlt_entry_field_add(
+        *entry_hdl, IPV6_UPPERs,
+        ByteStreamToUint<uint64>(write.subnet_ipv6.substr(0, 8))));
+    RETURN_IF_BCM_ERROR(bcmlt_entry_field_add(
+        *entry_hdl, IPV6_LOWERs,
+        ByteStreamToUint<uint64>(write.subnet_ipv6.substr(8, 16))));
+    if (!write.host) {
+      RETURN_IF_BCM_ERROR(bcmlt_entry_field_add(
+          *entry_hdl, IPV6_UPPER_MASKs,
+          ByteStreamToUint<uint64>(write.mask_ipv6.substr(0, 8))));
+      RETURN_IF_BCM_ERROR(bcmlt_entry_field_add(
+          *entry_hdl, IPV6_LOWER_MASKs,
+          ByteStreamToUint<uint64>(write.mask_ipv6.substr(8, 16))));
+    }
+  } else {
+    RETURN_IF_BCM_ERROR(
+        bcmlt_entry_field_add(*entry_hdl, IPV4s, write.subnet_ipv4));
+    if (!write.host) {
+      RETURN_IF_BCM_ERROR(bcmlt_entry_field_add(
+          *entry_hdl, IPV4_MASKs,
+          !write.subnet_ipv4 ? 0
+                             : (write.mask_ipv4 ? write.mask_ipv4
+                                                : 0xffffffff)));
+    }
+  }
+  if (write.type != BcmSdkInterface::L3RouteWrite::Type::DELETE) {
+    if (write.class_id > 0) {
+      RETURN_IF_BCM_ERROR(
+          bcmlt_entry_field_add(*entry_hdl, CLASS_IDs, write.class_id));
+    }
+    const bool multipath = !write.host && write.is_intf_multipath;
+    RETURN_IF_BCM_ERROR(
+        bcmlt_entry_field_add(*entry_hdl, ECMP_NHOPs, multipath));
+    RETURN_IF_BCM_ERROR(bcmlt_entry_field_add(
+        *entry_hdl, multipath ? ECMP_IDs : NHOP_IDs, write.egress_intf_id));
+  }
+  std::move(cleanup).Cancel();
+
+  return ::util::OkStatus();
+}
+
+// Returns the logical table opcode of the given L3 route or host write.
+bcmlt_opcode_t L3RouteWriteOpcode(const BcmSdkInterface::L3RouteWrite& write) {
+  switch (write.type) {
+    case BcmSdkInterface::L3RouteWrite::Type::ADD:
+      return BCMLT_OPCODE_INSERT;
+    case BcmSdkInterface::L3RouteWrite::Type::MODIFY:
+      return BCMLT_OPCODE_UPDATE;
+    case BcmSdkInterface::L3RouteWrite::Type::DELETE:
+      return BCMLT_OPCODE_DELETE;
+  }
+  return BCMLT_OPCODE_NOP;
+}
+
+// Pretty prints the L3 route or host of a validated write.
+std::string PrintL3RouteWrite(const BcmSdkInterface::L3RouteWrite& write) {
+  if (write.host) {
+    l3_host_t host = {write.ipv6,           write.vrf,
+                      write.class_id,       write.egress_intf_id,
+                      write.subnet_ipv4,    write.subnet_ipv6};
+    return PrintL3Host(host);
+  }
+  l3_route_t route = {write.ipv6,          write.vrf,
+                      write.class_id,      write.egress_intf_id,
+                      write.subnet_ipv4,   write.mask_ipv4,
+                      write.subnet_ipv6,   write.mask_ipv6};
+  return PrintL3Route(route);
+}
+
+// A batch transaction of L3 route and host writes which is committed
+// asynchronously.
+struct L3RouteTransaction {
+  L3RouteTransaction() : hdl(), committed(false) {}
+  bcmlt_transaction_hdl_t hdl;
+  // Index of the write of every entry of the transaction, in entry order.
+  std::vector<size_t> write_indices;
+  // Set once bcmlt_transaction_commit_async() succeeded.
+  bool committed;
+  // Notified by the SDK once the transaction has been written to the HW.
+  absl::Notification done;
+};
+
+// Called by the SDK for the asynchronously committed L3 route transactions.
+void L3RouteTransactionNotify(bcmlt_notif_option_t event,
+                              bcmlt_transaction_info_t* trans_info,
+                              void* user_data) {
+  auto* transaction = static_cast<L3RouteTransaction*>(user_data);
+  // Failed transactions may never reach the HW stage.
+  if ((event == BCMLT_NOTIF_OPTION_HW || trans_info->status != SHR_E_NONE) &&
+      !transaction->done.HasBeenNotified()) {
+    transaction->done.Notify();
+  }
+}
+
+// Max number of L3 route transactions committed but not yet completed while
+// the next one is built.
+constexpr size_t kMaxL3RouteTransactionsInFlight = 4;
+
 ::util::Status GetTableLimits(int unit, const char* table, int* min, int* max) {
   uint64_t table_max;
   uint64_t table_min;
@@ -1921,23 +2117,11 @@ BcmSdkWrapper::~BcmSdkWrapper() { ShutdownAllUnits().IgnoreError(); }
   return ::util::OkStatus();
 }
 
-::util::Status BcmSdkWrapper::GetPortCounters(int unit, int port,
-                                              PortCounters* pc) {
-  // Check if unit is valid
-  RETURN_IF_BCM_ERROR(CheckIfUnitExists(unit));
-  // Check if port is valid
-  RETURN_IF_BCM_ERROR(CheckIfPortExists(unit, port))
-      << "Port " << port << " does not exit on unit " << unit << ".";
-  RET_CHECK(pc != nullptr);
-
+namespace {
+// Copies the counters of a port from its looked up CTR_MAC entry.
+::util::Status ReadPortCounters(bcmlt_entry_handle_t entry_hdl,
+                                PortCounters* pc) {
   uint64 value;
-  // Read good counters
-  bcmlt_entry_handle_t entry_hdl;
-  RETURN_IF_BCM_ERROR(bcmlt_entry_allocate(unit, CTR_MACs, &entry_hdl));
-  auto cl1 = absl::MakeCleanup([entry_hdl]() { bcmlt_entry_free(entry_hdl); });
-  RETURN_IF_BCM_ERROR(bcmlt_entry_field_add(entry_hdl, PORT_IDs, port));
-  RETURN_IF_BCM_ERROR(bcmlt_entry_commit(entry_hdl, BCMLT_OPCODE_LOOKUP,
-                                         BCMLT_PRIORITY_NORMAL));
   RETURN_IF_BCM_ERROR(bcmlt_entry_field_get(entry_hdl, RX_BYTESs, &value));
   pc->set_in_octets(value);
   RETURN_IF_BCM_ERROR(bcmlt_entry_field_get(entry_hdl, RX_UC_PKTs, &value));
@@ -1955,12 +2139,13 @@ BcmSdkWrapper::~BcmSdkWrapper() { ShutdownAllUnits().IgnoreError(); }
   RETURN_IF_BCM_ERROR(bcmlt_entry_field_get(entry_hdl, TX_MC_PKTs, &value));
   pc->set_out_multicast_pkts(value);
 
-  // Read error counters
-  RETURN_IF_BCM_ERROR(bcmlt_entry_allocate(unit, CTR_MAC_ERRs, &entry_hdl));
-  auto cl2 = absl::MakeCleanup([entry_hdl]() { bcmlt_entry_free(entry_hdl); });
-  RETURN_IF_BCM_ERROR(bcmlt_entry_field_add(entry_hdl, PORT_IDs, port));
-  RETURN_IF_BCM_ERROR(bcmlt_entry_commit(entry_hdl, BCMLT_OPCODE_LOOKUP,
-                                         BCMLT_PRIORITY_NORMAL));
+  return ::util::OkStatus();
+}
+
+// Copies the error counters of a port from its looked up CTR_MAC_ERR entry.
+::util::Status ReadPortErrorCounters(bcmlt_entry_handle_t entry_hdl,
+                                     PortCounters* pc) {
+  uint64 value;
   RETURN_IF_BCM_ERROR(
       bcmlt_entry_field_get(entry_hdl, RX_FCS_ERR_PKTs, &value));
   pc->set_in_fcs_errors(value);
@@ -1972,6 +2157,100 @@ BcmSdkWrapper::~BcmSdkWrapper() { ShutdownAllUnits().IgnoreError(); }
 
   return ::util::OkStatus();
 }
+}  // namespace
+
+::util::Status BcmSdkWrapper::GetPortCounters(int unit, int port,
+                                              PortCounters* pc) {
+  // Check if unit is valid
+  RETURN_IF_BCM_ERROR(CheckIfUnitExists(unit));
+  // Check if port is valid
+  RETURN_IF_BCM_ERROR(CheckIfPortExists(unit, port))
+      << "Port " << port << " does not exit on unit " << unit << ".";
+  RET_CHECK(pc != nullptr);
+
+  // Read good counters
+  bcmlt_entry_handle_t entry_hdl;
+  RETURN_IF_BCM_ERROR(bcmlt_entry_allocate(unit, CTR_MACs, &entry_hdl));
+  auto cl1 = absl::MakeCleanup([entry_hdl]() { bcmlt_entry_free(entry_hdl); });
+  RETURN_IF_BCM_ERROR(bcmlt_entry_field_add(entry_hdl, PORT_IDs, port));
+  RETURN_IF_BCM_ERROR(bcmlt_entry_commit(entry_hdl, BCMLT_OPCODE_LOOKUP,
+                                         BCMLT_PRIORITY_NORMAL));
+  RETURN_IF_ERROR(ReadPortCounters(entry_hdl, pc));
+
+  // Read error counters
+  RETURN_IF_BCM_ERROR(bcmlt_entry_allocate(unit, CTR_MAC_ERRs, &entry_hdl));
+  auto cl2 = absl::MakeCleanup([entry_hdl]() { bcmlt_entry_free(entry_hdl); });
+  RETURN_IF_BCM_ERROR(bcmlt_entry_field_add(entry_hdl, PORT_IDs, port));
+  RETURN_IF_BCM_ERROR(bcmlt_entry_commit(entry_hdl, BCMLT_OPCODE_LOOKUP,
+                                         BCMLT_PRIORITY_NORMAL));
+  RETURN_IF_ERROR(ReadPortErrorCounters(entry_hdl, pc));
+
+  return ::util::OkStatus();
+}
+
+::util::Status BcmSdkWrapper::GetPortCountersBulk(
+    int unit, const std::vector<int>& ports,
+    std::vector<PortCounters>* counters) {
+  // Check if unit is valid
+  RETURN_IF_BCM_ERROR(CheckIfUnitExists(unit));
+  RET_CHECK(counters != nullptr);
+  for (int port : ports) {
+    // Check if port is valid
+    RETURN_IF_BCM_ERROR(CheckIfPortExists(unit, port))
+        << "Port " << port << " does not exit on unit " << unit << ".";
+  }
+  counters->assign(ports.size(), PortCounters());
+  if (ports.empty()) return ::util::OkStatus();
+
+  // The lookups of the good and error counters of all ports are committed as a
+  // single batch transaction. Entry 2 * i is the CTR_MAC lookup and entry
+  // 2 * i + 1 is the CTR_MAC_ERR lookup of ports[i].
+  bcmlt_transaction_hdl_t trans_hdl;
+  RETURN_IF_BCM_ERROR(
+      bcmlt_transaction_allocate(BCMLT_TRANS_TYPE_BATCH, &trans_hdl));
+  // Also frees the entries of the transaction.
+  auto cleanup =
+      absl::MakeCleanup([trans_hdl]() { bcmlt_transaction_free(trans_hdl); });
+  for (int port : ports) {
+    for (const char* table : {CTR_MACs, CTR_MAC_ERRs}) {
+      bcmlt_entry_handle_t entry_hdl;
+      RETURN_IF_BCM_ERROR(bcmlt_entry_allocate(unit, table, &entry_hdl));
+      int rv = bcmlt_entry_field_add(entry_hdl, PORT_IDs, port);
+      if (rv == SHR_E_NONE) {
+        rv = bcmlt_transaction_entry_add(trans_hdl, BCMLT_OPCODE_LOOKUP,
+                                         entry_hdl);
+      }
+      if (rv != SHR_E_NONE) bcmlt_entry_free(entry_hdl);
+      RETURN_IF_BCM_ERROR(rv);
+    }
+  }
+  RETURN_IF_BCM_ERROR(
+      bcmlt_transaction_commit(trans_hdl, BCMLT_PRIORITY_NORMAL));
+
+  for (size_t i = 0; i < ports.size(); ++i) {
+    PortCounters* pc = &(*counters)[i];
+    bcmlt_entry_info_t entry_info;
+    // Read good counters
+    RETURN_IF_BCM_ERROR(
+        bcmlt_transaction_entry_num_get(trans_hdl, 2 * i, &entry_info));
+    RETURN_IF_BCM_ERROR(entry_info.status)
+        << "Failed to read the counters of port " << ports[i] << " on unit "
+        << unit << ".";
+    bcmlt_entry_handle_t entry_hdl = entry_info.entry_hdl;
+    RETURN_IF_ERROR(ReadPortCounters(entry_hdl, pc));
+
+    // Read error counters
+    RETURN_IF_BCM_ERROR(
+        bcmlt_transaction_entry_num_get(trans_hdl, 2 * i + 1, &entry_info));
+    RETURN_IF_BCM_ERROR(entry_info.status)
+        << "Failed to read the error counters of port " << ports[i]
+        << " on unit " << unit << ".";
+    entry_hdl = entry_info.entry_hdl;
+    RETURN_IF_ERROR(ReadPortErrorCounters(entry_hdl, pc));
+  }
+
+  return ::util::OkStatus();
+}
 
 ::util::Status BcmSdkWrapper::InitCLI() {
   // Initialize system log output
@@ -3864,6 +4143,132 @@ BcmSdkWrapper::GetPortLinkscanMode(int unit, int port) {
   return ::util::OkStatus();
 }
 
+::util::Status BcmSdkWrapper::WriteL3Routes(
+    int unit, const std::vector<L3RouteWrite>& writes,
+    std::vector<::util::Status>* results) {
+  RET_CHECK(results != nullptr);
+  results->assign(writes.size(), ::util::OkStatus());
+  if (writes.empty()) return ::util::OkStatus();
+  // Check if the unit is valid
+  RETURN_IF_BCM_ERROR(CheckIfUnitExists(unit));
+  InUseMap* l3_egress_intf = gtl::FindOrNull(l3_egress_interface_ids_, unit);
+  RET_CHECK(l3_egress_intf != nullptr)
+      << "Unit " << unit << " not initialized yet. Call InitializeUnit first.";
+
+  // The writes are committed in batch transactions of up to
+  // max_l3_route_writes_per_transaction entries. Transactions are committed
+  // asynchronously, so the SDK executes one while the next one is built.
+  const size_t max_entries = static_cast<size_t>(
+      std::max(FLAGS_max_l3_route_writes_per_transaction, 1));
+  std::deque<std::unique_ptr<L3RouteTransaction>> in_flight;
+  std::unique_ptr<L3RouteTransaction> transaction;
+
+  // Waits for the oldest transaction in flight and collects the status of its
+  // entries.
+  auto complete_oldest = [&in_flight, &writes, results, unit]() {
+    std::unique_ptr<L3RouteTransaction> done = std::move(in_flight.front());
+    in_flight.pop_front();
+    if (done->committed) done->done.WaitForNotification();
+    for (size_t i = 0; i < done->write_indices.size(); ++i) {
+      const size_t index = done->write_indices[i];
+      if (!done->committed) {
+        (*results)[index] = MAKE_ERROR(ERR_INTERNAL)
+                            << "Failed to commit the transaction of "
+                            << PrintL3RouteWrite(writes[index]) << " on unit "
+                            << unit << ".";
+        continue;
+      }
+      bcmlt_entry_info_t entry_info;
+      int rv = bcmlt_transaction_entry_num_get(done->hdl, i, &entry_info);
+      if (rv == SHR_E_NONE) rv = entry_info.status;
+      if (rv != SHR_E_NONE) {
+        (*results)[index] = MAKE_ERROR(BooleanBcmStatus(rv).error_code())
+                            << "Failed to write "
+                            << PrintL3RouteWrite(writes[index]) << " on unit "
+                            << unit << ": " << bcm_errmsg(rv) << ".";
+      }
+    }
+    // Also frees the entries of the transaction.
+    bcmlt_transaction_free(done->hdl);
+  };
+  // Commits the transaction being built and waits for the oldest ones if too
+  // many are in flight.
+  auto commit = [&in_flight, &transaction, &complete_oldest]() {
+    int rv = bcmlt_transaction_commit_async(
+        transaction->hdl, BCMLT_NOTIF_OPTION_HW, transaction.get(),
+        &L3RouteTransactionNotify, BCMLT_PRIORITY_NORMAL);
+    transaction->committed = (rv == SHR_E_NONE);
+    if (!transaction->committed) {
+      LOG(ERROR) << "Failed to commit L3 route transaction: "
+                 << bcm_errmsg(rv) << ".";
+    }
+    in_flight.push_back(std::move(transaction));
+    while (in_flight.size() > kMaxL3RouteTransactionsInFlight) {
+      complete_oldest();
+    }
+  };
+
+  FieldRangeCache ranges(unit);
+  for (size_t i = 0; i < writes.size(); ++i) {
+    const auto& write = writes[i];
+    ::util::Status write_status =
+        ValidateL3RouteWrite(write, *l3_egress_intf, &ranges);
+    if (!write_status.ok()) {
+      (*results)[i] = write_status;
+      continue;
+    }
+    if (transaction == nullptr) {
+      transaction = absl::make_unique<L3RouteTransaction>();
+      int rv = bcmlt_transaction_allocate(BCMLT_TRANS_TYPE_BATCH,
+                                          &transaction->hdl);
+      if (rv != SHR_E_NONE) {
+        transaction.reset();
+        ::util::Status status =
+            MAKE_ERROR(BooleanBcmStatus(rv).error_code())
+            << "Failed to allocate L3 route transaction on unit " << unit
+            << ": " << bcm_errmsg(rv) << ".";
+        // Nothing has been written yet, so the whole batch failed.
+        if (in_flight.empty()) return status;
+        // The transactions committed so far are still completed below, so
+        // the failure is only reported for the remaining writes.
+        std::fill(results->begin() + i, results->end(), status);
+        break;
+      }
+    }
+    bcmlt_entry_handle_t entry_hdl;
+    write_status = AllocateL3RouteEntry(unit, write, &entry_hdl);
+    if (write_status.ok()) {
+      int rv = bcmlt_transaction_entry_add(
+          transaction->hdl, L3RouteWriteOpcode(write), entry_hdl);
+      if (rv != SHR_E_NONE) {
+        bcmlt_entry_free(entry_hdl);
+        write_status = MAKE_ERROR(BooleanBcmStatus(rv).error_code())
+                       << "Failed to add " << PrintL3RouteWrite(write)
+                       << " to transaction: " << bcm_errmsg(rv) << ".";
+      }
+    }
+    if (!write_status.ok()) {
+      (*results)[i] = write_status;
+      continue;
+    }
+    transaction->write_indices.push_back(i);
+    if (transaction->write_indices.size() >= max_entries) commit();
+  }
+  if (transaction != nullptr) {
+    if (transaction->write_indices.empty()) {
+      bcmlt_transaction_free(transaction->hdl);
+    } else {
+      commit();
+    }
+  }
+  while (!in_flight.empty()) complete_oldest();
+
+  VLOG(1) << "Wrote " << writes.size() << " L3 routes and hosts on unit "
+          << unit << ".";
+
+  return ::util::OkStatus();
+}
+
 ::util::StatusOr<int> BcmSdkWrapper::AddMyStationEntry(int unit, int priority,
                                                        int vlan, int vlan_mask,
                                                        uint64 dst_mac,
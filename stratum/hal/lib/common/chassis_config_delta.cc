@@ -0,0 +1,54 @@
+// Copyright 2018-present Open Networking Foundation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "stratum/hal/lib/common/chassis_config_delta.h"
+
+#include <map>
+#include <utility>
+
+#include "google/protobuf/util/message_differencer.h"
+
+namespace stratum {
+namespace hal {
+
+using ::google::protobuf::util::MessageDifferencer;
+
+ChassisConfigDelta ComputeChassisConfigDelta(const ChassisConfig& old_config,
+                                             const ChassisConfig& new_config) {
+  ChassisConfigDelta delta;
+
+  MessageDifferencer differencer;
+  differencer.IgnoreField(
+      ChassisConfig::descriptor()->FindFieldByName("singleton_ports"));
+  delta.other_changed = !differencer.Compare(old_config, new_config);
+
+  // Singleton ports are matched by (node, id), which are unique per config.
+  std::map<std::pair<uint64, uint32>, const SingletonPort*> old_ports;
+  for (const auto& singleton_port : old_config.singleton_ports()) {
+    old_ports[std::make_pair(singleton_port.node(), singleton_port.id())] =
+        &singleton_port;
+  }
+  for (const auto& singleton_port : new_config.singleton_ports()) {
+    auto it = old_ports.find(
+        std::make_pair(singleton_port.node(), singleton_port.id()));
+    if (it == old_ports.end()) {
+      delta.added_singleton_ports.push_back(singleton_port);
+      delta.changed_node_ids.insert(singleton_port.node());
+      continue;
+    }
+    if (!MessageDifferencer::Equals(*it->second, singleton_port)) {
+      delta.modified_singleton_ports.push_back(singleton_port);
+      delta.changed_node_ids.insert(singleton_port.node());
+    }
+    old_ports.erase(it);
+  }
+  for (const auto& e : old_ports) {
+    delta.removed_singleton_ports.push_back(*e.second);
+    delta.changed_node_ids.insert(e.second->node());
+  }
+
+  return delta;
+}
+
+}  // namespace hal
+}  // namespace stratum
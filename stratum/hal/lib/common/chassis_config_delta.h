@@ -0,0 +1,59 @@
+// Copyright 2018-present Open Networking Foundation
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef STRATUM_HAL_LIB_COMMON_CHASSIS_CONFIG_DELTA_H_
+#define STRATUM_HAL_LIB_COMMON_CHASSIS_CONFIG_DELTA_H_
+
+#include <set>
+#include <vector>
+
+#include "stratum/glue/integral_types.h"
+#include "stratum/hal/lib/common/common.pb.h"
+
+namespace stratum {
+namespace hal {
+
+// ChassisConfigDelta describes how a new ChassisConfig differs from the one
+// running on the switch. gNMI Set requests usually change a few leaves of a
+// few ports only, and the delta lets the switch implementations apply such
+// changes without rebuilding their state for the whole chassis. Singleton
+// ports are identified by their (node, id) pair.
+struct ChassisConfigDelta {
+  ChassisConfigDelta() : other_changed(false) {}
+
+  // True if anything other than the singleton ports changed, e.g. the chassis,
+  // the nodes, the port groups or the vendor config. Such changes can only be
+  // applied by a full push of the new config.
+  bool other_changed;
+  // Singleton ports which only exist in the new config.
+  std::vector<SingletonPort> added_singleton_ports;
+  // The new version of the singleton ports which exist in both configs but
+  // differ.
+  std::vector<SingletonPort> modified_singleton_ports;
+  // Singleton ports which only exist in the old config.
+  std::vector<SingletonPort> removed_singleton_ports;
+  // IDs of the nodes owning any added, modified or removed singleton port.
+  std::set<uint64> changed_node_ids;
+
+  // Returns true if the configs are the same.
+  bool empty() const {
+    return !other_changed && changed_node_ids.empty();
+  }
+
+  // Returns true if the only changes are modifications of existing singleton
+  // ports.
+  bool OnlyModifiesSingletonPorts() const {
+    return !other_changed && added_singleton_ports.empty() &&
+           removed_singleton_ports.empty();
+  }
+};
+
+// Computes the delta from old_config to new_config. Takes O(n log n) time for
+// n singleton ports.
+ChassisConfigDelta ComputeChassisConfigDelta(const ChassisConfig& old_config,
+                                             const ChassisConfig& new_config);
+
+}  // namespace hal
+}  // namespace stratum
+
+#endif  // STRATUM_HAL_LIB_COMMON_CHASSIS_CONFIG_DELTA_H_
@@ -0,0 +1,120 @@
+// Copyright 2018-present Open Networking Foundation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "stratum/hal/lib/common/chassis_config_delta.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "stratum/glue/status/status_test_util.h"
+#include "stratum/lib/test_utils/matchers.h"
+#include "stratum/lib/utils.h"
+
+namespace stratum {
+namespace hal {
+namespace {
+
+using test_utils::EqualsProto;
+
+constexpr char kChassisConfig[] = R"pb(
+  description: "Test config"
+  chassis { platform: PLT_GENERIC_BAREFOOT_TOFINO name: "chassis" }
+  nodes { id: 1 slot: 1 }
+  nodes { id: 2 slot: 1 }
+  singleton_ports {
+    id: 1
+    slot: 1
+    port: 1
+    speed_bps: 100000000000
+    node: 1
+    config_params { admin_state: ADMIN_STATE_ENABLED }
+  }
+  singleton_ports {
+    id: 2
+    slot: 1
+    port: 2
+    speed_bps: 100000000000
+    node: 1
+    config_params { admin_state: ADMIN_STATE_ENABLED }
+  }
+  singleton_ports {
+    id: 1
+    slot: 1
+    port: 3
+    speed_bps: 100000000000
+    node: 2
+    config_params { admin_state: ADMIN_STATE_ENABLED }
+  }
+)pb";
+
+class ChassisConfigDeltaTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_OK(ParseProtoFromString(kChassisConfig, &old_config_));
+    new_config_ = old_config_;
+  }
+
+  ChassisConfig old_config_;
+  ChassisConfig new_config_;
+};
+
+TEST_F(ChassisConfigDeltaTest, SameConfigs) {
+  // The order of the ports does not matter.
+  new_config_.mutable_singleton_ports()->SwapElements(0, 2);
+  ChassisConfigDelta delta =
+      ComputeChassisConfigDelta(old_config_, new_config_);
+  EXPECT_TRUE(delta.empty());
+  EXPECT_TRUE(delta.OnlyModifiesSingletonPorts());
+}
+
+TEST_F(ChassisConfigDeltaTest, ModifiedSingletonPort) {
+  new_config_.mutable_singleton_ports(2)->mutable_config_params()->set_mtu(
+      9000);
+  ChassisConfigDelta delta =
+      ComputeChassisConfigDelta(old_config_, new_config_);
+  EXPECT_FALSE(delta.empty());
+  EXPECT_TRUE(delta.OnlyModifiesSingletonPorts());
+  ASSERT_EQ(1, delta.modified_singleton_ports.size());
+  EXPECT_THAT(delta.modified_singleton_ports[0],
+              EqualsProto(new_config_.singleton_ports(2)));
+  EXPECT_TRUE(delta.added_singleton_ports.empty());
+  EXPECT_TRUE(delta.removed_singleton_ports.empty());
+  EXPECT_THAT(delta.changed_node_ids, ::testing::ElementsAre(2));
+}
+
+TEST_F(ChassisConfigDeltaTest, AddedAndRemovedSingletonPorts) {
+  // Moving port 2 from node 1 to node 2 removes it from node 1 and adds it to
+  // node 2.
+  new_config_.mutable_singleton_ports(1)->set_node(2);
+  new_config_.mutable_singleton_ports(1)->set_id(2);
+  ChassisConfigDelta delta =
+      ComputeChassisConfigDelta(old_config_, new_config_);
+  EXPECT_FALSE(delta.OnlyModifiesSingletonPorts());
+  EXPECT_FALSE(delta.other_changed);
+  ASSERT_EQ(1, delta.added_singleton_ports.size());
+  EXPECT_THAT(delta.added_singleton_ports[0],
+              EqualsProto(new_config_.singleton_ports(1)));
+  ASSERT_EQ(1, delta.removed_singleton_ports.size());
+  EXPECT_THAT(delta.removed_singleton_ports[0],
+              EqualsProto(old_config_.singleton_ports(1)));
+  EXPECT_TRUE(delta.modified_singleton_ports.empty());
+  EXPECT_THAT(delta.changed_node_ids, ::testing::ElementsAre(1, 2));
+}
+
+TEST_F(ChassisConfigDeltaTest, OtherChanges) {
+  new_config_.mutable_nodes(1)->set_slot(2);
+  ChassisConfigDelta delta =
+      ComputeChassisConfigDelta(old_config_, new_config_);
+  EXPECT_TRUE(delta.other_changed);
+  EXPECT_FALSE(delta.empty());
+  EXPECT_FALSE(delta.OnlyModifiesSingletonPorts());
+  EXPECT_TRUE(delta.changed_node_ids.empty());
+
+  new_config_ = old_config_;
+  new_config_.set_description("Other description");
+  EXPECT_TRUE(
+      ComputeChassisConfigDelta(old_config_, new_config_).other_changed);
+}
+
+}  // namespace
+}  // namespace hal
+}  // namespace stratum
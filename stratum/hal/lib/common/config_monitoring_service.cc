@@ -18,6 +18,7 @@
 #include "stratum/glue/gtl/stl_util.h"
 #include "stratum/glue/logging.h"
 #include "stratum/glue/status/status_macros.h"
+#include "stratum/hal/lib/common/chassis_config_delta.h"
 #include "stratum/hal/lib/common/gnmi_publisher.h"
 #include "stratum/hal/lib/common/openconfig_converter.h"
 #include "stratum/lib/macros.h"
@@ -44,13 +45,20 @@ ConfigMonitoringService::ConfigMonitoringService(
       switch_interface_(ABSL_DIE_IF_NULL(switch_interface)),
       auth_policy_checker_(ABSL_DIE_IF_NULL(auth_policy_checker)),
       error_buffer_(ABSL_DIE_IF_NULL(error_buffer)),
-      gnmi_publisher_(switch_interface) {
+      gnmi_publisher_(switch_interface),
+      pending_config_file_(nullptr),
+      config_file_write_in_progress_(false),
+      config_file_writer_tid_(),
+      config_file_writer_running_(false),
+      config_file_writer_stop_(false) {
   if (TimerDaemon::Start() != ::util::OkStatus()) {
     LOG(ERROR) << "Could not start the timer subsystem.";
   }
 }
 
 ConfigMonitoringService::~ConfigMonitoringService() {
+  ::util::Status status = StopConfigFileWriter();
+  LOG_IF(ERROR, !status.ok()) << status.error_message();
   if (TimerDaemon::Stop() != ::util::OkStatus()) {
     LOG(ERROR) << "Could not stop the timer subsystem.";
   }
@@ -63,6 +71,12 @@ ConfigMonitoringService::~ConfigMonitoringService() {
         status, "Could not start the gNMI notification subsystem: ", GTL_LOC);
     return status;
   }
+  status = StartConfigFileWriter();
+  if (!status.ok()) {
+    error_buffer_->AddError(
+        status, "Could not start the chassis config file writer: ", GTL_LOC);
+    return status;
+  }
 
   // If we are coupled mode and are coldbooting, we do not do anything here.
   // TODO(unknown): This will be removed when we completely move to
@@ -77,6 +91,9 @@ ConfigMonitoringService::~ConfigMonitoringService() {
 }
 
 ::util::Status ConfigMonitoringService::Teardown() {
+  // Make sure the last pushed config has been saved before shutting down.
+  RETURN_IF_ERROR(StopConfigFileWriter());
+
   absl::WriterMutexLock l(&config_lock_);
   running_chassis_config_ = nullptr;
 
@@ -136,6 +153,96 @@ ConfigMonitoringService::~ConfigMonitoringService() {
   return ::util::OkStatus();
 }
 
+::util::Status ConfigMonitoringService::StartConfigFileWriter() {
+  absl::MutexLock l(&config_file_lock_);
+  if (config_file_writer_running_) return ::util::OkStatus();
+  config_file_writer_stop_ = false;
+  int ret = pthread_create(&config_file_writer_tid_, nullptr,
+                           ConfigFileWriterThreadFunc, this);
+  if (ret != 0) {
+    return MAKE_ERROR(ERR_INTERNAL)
+           << "Failed to create the chassis config file writer thread. Err: "
+           << ret << ".";
+  }
+  config_file_writer_running_ = true;
+
+  return ::util::OkStatus();
+}
+
+::util::Status ConfigMonitoringService::StopConfigFileWriter() {
+  pthread_t tid;
+  {
+    absl::MutexLock l(&config_file_lock_);
+    // Nothing to do if the thread is not running or being stopped already.
+    if (!config_file_writer_running_ || config_file_writer_stop_) {
+      return ::util::OkStatus();
+    }
+    config_file_writer_stop_ = true;
+    config_file_cond_.SignalAll();
+    tid = config_file_writer_tid_;
+  }
+  int ret = pthread_join(tid, nullptr);
+  if (ret != 0) {
+    return MAKE_ERROR(ERR_INTERNAL)
+           << "Failed to join the chassis config file writer thread. Err: "
+           << ret << ".";
+  }
+
+  return ::util::OkStatus();
+}
+
+::util::Status ConfigMonitoringService::SaveChassisConfig(
+    std::unique_ptr<ChassisConfig> config) {
+  {
+    absl::MutexLock l(&config_file_lock_);
+    if (config_file_writer_running_) {
+      pending_config_file_ = std::move(config);
+      config_file_cond_.SignalAll();
+      return ::util::OkStatus();
+    }
+  }
+
+  return WriteProtoToTextFile(*config, FLAGS_chassis_config_file);
+}
+
+void ConfigMonitoringService::FlushChassisConfigFile() {
+  absl::MutexLock l(&config_file_lock_);
+  while (pending_config_file_ != nullptr || config_file_write_in_progress_) {
+    config_file_cond_.Wait(&config_file_lock_);
+  }
+}
+
+void* ConfigMonitoringService::ConfigFileWriterThreadFunc(void* arg) {
+  static_cast<ConfigMonitoringService*>(arg)->ConfigFileWriterLoop();
+  return nullptr;
+}
+
+void ConfigMonitoringService::ConfigFileWriterLoop() {
+  absl::MutexLock l(&config_file_lock_);
+  while (true) {
+    while (pending_config_file_ == nullptr && !config_file_writer_stop_) {
+      config_file_cond_.Wait(&config_file_lock_);
+    }
+    // The queued config is saved even if the thread is being stopped.
+    if (pending_config_file_ == nullptr) break;
+    std::unique_ptr<ChassisConfig> config = std::move(pending_config_file_);
+    config_file_write_in_progress_ = true;
+    config_file_lock_.Unlock();
+    ::util::Status status =
+        WriteProtoToTextFile(*config, FLAGS_chassis_config_file);
+    if (!status.ok()) {
+      error_buffer_->AddError(status,
+                              "Saving chassis config failed: ", GTL_LOC);
+    }
+    config_file_lock_.Lock();
+    config_file_write_in_progress_ = false;
+    config_file_cond_.SignalAll();
+  }
+  // Configs saved from now on are written synchronously by the caller.
+  config_file_writer_running_ = false;
+  config_file_cond_.SignalAll();
+}
+
 namespace {
 // Helper function to determine whether all protobuf messages in a container
 // have an unique name field.
@@ -250,13 +357,22 @@ bool ContainsUniqueNames(const T& values) {
       return ::grpc::Status(ToGrpcCode(status.CanonicalCode()),
                             status.error_message());
     }
-    status = switch_interface_->PushChassisConfig(*config);
+    // Most Set requests only change a few leaves of the running config. Pass
+    // on what changed, so that the switch does not need to reconfigure the
+    // whole chassis.
+    if (running_chassis_config_ != nullptr) {
+      ChassisConfigDelta delta =
+          ComputeChassisConfigDelta(*running_chassis_config_, *config);
+      status = switch_interface_->PushChassisConfigDelta(*config, delta);
+    } else {
+      status = switch_interface_->PushChassisConfig(*config);
+    }
     // If the config push was successful or reported reboot required, save the
     // config on the switch. Any other config push error is considered
     // blocking.
     if (status.ok() || status.error_code() == ERR_REBOOT_REQUIRED) {
       APPEND_STATUS_IF_ERROR(
-          status, WriteProtoToTextFile(*config, FLAGS_chassis_config_file));
+          status, SaveChassisConfig(absl::make_unique<ChassisConfig>(*config)));
     }
     if (!status.ok()) {
       error_buffer_->AddError(status,
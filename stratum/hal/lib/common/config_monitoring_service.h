@@ -5,6 +5,8 @@
 #ifndef STRATUM_HAL_LIB_COMMON_CONFIG_MONITORING_SERVICE_H_
 #define STRATUM_HAL_LIB_COMMON_CONFIG_MONITORING_SERVICE_H_
 
+#include <pthread.h>
+
 #include <memory>
 
 #include "absl/base/thread_annotations.h"
@@ -135,6 +137,27 @@ class ConfigMonitoringService final : public ::gnmi::gNMI::Service {
                        const ::gnmi::SetRequest* req, ::gnmi::SetResponse* resp)
       LOCKS_EXCLUDED(config_lock_);
 
+  // Starts the background thread which saves the pushed chassis configs to
+  // FLAGS_chassis_config_file.
+  ::util::Status StartConfigFileWriter() LOCKS_EXCLUDED(config_file_lock_);
+
+  // Saves the last queued config, if any, and stops the background thread.
+  ::util::Status StopConfigFileWriter() LOCKS_EXCLUDED(config_file_lock_);
+
+  // Queues the config for being saved to FLAGS_chassis_config_file by the
+  // background thread, replacing any queued config which has not been saved
+  // yet. Saves the config synchronously if the background thread is not
+  // running.
+  ::util::Status SaveChassisConfig(std::unique_ptr<ChassisConfig> config)
+      LOCKS_EXCLUDED(config_file_lock_);
+
+  // Blocks until all queued configs have been saved.
+  void FlushChassisConfigFile() LOCKS_EXCLUDED(config_file_lock_);
+
+  // Thread function of the background thread saving the chassis configs.
+  static void* ConfigFileWriterThreadFunc(void* arg);
+  void ConfigFileWriterLoop() LOCKS_EXCLUDED(config_file_lock_);
+
   // Mutex lock for protecting the internal chassis config pushed to the switch.
   mutable absl::Mutex config_lock_;
 
@@ -166,6 +189,27 @@ class ConfigMonitoringService final : public ::gnmi::gNMI::Service {
   // An object handling gNMI Subscribe, Set and Get requests.
   GnmiPublisher gnmi_publisher_;
 
+  // Mutex lock for protecting the state of the background thread which saves
+  // the chassis configs. Never held while writing the file.
+  absl::Mutex config_file_lock_;
+
+  // Signaled whenever a config is queued or saved, or the thread is stopped.
+  absl::CondVar config_file_cond_;
+
+  // The config waiting to be saved to FLAGS_chassis_config_file, if any.
+  // Saving only the latest config lets a burst of Set requests cost a single
+  // file write.
+  std::unique_ptr<ChassisConfig> pending_config_file_
+      GUARDED_BY(config_file_lock_);
+
+  // True while the background thread writes a config to the file.
+  bool config_file_write_in_progress_ GUARDED_BY(config_file_lock_);
+
+  // State of the background thread.
+  pthread_t config_file_writer_tid_ GUARDED_BY(config_file_lock_);
+  bool config_file_writer_running_ GUARDED_BY(config_file_lock_);
+  bool config_file_writer_stop_ GUARDED_BY(config_file_lock_);
+
   friend class ConfigMonitoringServiceTest;
 };
 
@@ -109,6 +109,11 @@ class ConfigMonitoringServiceTest
     return config_monitoring_service_->DoSet(context, req, resp);
   }
 
+  // A proxy to private method of ConfigMonitoringService class.
+  void FlushChassisConfigFile() {
+    config_monitoring_service_->FlushChassisConfigFile();
+  }
+
   // A proxy to private method of ConfigMonitoringService class.
   ::grpc::Status DoCapabilities(::grpc::ServerContext* context,
                                 const ::gnmi::CapabilityRequest* req,
@@ -986,6 +991,49 @@ TEST_P(ConfigMonitoringServiceTest, GnmiSetRootReplace) {
   ASSERT_OK(config_monitoring_service_->Teardown());
 }
 
+// A config-changing DoSet() saves the new config in the background.
+TEST_P(ConfigMonitoringServiceTest, GnmiSetSavesChassisConfig) {
+  if (mode_ == OPERATION_MODE_COUPLED) return;
+
+  ChassisConfig config;
+  FillTestChassisConfigAndSave(&config);
+  EXPECT_CALL(*switch_mock_, RegisterEventNotifyWriter(_))
+      .WillOnce(Return(::util::OkStatus()));
+  EXPECT_CALL(*switch_mock_, PushChassisConfig(_))
+      .WillOnce(Return(::util::OkStatus()));
+  ASSERT_OK(config_monitoring_service_->Setup(false));
+
+  ::gnmi::SetRequest req;
+  openconfig::Device device;
+  ASSERT_OK(ReadProtoFromTextFile(
+      "stratum/hal/lib/common/testdata/simple_oc_device.pb.txt", &device));
+  std::string msg_bytes;
+  device.SerializeToString(&msg_bytes);
+  req.add_replace()->mutable_val()->set_bytes_val(msg_bytes);
+
+  // The default PushChassisConfigDelta() pushes the whole config.
+  ChassisConfig pushed_config;
+  EXPECT_CALL(*switch_mock_, PushChassisConfig(_))
+      .WillOnce(DoAll(SaveArg<0>(&pushed_config), Return(::util::OkStatus())));
+
+  ::grpc::ServerContext context;
+  ::gnmi::SetResponse resp;
+  auto grpc_status = DoSet(&context, &req, &resp);
+  ASSERT_TRUE(grpc_status.ok()) << grpc_status.error_message();
+  CheckRunningChassisConfig(&pushed_config);
+
+  FlushChassisConfigFile();
+  ChassisConfig saved_config;
+  ASSERT_OK(ReadProtoFromTextFile(FLAGS_chassis_config_file, &saved_config));
+  EXPECT_TRUE(ProtoEqual(pushed_config, saved_config));
+
+  // Clean-up.
+  EXPECT_CALL(*switch_mock_, UnregisterEventNotifyWriter())
+      .WillOnce(Return(::util::OkStatus()));
+  ASSERT_OK(config_monitoring_service_->Teardown());
+  EXPECT_TRUE(error_buffer_->GetErrors().empty());
+}
+
 // FIXME(boc) google only
 // Unsuccessful DoSet() execution for simple leaf gNMI SET UPDATE message.
 // TEST_P(ConfigMonitoringServiceTest, GnmiSetRootUpdate) {
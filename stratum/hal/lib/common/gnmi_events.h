@@ -5,6 +5,7 @@
 #ifndef STRATUM_HAL_LIB_COMMON_GNMI_EVENTS_H_
 #define STRATUM_HAL_LIB_COMMON_GNMI_EVENTS_H_
 
+#include <algorithm>
 #include <list>
 #include <memory>
 #include <set>
@@ -18,8 +19,10 @@
 #include "stratum/glue/integral_types.h"
 #include "stratum/glue/status/status.h"
 #include "stratum/hal/lib/common/common.pb.h"
+#include "stratum/lib/macros.h"
 #include "stratum/lib/timer_daemon.h"
 #include "stratum/lib/utils.h"
+#include "stratum/public/lib/error.h"
 
 namespace stratum {
 namespace hal {
@@ -500,6 +503,123 @@ class InlineGnmiSubscribeStream : public GnmiSubscribeStream {
   WriteFunctor write_func_;
 };
 
+// A GnmiSubscribeStream that gathers the updates written by a single handler
+// invocation (one timer tick, poll or event) into as few notifications as
+// possible. The updates share the timestamp of the first one and the longest
+// common path prefix, which is moved into the prefix of the notification.
+// A notification is sent once adding another update would exceed
+// max_notification_bytes and when Flush() is called. Responses which cannot
+// be merged (sync_response, deletes, notifications with a prefix, alias or
+// the atomic flag) flush the pending notification and are passed through
+// unchanged, so the order of the responses is preserved.
+class CoalescingGnmiSubscribeStream : public GnmiSubscribeStream {
+ public:
+  CoalescingGnmiSubscribeStream(GnmiSubscribeStream* stream,
+                                size_t max_notification_bytes)
+      : stream_(stream),
+        max_notification_bytes_(max_notification_bytes),
+        pending_bytes_(0) {}
+
+  bool Write(const ::gnmi::SubscribeResponse& msg,
+             ::grpc::WriteOptions options) override {
+    if (!IsMergeable(msg)) {
+      if (!Flush()) return false;
+      return stream_->Write(msg, options);
+    }
+    const size_t msg_bytes = msg.update().ByteSizeLong();
+    if (pending_bytes_ > 0 &&
+        pending_bytes_ + msg_bytes > max_notification_bytes_) {
+      if (!Flush()) return false;
+    }
+    ::gnmi::Notification* notification = pending_.mutable_update();
+    if (notification->update_size() == 0) {
+      notification->set_timestamp(msg.update().timestamp());
+    }
+    for (const auto& update : msg.update().update()) {
+      *notification->add_update() = update;
+    }
+    pending_bytes_ += msg_bytes;
+    return true;
+  }
+
+  // Sends the pending notification, if any. Returns false if the write to the
+  // underlying stream failed.
+  bool Flush() {
+    if (pending_.update().update_size() == 0) return true;
+    FactorOutCommonPrefix(pending_.mutable_update());
+    bool result = stream_->Write(pending_, ::grpc::WriteOptions());
+    pending_.Clear();
+    pending_bytes_ = 0;
+    return result;
+  }
+
+ private:
+  static bool IsMergeable(const ::gnmi::SubscribeResponse& msg) {
+    if (!msg.has_update()) return false;
+    const ::gnmi::Notification& notification = msg.update();
+    return !notification.has_prefix() && notification.alias().empty() &&
+           !notification.atomic() && notification.delete__size() == 0 &&
+           notification.update_size() > 0;
+  }
+
+  static bool PathElemsEqual(const ::gnmi::PathElem& a,
+                             const ::gnmi::PathElem& b) {
+    if (a.name() != b.name() || a.key_size() != b.key_size()) return false;
+    for (const auto& key : a.key()) {
+      auto it = b.key().find(key.first);
+      if (it == b.key().end() || it->second != key.second) return false;
+    }
+    return true;
+  }
+
+  // Moves the path elements shared by all updates into the prefix of the
+  // notification. Every update keeps at least its leaf element. Paths using
+  // the deprecated 'element' field, an origin or a target are left as is.
+  static void FactorOutCommonPrefix(::gnmi::Notification* notification) {
+    if (notification->update_size() < 2) return;
+    const ::gnmi::Path& first = notification->update(0).path();
+    int common = first.elem_size() - 1;
+    for (const auto& update : notification->update()) {
+      const ::gnmi::Path& path = update.path();
+      if (path.element_size() > 0 || !path.origin().empty() ||
+          !path.target().empty()) {
+        return;
+      }
+      common = std::min(common, path.elem_size() - 1);
+      for (int i = 0; i < common; ++i) {
+        if (!PathElemsEqual(first.elem(i), path.elem(i))) {
+          common = i;
+          break;
+        }
+      }
+    }
+    if (common <= 0) return;
+    ::gnmi::Path* prefix = notification->mutable_prefix();
+    for (int i = 0; i < common; ++i) *prefix->add_elem() = first.elem(i);
+    for (auto& update : *notification->mutable_update()) {
+      update.mutable_path()->mutable_elem()->DeleteSubrange(0, common);
+    }
+  }
+
+  // Forwarded to the underlying stream.
+  void SendInitialMetadata() override { stream_->SendInitialMetadata(); }
+  bool NextMessageSize(uint32_t* sz) override {
+    return stream_->NextMessageSize(sz);
+  }
+  bool Read(::gnmi::SubscribeRequest* msg) override {
+    return stream_->Read(msg);
+  }
+
+  // The stream the (coalesced) responses are written to. Not owned.
+  GnmiSubscribeStream* stream_;
+  // The size in bytes above which a notification is not extended anymore.
+  const size_t max_notification_bytes_;
+  // The response that gathers the updates.
+  ::gnmi::SubscribeResponse pending_;
+  // The serialized size of the updates gathered in pending_.
+  size_t pending_bytes_;
+};
+
 using GnmiEventHandler = std::function<::util::Status(
     const GnmiEvent& event, GnmiSubscribeStream* stream)>;
 
@@ -584,20 +704,49 @@ using GnmiDeleteHandler = std::function<::util::Status(
 // A class used to keep information about a subscription.
 class EventHandlerRecord {
  public:
-  // Constructor.
+  // Constructor. If max_notification_bytes is not zero, the updates written
+  // by one invocation of the handler are coalesced into notifications of at
+  // most (roughly) that size, see CoalescingGnmiSubscribeStream. The records
+  // writing to the same stream must share its stream_lock. A record gets a
+  // lock of its own if none is given.
   EventHandlerRecord(const GnmiEventHandler& handler,
-                     GnmiSubscribeStream* stream)
-      : handler_(handler), stream_(stream) {}
+                     GnmiSubscribeStream* stream,
+                     size_t max_notification_bytes = 0,
+                     std::shared_ptr<absl::Mutex> stream_lock = nullptr)
+      : handler_(handler),
+        stream_(stream),
+        max_notification_bytes_(max_notification_bytes),
+        stream_lock_(stream_lock != nullptr
+                         ? std::move(stream_lock)
+                         : std::make_shared<absl::Mutex>()),
+        cancelled_(false) {}
   // Destructor.
   virtual ~EventHandlerRecord() {}
 
-  // Generic processing of an event.
+  // Generic processing of an event. The handlers of the records sharing a
+  // stream are run one at a time, so their responses are not interleaved.
+  // Does nothing once Cancel() has been called.
   ::util::Status operator()(const GnmiEvent& event) const {
-    auto status = handler_(event, stream_);
-    if (status != ::util::OkStatus()) {
-      return status;
+    absl::MutexLock l(stream_lock_.get());
+    if (cancelled_) return ::util::OkStatus();
+    if (stream_ == nullptr || max_notification_bytes_ == 0) {
+      return handler_(event, stream_);
     }
-    return ::util::OkStatus();
+    CoalescingGnmiSubscribeStream coalescing_stream(stream_,
+                                                    max_notification_bytes_);
+    auto status = handler_(event, &coalescing_stream);
+    // Send whatever has been gathered, even if the handler failed half way.
+    if (!coalescing_stream.Flush() && status.ok()) {
+      return MAKE_ERROR(ERR_INTERNAL) << "Writing response to stream failed.";
+    }
+    return status;
+  }
+
+  // Waits for a running invocation of the handler to finish and turns the
+  // later ones into no-ops, after which the stream may be destroyed.
+  void Cancel() {
+    absl::MutexLock l(stream_lock_.get());
+    cancelled_ = true;
   }
 
   TimerDaemon::DescriptorPtr* mutable_timer() { return &timer_; }
@@ -607,6 +756,12 @@ class EventHandlerRecord {
   GnmiEventHandler handler_;
   // A stream to the client (the controller).
   GnmiSubscribeStream* stream_;
+  // Upper bound of the size of coalesced notifications. 0 disables coalescing.
+  size_t max_notification_bytes_;
+  // Serializes the writes to stream_ and guards cancelled_.
+  std::shared_ptr<absl::Mutex> stream_lock_;
+  // Set by Cancel().
+  bool cancelled_;
   // Not every EventHandler is executed on timer, but some are and this is the
   // handler that is used by the timer sub-system.
   TimerDaemon::DescriptorPtr timer_;
@@ -4,16 +4,24 @@
 
 #include "stratum/hal/lib/common/gnmi_publisher.h"
 
+#include <algorithm>
 #include <list>
 #include <string>
 #include <utility>
 
 #include "absl/synchronization/mutex.h"
+#include "gflags/gflags.h"
 #include "gnmi/gnmi.pb.h"
 #include "stratum/glue/gtl/map_util.h"
 #include "stratum/hal/lib/common/channel_writer_wrapper.h"
 #include "stratum/hal/lib/common/yang_parse_tree_paths.h"
 
+DEFINE_int32(gnmi_max_coalesced_notification_bytes, 256 * 1024,
+             "Upper bound in bytes of the notifications into which the updates "
+             "of one subscription produced during one sampling tick, poll or "
+             "event are coalesced. 0 sends every update in its own "
+             "notification.");
+
 namespace stratum {
 namespace hal {
 
@@ -93,7 +101,9 @@ GnmiPublisher::~GnmiPublisher() {}
 
 ::util::Status GnmiPublisher::HandleEvent(
     const GnmiEvent& event, const std::weak_ptr<EventHandlerRecord>& h) {
-  absl::WriterMutexLock l(&access_lock_);
+  // No access_lock_ here, so that a slow handler does not delay the others.
+  // The handler locks the parse tree nodes it walks and the stream it writes
+  // to on its own.
 
   // In order to reference a weak pointer, first it has to be used to create a
   // shared pointer.
@@ -104,8 +114,7 @@ GnmiPublisher::~GnmiPublisher() {}
 }
 
 ::util::Status GnmiPublisher::HandlePoll(const SubscriptionHandle& handle) {
-  absl::WriterMutexLock l(&access_lock_);
-
+  // Like HandleEvent(), runs the handler without access_lock_.
   return (*handle)(PollEvent());
 }
 
@@ -185,12 +194,34 @@ GnmiPublisher::~GnmiPublisher() {}
            << ") support this mode!";
   }
   // All good! Save the handler that handles this leaf.
-  h->reset(new EventHandlerRecord((node->*get_handler)(), stream));
+  h->reset(new EventHandlerRecord(
+      (node->*get_handler)(), stream,
+      std::max(FLAGS_gnmi_max_coalesced_notification_bytes, 0),
+      GetStreamLock(stream)));
   return ::util::OkStatus();
 }
 
+std::shared_ptr<absl::Mutex> GnmiPublisher::GetStreamLock(
+    GnmiSubscribeStream* stream) {
+  std::shared_ptr<absl::Mutex> stream_lock = stream_locks_[stream].lock();
+  if (stream_lock != nullptr) return stream_lock;
+  // Forget the locks of the streams that have no subscriptions left.
+  for (auto it = stream_locks_.begin(); it != stream_locks_.end();) {
+    if (it->second.expired()) {
+      stream_locks_.erase(it++);
+    } else {
+      ++it;
+    }
+  }
+  stream_lock = std::make_shared<absl::Mutex>();
+  stream_locks_[stream] = stream_lock;
+  return stream_lock;
+}
+
 ::util::Status GnmiPublisher::UnSubscribe(const SubscriptionHandle& h) {
   absl::WriterMutexLock l(&access_lock_);
+  // The handler may still be running on a timer worker.
+  h->Cancel();
   // There is no way to match a subscription to a certain type of event.
   // Therefore we have to try removing it from every list we register events
   // on. Currently this is just TimerEvent.
@@ -227,6 +258,13 @@ GnmiPublisher::UpdateSubscriptionWithTargetSpecificModeSpecification(
     LOG(ERROR) << "Message cannot be sent as the stream pointer is null!";
     return MAKE_ERROR(ERR_INTERNAL) << "stream pointer is null!";
   }
+  std::shared_ptr<absl::Mutex> stream_lock;
+  {
+    absl::WriterMutexLock l(&access_lock_);
+    stream_lock = GetStreamLock(stream);
+  }
+  // Do not interleave with the responses of the running handlers.
+  absl::MutexLock l(stream_lock.get());
   return YangParseTreePaths::SendEndOfSeriesMessage(stream);
 }
 
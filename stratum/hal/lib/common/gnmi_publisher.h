@@ -128,7 +128,8 @@ class GnmiPublisher {
       LOCKS_EXCLUDED(access_lock_);
 
   // The method sends a gNMI message denoting the end of initial set of values.
-  virtual ::util::Status SendSyncResponse(GnmiSubscribeStream* stream);
+  virtual ::util::Status SendSyncResponse(GnmiSubscribeStream* stream)
+      LOCKS_EXCLUDED(access_lock_);
 
   // Method creating the channel to be used to receive notifications from
   // the switch.
@@ -154,7 +155,8 @@ class GnmiPublisher {
   }
 
   // An internal method that handles an event in the context of particular event
-  // handler.
+  // handler. Called by the timer workers, so the handler is run without
+  // access_lock_.
   ::util::Status HandleEvent(const GnmiEvent& event,
                              const EventHandlerRecordPtr& h)
       LOCKS_EXCLUDED(access_lock_);
@@ -168,6 +170,10 @@ class GnmiPublisher {
                            GnmiSubscribeStream* stream, SubscriptionHandle* h)
       LOCKS_EXCLUDED(access_lock_);
 
+  // Returns the lock shared by the subscriptions writing to 'stream'.
+  std::shared_ptr<absl::Mutex> GetStreamLock(GnmiSubscribeStream* stream)
+      EXCLUSIVE_LOCKS_REQUIRED(access_lock_);
+
   // A handler of events received over the event_channel_ channel.
   void ReadGnmiEvents(
       const std::unique_ptr<ChannelReader<GnmiEventPtr>>& reader)
@@ -188,6 +194,11 @@ class GnmiPublisher {
   // that node.
   YangParseTree parse_tree_ GUARDED_BY(access_lock_);
 
+  // The locks serializing the handlers of the subscriptions per stream, see
+  // EventHandlerRecord. Owned by the records.
+  absl::flat_hash_map<GnmiSubscribeStream*, std::weak_ptr<absl::Mutex>>
+      stream_locks_ GUARDED_BY(access_lock_);
+
   // Channel for receiving transceiver events from the SwitchInterface.
   std::shared_ptr<Channel<GnmiEventPtr>> event_channel_
       GUARDED_BY(access_lock_);
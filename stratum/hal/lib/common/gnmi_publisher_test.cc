@@ -4,18 +4,26 @@
 
 #include "stratum/hal/lib/common/gnmi_publisher.h"
 
+#include <atomic>
+#include <memory>
+#include <thread>  // NOLINT
+#include <vector>
+
 #include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
 #include "gmock/gmock.h"
 #include "gnmi/gnmi.pb.h"
 #include "gtest/gtest.h"
 #include "stratum/glue/status/status_test_util.h"
 #include "stratum/hal/lib/common/subscribe_reader_writer_mock.h"
 #include "stratum/hal/lib/common/switch_mock.h"
+#include "stratum/lib/test_utils/matchers.h"
 #include "stratum/lib/utils.h"
 
 namespace stratum {
 namespace hal {
 
+using test_utils::EqualsProto;
 using ::testing::_;
 using ::testing::DoAll;
 using ::testing::HasSubstr;
@@ -231,6 +239,21 @@ TEST_F(SubscriptionTest, HandleTimer) {
   EXPECT_OK(gnmi_publisher_->HandleChange(TimerEvent()));
 }
 
+TEST_F(SubscriptionTest, HandlerIsNotRunAfterUnSubscribe) {
+  SubscribeReaderWriterMock stream;
+
+  SubscriptionHandle h;
+  ::gnmi::Path path = GetPath("interfaces")(
+      "interface", "device1.domain.net.com:ce-1/1")("state")("admin-status")();
+  EXPECT_OK(gnmi_publisher_->SubscribePoll(path, &stream, &h));
+  EXPECT_OK(gnmi_publisher_->UnSubscribe(h));
+
+  // A timer worker may still hold the handle, but the stream may be gone.
+  EXPECT_CALL(stream, Write(_, _)).Times(0);
+  EXPECT_CALL(switch_mock_, RetrieveValue(_, _, _, _)).Times(0);
+  EXPECT_OK(gnmi_publisher_->HandlePoll(h));
+}
+
 TEST_F(SubscriptionTest, OnUpdateUnSupportedPath) {
   // Configure the device - the model will reconfigure itself to reflect the
   // configuration.
@@ -298,6 +321,182 @@ TEST_F(SubscriptionTest, SyncResponseWriteError) {
               HasSubstr("failed"));
 }
 
+// Checks that the updates of all leaves of a subtree polled at once are sent
+// in a single notification that carries their common path prefix.
+TEST_F(SubscriptionTest, PollOfSubtreeIsCoalesced) {
+  SubscribeReaderWriterMock stream;
+  SubscriptionHandle h;
+  ::gnmi::Path path = GetPath("interfaces")(
+      "interface", "device1.domain.net.com:ce-1/1")("state")("counters")();
+  ASSERT_OK(gnmi_publisher_->SubscribePoll(path, &stream, &h));
+
+  EXPECT_CALL(switch_mock_, RetrieveValue(_, _, _, _))
+      .WillRepeatedly(Invoke([](uint64 node_id, const DataRequest& request,
+                                WriterInterface<DataResponse>* w,
+                                std::vector<::util::Status>* details) {
+        for (int i = 0; i < request.requests_size(); ++i) {
+          DataResponse resp;
+          resp.mutable_port_counters()->set_in_octets(42);
+          w->Write(resp);
+          if (details) details->push_back(::util::OkStatus());
+        }
+        return ::util::OkStatus();
+      }));
+  ::gnmi::SubscribeResponse resp;
+  EXPECT_CALL(stream, Write(_, _))
+      .WillOnce(DoAll(SaveArg<0>(&resp), Return(true)));
+
+  EXPECT_OK(gnmi_publisher_->HandlePoll(h));
+  ASSERT_TRUE(resp.has_update());
+  EXPECT_GT(resp.update().update_size(), 1);
+  EXPECT_THAT(resp.update().prefix(), EqualsProto(path));
+  for (const auto& update : resp.update().update()) {
+    EXPECT_EQ(1, update.path().elem_size()) << update.ShortDebugString();
+  }
+}
+
+namespace {
+
+// Returns a SubscribeResponse with a single update of the given leaf path.
+::gnmi::SubscribeResponse GetLeafResponse(const ::gnmi::Path& path,
+                                          uint64 timestamp) {
+  ::gnmi::SubscribeResponse resp;
+  resp.mutable_update()->set_timestamp(timestamp);
+  ::gnmi::Update* update = resp.mutable_update()->add_update();
+  *update->mutable_path() = path;
+  update->mutable_val()->set_uint_val(1);
+  return resp;
+}
+
+}  // namespace
+
+TEST(CoalescingGnmiSubscribeStreamTest, UpdatesAreMergedUntilFlush) {
+  SubscribeReaderWriterMock stream;
+  CoalescingGnmiSubscribeStream coalescing_stream(&stream, 1024);
+  ::gnmi::SubscribeResponse resp;
+  EXPECT_CALL(stream, Write(_, _))
+      .WillOnce(DoAll(SaveArg<0>(&resp), Return(true)));
+
+  EXPECT_TRUE(coalescing_stream.Write(
+      GetLeafResponse(GetPath("a")("b")("c")(), 10), ::grpc::WriteOptions()));
+  EXPECT_TRUE(coalescing_stream.Write(
+      GetLeafResponse(GetPath("a")("b")("d")("e")(), 20),
+      ::grpc::WriteOptions()));
+  EXPECT_TRUE(coalescing_stream.Flush());
+  // Nothing left to send.
+  EXPECT_TRUE(coalescing_stream.Flush());
+
+  EXPECT_EQ(10, resp.update().timestamp());
+  EXPECT_THAT(resp.update().prefix(), EqualsProto(GetPath("a")("b")()));
+  ASSERT_EQ(2, resp.update().update_size());
+  EXPECT_THAT(resp.update().update(0).path(), EqualsProto(GetPath("c")()));
+  EXPECT_THAT(resp.update().update(1).path(), EqualsProto(GetPath("d")("e")()));
+}
+
+TEST(CoalescingGnmiSubscribeStreamTest, SingleUpdateIsUnchanged) {
+  SubscribeReaderWriterMock stream;
+  CoalescingGnmiSubscribeStream coalescing_stream(&stream, 1024);
+  const auto leaf = GetLeafResponse(GetPath("a")("b")(), 10);
+  ::gnmi::SubscribeResponse resp;
+  EXPECT_CALL(stream, Write(_, _))
+      .WillOnce(DoAll(SaveArg<0>(&resp), Return(true)));
+
+  EXPECT_TRUE(coalescing_stream.Write(leaf, ::grpc::WriteOptions()));
+  EXPECT_TRUE(coalescing_stream.Flush());
+  EXPECT_THAT(resp, EqualsProto(leaf));
+}
+
+TEST(CoalescingGnmiSubscribeStreamTest, ByteBudgetSplitsNotifications) {
+  SubscribeReaderWriterMock stream;
+  const auto leaf = GetLeafResponse(GetPath("a")("b")(), 10);
+  // Room for two updates per notification.
+  CoalescingGnmiSubscribeStream coalescing_stream(
+      &stream, 2 * leaf.update().ByteSizeLong());
+  std::vector<::gnmi::SubscribeResponse> resps;
+  EXPECT_CALL(stream, Write(_, _))
+      .Times(3)
+      .WillRepeatedly(Invoke([&resps](const ::gnmi::SubscribeResponse& msg,
+                                      ::grpc::WriteOptions options) {
+        resps.push_back(msg);
+        return true;
+      }));
+
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_TRUE(coalescing_stream.Write(leaf, ::grpc::WriteOptions()));
+  }
+  EXPECT_TRUE(coalescing_stream.Flush());
+  ASSERT_EQ(3, resps.size());
+  EXPECT_EQ(2, resps[0].update().update_size());
+  EXPECT_EQ(2, resps[1].update().update_size());
+  EXPECT_EQ(1, resps[2].update().update_size());
+}
+
+TEST(CoalescingGnmiSubscribeStreamTest, SyncResponseFlushesPendingUpdates) {
+  SubscribeReaderWriterMock stream;
+  CoalescingGnmiSubscribeStream coalescing_stream(&stream, 1024);
+  std::vector<::gnmi::SubscribeResponse> resps;
+  EXPECT_CALL(stream, Write(_, _))
+      .Times(2)
+      .WillRepeatedly(Invoke([&resps](const ::gnmi::SubscribeResponse& msg,
+                                      ::grpc::WriteOptions options) {
+        resps.push_back(msg);
+        return true;
+      }));
+
+  EXPECT_TRUE(coalescing_stream.Write(GetLeafResponse(GetPath("a")(), 10),
+                                      ::grpc::WriteOptions()));
+  ::gnmi::SubscribeResponse sync;
+  sync.set_sync_response(true);
+  EXPECT_TRUE(coalescing_stream.Write(sync, ::grpc::WriteOptions()));
+  EXPECT_TRUE(coalescing_stream.Flush());
+  ASSERT_EQ(2, resps.size());
+  EXPECT_TRUE(resps[0].has_update());
+  EXPECT_TRUE(resps[1].sync_response());
+}
+
+TEST(CoalescingGnmiSubscribeStreamTest, WriteErrorIsReported) {
+  SubscribeReaderWriterMock stream;
+  EXPECT_CALL(stream, Write(_, _)).WillOnce(Return(false));
+  GnmiEventHandler handler = [](const GnmiEvent& event,
+                                GnmiSubscribeStream* stream) {
+    stream->Write(GetLeafResponse(GetPath("a")(), 10), ::grpc::WriteOptions());
+    return ::util::OkStatus();
+  };
+  EventHandlerRecord record(handler, &stream, 1024);
+
+  EXPECT_THAT(record(PollEvent()).error_message(), HasSubstr("failed"));
+}
+
+TEST(EventHandlerRecordTest, HandlersSharingAStreamRunOneAtATime) {
+  auto stream_lock = std::make_shared<absl::Mutex>();
+  absl::Notification first_started;
+  absl::Notification first_may_finish;
+  std::atomic<bool> first_done(false);
+  EventHandlerRecord first(
+      [&](const GnmiEvent& event, GnmiSubscribeStream* stream) {
+        first_started.Notify();
+        first_may_finish.WaitForNotification();
+        first_done = true;
+        return ::util::OkStatus();
+      },
+      nullptr, 0, stream_lock);
+  bool first_done_before_second = false;
+  EventHandlerRecord second(
+      [&](const GnmiEvent& event, GnmiSubscribeStream* stream) {
+        first_done_before_second = first_done;
+        return ::util::OkStatus();
+      },
+      nullptr, 0, stream_lock);
+
+  std::thread first_thread([&first]() { EXPECT_OK(first(TimerEvent())); });
+  first_started.WaitForNotification();
+  std::thread second_thread([&second]() { EXPECT_OK(second(TimerEvent())); });
+  first_may_finish.Notify();
+  first_thread.join();
+  second_thread.join();
+  EXPECT_TRUE(first_done_before_second);
+}
+
 TEST_F(SubscriptionTest, CheckConvertTargetDefinedToOnChange) {
   ::gnmi::Subscription subscription;
   subscription.set_mode(::gnmi::SubscriptionMode::TARGET_DEFINED);
@@ -15,6 +15,7 @@
 #include "absl/synchronization/mutex.h"
 #include "gflags/gflags.h"
 #include "stratum/glue/logging.h"
+#include "stratum/hal/lib/common/write_audit_log.h"
 #include "stratum/lib/constants.h"
 #include "stratum/lib/macros.h"
 #include "stratum/lib/utils.h"
@@ -128,6 +129,8 @@ Hal::~Hal() {
             << (FLAGS_warmboot ? "WARMBOOT" : "COLDBOOT") << " mode...";
 
   RETURN_IF_ERROR(RecursivelyCreateDir(FLAGS_persistent_config_dir));
+  // The write audit log is shut down by Teardown(), start it again.
+  RETURN_IF_ERROR(WriteAuditLog::GetSingleton()->Start());
 
   // Setup all the services. In case of coldboot setup, we push the saved
   // configs to the switch as part of setup. In case of warmboot, we only
@@ -169,6 +172,9 @@ Hal::~Hal() {
   APPEND_STATUS_IF_ERROR(status, diag_service_->Teardown());
   APPEND_STATUS_IF_ERROR(status, file_service_->Teardown());
   APPEND_STATUS_IF_ERROR(status, switch_interface_->Shutdown());
+  // Writes out the records still queued by P4Service and the switch, now
+  // that no more writes can happen.
+  APPEND_STATUS_IF_ERROR(status, WriteAuditLog::GetSingleton()->Shutdown());
   APPEND_STATUS_IF_ERROR(status, auth_policy_checker_->Shutdown());
   APPEND_STATUS_IF_ERROR(status, admin_service_->Teardown());
   if (!status.ok()) {
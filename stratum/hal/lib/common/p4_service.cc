@@ -5,7 +5,9 @@
 #include "stratum/hal/lib/common/p4_service.h"
 
 #include <functional>
+#include <memory>
 #include <sstream>  // IWYU pragma: keep
+#include <string>
 #include <utility>
 
 #include "absl/cleanup/cleanup.h"
@@ -22,6 +24,7 @@
 #include "stratum/glue/logging.h"
 #include "stratum/glue/status/status_macros.h"
 #include "stratum/hal/lib/common/server_writer_wrapper.h"
+#include "stratum/hal/lib/common/write_audit_log.h"
 #include "stratum/lib/channel/channel.h"
 #include "stratum/lib/macros.h"
 #include "stratum/lib/utils.h"
@@ -33,6 +36,12 @@ DEFINE_string(forwarding_pipeline_configs_file,
               "pushed to the switch. This file is updated whenever "
               "ForwardingPipelineConfig proto for switching node is added or "
               "modified.");
+DEFINE_bool(binary_forwarding_pipeline_configs_file, false,
+            "Save the forwarding pipeline configs file in a checksummed binary "
+            "format instead of text format. Saved files in either format are "
+            "read on startup, and text files are converted to binary if this "
+            "flag is set. Older Stratum versions can only read the text "
+            "format.");
 DEFINE_string(write_req_log_file, "/var/log/stratum/p4_writes.pb.txt",
               "The log file for all the individual write request updates and "
               "the corresponding result. The format for each line is: "
@@ -50,6 +59,44 @@ DEFINE_int32(max_num_controller_connections, 20,
 namespace stratum {
 namespace hal {
 
+namespace {
+
+// Reads the saved forwarding pipeline configs, in text or binary format. Text
+// files are converted to the binary format so that subsequent starts skip the
+// slow text parsing of the embedded binary pipeline blobs.
+::util::Status ReadForwardingPipelineConfigsFile(
+    ForwardingPipelineConfigs* configs) {
+  const std::string& filename = FLAGS_forwarding_pipeline_configs_file;
+  if (IsChecksummedBinFile(filename)) {
+    return ReadProtoFromChecksummedBinFile(filename, configs);
+  }
+  RETURN_IF_ERROR(ReadProtoFromTextFile(filename, configs));
+  if (FLAGS_binary_forwarding_pipeline_configs_file) {
+    ::util::Status status = WriteProtoToChecksummedBinFile(*configs, filename);
+    if (status.ok()) {
+      LOG(INFO) << "Converted the saved forwarding pipeline configs in "
+                << filename << " to binary format.";
+    } else {
+      LOG(WARNING) << "Failed to convert the saved forwarding pipeline configs "
+                   << "in " << filename << " to binary format: " << status;
+    }
+  }
+
+  return ::util::OkStatus();
+}
+
+// Saves the forwarding pipeline configs in the configured file format.
+::util::Status WriteForwardingPipelineConfigsFile(
+    const ForwardingPipelineConfigs& configs) {
+  if (FLAGS_binary_forwarding_pipeline_configs_file) {
+    return WriteProtoToChecksummedBinFile(
+        configs, FLAGS_forwarding_pipeline_configs_file);
+  }
+  return WriteProtoToTextFile(configs, FLAGS_forwarding_pipeline_configs_file);
+}
+
+}  // namespace
+
 // TODO(unknown): This class move possibly big configs in memory. See if there
 // is a way to make this more efficient.
 
@@ -110,8 +157,8 @@ P4Service::~P4Service() {}
   {
     absl::WriterMutexLock l(&config_lock_);
     forwarding_pipeline_configs_ = nullptr;
+    RebuildForwardingPipelineConfigSnapshots();
   }
-
   return ::util::OkStatus();
 }
 
@@ -122,8 +169,7 @@ P4Service::~P4Service() {}
             << FLAGS_forwarding_pipeline_configs_file << "...";
   absl::WriterMutexLock l(&config_lock_);
   ForwardingPipelineConfigs configs;
-  ::util::Status status =
-      ReadProtoFromTextFile(FLAGS_forwarding_pipeline_configs_file, &configs);
+  ::util::Status status = ReadForwardingPipelineConfigsFile(&configs);
   if (!status.ok()) {
     if (!warmboot && status.error_code() == ERR_FILE_NOT_FOUND) {
       // Not a critical error. If coldboot, we don't even return error.
@@ -170,6 +216,7 @@ P4Service::~P4Service() {}
     // nodes.
     *forwarding_pipeline_configs_ = configs;
   }
+  RebuildForwardingPipelineConfigSnapshots();
 
   return status;
 }
@@ -241,18 +288,10 @@ void LogWriteRequest(uint64 node_id, const ::p4::v1::WriteRequest& req,
                << " != " << req.updates_size() << ". Did not log anything!";
     return;
   }
-  std::string msg = "";
-  std::string ts =
-      absl::FormatTime("%Y-%m-%d %H:%M:%E6S", timestamp, absl::LocalTimeZone());
-  for (size_t i = 0; i < results.size(); ++i) {
-    absl::StrAppend(&msg, ts, ";", node_id, ";",
-                    req.updates(i).ShortDebugString(), ";",
-                    results[i].error_message(), "\n");
-  }
-  ::util::Status status =
-      WriteStringToFile(msg, FLAGS_write_req_log_file, /*append=*/true);
-  LOG_IF_EVERY_N(ERROR, !status.ok(), 50)
-      << "Failed to log the write request: " << status.error_message();
+  // The request is formatted and written to the file in the background, so
+  // that the RPC does not wait for the file I/O.
+  WriteAuditLog::GetSingleton()->AppendWriteRequest(
+      FLAGS_write_req_log_file, node_id, req, results, timestamp);
 }
 
 // Helper to facilitate logging the read requests to the desired log file.
@@ -317,7 +356,8 @@ void LogReadRequest(uint64 node_id, const ::p4::v1::ReadRequest& req,
                           "Invalid device ID.");
   }
 
-  // Check that a forwarding config is present.
+  // Check that a forwarding config is present. This only takes a reference to
+  // the config snapshot of the node, the config itself is not copied.
   auto ret = DoGetForwardingPipelineConfig(node_id);
   if (!ret.ok()) {
     return ::grpc::Status(ToGrpcCode(ret.status().CanonicalCode()),
@@ -363,12 +403,16 @@ void LogReadRequest(uint64 node_id, const ::p4::v1::ReadRequest& req,
                           "Invalid device ID.");
   }
 
-  // Check that a forwarding config is present.
+  // Check that a forwarding config is present. The returned snapshot keeps the
+  // P4Info alive for the wildcard expansion below, even if a new config is
+  // pushed concurrently.
   auto ret = DoGetForwardingPipelineConfig(node_id);
   if (!ret.ok()) {
     return ::grpc::Status(ToGrpcCode(ret.status().CanonicalCode()),
                           ret.status().error_message());
   }
+  const std::shared_ptr<const ::p4::v1::ForwardingPipelineConfig> config =
+      ret.ConsumeValueOrDie();
 
   // To allow role config read filtering in wildcard requests, we have to expand
   // wildcard reads targeting all tables into individual table wildcards. At the
@@ -378,7 +422,7 @@ void LogReadRequest(uint64 node_id, const ::p4::v1::ReadRequest& req,
   ::p4::v1::ReadRequest expanded_req;
   if (!req->role().empty()) {
     expanded_req =
-        ExpandWildcardsInReadRequest(*req, ret.ValueOrDie().p4info());
+        ExpandWildcardsInReadRequest(*req, config->p4info());
     req = &expanded_req;
     VLOG(1) << "Expanded wildcard read into "
             << expanded_req.ShortDebugString();
@@ -470,14 +514,21 @@ void LogReadRequest(uint64 node_id, const ::p4::v1::ReadRequest& req,
       if (error.ok() || error.error_code() == ERR_REBOOT_REQUIRED) {
         (*configs_to_save_in_file.mutable_node_id_to_config())[node_id] =
             req->config();
-        APPEND_STATUS_IF_ERROR(
-            status,
-            WriteProtoToTextFile(configs_to_save_in_file,
-                                 FLAGS_forwarding_pipeline_configs_file));
+        APPEND_STATUS_IF_ERROR(status, WriteForwardingPipelineConfigsFile(
+                                           configs_to_save_in_file));
       }
       if (error.ok()) {
         (*forwarding_pipeline_configs_->mutable_node_id_to_config())[node_id] =
             req->config();
+        std::shared_ptr<const ::p4::v1::ForwardingPipelineConfig> snapshot =
+            std::make_shared<const ::p4::v1::ForwardingPipelineConfig>(
+                req->config());
+        {
+          absl::WriterMutexLock snapshot_lock(&config_snapshot_lock_);
+          node_id_to_config_snapshot_[node_id].swap(snapshot);
+        }
+        // 'snapshot' now holds the previous config of the node, which is freed
+        // once the last in-flight RPC using it is done.
       }
       break;
     }
@@ -528,7 +579,9 @@ void LogReadRequest(uint64 node_id, const ::p4::v1::ReadRequest& req,
     return ::grpc::Status(ToGrpcCode(status.status().CanonicalCode()),
                           status.status().error_message());
   }
-  const ::p4::v1::ForwardingPipelineConfig& config = status.ValueOrDie();
+  const std::shared_ptr<const ::p4::v1::ForwardingPipelineConfig> snapshot =
+      status.ConsumeValueOrDie();
+  const ::p4::v1::ForwardingPipelineConfig& config = *snapshot;
 
   switch (req->response_type()) {
     case ::p4::v1::GetForwardingPipelineConfigRequest::ALL: {
@@ -812,17 +865,16 @@ bool P4Service::IsMasterController(
   return it->second.AllowRequest(role_name, election_id).ok();
 }
 
-::util::StatusOr<::p4::v1::ForwardingPipelineConfig>
+::util::StatusOr<std::shared_ptr<const ::p4::v1::ForwardingPipelineConfig>>
 P4Service::DoGetForwardingPipelineConfig(uint64 node_id) const {
-  absl::ReaderMutexLock l(&config_lock_);
-  if (forwarding_pipeline_configs_ == nullptr ||
-      forwarding_pipeline_configs_->node_id_to_config_size() == 0) {
+  absl::ReaderMutexLock l(&config_snapshot_lock_);
+  if (node_id_to_config_snapshot_.empty()) {
     return MAKE_ERROR(ERR_FAILED_PRECONDITION)
            << "No valid forwarding pipeline config has been pushed for any "
            << "node so far.";
   }
-  auto it = forwarding_pipeline_configs_->node_id_to_config().find(node_id);
-  if (it == forwarding_pipeline_configs_->node_id_to_config().end()) {
+  auto it = node_id_to_config_snapshot_.find(node_id);
+  if (it == node_id_to_config_snapshot_.end()) {
     return MAKE_ERROR(ERR_FAILED_PRECONDITION)
            << "Invalid node id or no valid forwarding pipeline config has been "
            << "pushed for node " << node_id << " yet.";
@@ -831,6 +883,23 @@ P4Service::DoGetForwardingPipelineConfig(uint64 node_id) const {
   return it->second;
 }
 
+void P4Service::RebuildForwardingPipelineConfigSnapshots() {
+  absl::flat_hash_map<uint64,
+                      std::shared_ptr<const ::p4::v1::ForwardingPipelineConfig>>
+      snapshots;
+  if (forwarding_pipeline_configs_ != nullptr) {
+    for (const auto& e : forwarding_pipeline_configs_->node_id_to_config()) {
+      snapshots[e.first] =
+          std::make_shared<const ::p4::v1::ForwardingPipelineConfig>(e.second);
+    }
+  }
+  // Swap under the lock and let the old snapshots be released outside of it.
+  {
+    absl::WriterMutexLock l(&config_snapshot_lock_);
+    node_id_to_config_snapshot_.swap(snapshots);
+  }
+}
+
 p4::v1::ReadRequest P4Service::ExpandWildcardsInReadRequest(
     const p4::v1::ReadRequest& req,
     const p4::config::v1::P4Info& p4info) const {
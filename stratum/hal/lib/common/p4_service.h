@@ -168,10 +168,19 @@ class P4Service final : public ::p4::v1::P4Runtime::Service {
       const absl::optional<absl::uint128>& election_id) const
       LOCKS_EXCLUDED(controller_lock_);
 
-  // Return the stored forwarding pipeline for the given node.
-  ::util::StatusOr<::p4::v1::ForwardingPipelineConfig>
+  // Returns a shared immutable snapshot of the stored forwarding pipeline for
+  // the given node. The snapshot stays valid even if the config of the node is
+  // replaced while the caller still holds on to it. Does not copy the config.
+  ::util::StatusOr<std::shared_ptr<const ::p4::v1::ForwardingPipelineConfig>>
   DoGetForwardingPipelineConfig(uint64 node_id) const
-      LOCKS_EXCLUDED(config_lock_);
+      LOCKS_EXCLUDED(config_snapshot_lock_);
+
+  // Replaces the per-node config snapshots with the content of
+  // forwarding_pipeline_configs_. Called every time the latter is replaced as
+  // a whole, e.g. in Setup() and Teardown().
+  void RebuildForwardingPipelineConfigSnapshots()
+      EXCLUSIVE_LOCKS_REQUIRED(config_lock_)
+          LOCKS_EXCLUDED(config_snapshot_lock_);
 
   // Expands a generic wildcard request into individual entity wildcard reads.
   ::p4::v1::ReadRequest ExpandWildcardsInReadRequest(
@@ -203,9 +212,14 @@ class P4Service final : public ::p4::v1::P4Runtime::Service {
   mutable absl::Mutex controller_lock_;
 
   // Mutex lock for protecting the internal forwarding pipeline configs pushed
-  // to the switch.
+  // to the switch. Held for the entire duration of a config push.
   mutable absl::Mutex config_lock_;
 
+  // Mutex lock for protecting the per-node config snapshots. Only held for the
+  // time it takes to copy or swap a shared_ptr, so Write and Read RPCs are
+  // never blocked by an ongoing config push.
+  mutable absl::Mutex config_snapshot_lock_;
+
   // Mutex which protects the creation and destruction of the stream response RX
   // Channels and threads.
   mutable absl::Mutex stream_response_thread_lock_;
@@ -240,6 +254,15 @@ class P4Service final : public ::p4::v1::P4Runtime::Service {
   std::unique_ptr<ForwardingPipelineConfigs> forwarding_pipeline_configs_
       GUARDED_BY(config_lock_);
 
+  // Map from node ID to an immutable snapshot of the forwarding pipeline config
+  // which is currently in effect on that node. Mirrors the content of
+  // forwarding_pipeline_configs_. A snapshot is never modified after creation,
+  // only swapped for a new one, which lets the Write and Read hot paths access
+  // the config (e.g. the P4Info) without copying it.
+  absl::flat_hash_map<uint64,
+                      std::shared_ptr<const ::p4::v1::ForwardingPipelineConfig>>
+      node_id_to_config_snapshot_ GUARDED_BY(config_snapshot_lock_);
+
   // Determines the mode of operation:
   // - OPERATION_MODE_STANDALONE: when Stratum stack runs independently and
   // therefore needs to do all the SDK initialization itself.
@@ -21,6 +21,7 @@
 #include "stratum/glue/status/status_test_util.h"
 #include "stratum/hal/lib/common/error_buffer.h"
 #include "stratum/hal/lib/common/switch_mock.h"
+#include "stratum/hal/lib/common/write_audit_log.h"
 #include "stratum/lib/macros.h"
 #include "stratum/lib/p4runtime/stream_message_reader_writer_mock.h"
 #include "stratum/lib/security/auth_policy_checker_mock.h"
@@ -31,6 +32,7 @@
 DECLARE_int32(max_num_controllers_per_node);
 DECLARE_int32(max_num_controller_connections);
 DECLARE_string(forwarding_pipeline_configs_file);
+DECLARE_bool(binary_forwarding_pipeline_configs_file);
 DECLARE_string(write_req_log_file);
 DECLARE_string(read_req_log_file);
 DECLARE_string(test_tmpdir);
@@ -78,6 +80,7 @@ class P4ServiceTest
     FLAGS_max_num_controller_connections = 20;
     FLAGS_forwarding_pipeline_configs_file =
         FLAGS_test_tmpdir + "/forwarding_pipeline_configs_file.pb.txt";
+    FLAGS_binary_forwarding_pipeline_configs_file = true;
     FLAGS_write_req_log_file = FLAGS_test_tmpdir + "/write_req_log_fil.csv";
     FLAGS_read_req_log_file = FLAGS_test_tmpdir + "/read_req_log_fil.csv";
     // Before starting the tests, remove the read and write req file if exists.
@@ -117,12 +120,18 @@ class P4ServiceTest
     absl::ReaderMutexLock l(&p4_service_->config_lock_);
     if (configs == nullptr) {
       ASSERT_TRUE(p4_service_->forwarding_pipeline_configs_ == nullptr);
+      EXPECT_FALSE(p4_service_->DoGetForwardingPipelineConfig(node_id).ok());
     } else {
       ASSERT_TRUE(p4_service_->forwarding_pipeline_configs_ != nullptr);
       EXPECT_TRUE(ProtoEqual(
           configs->node_id_to_config().at(node_id),
           p4_service_->forwarding_pipeline_configs_->node_id_to_config().at(
               node_id)));
+      // The snapshot used on the Write/Read path must mirror the config.
+      auto ret = p4_service_->DoGetForwardingPipelineConfig(node_id);
+      ASSERT_OK(ret);
+      EXPECT_TRUE(ProtoEqual(configs->node_id_to_config().at(node_id),
+                             *ret.ValueOrDie()));
     }
   }
 
@@ -135,6 +144,7 @@ class P4ServiceTest
         kForwardingPipelineConfigsTemplate, kNodeId1, kNodeId2);
     ASSERT_OK(ParseProtoFromString(
         configs_text, p4_service_->forwarding_pipeline_configs_.get()));
+    p4_service_->RebuildForwardingPipelineConfigSnapshots();
   }
 
   void AddFakeMasterController(
@@ -337,6 +347,42 @@ TEST_P(P4ServiceTest, ColdbootSetupSuccessForSavedConfigs) {
   CheckForwardingPipelineConfigs(&configs, kNodeId2);
 }
 
+TEST_P(P4ServiceTest, ColdbootSetupConvertsSavedTextConfigsToBinary) {
+  if (mode_ == OPERATION_MODE_COUPLED) return;
+
+  // Setup the test config and also save it to the file in text format.
+  ForwardingPipelineConfigs configs;
+  FillTestForwardingPipelineConfigsAndSave(&configs);
+  ASSERT_FALSE(IsChecksummedBinFile(FLAGS_forwarding_pipeline_configs_file));
+
+  EXPECT_CALL(*switch_mock_, PushForwardingPipelineConfig(_, _))
+      .Times(2)
+      .WillRepeatedly(Return(::util::OkStatus()));
+
+  // Call and validate results. The file is rewritten in binary format.
+  ASSERT_OK(p4_service_->Setup(false));
+  EXPECT_TRUE(error_buffer_->GetErrors().empty());
+  CheckForwardingPipelineConfigs(&configs, kNodeId1);
+  ASSERT_TRUE(IsChecksummedBinFile(FLAGS_forwarding_pipeline_configs_file));
+  ForwardingPipelineConfigs saved_configs;
+  ASSERT_OK(ReadProtoFromChecksummedBinFile(
+      FLAGS_forwarding_pipeline_configs_file, &saved_configs));
+  EXPECT_TRUE(ProtoEqual(configs, saved_configs));
+}
+
+TEST_P(P4ServiceTest, WarmbootSetupSuccessForSavedBinaryConfigs) {
+  ForwardingPipelineConfigs configs;
+  FillTestForwardingPipelineConfigsAndSave(&configs);
+  ASSERT_OK(WriteProtoToChecksummedBinFile(
+      configs, FLAGS_forwarding_pipeline_configs_file));
+
+  // Call and validate results.
+  ASSERT_OK(p4_service_->Setup(true));
+  EXPECT_TRUE(error_buffer_->GetErrors().empty());
+  CheckForwardingPipelineConfigs(&configs, kNodeId1);
+  CheckForwardingPipelineConfigs(&configs, kNodeId2);
+}
+
 TEST_P(P4ServiceTest, ColdbootSetupSuccessForNoSavedConfig) {
   if (mode_ == OPERATION_MODE_COUPLED) return;
 
@@ -506,6 +552,50 @@ TEST_P(P4ServiceTest, SetupAndPushForwardingPipelineConfigSuccess) {
   CheckForwardingPipelineConfigs(nullptr, 0 /*ignored*/);
 }
 
+// A config snapshot taken by an in-flight RPC must not be affected by a
+// concurrent config push.
+TEST_P(P4ServiceTest, ForwardingPipelineConfigSnapshotSurvivesConfigPush) {
+  SetTestForwardingPipelineConfigs();
+  auto ret = p4_service_->DoGetForwardingPipelineConfig(kNodeId1);
+  ASSERT_OK(ret);
+  const auto old_snapshot = ret.ConsumeValueOrDie();
+  const ::p4::v1::ForwardingPipelineConfig old_config = *old_snapshot;
+
+  EXPECT_CALL(*auth_policy_checker_mock_,
+              Authorize("P4Service", "SetForwardingPipelineConfig", _))
+      .WillOnce(Return(::util::OkStatus()));
+  EXPECT_CALL(*switch_mock_, PushForwardingPipelineConfig(kNodeId1, _))
+      .WillOnce(Return(::util::OkStatus()));
+
+  ::grpc::ServerContext context;
+  StreamMessageReaderWriterMock stream;
+  p4runtime::SdnConnection controller(&context, &stream);
+  controller.SetElectionId(kElectionId1);
+  AddFakeMasterController(kNodeId1, &controller);
+
+  ::p4::v1::SetForwardingPipelineConfigRequest request;
+  ::p4::v1::SetForwardingPipelineConfigResponse response;
+  request.set_device_id(kNodeId1);
+  request.mutable_election_id()->set_high(absl::Uint128High64(kElectionId1));
+  request.mutable_election_id()->set_low(absl::Uint128Low64(kElectionId1));
+  request.set_role(role_name_);
+  request.set_action(
+      ::p4::v1::SetForwardingPipelineConfigRequest::VERIFY_AND_COMMIT);
+  *request.mutable_config() = old_config;
+  request.mutable_config()->set_p4_device_config("fake");
+
+  ::grpc::Status status =
+      p4_service_->SetForwardingPipelineConfig(&context, &request, &response);
+  EXPECT_TRUE(status.ok()) << "Error: " << status.error_message();
+
+  // The old snapshot is untouched, new lookups see the new config.
+  EXPECT_TRUE(ProtoEqual(old_config, *old_snapshot));
+  ret = p4_service_->DoGetForwardingPipelineConfig(kNodeId1);
+  ASSERT_OK(ret);
+  EXPECT_NE(old_snapshot, ret.ValueOrDie());
+  EXPECT_TRUE(ProtoEqual(request.config(), *ret.ValueOrDie()));
+}
+
 TEST_P(P4ServiceTest, VerifyForwardingPipelineConfigSuccess) {
   ForwardingPipelineConfigs configs;
   FillTestForwardingPipelineConfigsAndSave(&configs);
@@ -769,6 +859,7 @@ TEST_P(P4ServiceTest, WriteSuccess) {
   EXPECT_TRUE(status.ok());
   EXPECT_TRUE(status.error_message().empty());
   EXPECT_TRUE(status.error_details().empty());
+  WriteAuditLog::GetSingleton()->Flush();
   std::string s;
   ASSERT_OK(ReadFileToString(FLAGS_write_req_log_file, &s));
   EXPECT_THAT(s, HasSubstr(req.updates(0).ShortDebugString()));
@@ -892,6 +983,7 @@ TEST_P(P4ServiceTest, WriteFailureWhenWriteForwardingEntriesFails) {
   EXPECT_EQ(kOperErrorMsg, detail.message());
   const auto& errors = error_buffer_->GetErrors();
   EXPECT_TRUE(errors.empty());
+  WriteAuditLog::GetSingleton()->Flush();
   std::string s;
   ASSERT_OK(ReadFileToString(FLAGS_write_req_log_file, &s));
   EXPECT_THAT(s, HasSubstr(req.updates(0).ShortDebugString()));
@@ -0,0 +1,129 @@
+// Copyright 2018-present Open Networking Foundation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "stratum/hal/lib/common/port_counters_cache.h"
+
+#include "absl/time/clock.h"
+#include "stratum/glue/gtl/map_util.h"
+#include "stratum/glue/logging.h"
+#include "stratum/glue/status/status_macros.h"
+#include "stratum/hal/lib/common/writer_interface.h"
+#include "stratum/lib/macros.h"
+#include "stratum/public/lib/error.h"
+
+namespace stratum {
+namespace hal {
+
+namespace {
+
+// Collects all responses of a RetrieveValue() call.
+class DataResponseCollector : public WriterInterface<DataResponse> {
+ public:
+  bool Write(const DataResponse& resp) override {
+    responses_.push_back(resp);
+    return true;
+  }
+
+  std::vector<DataResponse>& responses() { return responses_; }
+
+ private:
+  std::vector<DataResponse> responses_;
+};
+
+}  // namespace
+
+PortCountersCache::PortCountersCache(SwitchInterface* switch_interface,
+                                     absl::Duration max_staleness)
+    : switch_interface_(ABSL_DIE_IF_NULL(switch_interface)),
+      max_staleness_(max_staleness),
+      num_retrievals_(0) {}
+
+void PortCountersCache::AddPort(uint64 node_id, uint32 port_id) {
+  absl::MutexLock l(&lock_);
+  snapshots_[node_id].port_ids.insert(port_id);
+}
+
+void PortCountersCache::RemovePort(uint64 node_id, uint32 port_id) {
+  absl::MutexLock l(&lock_);
+  NodeSnapshot* snapshot = gtl::FindOrNull(snapshots_, node_id);
+  if (snapshot == nullptr) return;
+  snapshot->port_ids.erase(port_id);
+  snapshot->counters.erase(port_id);
+}
+
+void PortCountersCache::Clear() {
+  absl::MutexLock l(&lock_);
+  snapshots_.clear();
+}
+
+::util::StatusOr<PortCounters> PortCountersCache::GetPortCounters(
+    uint64 node_id, uint32 port_id) {
+  absl::MutexLock l(&lock_);
+  NodeSnapshot& snapshot = snapshots_[node_id];
+  if (max_staleness_ <= absl::ZeroDuration()) {
+    RETURN_IF_ERROR(Retrieve(node_id, {port_id}, &snapshot));
+  } else if (snapshot.port_ids.insert(port_id).second ||
+             absl::Now() - snapshot.timestamp > max_staleness_) {
+    // A port new to the snapshot is only retrieved together with all others,
+    // to keep a single timestamp for the whole snapshot.
+    std::vector<uint32> port_ids(snapshot.port_ids.begin(),
+                                 snapshot.port_ids.end());
+    snapshot.counters.clear();
+    RETURN_IF_ERROR(Retrieve(node_id, port_ids, &snapshot));
+  }
+  const PortCounters* counters = gtl::FindOrNull(snapshot.counters, port_id);
+  if (counters == nullptr) {
+    return MAKE_ERROR(ERR_ENTRY_NOT_FOUND).without_logging()
+           << "No counters retrieved for port " << port_id << " on node "
+           << node_id << ".";
+  }
+
+  return *counters;
+}
+
+uint64 PortCountersCache::GetNumRetrievals() const {
+  absl::MutexLock l(&lock_);
+  return num_retrievals_;
+}
+
+::util::Status PortCountersCache::Retrieve(uint64 node_id,
+                                           const std::vector<uint32>& port_ids,
+                                           NodeSnapshot* snapshot) {
+  DataRequest req;
+  for (const auto port_id : port_ids) {
+    auto* request = req.add_requests()->mutable_port_counters();
+    request->set_node_id(node_id);
+    request->set_port_id(port_id);
+  }
+  const absl::Time timestamp = absl::Now();
+  DataResponseCollector writer;
+  std::vector<::util::Status> details;
+  ++num_retrievals_;
+  RETURN_IF_ERROR(
+      switch_interface_->RetrieveValue(node_id, req, &writer, &details));
+
+  // Only successful requests produce a response, in the order of the requests.
+  // Implementations not reporting the details must answer all requests.
+  auto& responses = writer.responses();
+  const bool has_details = details.size() == port_ids.size();
+  if (!has_details && responses.size() != port_ids.size()) {
+    return MAKE_ERROR(ERR_INTERNAL)
+           << "Retrieved " << responses.size() << " responses for "
+           << port_ids.size() << " port counters requests on node " << node_id
+           << ".";
+  }
+  size_t next_response = 0;
+  for (size_t i = 0; i < port_ids.size(); ++i) {
+    if (has_details && !details[i].ok()) continue;
+    if (next_response >= responses.size()) break;
+    auto& resp = responses[next_response++];
+    if (!resp.has_port_counters()) continue;
+    snapshot->counters[port_ids[i]].Swap(resp.mutable_port_counters());
+  }
+  snapshot->timestamp = timestamp;
+
+  return ::util::OkStatus();
+}
+
+}  // namespace hal
+}  // namespace stratum
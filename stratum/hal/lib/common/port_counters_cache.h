@@ -0,0 +1,88 @@
+// Copyright 2018-present Open Networking Foundation
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef STRATUM_HAL_LIB_COMMON_PORT_COUNTERS_CACHE_H_
+#define STRATUM_HAL_LIB_COMMON_PORT_COUNTERS_CACHE_H_
+
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "stratum/glue/integral_types.h"
+#include "stratum/glue/status/statusor.h"
+#include "stratum/hal/lib/common/common.pb.h"
+#include "stratum/hal/lib/common/switch_interface.h"
+
+namespace stratum {
+namespace hal {
+
+// A snapshot of the counters of all ports of a node, shared by all gNMI
+// counter leaves. The first read of a port after the snapshot of its node
+// expired refreshes the counters of all known ports of that node with a single
+// SwitchInterface::RetrieveValue() call. All other counter leaves of the same
+// sampling tick are then served from the snapshot.
+class PortCountersCache {
+ public:
+  // Snapshots are refreshed once older than max_staleness. A zero
+  // max_staleness disables the snapshots, every read then retrieves the
+  // counters of just the requested port.
+  PortCountersCache(SwitchInterface* switch_interface,
+                    absl::Duration max_staleness);
+  virtual ~PortCountersCache() {}
+
+  // Adds a port to the set of ports refreshed with every snapshot of its node.
+  // Ports read through GetPortCounters() are added implicitly.
+  void AddPort(uint64 node_id, uint32 port_id) LOCKS_EXCLUDED(lock_);
+
+  // Removes a port and its counters from the snapshot of its node.
+  void RemovePort(uint64 node_id, uint32 port_id) LOCKS_EXCLUDED(lock_);
+
+  // Forgets all ports and snapshots, e.g. after a new config has been pushed.
+  void Clear() LOCKS_EXCLUDED(lock_);
+
+  // Returns the counters of the given port, at most max_staleness old.
+  ::util::StatusOr<PortCounters> GetPortCounters(uint64 node_id, uint32 port_id)
+      LOCKS_EXCLUDED(lock_);
+
+  // Returns the number of RetrieveValue() calls issued so far.
+  uint64 GetNumRetrievals() const LOCKS_EXCLUDED(lock_);
+
+  // PortCountersCache is neither copyable nor movable.
+  PortCountersCache(const PortCountersCache&) = delete;
+  PortCountersCache& operator=(const PortCountersCache&) = delete;
+
+ private:
+  // The ports and last retrieved counters of a node.
+  struct NodeSnapshot {
+    absl::flat_hash_set<uint32> port_ids;
+    absl::flat_hash_map<uint32, PortCounters> counters;
+    // Time the counters were retrieved.
+    absl::Time timestamp = absl::InfinitePast();
+  };
+
+  // Retrieves the counters of the given ports with a single RetrieveValue()
+  // call and stores them in the snapshot.
+  ::util::Status Retrieve(uint64 node_id, const std::vector<uint32>& port_ids,
+                          NodeSnapshot* snapshot)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  SwitchInterface* const switch_interface_;
+  const absl::Duration max_staleness_;
+
+  // Held while the counters are retrieved, so that concurrent readers of an
+  // expired snapshot wait for a single refresh instead of issuing their own.
+  mutable absl::Mutex lock_;
+
+  // Map from node ID to the snapshot of its ports.
+  absl::flat_hash_map<uint64, NodeSnapshot> snapshots_ GUARDED_BY(lock_);
+
+  uint64 num_retrievals_ GUARDED_BY(lock_);
+};
+
+}  // namespace hal
+}  // namespace stratum
+
+#endif  // STRATUM_HAL_LIB_COMMON_PORT_COUNTERS_CACHE_H_
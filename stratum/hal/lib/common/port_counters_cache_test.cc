@@ -0,0 +1,179 @@
+// Copyright 2018-present Open Networking Foundation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "stratum/hal/lib/common/port_counters_cache.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "stratum/glue/status/status_test_util.h"
+#include "stratum/hal/lib/common/switch_mock.h"
+#include "stratum/lib/test_utils/matchers.h"
+#include "stratum/public/lib/error.h"
+
+namespace stratum {
+namespace hal {
+
+using test_utils::StatusIs;
+using ::testing::_;
+using ::testing::HasSubstr;
+using ::testing::Invoke;
+using ::testing::Return;
+
+namespace {
+
+constexpr uint64 kNodeId = 1;
+
+// Answers every port counters request with in_octets set to 10 times the port
+// ID. Requests for ports in failed_ports are reported as failed in details.
+class RetrievePortCounters {
+ public:
+  explicit RetrievePortCounters(std::vector<uint32> failed_ports = {})
+      : failed_ports_(std::move(failed_ports)) {}
+
+  ::util::Status operator()(uint64 node_id, const DataRequest& request,
+                            WriterInterface<DataResponse>* writer,
+                            std::vector<::util::Status>* details) const {
+    for (const auto& req : request.requests()) {
+      const uint32 port_id = req.port_counters().port_id();
+      if (std::count(failed_ports_.begin(), failed_ports_.end(), port_id)) {
+        if (details) {
+          details->push_back(MAKE_ERROR(ERR_INVALID_PARAM) << "Bad port.");
+        }
+        continue;
+      }
+      DataResponse resp;
+      resp.mutable_port_counters()->set_in_octets(port_id * 10);
+      writer->Write(resp);
+      if (details) details->push_back(::util::OkStatus());
+    }
+    return ::util::OkStatus();
+  }
+
+ private:
+  const std::vector<uint32> failed_ports_;
+};
+
+MATCHER_P(HasNumRequests, num_requests, "") {
+  return arg.requests_size() == num_requests;
+}
+
+}  // namespace
+
+TEST(PortCountersCacheTest, AllPortsAreRetrievedOnce) {
+  SwitchMock switch_mock;
+  PortCountersCache cache(&switch_mock, absl::Minutes(1));
+  cache.AddPort(kNodeId, 1);
+  cache.AddPort(kNodeId, 2);
+  cache.AddPort(kNodeId, 3);
+  EXPECT_CALL(switch_mock, RetrieveValue(kNodeId, HasNumRequests(3), _, _))
+      .WillOnce(Invoke(RetrievePortCounters()));
+
+  for (int i = 0; i < 3; ++i) {
+    for (uint32 port_id = 1; port_id <= 3; ++port_id) {
+      auto counters = cache.GetPortCounters(kNodeId, port_id);
+      ASSERT_OK(counters);
+      EXPECT_EQ(port_id * 10, counters.ValueOrDie().in_octets());
+    }
+  }
+  EXPECT_EQ(1, cache.GetNumRetrievals());
+}
+
+TEST(PortCountersCacheTest, ExpiredSnapshotIsRefreshed) {
+  SwitchMock switch_mock;
+  PortCountersCache cache(&switch_mock, absl::Milliseconds(1));
+  EXPECT_CALL(switch_mock, RetrieveValue(kNodeId, HasNumRequests(1), _, _))
+      .Times(2)
+      .WillRepeatedly(Invoke(RetrievePortCounters()));
+
+  ASSERT_OK(cache.GetPortCounters(kNodeId, 1));
+  absl::SleepFor(absl::Milliseconds(5));
+  ASSERT_OK(cache.GetPortCounters(kNodeId, 1));
+  EXPECT_EQ(2, cache.GetNumRetrievals());
+}
+
+TEST(PortCountersCacheTest, ZeroStalenessRetrievesRequestedPortOnly) {
+  SwitchMock switch_mock;
+  PortCountersCache cache(&switch_mock, absl::ZeroDuration());
+  cache.AddPort(kNodeId, 1);
+  cache.AddPort(kNodeId, 2);
+  EXPECT_CALL(switch_mock, RetrieveValue(kNodeId, HasNumRequests(1), _, _))
+      .Times(2)
+      .WillRepeatedly(Invoke(RetrievePortCounters()));
+
+  auto counters = cache.GetPortCounters(kNodeId, 2);
+  ASSERT_OK(counters);
+  EXPECT_EQ(20, counters.ValueOrDie().in_octets());
+  ASSERT_OK(cache.GetPortCounters(kNodeId, 2));
+}
+
+TEST(PortCountersCacheTest, FailedPortDoesNotAffectOtherPorts) {
+  SwitchMock switch_mock;
+  PortCountersCache cache(&switch_mock, absl::Minutes(1));
+  cache.AddPort(kNodeId, 1);
+  cache.AddPort(kNodeId, 2);
+  EXPECT_CALL(switch_mock, RetrieveValue(kNodeId, HasNumRequests(2), _, _))
+      .WillOnce(Invoke(RetrievePortCounters({1})));
+
+  EXPECT_THAT(cache.GetPortCounters(kNodeId, 1),
+              StatusIs(StratumErrorSpace(), ERR_ENTRY_NOT_FOUND,
+                       HasSubstr("port 1")));
+  auto counters = cache.GetPortCounters(kNodeId, 2);
+  ASSERT_OK(counters);
+  EXPECT_EQ(20, counters.ValueOrDie().in_octets());
+  EXPECT_EQ(1, cache.GetNumRetrievals());
+}
+
+TEST(PortCountersCacheTest, RetrieveValueErrorIsReturned) {
+  SwitchMock switch_mock;
+  PortCountersCache cache(&switch_mock, absl::Minutes(1));
+  EXPECT_CALL(switch_mock, RetrieveValue(kNodeId, _, _, _))
+      .WillOnce(Return(MAKE_ERROR(ERR_INTERNAL) << "Some error."))
+      .WillOnce(Invoke(RetrievePortCounters()));
+
+  EXPECT_THAT(cache.GetPortCounters(kNodeId, 1),
+              StatusIs(StratumErrorSpace(), ERR_INTERNAL,
+                       HasSubstr("Some error")));
+  // The failed retrieval is retried on the next read.
+  ASSERT_OK(cache.GetPortCounters(kNodeId, 1));
+}
+
+TEST(PortCountersCacheTest, ClearForgetsPorts) {
+  SwitchMock switch_mock;
+  PortCountersCache cache(&switch_mock, absl::Minutes(1));
+  cache.AddPort(kNodeId, 1);
+  cache.AddPort(kNodeId, 2);
+  EXPECT_CALL(switch_mock, RetrieveValue(kNodeId, HasNumRequests(2), _, _))
+      .WillOnce(Invoke(RetrievePortCounters()));
+  EXPECT_CALL(switch_mock, RetrieveValue(kNodeId, HasNumRequests(1), _, _))
+      .WillOnce(Invoke(RetrievePortCounters()));
+
+  ASSERT_OK(cache.GetPortCounters(kNodeId, 2));
+  cache.Clear();
+  ASSERT_OK(cache.GetPortCounters(kNodeId, 2));
+  EXPECT_EQ(2, cache.GetNumRetrievals());
+}
+
+TEST(PortCountersCacheTest, RemovedPortIsNotRetrieved) {
+  SwitchMock switch_mock;
+  PortCountersCache cache(&switch_mock, absl::Minutes(1));
+  cache.AddPort(kNodeId, 1);
+  cache.AddPort(kNodeId, 2);
+  cache.AddPort(kNodeId, 3);
+  cache.RemovePort(kNodeId, 2);
+  cache.RemovePort(kNodeId + 1, 1);
+  EXPECT_CALL(switch_mock, RetrieveValue(kNodeId, HasNumRequests(2), _, _))
+      .WillOnce(Invoke(RetrievePortCounters()));
+
+  ASSERT_OK(cache.GetPortCounters(kNodeId, 3));
+  ASSERT_OK(cache.GetPortCounters(kNodeId, 1));
+  EXPECT_EQ(1, cache.GetNumRetrievals());
+}
+
+}  // namespace hal
+}  // namespace stratum
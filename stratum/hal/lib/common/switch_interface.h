@@ -12,6 +12,7 @@
 #include "p4/v1/p4runtime.grpc.pb.h"
 #include "stratum/glue/status/status.h"
 #include "stratum/glue/status/statusor.h"
+#include "stratum/hal/lib/common/chassis_config_delta.h"
 #include "stratum/hal/lib/common/common.pb.h"
 #include "stratum/hal/lib/common/gnmi_events.h"
 #include "stratum/hal/lib/common/writer_interface.h"
@@ -52,6 +53,17 @@ class SwitchInterface {
   // expected to handle partially populated ChassisConfig protos seamlessly.
   virtual ::util::Status PushChassisConfig(const ChassisConfig& config) = 0;
 
+  // Configures the switch based on the given ChassisConfig proto, which
+  // differs from the last pushed config as described by delta. Implementations
+  // can use the delta to only touch the changed parts of the switch, e.g. to
+  // reconfigure a single port when a gNMI Set changes one of its leaves. The
+  // result must be the same as the one of PushChassisConfig(config), which is
+  // what the default implementation calls.
+  virtual ::util::Status PushChassisConfigDelta(
+      const ChassisConfig& config, const ChassisConfigDelta& delta) {
+    return PushChassisConfig(config);
+  }
+
   // Verifies the given ChassisConfig proto without pushing anything to the
   // hardware. Note that PushChassisConfig() calls VerifyChassisConfig() at
   // the beginning before performing the push. Also, VerifyChassisConfig() must
@@ -0,0 +1,285 @@
+// Copyright 2018-present Open Networking Foundation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "stratum/hal/lib/common/write_audit_log.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/time/clock.h"
+#include "gflags/gflags.h"
+#include "stratum/glue/logging.h"
+#include "stratum/glue/status/status_macros.h"
+#include "stratum/lib/macros.h"
+#include "stratum/lib/utils.h"
+#include "stratum/public/lib/error.h"
+
+DEFINE_int32(write_audit_log_capacity, 4096,
+             "Number of write records buffered for the background write audit "
+             "logger. Records are dropped when the buffer is full.");
+DEFINE_int32(write_audit_summary_interval_ms, 10000,
+             "Minimum interval in milliseconds between two summary log "
+             "messages of the P4-based forwarding writes of a node.");
+
+namespace stratum {
+namespace hal {
+
+namespace {
+
+// Time the consumer sleeps when the ring is empty.
+constexpr absl::Duration kPollInterval = absl::Milliseconds(10);
+
+uint64 RoundUpToPowerOfTwo(uint64 n) {
+  uint64 p = 1;
+  while (p < n) p <<= 1;
+  return p;
+}
+
+}  // namespace
+
+WriteAuditLog::WriteAuditLog(size_t capacity, absl::Duration summary_interval)
+    : mask_(RoundUpToPowerOfTwo(std::max<uint64>(capacity, 2)) - 1),
+      summary_interval_(summary_interval),
+      slots_(new Slot[mask_ + 1]),
+      enqueue_pos_(0),
+      num_dropped_(0),
+      dequeue_pos_(0),
+      summaries_(),
+      last_summary_time_(absl::Now()),
+      last_num_dropped_(0),
+      consumer_tid_(),
+      running_(false),
+      stop_(false),
+      flush_requested_(false),
+      processed_pos_(0) {
+  for (uint64 i = 0; i <= mask_; ++i) {
+    slots_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+WriteAuditLog::~WriteAuditLog() {
+  ::util::Status status = Shutdown();
+  LOG_IF(ERROR, !status.ok()) << status.error_message();
+}
+
+WriteAuditLog* WriteAuditLog::GetSingleton() {
+  // Never destroyed, so the writers do not need to care about the destruction
+  // order of statics at exit.
+  static WriteAuditLog* const singleton = []() {
+    auto* log = new WriteAuditLog(
+        std::max(FLAGS_write_audit_log_capacity, 1),
+        absl::Milliseconds(FLAGS_write_audit_summary_interval_ms));
+    ::util::Status status = log->Start();
+    LOG_IF(ERROR, !status.ok())
+        << "Failed to start the write audit log: " << status.error_message();
+    return log;
+  }();
+  return singleton;
+}
+
+::util::Status WriteAuditLog::Start() {
+  absl::MutexLock l(&lock_);
+  if (running_) return ::util::OkStatus();
+  stop_ = false;
+  int ret = pthread_create(&consumer_tid_, nullptr, ConsumerThreadFunc, this);
+  if (ret != 0) {
+    return MAKE_ERROR(ERR_INTERNAL)
+           << "Failed to create the write audit log thread. Err: " << ret
+           << ".";
+  }
+  running_ = true;
+
+  return ::util::OkStatus();
+}
+
+::util::Status WriteAuditLog::Shutdown() {
+  pthread_t tid;
+  {
+    absl::MutexLock l(&lock_);
+    if (!running_) return ::util::OkStatus();
+    stop_ = true;
+    flush_requested_ = true;
+    tid = consumer_tid_;
+  }
+  int ret = pthread_join(tid, nullptr);
+  absl::MutexLock l(&lock_);
+  running_ = false;
+  processed_cond_.SignalAll();
+  if (ret != 0) {
+    return MAKE_ERROR(ERR_INTERNAL)
+           << "Failed to join the write audit log thread. Err: " << ret << ".";
+  }
+
+  return ::util::OkStatus();
+}
+
+bool WriteAuditLog::AppendWriteRequest(
+    const std::string& log_file, uint64 node_id,
+    const ::p4::v1::WriteRequest& req,
+    const std::vector<::util::Status>& results, absl::Time timestamp) {
+  Record record;
+  record.node_id = node_id;
+  record.log_file = log_file;
+  record.request = absl::make_unique<::p4::v1::WriteRequest>(req);
+  record.results = results;
+  record.timestamp = timestamp;
+  return TryPush(&record);
+}
+
+bool WriteAuditLog::AppendWriteSummary(uint64 node_id, int num_updates,
+                                       int num_failed) {
+  Record record;
+  record.node_id = node_id;
+  record.num_updates = num_updates;
+  record.num_failed = num_failed;
+  return TryPush(&record);
+}
+
+void WriteAuditLog::Flush() {
+  const uint64 target = enqueue_pos_.load(std::memory_order_acquire);
+  absl::MutexLock l(&lock_);
+  if (!running_) {
+    ProcessPendingRecords();
+    return;
+  }
+  while (running_ && processed_pos_ < target) {
+    flush_requested_ = true;
+    processed_cond_.WaitWithTimeout(&lock_, kPollInterval);
+  }
+}
+
+uint64 WriteAuditLog::GetNumDropped() const {
+  return num_dropped_.load(std::memory_order_relaxed);
+}
+
+bool WriteAuditLog::TryPush(Record* record) {
+  uint64 pos = enqueue_pos_.load(std::memory_order_relaxed);
+  while (true) {
+    Slot& slot = slots_[pos & mask_];
+    const uint64 seq = slot.sequence.load(std::memory_order_acquire);
+    const int64 diff = static_cast<int64>(seq) - static_cast<int64>(pos);
+    if (diff == 0) {
+      // The slot is free, try to claim the position.
+      if (enqueue_pos_.compare_exchange_weak(pos, pos + 1,
+                                             std::memory_order_relaxed)) {
+        slot.record = std::move(*record);
+        slot.sequence.store(pos + 1, std::memory_order_release);
+        return true;
+      }
+    } else if (diff < 0) {
+      // The slot still holds the record of the previous lap, the ring is full.
+      num_dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    } else {
+      // Another producer claimed the position first.
+      pos = enqueue_pos_.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+bool WriteAuditLog::TryPop(Record* record) {
+  Slot& slot = slots_[dequeue_pos_ & mask_];
+  const uint64 seq = slot.sequence.load(std::memory_order_acquire);
+  if (seq != dequeue_pos_ + 1) return false;
+  *record = std::move(slot.record);
+  slot.record = Record();
+  slot.sequence.store(dequeue_pos_ + mask_ + 1, std::memory_order_release);
+  ++dequeue_pos_;
+  return true;
+}
+
+uint64 WriteAuditLog::Drain() {
+  // The lines to append to each log file. Each file is written once per drain.
+  absl::flat_hash_map<std::string, std::string> lines;
+  uint64 num_processed = 0;
+  Record record;
+  while (num_processed <= mask_ && TryPop(&record)) {
+    ++num_processed;
+    if (record.request == nullptr) {
+      NodeSummary& summary = summaries_[record.node_id];
+      ++summary.num_requests;
+      summary.num_updates += record.num_updates;
+      summary.num_failed += record.num_failed;
+      continue;
+    }
+    if (record.results.size() !=
+        static_cast<size_t>(record.request->updates_size())) {
+      LOG(ERROR) << "Size mismatch: " << record.results.size()
+                 << " != " << record.request->updates_size()
+                 << ". Did not log anything!";
+      continue;
+    }
+    std::string& msg = lines[record.log_file];
+    const std::string ts = absl::FormatTime(
+        "%Y-%m-%d %H:%M:%E6S", record.timestamp, absl::LocalTimeZone());
+    for (size_t i = 0; i < record.results.size(); ++i) {
+      absl::StrAppend(&msg, ts, ";", record.node_id, ";",
+                      record.request->updates(i).ShortDebugString(), ";",
+                      record.results[i].error_message(), "\n");
+    }
+  }
+  for (const auto& e : lines) {
+    ::util::Status status =
+        WriteStringToFile(e.second, e.first, /*append=*/true);
+    LOG_IF_EVERY_N(ERROR, !status.ok(), 50)
+        << "Failed to log the write request: " << status.error_message();
+  }
+
+  return num_processed;
+}
+
+void WriteAuditLog::MaybeLogSummaries(bool force) {
+  const absl::Time now = absl::Now();
+  if (!force && now - last_summary_time_ < summary_interval_) return;
+  for (const auto& e : summaries_) {
+    LOG(INFO) << e.second.num_requests << " P4-based forwarding write "
+              << "requests with " << e.second.num_updates << " updates ("
+              << e.second.num_failed << " failed) written to node with ID "
+              << e.first << " in the last "
+              << absl::FormatDuration(now - last_summary_time_) << ".";
+  }
+  summaries_.clear();
+  const uint64 num_dropped = num_dropped_.load(std::memory_order_relaxed);
+  if (num_dropped != last_num_dropped_) {
+    LOG(WARNING) << "Dropped " << num_dropped - last_num_dropped_
+                 << " write audit records as the buffer was full.";
+    last_num_dropped_ = num_dropped;
+  }
+  last_summary_time_ = now;
+}
+
+void WriteAuditLog::ProcessPendingRecords() {
+  while (Drain() > mask_) MaybeLogSummaries(false);
+  MaybeLogSummaries(false);
+  processed_pos_ = dequeue_pos_;
+}
+
+void* WriteAuditLog::ConsumerThreadFunc(void* arg) {
+  static_cast<WriteAuditLog*>(arg)->ConsumerLoop();
+  return nullptr;
+}
+
+void WriteAuditLog::ConsumerLoop() {
+  while (true) {
+    bool stop;
+    {
+      absl::MutexLock l(&lock_);
+      stop = stop_;
+    }
+    // Each drain processes at most one lap of the ring, so that the summaries
+    // are logged on time also while the producers keep the ring busy.
+    while (Drain() > mask_) MaybeLogSummaries(false);
+    MaybeLogSummaries(stop);
+    absl::MutexLock l(&lock_);
+    processed_pos_ = dequeue_pos_;
+    processed_cond_.SignalAll();
+    if (stop) break;
+    lock_.AwaitWithTimeout(absl::Condition(&flush_requested_), kPollInterval);
+    flush_requested_ = false;
+  }
+}
+
+}  // namespace hal
+}  // namespace stratum
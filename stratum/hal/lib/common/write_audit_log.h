@@ -0,0 +1,159 @@
+// Copyright 2018-present Open Networking Foundation
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef STRATUM_HAL_LIB_COMMON_WRITE_AUDIT_LOG_H_
+#define STRATUM_HAL_LIB_COMMON_WRITE_AUDIT_LOG_H_
+
+#include <pthread.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "stratum/glue/integral_types.h"
+#include "stratum/glue/status/status.h"
+
+namespace stratum {
+namespace hal {
+
+// WriteAuditLog takes the logging of P4Runtime writes off the write path.
+// Writers only move a record into a bounded lock-free ring buffer, which never
+// blocks: if the ring is full the record is dropped and counted, and the
+// number of dropped records is logged with the next write summaries. A
+// background thread drains the ring, formats the write requests and appends
+// them to their log files, and aggregates the write summaries into a per-node
+// INFO log message emitted at most once per summary interval. A single
+// instance is shared by P4Service and the switch implementations, and is
+// started and shut down by Hal.
+class WriteAuditLog {
+ public:
+  // The ring holds at least capacity records. The background thread logs the
+  // write summaries of each node at most once per summary_interval.
+  WriteAuditLog(size_t capacity, absl::Duration summary_interval);
+  virtual ~WriteAuditLog();
+
+  // Returns the process wide instance, created and started on first use.
+  static WriteAuditLog* GetSingleton();
+
+  // Starts the background thread.
+  ::util::Status Start() LOCKS_EXCLUDED(lock_);
+
+  // Drains all pending records and stops the background thread. Records
+  // appended after Shutdown() stay in the ring until the next Start().
+  ::util::Status Shutdown() LOCKS_EXCLUDED(lock_);
+
+  // Queues a write request and its per-update results for being appended to
+  // log_file, one line per update. Returns false if the record was dropped.
+  bool AppendWriteRequest(const std::string& log_file, uint64 node_id,
+                          const ::p4::v1::WriteRequest& req,
+                          const std::vector<::util::Status>& results,
+                          absl::Time timestamp);
+
+  // Queues the outcome of a write request with num_updates updates, out of
+  // which num_failed failed, for the rate-limited write summary of the node.
+  // Returns false if the record was dropped.
+  bool AppendWriteSummary(uint64 node_id, int num_updates, int num_failed);
+
+  // Blocks until all records appended before the call have been processed. If
+  // the background thread is not running, processes them in the calling
+  // thread.
+  void Flush() LOCKS_EXCLUDED(lock_);
+
+  // Returns the number of records dropped because the ring was full.
+  uint64 GetNumDropped() const;
+
+  // WriteAuditLog is neither copyable nor movable.
+  WriteAuditLog(const WriteAuditLog&) = delete;
+  WriteAuditLog& operator=(const WriteAuditLog&) = delete;
+
+ private:
+  // A queued write request or write summary.
+  struct Record {
+    uint64 node_id = 0;
+    // Non-empty for write requests.
+    std::string log_file;
+    std::unique_ptr<::p4::v1::WriteRequest> request;
+    std::vector<::util::Status> results;
+    absl::Time timestamp;
+    // Only used by write summaries.
+    int num_updates = 0;
+    int num_failed = 0;
+  };
+
+  // A slot of the ring. The sequence number tells producers and the consumer
+  // whose turn it is to access the record: a slot at position pos is free for
+  // the producer of pos if sequence == pos, and holds the record of pos for
+  // the consumer if sequence == pos + 1.
+  struct Slot {
+    std::atomic<uint64> sequence;
+    Record record;
+  };
+
+  // The write summaries of a node since the last summary log message.
+  struct NodeSummary {
+    uint64 num_requests = 0;
+    uint64 num_updates = 0;
+    uint64 num_failed = 0;
+  };
+
+  // Moves the record into the ring, unless it is full. Lock-free.
+  bool TryPush(Record* record);
+
+  // Moves the oldest record out of the ring. Only called by the consumer.
+  bool TryPop(Record* record);
+
+  // Drains the ring and processes the records. Returns the number of records
+  // processed. Only called by the consumer.
+  uint64 Drain();
+
+  // Logs and resets the write summaries if the summary interval has passed, or
+  // unconditionally if force is true. Only called by the consumer.
+  void MaybeLogSummaries(bool force);
+
+  // Acts as the consumer in the calling thread, processing all pending records.
+  // Only called by Flush() while the background thread is not running.
+  void ProcessPendingRecords() EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Thread function of the background thread.
+  static void* ConsumerThreadFunc(void* arg);
+  void ConsumerLoop() LOCKS_EXCLUDED(lock_);
+
+  const uint64 mask_;
+  const absl::Duration summary_interval_;
+  std::unique_ptr<Slot[]> slots_;
+
+  // Position of the next record to be written by producers.
+  std::atomic<uint64> enqueue_pos_;
+  std::atomic<uint64> num_dropped_;
+
+  // The state below is only accessed by the consumer, which is the background
+  // thread while it is running, or else a thread holding lock_.
+  uint64 dequeue_pos_;
+  absl::flat_hash_map<uint64, NodeSummary> summaries_;
+  absl::Time last_summary_time_;
+  uint64 last_num_dropped_;
+
+  // Protects the consumer thread state. Never taken by producers.
+  mutable absl::Mutex lock_;
+  pthread_t consumer_tid_ GUARDED_BY(lock_);
+  bool running_ GUARDED_BY(lock_);
+  bool stop_ GUARDED_BY(lock_);
+  // Set by Flush() and Shutdown() to wake the consumer up before its poll
+  // interval expires.
+  bool flush_requested_ GUARDED_BY(lock_);
+  // Ring position up to which all records have been processed.
+  uint64 processed_pos_ GUARDED_BY(lock_);
+  // Signaled whenever processed_pos_ advances.
+  absl::CondVar processed_cond_;
+};
+
+}  // namespace hal
+}  // namespace stratum
+
+#endif  // STRATUM_HAL_LIB_COMMON_WRITE_AUDIT_LOG_H_
@@ -0,0 +1,151 @@
+// Copyright 2018-present Open Networking Foundation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "stratum/hal/lib/common/write_audit_log.h"
+
+#include <pthread.h>
+
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_split.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "gflags/gflags.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "stratum/glue/status/status_test_util.h"
+#include "stratum/lib/utils.h"
+#include "stratum/public/lib/error.h"
+
+DECLARE_string(test_tmpdir);
+
+namespace stratum {
+namespace hal {
+
+using ::testing::HasSubstr;
+using ::testing::SizeIs;
+
+namespace {
+
+constexpr uint64 kNodeId = 1;
+constexpr int kNumThreads = 4;
+constexpr int kNumRequestsPerThread = 500;
+
+class WriteAuditLogTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    log_file_ = FLAGS_test_tmpdir + "/write_audit_log_test.txt";
+    if (PathExists(log_file_)) {
+      ASSERT_OK(RemoveFile(log_file_));
+    }
+    req_.add_updates()->set_type(::p4::v1::Update::INSERT);
+    req_.mutable_updates(0)
+        ->mutable_entity()
+        ->mutable_table_entry()
+        ->set_table_id(1);
+  }
+
+  std::vector<std::string> ReadLogLines() {
+    std::string s;
+    EXPECT_OK(ReadFileToString(log_file_, &s));
+    return absl::StrSplit(s, '\n', absl::SkipEmpty());
+  }
+
+  std::string log_file_;
+  ::p4::v1::WriteRequest req_;
+};
+
+struct AppendThreadArgs {
+  WriteAuditLog* log;
+  std::string log_file;
+  const ::p4::v1::WriteRequest* req;
+};
+
+void* AppendThreadFunc(void* arg) {
+  auto* args = static_cast<AppendThreadArgs*>(arg);
+  for (int i = 0; i < kNumRequestsPerThread; ++i) {
+    args->log->AppendWriteRequest(args->log_file, kNodeId, *args->req,
+                                  {::util::OkStatus()}, absl::Now());
+    args->log->AppendWriteSummary(kNodeId, 1, 0);
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+TEST_F(WriteAuditLogTest, WriteRequestIsLoggedInTheBackground) {
+  WriteAuditLog log(16, absl::Seconds(10));
+  ASSERT_OK(log.Start());
+  EXPECT_TRUE(log.AppendWriteRequest(
+      log_file_, kNodeId, req_,
+      {::util::Status(StratumErrorSpace(), ERR_TABLE_FULL, "Table full.")},
+      absl::Now()));
+  log.Flush();
+
+  auto lines = ReadLogLines();
+  ASSERT_THAT(lines, SizeIs(1));
+  std::vector<std::string> fields = absl::StrSplit(lines[0], ';');
+  ASSERT_THAT(fields, SizeIs(4));
+  EXPECT_EQ("1", fields[1]);
+  EXPECT_EQ(req_.updates(0).ShortDebugString(), fields[2]);
+  EXPECT_EQ("Table full.", fields[3]);
+  ASSERT_OK(log.Shutdown());
+}
+
+TEST_F(WriteAuditLogTest, RecordsAreDroppedWhenFull) {
+  WriteAuditLog log(2, absl::Seconds(10));
+  // Without the background thread nothing drains the ring, and the writers
+  // do not wait for room.
+  EXPECT_TRUE(log.AppendWriteRequest(log_file_, kNodeId, req_,
+                                     {::util::OkStatus()}, absl::Now()));
+  EXPECT_TRUE(log.AppendWriteRequest(log_file_, kNodeId, req_,
+                                     {::util::OkStatus()}, absl::Now()));
+  EXPECT_FALSE(log.AppendWriteSummary(kNodeId, 1, 0));
+  EXPECT_EQ(1, log.GetNumDropped());
+  EXPECT_FALSE(PathExists(log_file_));
+
+  // Flush() processes the queued records in the calling thread.
+  log.Flush();
+  EXPECT_THAT(ReadLogLines(), SizeIs(2));
+  EXPECT_TRUE(log.AppendWriteSummary(kNodeId, 1, 0));
+  EXPECT_EQ(1, log.GetNumDropped());
+}
+
+TEST_F(WriteAuditLogTest, ConcurrentWritersAreAllLogged) {
+  // The ring can hold all records, so none is dropped.
+  WriteAuditLog log(2 * kNumThreads * kNumRequestsPerThread,
+                    absl::Milliseconds(1));
+  ASSERT_OK(log.Start());
+  AppendThreadArgs args = {&log, log_file_, &req_};
+  std::vector<pthread_t> tids(kNumThreads);
+  for (auto& tid : tids) {
+    ASSERT_EQ(0, pthread_create(&tid, nullptr, AppendThreadFunc, &args));
+  }
+  for (auto& tid : tids) {
+    ASSERT_EQ(0, pthread_join(tid, nullptr));
+  }
+  log.Flush();
+
+  auto lines = ReadLogLines();
+  EXPECT_THAT(lines, SizeIs(kNumThreads * kNumRequestsPerThread));
+  for (const auto& line : lines) {
+    EXPECT_THAT(line, HasSubstr(req_.updates(0).ShortDebugString()));
+  }
+  EXPECT_EQ(0, log.GetNumDropped());
+  ASSERT_OK(log.Shutdown());
+}
+
+TEST_F(WriteAuditLogTest, ShutdownDrainsPendingRecords) {
+  WriteAuditLog log(16, absl::Seconds(10));
+  ASSERT_OK(log.Start());
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_TRUE(log.AppendWriteRequest(log_file_, kNodeId, req_,
+                                       {::util::OkStatus()}, absl::Now()));
+  }
+  ASSERT_OK(log.Shutdown());
+  EXPECT_THAT(ReadLogLines(), SizeIs(8));
+}
+
+}  // namespace hal
+}  // namespace stratum
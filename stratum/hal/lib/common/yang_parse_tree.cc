@@ -4,70 +4,140 @@
 
 #include "stratum/hal/lib/common/yang_parse_tree.h"
 
+#include <algorithm>
 #include <list>
 #include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/memory/memory.h"
+#include "absl/time/time.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/synchronization/mutex.h"
+#include "gflags/gflags.h"
+#include "google/protobuf/util/message_differencer.h"
 #include "grpcpp/grpcpp.h"
 #include "stratum/glue/status/status_macros.h"
 #include "stratum/hal/lib/common/gnmi_publisher.h"
 #include "stratum/hal/lib/common/yang_parse_tree_paths.h"
 
+DEFINE_int32(gnmi_port_counters_max_staleness_ms, 500,
+             "Maximum age in milliseconds of the port counters snapshot the "
+             "gNMI counter leaves are read from. All ports of a node are "
+             "retrieved at once when the snapshot is older. Should be less "
+             "than the shortest sample interval. 0 disables the snapshot.");
+
 namespace stratum {
 namespace hal {
 
-TreeNode::TreeNode(const TreeNode& src) {
+using ::google::protobuf::util::MessageDifferencer;
+
+TreeNode::TreeNode(const TreeNode& src)
+    : use_token_(std::make_shared<const TreeNode*>(this)) {
   name_ = src.name_;
   // Deep-copy children.
   this->CopySubtree(src);
 }
 
 void TreeNode::CopySubtree(const TreeNode& src) {
-  // Copy the handlers.
-  on_timer_handler_ = src.on_timer_handler_;
-  on_poll_handler_ = src.on_poll_handler_;
-  on_change_handler_ = src.on_change_handler_;
-  on_update_handler_ = src.on_update_handler_;
-  on_replace_handler_ = src.on_replace_handler_;
-  on_delete_handler_ = src.on_delete_handler_;
-  // Set the parent.
-  parent_ = src.parent_;
-  // Copy the supported_* flags.
-  supports_on_timer_ = src.supports_on_timer_;
-  supports_on_poll_ = src.supports_on_poll_;
-  supports_on_change_ = src.supports_on_change_;
-  supports_on_update_ = src.supports_on_update_;
-  supports_on_replace_ = src.supports_on_replace_;
-  supports_on_delete_ = src.supports_on_delete_;
-  // Copy flags.
-  is_name_a_key_ = src.is_name_a_key_;
-
+  {
+    absl::ReaderMutexLock s(&src.access_lock_);
+    absl::WriterMutexLock l(&access_lock_);
+    // Copy the handlers.
+    on_timer_handler_ = src.on_timer_handler_;
+    on_poll_handler_ = src.on_poll_handler_;
+    on_change_handler_ = src.on_change_handler_;
+    on_update_handler_ = src.on_update_handler_;
+    on_replace_handler_ = src.on_replace_handler_;
+    on_delete_handler_ = src.on_delete_handler_;
+    // Set the parent.
+    parent_ = src.parent_;
+    // Copy the supported_* flags.
+    supports_on_timer_ = src.supports_on_timer_;
+    supports_on_poll_ = src.supports_on_poll_;
+    supports_on_change_ = src.supports_on_change_;
+    supports_on_update_ = src.supports_on_update_;
+    supports_on_replace_ = src.supports_on_replace_;
+    supports_on_delete_ = src.supports_on_delete_;
+    // Copy flags.
+    is_name_a_key_ = src.is_name_a_key_;
+  }
   // Deep-copy children.
-  for (const auto& entry : src.children_) {
-    children_.emplace(entry.first, TreeNode(*this, entry.first));
-    children_[entry.first].CopySubtree(entry.second);
+  for (const auto& token : src.GetChildren()) {
+    const TreeNode* child = *token;
+    AddChild(child->name_, child->is_name_a_key_)->CopySubtree(*child);
+  }
+}
+
+TreeNode* TreeNode::AddChild(const std::string& name, bool is_name_a_key) {
+  absl::WriterMutexLock l(&access_lock_);
+  auto result = children_.emplace(std::piecewise_construct,
+                                  std::forward_as_tuple(name),
+                                  std::forward_as_tuple(*this, name,
+                                                        is_name_a_key));
+  TreeNode* child = &result.first->second;
+  if (result.second) {
+    auto it = std::lower_bound(
+        sorted_children_.begin(), sorted_children_.end(), name,
+        [](const TreeNode* node, const std::string& name) {
+          return node->name_ < name;
+        });
+    sorted_children_.insert(it, child);
   }
+  return child;
+}
+
+TreeNode::Children::node_type TreeNode::DetachChild(const std::string& name) {
+  absl::WriterMutexLock l(&access_lock_);
+  auto it = children_.find(name);
+  if (it == children_.end()) return Children::node_type();
+  sorted_children_.erase(std::find(sorted_children_.begin(),
+                                   sorted_children_.end(), &it->second));
+  return children_.extract(it);
+}
+
+bool TreeNode::IsSubtreeInUse() const {
+  // The nodes of a detached subtree can only be reached through a copy of the
+  // token of one of them, so a count of one cannot grow behind our back.
+  if (use_token_.use_count() > 1) return true;
+  absl::ReaderMutexLock l(&access_lock_);
+  for (const TreeNode* child : sorted_children_) {
+    if (child->IsSubtreeInUse()) return true;
+  }
+  return false;
+}
+
+std::vector<std::shared_ptr<const TreeNode*>> TreeNode::GetChildren() const {
+  absl::ReaderMutexLock l(&access_lock_);
+  std::vector<std::shared_ptr<const TreeNode*>> children;
+  children.reserve(sorted_children_.size());
+  for (const TreeNode* child : sorted_children_) {
+    children.push_back(child->use_token_);
+  }
+  return children;
 }
 
 ::util::Status TreeNode::VisitThisNodeAndItsChildren(
     const TreeNodeEventHandlerPtr& handler, const GnmiEvent& event,
     const ::gnmi::Path& path, GnmiSubscribeStream* stream) const {
-  RETURN_IF_ERROR((this->*handler)(event, path, stream));
-  for (const auto& child : children_) {
-    RETURN_IF_ERROR(child.second.VisitThisNodeAndItsChildren(
-        handler, event, child.second.GetPath(), stream));
+  RETURN_IF_ERROR(GetHandler(handler)(event, path, stream));
+  for (const auto& token : GetChildren()) {
+    const TreeNode* child = *token;
+    RETURN_IF_ERROR(child->VisitThisNodeAndItsChildren(
+        handler, event, child->GetPath(), stream));
   }
   return ::util::OkStatus();
 }
 
 ::util::Status TreeNode::RegisterThisNodeAndItsChildren(
     const EventHandlerRecordPtr& record) const {
-  RETURN_IF_ERROR(this->on_change_registration_(record));
-  for (const auto& child : children_) {
-    RETURN_IF_ERROR(child.second.RegisterThisNodeAndItsChildren(record));
+  RETURN_IF_ERROR(GetHandler(&TreeNode::on_change_registration_)(record));
+  for (const auto& token : GetChildren()) {
+    RETURN_IF_ERROR((*token)->RegisterThisNodeAndItsChildren(record));
   }
   return ::util::OkStatus();
 }
@@ -105,12 +175,11 @@ const TreeNode* TreeNode::FindNodeOrNull(const ::gnmi::Path& path) const {
   // move to the next one. If not found, return an error (nullptr).
   int element = 0;
   const TreeNode* node = this;
-  for (; node != nullptr && !node->children_.empty() &&
-         element < path.elem_size();) {
-    node = gtl::FindOrNull(node->children_, path.elem(element).name());
+  for (; node != nullptr && !node->IsLeaf() && element < path.elem_size();) {
+    node = node->FindChildOrNull(path.elem(element).name());
     auto* search = gtl::FindOrNull(path.elem(element).key(), "name");
     if (search != nullptr && node != nullptr) {
-      node = gtl::FindOrNull(node->children_, *search);
+      node = node->FindChildOrNull(*search);
     }
     ++element;
   }
@@ -131,55 +200,204 @@ void YangParseTree::SendNotification(const GnmiEventPtr& event) {
   }
 }
 
-void YangParseTree::ProcessPushedConfig(
-    const ConfigHasBeenPushedEvent& change) {
-  absl::WriterMutexLock r(&root_access_lock_);
-
-  // Translation from node ID to an object describing the node.
-  absl::flat_hash_map<uint64, const Node*> node_id_to_node;
-  for (const auto& node : change.new_config_.nodes()) {
-    node_id_to_node[node.id()] = &node;
+namespace {
+
+// A singleton or trunk interface of a ChassisConfig and the config of the node
+// it belongs to.
+struct InterfaceSubtree {
+  const SingletonPort* singleton;
+  const TrunkPort* trunk;
+  uint64 node_id;
+  uint32 port_id;
+  const NodeConfigParams* node_config;
+};
+
+// Returns true if the two interfaces are described by the same subtree.
+bool IsSameInterface(const InterfaceSubtree& a, const InterfaceSubtree& b) {
+  if (a.node_id != b.node_id || a.port_id != b.port_id) return false;
+  if ((a.singleton == nullptr) != (b.singleton == nullptr)) return false;
+  if (a.singleton != nullptr &&
+      !MessageDifferencer::Equals(*a.singleton, *b.singleton)) {
+    return false;
+  }
+  if (a.trunk != nullptr && !MessageDifferencer::Equals(*a.trunk, *b.trunk)) {
+    return false;
   }
+  return MessageDifferencer::Equals(*a.node_config, *b.node_config);
+}
 
-  // An empty config to be used when node ID is not defined.
-  const NodeConfigParams empty_node_config;
+// The parts of a ChassisConfig the parse tree has subtrees for, keyed by the
+// name of the subtree. The pointers refer to the config.
+struct ConfigSubtrees {
+  explicit ConfigSubtrees(const ChassisConfig& config);
+
+  // The singleton interfaces followed by the trunks, in config order.
+  std::vector<std::pair<std::string, InterfaceSubtree>> interfaces;
+  absl::flat_hash_map<std::string, const InterfaceSubtree*> interface_by_name;
+  absl::flat_hash_map<std::string, const OpticalNetworkInterface*> opticals;
+  absl::flat_hash_map<std::string, const Node*> nodes;
+  // The names of all /components/component[name] subtrees.
+  absl::flat_hash_set<std::string> component_names;
+};
+
+ConfigSubtrees::ConfigSubtrees(const ChassisConfig& config) {
+  // Translation from node ID to the config of the node. An empty config is
+  // used when the node ID is not defined.
+  absl::flat_hash_map<uint64, const NodeConfigParams*> node_id_to_config;
+  for (const auto& node : config.nodes()) {
+    node_id_to_config[node.id()] = &node.config_params();
+    const std::string name = YangParseTreePaths::GetComponentName(node);
+    nodes[name] = &node;
+    component_names.insert(name);
+  }
+  auto get_node_config = [&node_id_to_config](uint64 node_id) {
+    return gtl::FindWithDefault(node_id_to_config, node_id,
+                                &NodeConfigParams::default_instance());
+  };
 
   // Translation from port ID to node ID.
   absl::flat_hash_map<uint32, uint64> port_id_to_node_id;
-  for (const auto& singleton : change.new_config_.singleton_ports()) {
-    const NodeConfigParams& node_config =
-        node_id_to_node[singleton.node()]
-            ? node_id_to_node[singleton.node()]->config_params()
-            : empty_node_config;
-    AddSubtreeInterfaceFromSingleton(singleton, node_config);
+  for (const auto& singleton : config.singleton_ports()) {
+    const InterfaceSubtree interface = {&singleton, nullptr, singleton.node(),
+                                        singleton.id(),
+                                        get_node_config(singleton.node())};
+    interfaces.emplace_back(YangParseTreePaths::GetInterfaceName(singleton),
+                            interface);
+    component_names.insert(interfaces.back().first);
     port_id_to_node_id[singleton.id()] = singleton.node();
   }
 
-  for (const auto& optical : change.new_config_.optical_network_interfaces()) {
-    AddSubtreeInterfaceFromOptical(optical);
-  }
-
-  for (const auto& trunk : change.new_config_.trunk_ports()) {
+  for (const auto& trunk : config.trunk_ports()) {
     // Find out on which node the trunk is created.
     // TODO(b/70300190): Once TrunkPort message in common.proto is extended to
     // include node_id remove 3 following lines.
     constexpr uint64 kNodeIdUnknown = 0xFFFF;
     uint64 node_id = trunk.members_size() ? port_id_to_node_id[trunk.members(0)]
                                           : kNodeIdUnknown;
-    const NodeConfigParams& node_config =
-        node_id != kNodeIdUnknown ? node_id_to_node[node_id]->config_params()
-                                  : empty_node_config;
-    AddSubtreeInterfaceFromTrunk(trunk.name(), node_id, trunk.id(),
-                                 node_config);
+    const InterfaceSubtree interface = {nullptr, &trunk, node_id, trunk.id(),
+                                        get_node_config(node_id)};
+    interfaces.emplace_back(trunk.name(), interface);
+  }
+  for (const auto& entry : interfaces) {
+    interface_by_name[entry.first] = &entry.second;
   }
-  // Add all chassis-related gNMI paths.
-  AddSubtreeChassis(change.new_config_.chassis());
-  // Add all system-related gNMI paths.
-  AddSubtreeSystem();
-  // Add all node-related gNMI paths.
-  for (const auto& node : change.new_config_.nodes()) {
-    AddSubtreeNode(node);
+
+  for (const auto& optical : config.optical_network_interfaces()) {
+    const std::string name = YangParseTreePaths::GetInterfaceName(optical);
+    opticals[name] = &optical;
+    component_names.insert(name);
   }
+  component_names.insert(
+      YangParseTreePaths::GetComponentName(config.chassis()));
+}
+
+}  // namespace
+
+void YangParseTree::ProcessPushedConfig(
+    const ConfigHasBeenPushedEvent& change) {
+  absl::MutexLock l(&pushed_config_lock_);
+  // All subtrees are added for the first config.
+  const bool first_config = pushed_config_ == nullptr;
+  const ChassisConfig& old_config =
+      first_config ? ChassisConfig::default_instance() : *pushed_config_;
+  const ChassisConfig& new_config = change.new_config_;
+
+  // Find out what has changed before blocking the readers of the tree.
+  const ConfigSubtrees old_subtrees(old_config);
+  const ConfigSubtrees new_subtrees(new_config);
+
+  std::vector<const InterfaceSubtree*> changed_interfaces;
+  for (const auto& entry : new_subtrees.interfaces) {
+    const InterfaceSubtree* old_interface =
+        gtl::FindPtrOrNull(old_subtrees.interface_by_name, entry.first);
+    if (old_interface == nullptr ||
+        !IsSameInterface(*old_interface, entry.second)) {
+      changed_interfaces.push_back(&entry.second);
+    }
+  }
+  std::vector<std::string> removed_interfaces;
+  std::vector<std::pair<uint64, uint32>> removed_ports;
+  for (const auto& entry : old_subtrees.interfaces) {
+    const InterfaceSubtree* new_interface =
+        gtl::FindPtrOrNull(new_subtrees.interface_by_name, entry.first);
+    if (new_interface == nullptr) removed_interfaces.push_back(entry.first);
+    if (new_interface == nullptr ||
+        new_interface->node_id != entry.second.node_id ||
+        new_interface->port_id != entry.second.port_id) {
+      removed_ports.emplace_back(entry.second.node_id, entry.second.port_id);
+    }
+  }
+  std::vector<std::string> removed_components;
+  for (const auto& name : old_subtrees.component_names) {
+    if (!new_subtrees.component_names.count(name)) {
+      removed_components.push_back(name);
+    }
+  }
+  std::vector<std::string> removed_nodes;
+  for (const auto& entry : old_subtrees.nodes) {
+    if (!new_subtrees.nodes.count(entry.first)) {
+      removed_nodes.push_back(entry.first);
+    }
+  }
+  std::vector<const OpticalNetworkInterface*> changed_opticals;
+  for (const auto& optical : new_config.optical_network_interfaces()) {
+    const OpticalNetworkInterface* old_optical = gtl::FindPtrOrNull(
+        old_subtrees.opticals, YangParseTreePaths::GetInterfaceName(optical));
+    if (old_optical == nullptr ||
+        !MessageDifferencer::Equals(*old_optical, optical)) {
+      changed_opticals.push_back(&optical);
+    }
+  }
+  std::vector<const Node*> changed_nodes;
+  for (const auto& node : new_config.nodes()) {
+    const Node* old_node = gtl::FindPtrOrNull(
+        old_subtrees.nodes, YangParseTreePaths::GetComponentName(node));
+    if (old_node == nullptr || !MessageDifferencer::Equals(*old_node, node)) {
+      changed_nodes.push_back(&node);
+    }
+  }
+  const bool chassis_changed =
+      first_config ||
+      !MessageDifferencer::Equals(old_config.chassis(), new_config.chassis());
+
+  {
+    absl::WriterMutexLock r(&root_access_lock_);
+    if (first_config) port_counters_cache_.Clear();
+    // Remove the subtrees of everything that is no longer configured.
+    for (const auto& name : removed_interfaces) RemoveSubtreeInterface(name);
+    for (const auto& name : removed_components) RemoveSubtreeComponent(name);
+    for (const auto& name : removed_nodes) RemoveSubtreeNode(name);
+    for (const auto& port : removed_ports) {
+      port_counters_cache_.RemovePort(port.first, port.second);
+    }
+
+    // (Re)build the subtrees of everything that is new or has changed.
+    for (const auto* interface : changed_interfaces) {
+      if (interface->singleton != nullptr) {
+        AddSubtreeInterfaceFromSingleton(*interface->singleton,
+                                         *interface->node_config);
+      } else {
+        AddSubtreeInterfaceFromTrunk(interface->trunk->name(),
+                                     interface->node_id, interface->port_id,
+                                     *interface->node_config);
+      }
+    }
+    for (const auto* optical : changed_opticals) {
+      AddSubtreeInterfaceFromOptical(*optical);
+    }
+    // Add all chassis-related gNMI paths.
+    if (chassis_changed) AddSubtreeChassis(new_config.chassis());
+    // Add all system-related gNMI paths.
+    AddSubtreeSystem();
+    // Add all node-related gNMI paths.
+    for (const auto* node : changed_nodes) AddSubtreeNode(*node);
+    FreeUnusedRetiredSubtrees();
+  }
+
+  VLOG(1) << "Updated the gNMI parse tree: " << changed_interfaces.size()
+          << " interfaces added or changed, " << removed_interfaces.size()
+          << " interfaces removed.";
+  pushed_config_ = absl::make_unique<ChassisConfig>(new_config);
 }
 
 bool YangParseTree::IsWildcard(const std::string& name) const {
@@ -191,16 +409,18 @@ bool YangParseTree::IsWildcard(const std::string& name) const {
 ::util::Status YangParseTree::PerformActionForAllNonWildcardNodes(
     const gnmi::Path& path, const gnmi::Path& subpath,
     const std::function<::util::Status(const TreeNode& leaf)>& action) const {
+  // The nodes on 'path' are never removed. The tokens of the children keep
+  // them and their leaves alive if a config push removes them meanwhile.
   const auto* root = root_.FindNodeOrNull(path);
   RET_CHECK(root);
   ::util::Status ret = ::util::OkStatus();
-  for (const auto& entry : root->children_) {
-    if (IsWildcard(entry.first)) {
+  for (const auto& token : root->GetChildren()) {
+    const TreeNode* child = *token;
+    if (IsWildcard(child->name())) {
       // Skip this one!
       continue;
     }
-    auto* leaf = subpath.elem_size() ? entry.second.FindNodeOrNull(subpath)
-                                     : &entry.second;
+    auto* leaf = subpath.elem_size() ? child->FindNodeOrNull(subpath) : child;
     if (leaf == nullptr) {
       // This will happen if the subpath does not exist in the path.
       // For example, trying to query node-id from all components
@@ -213,7 +433,10 @@ bool YangParseTree::IsWildcard(const std::string& name) const {
 }
 
 YangParseTree::YangParseTree(SwitchInterface* switch_interface)
-    : switch_interface_(ABSL_DIE_IF_NULL(switch_interface)) {
+    : switch_interface_(ABSL_DIE_IF_NULL(switch_interface)),
+      port_counters_cache_(
+          switch_interface,
+          absl::Milliseconds(FLAGS_gnmi_port_counters_max_staleness_ms)) {
   // Add the minimum nodes:
   //   /interfaces/interface[name=*]/state/ifindex
   //   /interfaces/interface[name=*]/state/name
@@ -230,33 +453,51 @@ TreeNode* YangParseTree::AddNode(const ::gnmi::Path& path) {
   // No need to lock the mutex - it is locked by method calling this one.
   TreeNode* node = &root_;
   for (const auto& element : path.elem()) {
-    TreeNode* child = gtl::FindOrNull(node->children_, element.name());
-    if (child == nullptr) {
-      // This path is not supported yet. Let's add a node with default
-      // processing.
-      node->children_.emplace(element.name(), TreeNode(*node, element.name()));
-      child = gtl::FindOrNull(node->children_, element.name());
-    }
-    node = child;
+    // If this path is not supported yet, a node with default processing is
+    // added.
+    node = node->AddChild(element.name(), false);
     auto* search = gtl::FindOrNull(element.key(), "name");
     if (search == nullptr) {
       continue;
     }
 
     // A filtering pattern has been found!
-    child = gtl::FindOrNull(node->children_, *search);
-    if (child == nullptr) {
-      // This path is not supported yet. Let's add a node with default
-      // processing.
-      node->children_.emplace(
-          *search, TreeNode(*node, *search, true /* mark as a key */));
-      child = gtl::FindOrNull(node->children_, *search);
-    }
-    node = child;
+    node = node->AddChild(*search, true /* mark as a key */);
   }
   return node;
 }
 
+void YangParseTree::RemoveNode(const ::gnmi::Path& path) {
+  // No need to lock the mutex - it is locked by method calling this one.
+  TreeNode* parent = nullptr;
+  TreeNode* node = &root_;
+  for (const auto& element : path.elem()) {
+    parent = node;
+    node = parent->FindChildOrNull(element.name());
+    if (node == nullptr) return;
+    auto* search = gtl::FindOrNull(element.key(), "name");
+    if (search == nullptr) {
+      continue;
+    }
+    parent = node;
+    node = parent->FindChildOrNull(*search);
+    if (node == nullptr) return;
+  }
+  if (parent == nullptr) return;
+  retired_subtrees_.push_back(parent->DetachChild(node->name()));
+}
+
+void YangParseTree::FreeUnusedRetiredSubtrees() {
+  // No need to lock the mutex - it is locked by method calling this one.
+  retired_subtrees_.erase(
+      std::remove_if(retired_subtrees_.begin(), retired_subtrees_.end(),
+                     [](const TreeNode::Children::node_type& subtree) {
+                       return subtree.empty() ||
+                              !subtree.mapped().IsSubtreeInUse();
+                     }),
+      retired_subtrees_.end());
+}
+
 ::util::Status YangParseTree::CopySubtree(const ::gnmi::Path& from,
                                           const ::gnmi::Path& to) {
   // No need to lock the mutex - it is locked by method calling this one.
@@ -279,7 +520,7 @@ TreeNode* YangParseTree::AddNode(const ::gnmi::Path& path) {
 }
 
 const TreeNode* YangParseTree::FindNodeOrNull(const ::gnmi::Path& path) const {
-  absl::WriterMutexLock l(&root_access_lock_);
+  absl::ReaderMutexLock l(&root_access_lock_);
 
   // Map the input path to the supported one - walk the tree of known elements
   // element by element starting from the root and if the element is found the
@@ -288,7 +529,7 @@ const TreeNode* YangParseTree::FindNodeOrNull(const ::gnmi::Path& path) const {
 }
 
 const TreeNode* YangParseTree::GetRoot() const {
-  absl::WriterMutexLock l(&root_access_lock_);
+  absl::ReaderMutexLock l(&root_access_lock_);
 
   return &root_;
 }
@@ -298,12 +539,14 @@ void YangParseTree::AddSubtreeInterfaceFromTrunk(
     const NodeConfigParams& node_config) {
   YangParseTreePaths::AddSubtreeInterfaceFromTrunk(name, node_id, port_id,
                                                    node_config, this);
+  port_counters_cache_.AddPort(node_id, port_id);
 }
 
 void YangParseTree::AddSubtreeInterfaceFromSingleton(
     const SingletonPort& singleton, const NodeConfigParams& node_config) {
   YangParseTreePaths::AddSubtreeInterfaceFromSingleton(singleton, node_config,
                                                        this);
+  port_counters_cache_.AddPort(singleton.node(), singleton.id());
 }
 
 void YangParseTree::AddSubtreeInterfaceFromOptical(
@@ -323,6 +566,18 @@ void YangParseTree::AddSubtreeSystem() {
   YangParseTreePaths::AddSubtreeSystem(this);
 }
 
+void YangParseTree::RemoveSubtreeInterface(const std::string& name) {
+  YangParseTreePaths::RemoveSubtreeInterface(name, this);
+}
+
+void YangParseTree::RemoveSubtreeComponent(const std::string& name) {
+  YangParseTreePaths::RemoveSubtreeComponent(name, this);
+}
+
+void YangParseTree::RemoveSubtreeNode(const std::string& name) {
+  YangParseTreePaths::RemoveSubtreeNode(name, this);
+}
+
 void YangParseTree::AddSubtreeAllInterfaces() {
   // No need to lock the mutex - it is locked by method calling this one.
 
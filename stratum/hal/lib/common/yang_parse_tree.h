@@ -5,17 +5,20 @@
 #ifndef STRATUM_HAL_LIB_COMMON_YANG_PARSE_TREE_H_
 #define STRATUM_HAL_LIB_COMMON_YANG_PARSE_TREE_H_
 
-#include <map>
 #include <memory>
 #include <string>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
+#include "absl/container/node_hash_map.h"
 #include "absl/synchronization/mutex.h"
 #include "gnmi/gnmi.grpc.pb.h"
+#include "stratum/glue/gtl/map_util.h"
 #include "stratum/glue/status/status.h"
 #include "stratum/hal/lib/common/common.pb.h"
 #include "stratum/hal/lib/common/gnmi_events.h"
+#include "stratum/hal/lib/common/port_counters_cache.h"
 #include "stratum/hal/lib/common/switch_interface.h"
 #include "stratum/hal/lib/common/writer_interface.h"
 #include "stratum/lib/macros.h"
@@ -55,12 +58,17 @@ using TreeNodeEventRegistration =
 // processed (which means that the leaf is supported).
 class TreeNode {
  public:
+  // The children are looked up by name for every element of every requested
+  // path. A node_hash_map keeps them at a stable address, which the functors
+  // returned by the Get*Handler() methods rely on.
+  using Children = absl::node_hash_map<std::string, TreeNode>;
   using SupportsOnPtr = bool TreeNode::*;
   using TargetDefinedModeFunc =
       std::function<::util::Status(::gnmi::Subscription* subscription)>;
 
   TreeNode()
-      : parent_(nullptr),
+      : use_token_(std::make_shared<const TreeNode*>(this)),
+        parent_(nullptr),
         name_(""),
         is_name_a_key_(false),
         supports_on_timer_(false),
@@ -71,7 +79,8 @@ class TreeNode {
         supports_on_delete_(false) {}
   TreeNode(const TreeNode& parent, const std::string& name,
            bool is_name_a_key = false)
-      : parent_(&parent),
+      : use_token_(std::make_shared<const TreeNode*>(this)),
+        parent_(&parent),
         name_(name),
         is_name_a_key_(is_name_a_key),
         supports_on_timer_(false),
@@ -87,6 +96,7 @@ class TreeNode {
   // Overrides the default-not-supported handler procedure called when
   // a set-update request is processed with a user-specified one.
   TreeNode* SetOnUpdateHandler(const TreeNodeSetHandler& handler) {
+    absl::WriterMutexLock l(&access_lock_);
     on_update_handler_ = handler;
     supports_on_update_ = true;
     return this;
@@ -95,6 +105,7 @@ class TreeNode {
   // Overrides the default-not-supported handler procedure called when
   // a set-replace request is processed with a user-specified one.
   TreeNode* SetOnReplaceHandler(const TreeNodeSetHandler& handler) {
+    absl::WriterMutexLock l(&access_lock_);
     on_replace_handler_ = handler;
     supports_on_replace_ = true;
     return this;
@@ -103,6 +114,7 @@ class TreeNode {
   // Overrides the default-not-supported handler procedure called when
   // a set-delete request is processed with a user-specified one.
   TreeNode* SetOnDeleteHandler(const TreeNodeDeleteHandler& handler) {
+    absl::WriterMutexLock l(&access_lock_);
     on_delete_handler_ = handler;
     supports_on_delete_ = true;
     return this;
@@ -111,6 +123,7 @@ class TreeNode {
   // Overrides the default-process-whole-sub-tree handler procedure called when
   // a timer event is processed with a user-specified one.
   TreeNode* SetOnTimerHandler(const TreeNodeEventHandler& handler) {
+    absl::WriterMutexLock l(&access_lock_);
     on_timer_handler_ = handler;
     supports_on_timer_ = true;
     return this;
@@ -119,6 +132,7 @@ class TreeNode {
   // Overrides the default-process-whole-sub-tree handler procedure called when
   // a poll event is processed with a user-specified one.
   TreeNode* SetOnPollHandler(const TreeNodeEventHandler& handler) {
+    absl::WriterMutexLock l(&access_lock_);
     on_poll_handler_ = handler;
     supports_on_poll_ = true;
     return this;
@@ -127,6 +141,7 @@ class TreeNode {
   // Overrides the default-process-whole-sub-tree handler procedure called when
   // a on-change event is processed with a user-specified one.
   TreeNode* SetOnChangeHandler(const TreeNodeEventHandler& handler) {
+    absl::WriterMutexLock l(&access_lock_);
     on_change_handler_ = handler;
     supports_on_change_ = true;
     return this;
@@ -135,6 +150,7 @@ class TreeNode {
   // Overrides the default-do-not-register-for-any-event-type handler procedure
   // called when a on-change event is subscribed to with a user-specified one.
   TreeNode* SetOnChangeRegistration(const TreeNodeEventRegistration& handler) {
+    absl::WriterMutexLock l(&access_lock_);
     on_change_registration_ = handler;
     return this;
   }
@@ -142,18 +158,54 @@ class TreeNode {
   // Overrides the default change-target-defined-mode-to-on-change-mode method
   // with a user-specified one.
   TreeNode* SetTargetDefinedMode(const TargetDefinedModeFunc& mode) {
+    absl::WriterMutexLock l(&access_lock_);
     target_defined_mode_ = mode;
     return this;
   }
 
-  // Returns a node that handles the YANG path starting from this node.
+  // Returns a node that handles the YANG path starting from this node. The
+  // returned node is only kept alive by a token of it or of one of its
+  // ancestors, see GetChildren().
   const TreeNode* FindNodeOrNull(const ::gnmi::Path& path) const;
 
+  // Returns the child with the specified name or nullptr if there is none.
+  const TreeNode* FindChildOrNull(const std::string& name) const
+      LOCKS_EXCLUDED(access_lock_) {
+    absl::ReaderMutexLock l(&access_lock_);
+    return gtl::FindOrNull(children_, name);
+  }
+  TreeNode* FindChildOrNull(const std::string& name)
+      LOCKS_EXCLUDED(access_lock_) {
+    absl::ReaderMutexLock l(&access_lock_);
+    return gtl::FindOrNull(children_, name);
+  }
+
+  // Returns the use tokens of the children ordered by name. A token points to
+  // its child and keeps it alive after the child has been detached by a
+  // concurrent config push.
+  std::vector<std::shared_ptr<const TreeNode*>> GetChildren() const
+      LOCKS_EXCLUDED(access_lock_);
+
+  // Returns the child with the specified name. A child with default processing
+  // is added if there is none yet.
+  TreeNode* AddChild(const std::string& name, bool is_name_a_key);
+
+  // Removes the child with the specified name and returns the handle owning
+  // its subtree. The nodes of the subtree keep their addresses while the
+  // handle is alive. Returns an empty handle if there is no such child.
+  Children::node_type DetachChild(const std::string& name);
+
+  // Returns true if a functor returned by the Get*Handler() methods of a node
+  // of the subtree starting from this node is still alive.
+  bool IsSubtreeInUse() const;
+
   // A generic method that checks if the subtree starting from this node
   // supports a particular type of events. The input parameter is a pointer to
   // the mameber variable that keeps information if this node supports the
   // requested type of events.
-  bool AllSubtreeLeavesSupportOn(SupportsOnPtr supports_on) const {
+  bool AllSubtreeLeavesSupportOn(SupportsOnPtr supports_on) const
+      LOCKS_EXCLUDED(access_lock_) {
+    absl::ReaderMutexLock l(&access_lock_);
     if (children_.empty()) {
       // This is a leaf - return what the flag says.
       return this->*supports_on;
@@ -206,32 +258,37 @@ class TreeNode {
 
   // Returns a functor that will execute handlers of this node.
   GnmiSetHandler GetOnUpdateHandler() const {
-    return
-        [this](const ::gnmi::Path& path, const ::google::protobuf::Message& val,
-               CopyOnWriteChassisConfig* config) {
-          return on_update_handler_(path, val, config);
-        };
+    auto token = GetUseToken();
+    return [this, token](const ::gnmi::Path& path,
+                         const ::google::protobuf::Message& val,
+                         CopyOnWriteChassisConfig* config) {
+      return GetHandler(&TreeNode::on_update_handler_)(path, val, config);
+    };
   }
 
   // Returns a functor that will execute handlers of this node.
   GnmiSetHandler GetOnReplaceHandler() const {
-    return
-        [this](const ::gnmi::Path& path, const ::google::protobuf::Message& val,
-               CopyOnWriteChassisConfig* config) {
-          return on_replace_handler_(path, val, config);
-        };
+    auto token = GetUseToken();
+    return [this, token](const ::gnmi::Path& path,
+                         const ::google::protobuf::Message& val,
+                         CopyOnWriteChassisConfig* config) {
+      return GetHandler(&TreeNode::on_replace_handler_)(path, val, config);
+    };
   }
 
   // Returns a functor that will execute handlers of this node.
   GnmiDeleteHandler GetOnDeleteHandler() const {
-    return [this](const ::gnmi::Path& path, CopyOnWriteChassisConfig* config) {
-      return on_delete_handler_(path, config);
+    auto token = GetUseToken();
+    return [this, token](const ::gnmi::Path& path,
+                         CopyOnWriteChassisConfig* config) {
+      return GetHandler(&TreeNode::on_delete_handler_)(path, config);
     };
   }
 
   // Returns a functor that will execute handlers of this node and its children.
   GnmiEventHandler GetOnTimerHandler() const {
-    return [this](const GnmiEvent& event, GnmiSubscribeStream* stream) {
+    auto token = GetUseToken();
+    return [this, token](const GnmiEvent& event, GnmiSubscribeStream* stream) {
       return VisitThisNodeAndItsChildren(&TreeNode::on_timer_handler_, event,
                                          this->GetPath(), stream);
     };
@@ -239,7 +296,8 @@ class TreeNode {
 
   // Returns a functor that will execute handlers of this node and its children.
   GnmiEventHandler GetOnChangeHandler() const {
-    return [this](const GnmiEvent& event, GnmiSubscribeStream* stream) {
+    auto token = GetUseToken();
+    return [this, token](const GnmiEvent& event, GnmiSubscribeStream* stream) {
       return VisitThisNodeAndItsChildren(&TreeNode::on_change_handler_, event,
                                          this->GetPath(), stream);
     };
@@ -247,7 +305,8 @@ class TreeNode {
 
   // Returns a functor that will execute handlers of this node and its children.
   GnmiEventHandler GetOnPollHandler() const {
-    return [this](const GnmiEvent& event, GnmiSubscribeStream* stream) {
+    auto token = GetUseToken();
+    return [this, token](const GnmiEvent& event, GnmiSubscribeStream* stream) {
       return VisitThisNodeAndItsChildren(&TreeNode::on_poll_handler_, event,
                                          this->GetPath(), stream);
     };
@@ -266,7 +325,7 @@ class TreeNode {
   // target_defined_mode_ functor to modify the 'subscription` protobuf.
   ::util::Status ApplyTargetDefinedModeToSubscription(
       ::gnmi::Subscription* subscription) const {
-    return target_defined_mode_(subscription);
+    return GetHandler(&TreeNode::target_defined_mode_)(subscription);
   }
 
   const TreeNode& parent() const { return *parent_; }
@@ -275,7 +334,8 @@ class TreeNode {
   // Returns path from root to this node.
   ::gnmi::Path GetPath() const;
 
-  std::map<std::string, TreeNode> children_;
+  // Guarded by access_lock_.
+  Children children_;
 
  private:
   using TreeNodeEventHandlerPtr = TreeNodeEventHandler TreeNode::*;
@@ -283,7 +343,9 @@ class TreeNode {
   // Traverses the whole subtree starting from this node.
   // This method is used to visit all subtree nodes and execute handler functor
   // - this implements the expected behavior when a client subscribes to a node
-  // that is not a leaf.
+  // that is not a leaf. The handler and the children of each node are copied
+  // under its access_lock_, so the subtree can be modified by a config push
+  // meanwhile. The handlers are run without any lock held.
   ::util::Status VisitThisNodeAndItsChildren(
       const TreeNodeEventHandlerPtr& handler, const GnmiEvent& event,
       const ::gnmi::Path& path, GnmiSubscribeStream* stream) const;
@@ -296,9 +358,37 @@ class TreeNode {
 
   bool IsAKey() { return is_name_a_key_; }
 
-  // A Mutex used to guard access to the handlers.
+  // Returns true if this node has no children.
+  bool IsLeaf() const LOCKS_EXCLUDED(access_lock_) {
+    absl::ReaderMutexLock l(&access_lock_);
+    return children_.empty();
+  }
+
+  // Returns a copy of a handler, so that it can be run while a config push
+  // replaces it.
+  template <typename T>
+  T GetHandler(T TreeNode::*handler) const LOCKS_EXCLUDED(access_lock_) {
+    absl::ReaderMutexLock l(&access_lock_);
+    return this->*handler;
+  }
+
+  // Returns the token captured by the functors returned by the Get*Handler()
+  // methods and by GetChildren(). The node is in use as long as copies of it
+  // exist.
+  std::shared_ptr<const TreeNode*> GetUseToken() const { return use_token_; }
+
+  // The children ordered by name. Subtrees are visited in this order, so that
+  // the responses do not depend on the order of the hash map.
+  std::vector<const TreeNode*> sorted_children_ GUARDED_BY(access_lock_);
+
+  // A Mutex used to guard access to the handlers, the supports_* flags and the
+  // children. The tree is modified by the config push thread, while the
+  // handlers of the subscriptions walk it.
   mutable absl::Mutex access_lock_;
 
+  // Points to this node. Never changes, so copies can be made without a lock.
+  const std::shared_ptr<const TreeNode*> use_token_;
+
   TreeNodeEventHandler on_timer_handler_ =
       [](const GnmiEvent&, const ::gnmi::Path&, GnmiSubscribeStream*) {
         // Intermediate node. No real processing but needs to
@@ -427,6 +517,18 @@ class YangParseTree {
   // Add supported leaf handles for the system.
   void AddSubtreeSystem() EXCLUSIVE_LOCKS_REQUIRED(root_access_lock_);
 
+  // Remove the leaf handles of an interface that is no longer configured.
+  void RemoveSubtreeInterface(const std::string& name)
+      EXCLUSIVE_LOCKS_REQUIRED(root_access_lock_);
+
+  // Remove the leaf handles of a component that is no longer configured.
+  void RemoveSubtreeComponent(const std::string& name)
+      EXCLUSIVE_LOCKS_REQUIRED(root_access_lock_);
+
+  // Remove the leaf handles of a node that is no longer configured.
+  void RemoveSubtreeNode(const std::string& name)
+      EXCLUSIVE_LOCKS_REQUIRED(root_access_lock_);
+
   // Configure the root element.
   void AddRoot() EXCLUSIVE_LOCKS_REQUIRED(root_access_lock_);
 
@@ -439,11 +541,14 @@ class YangParseTree {
   const TreeNode* GetRoot() const LOCKS_EXCLUDED(root_access_lock_);
 
   SwitchInterface* GetSwitchInterface() LOCKS_EXCLUDED(root_access_lock_) {
-    absl::WriterMutexLock r(&root_access_lock_);
+    absl::ReaderMutexLock r(&root_access_lock_);
 
     return switch_interface_;
   }
 
+  // Returns the port counters snapshot shared by all counter leaves.
+  PortCountersCache* GetPortCountersCache() { return &port_counters_cache_; }
+
   // A getter providing a functor setting TARGET_DEFINED mode of a leaf to be
   // STREAM:SAMPLE.
   const TreeNode::TargetDefinedModeFunc& GetStreamSampleModeFunc() {
@@ -455,9 +560,14 @@ class YangParseTree {
   virtual void SendNotification(const GnmiEventPtr& event)
       LOCKS_EXCLUDED(root_access_lock_);
 
-  // An action that modifies the tree to reflect new configuration.
+  // An action that modifies the tree to reflect new configuration. Only the
+  // subtrees of the interfaces, components and nodes that have been added,
+  // removed or changed since the previous config are rebuilt. The changes are
+  // computed before root_access_lock_ is taken. The handlers of the
+  // subscriptions may run meanwhile: they do not take root_access_lock_ to
+  // walk the tree, but lock one node at a time, see TreeNode::access_lock_.
   void ProcessPushedConfig(const ConfigHasBeenPushedEvent& change)
-      LOCKS_EXCLUDED(root_access_lock_);
+      LOCKS_EXCLUDED(root_access_lock_, pushed_config_lock_);
 
  protected:
   using Action = std::function<void()>;
@@ -466,6 +576,14 @@ class YangParseTree {
   TreeNode* AddNode(const ::gnmi::Path& path)
       EXCLUSIVE_LOCKS_REQUIRED(root_access_lock_);
 
+  // Removes the node at specified path and its subtree from the tree. Does
+  // nothing if there is no such node.
+  void RemoveNode(const ::gnmi::Path& path)
+      EXCLUSIVE_LOCKS_REQUIRED(root_access_lock_);
+
+  // Destroys the retired subtrees which are no longer used by any functor.
+  void FreeUnusedRetiredSubtrees() EXCLUSIVE_LOCKS_REQUIRED(root_access_lock_);
+
   // Copies a subtree.
   ::util::Status CopySubtree(const ::gnmi::Path& from, const ::gnmi::Path& to)
       EXCLUSIVE_LOCKS_REQUIRED(root_access_lock_);
@@ -495,6 +613,24 @@ class YangParseTree {
   // A Mutex used to guard access to the root.
   mutable absl::Mutex root_access_lock_;
 
+  // Subtrees removed from the tree by RemoveNode(). Subscriptions may still
+  // hold functors pointing to their nodes, so they are only destroyed by
+  // FreeUnusedRetiredSubtrees() once these functors are gone.
+  std::vector<TreeNode::Children::node_type> retired_subtrees_
+      GUARDED_BY(root_access_lock_);
+
+  // The config the tree has been built for by ProcessPushedConfig(), nullptr
+  // before the first config has been pushed.
+  std::unique_ptr<ChassisConfig> pushed_config_
+      GUARDED_BY(pushed_config_lock_);
+  // A Mutex serializing ProcessPushedConfig() calls. Acquired before
+  // root_access_lock_.
+  absl::Mutex pushed_config_lock_;
+
+  // The counters of all ports, refreshed at most once per sampling tick.
+  // Thread-safe on its own.
+  PortCountersCache port_counters_cache_;
+
   // In most cases the TARGET_DEFINED mode is ON_CHANGE mode as this mode
   // is the least resource-hungry. But to make the gNMI demo more realistic it
   // is changed to SAMPLE with the period of 1s.
@@ -1702,26 +1702,14 @@ TreeNodeEventHandler GetPollCounterFunctor(uint64 node_id, uint32 port_id,
   return [tree, node_id, port_id, func_ptr](const GnmiEvent& event,
                                             const ::gnmi::Path& path,
                                             GnmiSubscribeStream* stream) {
-    // Create a data retrieval request.
-    DataRequest req;
-    auto* request = req.add_requests()->mutable_port_counters();
-    request->set_node_id(node_id);
-    request->set_port_id(port_id);
-
-    // In-place definition of method retrieving data from generic response
-    // and saving into 'resp' local variable.
+    // All counter leaves of a port read the same snapshot, which retrieves the
+    // counters of all ports at most once per sampling tick.
     uint64 resp = 0;
-    DataResponseWriter writer(
-        [&resp, func_ptr](const DataResponse& in) -> bool {
-          if (!in.has_port_counters()) return false;
-          resp = (in.port_counters().*func_ptr)();
-          return true;
-        });
-    // Query the switch. The returned status is ignored as there is no way to
-    // notify the controller that something went wrong. The error is logged when
-    // it is created.
-    auto status = tree->GetSwitchInterface()->RetrieveValue(
-        node_id, req, &writer, /* details= */ nullptr);
+    auto counters =
+        tree->GetPortCountersCache()->GetPortCounters(node_id, port_id);
+    // The error is ignored as there is no way to notify the controller that
+    // something went wrong. The error is logged when it is created.
+    if (counters.ok()) resp = (counters.ValueOrDie().*func_ptr)();
     return SendResponse(GetResponse(path, resp), stream);
   };
 }
@@ -3549,6 +3537,30 @@ TreeNode* YangParseTreePaths::AddSubtreeInterface(
   return node;
 }
 
+std::string YangParseTreePaths::GetInterfaceName(
+    const SingletonPort& singleton) {
+  return singleton.name().empty()
+             ? absl::StrFormat("%d/%d/%d", singleton.slot(), singleton.port(),
+                               singleton.channel())
+             : singleton.name();
+}
+
+std::string YangParseTreePaths::GetInterfaceName(
+    const OpticalNetworkInterface& optical_port) {
+  return optical_port.name().empty()
+             ? absl::StrFormat("netif-%d", optical_port.network_interface())
+             : optical_port.name();
+}
+
+std::string YangParseTreePaths::GetComponentName(const Node& node) {
+  return node.name().empty() ? absl::StrFormat("node-%d", node.id())
+                             : node.name();
+}
+
+std::string YangParseTreePaths::GetComponentName(const Chassis& chassis) {
+  return chassis.name().empty() ? "chassis" : chassis.name();
+}
+
 void YangParseTreePaths::AddSubtreeInterfaceFromTrunk(
     const std::string& name, uint64 node_id, uint32 port_id,
     const NodeConfigParams& node_config, YangParseTree* tree) {
@@ -3558,11 +3570,7 @@ void YangParseTreePaths::AddSubtreeInterfaceFromTrunk(
 void YangParseTreePaths::AddSubtreeInterfaceFromSingleton(
     const SingletonPort& singleton, const NodeConfigParams& node_config,
     YangParseTree* tree) {
-  const std::string& name =
-      singleton.name().empty()
-          ? absl::StrFormat("%d/%d/%d", singleton.slot(), singleton.port(),
-                            singleton.channel())
-          : singleton.name();
+  const std::string name = GetInterfaceName(singleton);
   uint64 node_id = singleton.node();
   uint32 port_id = singleton.id();
   bool port_auto_neg_enabled = false;
@@ -3646,10 +3654,7 @@ void YangParseTreePaths::AddSubtreeInterfaceFromSingleton(
 
 void YangParseTreePaths::AddSubtreeInterfaceFromOptical(
     const OpticalNetworkInterface& optical_port, YangParseTree* tree) {
-  const std::string& name =
-      optical_port.name().empty()
-          ? absl::StrFormat("netif-%d", optical_port.network_interface())
-          : optical_port.name();
+  const std::string name = GetInterfaceName(optical_port);
   int32 module = optical_port.module();
   int32 network_interface = optical_port.network_interface();
   TreeNode* node{nullptr};
@@ -3783,8 +3788,7 @@ void YangParseTreePaths::AddSubtreeInterfaceFromOptical(
 
 void YangParseTreePaths::AddSubtreeNode(const Node& node, YangParseTree* tree) {
   // No need to lock the mutex - it is locked by method calling this one.
-  const std::string& name =
-      node.name().empty() ? absl::StrFormat("node-%d", node.id()) : node.name();
+  const std::string name = GetComponentName(node);
   TreeNode* tree_node = tree->AddNode(
       GetPath("debug")("nodes")("node", name)("packet-io")("debug-string")());
   SetUpDebugNodesNodePacketIoDebugString(node.id(), tree_node, tree);
@@ -3812,7 +3816,7 @@ void YangParseTreePaths::AddSubtreeNode(const Node& node, YangParseTree* tree) {
 
 void YangParseTreePaths::AddSubtreeChassis(const Chassis& chassis,
                                            YangParseTree* tree) {
-  const std::string& name = chassis.name().empty() ? "chassis" : chassis.name();
+  const std::string name = GetComponentName(chassis);
   TreeNode* node = tree->AddNode(GetPath("components")(
       "component", name)("chassis")("alarms")("memory-error")());
   SetUpComponentsComponentChassisAlarmsMemoryError(node, tree);
@@ -3862,6 +3866,23 @@ void YangParseTreePaths::AddSubtreeSystem(YangParseTree* tree) {
   SetUpSystemLoggingConsoleStateSeverity(node, tree);
 }
 
+void YangParseTreePaths::RemoveSubtreeInterface(const std::string& name,
+                                                YangParseTree* tree) {
+  tree->RemoveNode(GetPath("interfaces")("interface", name)());
+  tree->RemoveNode(GetPath("lacp")("interfaces")("interface", name)());
+  tree->RemoveNode(GetPath("qos")("interfaces")("interface", name)());
+}
+
+void YangParseTreePaths::RemoveSubtreeComponent(const std::string& name,
+                                                YangParseTree* tree) {
+  tree->RemoveNode(GetPath("components")("component", name)());
+}
+
+void YangParseTreePaths::RemoveSubtreeNode(const std::string& name,
+                                           YangParseTree* tree) {
+  tree->RemoveNode(GetPath("debug")("nodes")("node", name)());
+}
+
 void YangParseTreePaths::AddSubtreeAllInterfaces(YangParseTree* tree) {
   // Add support for "/interfaces/interface[name=*]/state/id".
   tree->AddNode(GetPath("interfaces")("interface", "*")("state")("id")())
@@ -23,6 +23,19 @@ class YangParseTreePaths {
   // the end of series of update messages.
   static ::util::Status SendEndOfSeriesMessage(GnmiSubscribeStream* stream);
 
+  // Returns the name of the subtrees of the specified singleton interface.
+  static std::string GetInterfaceName(const SingletonPort& singleton);
+
+  // Returns the name of the subtree of the specified optical interface.
+  static std::string GetInterfaceName(
+      const OpticalNetworkInterface& optical_port);
+
+  // Returns the name of the component subtree of the specified node.
+  static std::string GetComponentName(const Node& node);
+
+  // Returns the name of the component subtree of the specified chassis.
+  static std::string GetComponentName(const Chassis& chassis);
+
   // Adds all supported paths for the specified singleton interface.
   static void AddSubtreeInterfaceFromSingleton(
       const SingletonPort& singleton, const NodeConfigParams& node_config,
@@ -52,6 +65,21 @@ class YangParseTreePaths {
   static void AddSubtreeSystem(YangParseTree* tree)
       EXCLUSIVE_LOCKS_REQUIRED(tree->root_access_lock_);
 
+  // Removes all interface-related paths of the specified singleton or trunk
+  // interface.
+  static void RemoveSubtreeInterface(const std::string& name,
+                                     YangParseTree* tree)
+      EXCLUSIVE_LOCKS_REQUIRED(tree->root_access_lock_);
+
+  // Removes all paths of the specified component.
+  static void RemoveSubtreeComponent(const std::string& name,
+                                     YangParseTree* tree)
+      EXCLUSIVE_LOCKS_REQUIRED(tree->root_access_lock_);
+
+  // Removes all node-related paths of the specified node, except its component.
+  static void RemoveSubtreeNode(const std::string& name, YangParseTree* tree)
+      EXCLUSIVE_LOCKS_REQUIRED(tree->root_access_lock_);
+
   // Adds all supported wildcard interface-related paths.
   static void AddSubtreeAllInterfaces(YangParseTree* tree)
       EXCLUSIVE_LOCKS_REQUIRED(tree->root_access_lock_);
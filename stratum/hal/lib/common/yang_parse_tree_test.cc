@@ -2,6 +2,9 @@
 // Copyright 2018-present Open Networking Foundation
 // SPDX-License-Identifier: Apache-2.0
 
+#include <atomic>
+#include <thread>  // NOLINT
+
 #include "absl/synchronization/mutex.h"
 #include "gmock/gmock.h"
 #include "gnmi/gnmi.pb.h"
@@ -23,6 +26,7 @@
 namespace stratum {
 namespace hal {
 
+using test_utils::EqualsProto;
 using test_utils::StatusIs;
 using ::testing::_;
 using ::testing::ContainsRegex;
@@ -98,6 +102,12 @@ class YangParseTreeTest : public ::testing::Test {
                                                            action);
   }
 
+  // Returns the number of subtrees removed from the tree but kept alive.
+  int RetiredSubtreeCount() const {
+    absl::ReaderMutexLock l(&parse_tree_.root_access_lock_);
+    return parse_tree_.retired_subtrees_.size();
+  }
+
   // A proxy for YangParseTree::gnmi_event_writer_.
   void SetGnmiEventWriter(WriterInterface<GnmiEventPtr>* channel) {
     absl::WriterMutexLock l(&parse_tree_.root_access_lock_);
@@ -650,6 +660,111 @@ TEST_F(YangParseTreeTest, FindRoot) {
   ASSERT_OK(node->GetOnReplaceHandler()(path, req, &copy_on_write_config));
 }
 
+TEST_F(YangParseTreeTest, ProcessPushedConfigRebuildsChangedSubtreesOnly) {
+  ChassisConfig config;
+  ASSERT_OK(ParseProtoFromString(R"pb(
+    chassis { name: "chassis-1" }
+    nodes { id: 1 name: "node-1" }
+    singleton_ports { id: 1 name: "interface-1" node: 1 speed_bps: 25000000000 }
+    singleton_ports { id: 2 name: "interface-2" node: 1 speed_bps: 25000000000 }
+  )pb", &config));
+  parse_tree_.ProcessPushedConfig(ConfigHasBeenPushedEvent(config));
+
+  const ::gnmi::Path path1 = GetPath("interfaces")("interface", "interface-1")(
+      "ethernet")("config")("port-speed")();
+  const ::gnmi::Path path2 = GetPath("interfaces")("interface", "interface-2")(
+      "ethernet")("config")("port-speed")();
+  const TreeNode* leaf1 = parse_tree_.FindNodeOrNull(path1);
+  const TreeNode* leaf2 = parse_tree_.FindNodeOrNull(path2);
+  ASSERT_NE(leaf1, nullptr);
+  ASSERT_NE(leaf2, nullptr);
+  // A subscription to a leaf of the second interface.
+  auto handler = leaf2->GetOnPollHandler();
+
+  // Change the first interface, replace the second one with a third one.
+  config.mutable_singleton_ports(0)->set_speed_bps(kHundredGigBps);
+  config.mutable_singleton_ports(1)->set_id(3);
+  config.mutable_singleton_ports(1)->set_name("interface-3");
+  parse_tree_.ProcessPushedConfig(ConfigHasBeenPushedEvent(config));
+
+  // The leaves of a changed interface are updated in place.
+  EXPECT_EQ(parse_tree_.FindNodeOrNull(path1), leaf1);
+  EXPECT_EQ(parse_tree_.FindNodeOrNull(path2), nullptr);
+  EXPECT_EQ(parse_tree_.FindNodeOrNull(
+                GetPath("components")("component", "interface-2")()),
+            nullptr);
+  EXPECT_NE(parse_tree_.FindNodeOrNull(GetPath("interfaces")(
+                "interface", "interface-3")("ethernet")("config")(
+                "port-speed")()),
+            nullptr);
+  EXPECT_NE(parse_tree_.FindNodeOrNull(
+                GetPath("components")("component", "chassis-1")()),
+            nullptr);
+  EXPECT_NE(parse_tree_.FindNodeOrNull(
+                GetPath("components")("component", "node-1")()),
+            nullptr);
+  // The nodes of a removed interface are kept for the subscriptions that
+  // still refer to them.
+  EXPECT_THAT(leaf2->GetPath(), EqualsProto(path2));
+  EXPECT_EQ(RetiredSubtreeCount(), 1);
+
+  int counter = 0;
+  EXPECT_OK(PerformActionForAllNonWildcardNodes(
+      GetPath("interfaces")("interface")(), GetPath("state")("name")(),
+      [&counter](const TreeNode& leaf) {
+        ++counter;
+        return ::util::OkStatus();
+      }));
+  EXPECT_EQ(counter, 2);
+
+  // The retired subtrees are freed once they are no longer used.
+  handler = nullptr;
+  parse_tree_.ProcessPushedConfig(ConfigHasBeenPushedEvent(config));
+  EXPECT_EQ(RetiredSubtreeCount(), 0);
+}
+
+TEST_F(YangParseTreeTest, ProcessPushedConfigWhileHandlersWalkTheTree) {
+  ChassisConfig config;
+  ASSERT_OK(ParseProtoFromString(R"pb(
+    chassis { name: "chassis-1" }
+    nodes { id: 1 name: "node-1" }
+    singleton_ports { id: 1 name: "interface-1" node: 1 speed_bps: 25000000000 }
+    singleton_ports { id: 2 name: "interface-2" node: 1 speed_bps: 25000000000 }
+  )pb", &config));
+  ChassisConfig reduced_config = config;
+  reduced_config.mutable_singleton_ports()->RemoveLast();
+  parse_tree_.ProcessPushedConfig(ConfigHasBeenPushedEvent(config));
+
+  // Polling the wildcard leaf walks the children of all interfaces.
+  const TreeNode* node = parse_tree_.FindNodeOrNull(
+      GetPath("interfaces")("interface", "*")("state")("name")());
+  ASSERT_NE(node, nullptr);
+  auto handler = node->GetOnPollHandler();
+  std::atomic<bool> done(false);
+  std::atomic<int> num_polls(0);
+  std::thread poller([&handler, &done, &num_polls]() {
+    InlineGnmiSubscribeStream stream(
+        [](const ::gnmi::SubscribeResponse& resp) { return true; });
+    while (!done || num_polls == 0) {
+      EXPECT_OK(handler(PollEvent(), &stream));
+      ++num_polls;
+    }
+  });
+
+  // Remove and re-add the second interface while the tree is being polled.
+  for (int i = 0; i < 100; ++i) {
+    parse_tree_.ProcessPushedConfig(
+        ConfigHasBeenPushedEvent(i % 2 == 0 ? reduced_config : config));
+  }
+  done = true;
+  poller.join();
+  EXPECT_GT(num_polls, 0);
+
+  handler = nullptr;
+  parse_tree_.ProcessPushedConfig(ConfigHasBeenPushedEvent(config));
+  EXPECT_EQ(RetiredSubtreeCount(), 0);
+}
+
 TEST_F(YangParseTreeTest, PerformActionForAllNodesNonePresent) {
   // After tree creation only three leafs are defined:
   // /interfaces/interface[name=*]/state/id
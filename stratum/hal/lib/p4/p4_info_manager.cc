@@ -192,6 +192,57 @@ P4InfoManager::FindDigestByName(const std::string& digest_name) const {
   return digest_map_.FindByName(digest_name);
 }
 
+::util::StatusOr<const ::p4::config::v1::Table*>
+P4InfoManager::FindTablePtrByID(uint32 table_id) const {
+  return table_map_.FindPtrByID(table_id);
+}
+
+::util::StatusOr<const ::p4::config::v1::Table*>
+P4InfoManager::FindTablePtrByName(const std::string& table_name) const {
+  return table_map_.FindPtrByName(table_name);
+}
+
+::util::StatusOr<const ::p4::config::v1::Action*>
+P4InfoManager::FindActionPtrByID(uint32 action_id) const {
+  return action_map_.FindPtrByID(action_id);
+}
+
+::util::StatusOr<const ::p4::config::v1::Action*>
+P4InfoManager::FindActionPtrByName(const std::string& action_name) const {
+  return action_map_.FindPtrByName(action_name);
+}
+
+::util::StatusOr<const ::p4::config::v1::ActionProfile*>
+P4InfoManager::FindActionProfilePtrByID(uint32 profile_id) const {
+  return action_profile_map_.FindPtrByID(profile_id);
+}
+
+::util::StatusOr<const ::p4::config::v1::ActionProfile*>
+P4InfoManager::FindActionProfilePtrByName(
+    const std::string& profile_name) const {
+  return action_profile_map_.FindPtrByName(profile_name);
+}
+
+::util::StatusOr<const ::p4::config::v1::Counter*>
+P4InfoManager::FindCounterPtrByID(uint32 counter_id) const {
+  return counter_map_.FindPtrByID(counter_id);
+}
+
+::util::StatusOr<const ::p4::config::v1::Counter*>
+P4InfoManager::FindCounterPtrByName(const std::string& counter_name) const {
+  return counter_map_.FindPtrByName(counter_name);
+}
+
+::util::StatusOr<const ::p4::config::v1::Meter*>
+P4InfoManager::FindMeterPtrByID(uint32 meter_id) const {
+  return meter_map_.FindPtrByID(meter_id);
+}
+
+::util::StatusOr<const ::p4::config::v1::Meter*>
+P4InfoManager::FindMeterPtrByName(const std::string& meter_name) const {
+  return meter_map_.FindPtrByName(meter_name);
+}
+
 ::util::StatusOr<P4Annotation> P4InfoManager::GetSwitchStackAnnotations(
     const std::string& p4_object_name) const {
   auto preamble_ptr_ptr = gtl::FindOrNull(all_resource_names_, p4_object_name);
@@ -8,8 +8,10 @@
 #ifndef STRATUM_HAL_LIB_P4_P4_INFO_MANAGER_H_
 #define STRATUM_HAL_LIB_P4_P4_INFO_MANAGER_H_
 
+#include <algorithm>
 #include <functional>
 #include <string>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
@@ -109,6 +111,31 @@ class P4InfoManager {
   virtual ::util::StatusOr<const ::p4::config::v1::Digest> FindDigestByName(
       const std::string& digest_name) const;
 
+  // These methods do the same lookups as the methods above, but avoid the
+  // copy. A successful lookup returns a pointer into the P4Info owned by this
+  // P4InfoManager, which remains valid for the lifetime of the P4InfoManager.
+  // They are the preferred choice on per-entry paths such as table writes.
+  virtual ::util::StatusOr<const ::p4::config::v1::Table*> FindTablePtrByID(
+      uint32 table_id) const;
+  virtual ::util::StatusOr<const ::p4::config::v1::Table*> FindTablePtrByName(
+      const std::string& table_name) const;
+  virtual ::util::StatusOr<const ::p4::config::v1::Action*> FindActionPtrByID(
+      uint32 action_id) const;
+  virtual ::util::StatusOr<const ::p4::config::v1::Action*>
+  FindActionPtrByName(const std::string& action_name) const;
+  virtual ::util::StatusOr<const ::p4::config::v1::ActionProfile*>
+  FindActionProfilePtrByID(uint32 profile_id) const;
+  virtual ::util::StatusOr<const ::p4::config::v1::ActionProfile*>
+  FindActionProfilePtrByName(const std::string& profile_name) const;
+  virtual ::util::StatusOr<const ::p4::config::v1::Counter*>
+  FindCounterPtrByID(uint32 counter_id) const;
+  virtual ::util::StatusOr<const ::p4::config::v1::Counter*>
+  FindCounterPtrByName(const std::string& counter_name) const;
+  virtual ::util::StatusOr<const ::p4::config::v1::Meter*> FindMeterPtrByID(
+      uint32 meter_id) const;
+  virtual ::util::StatusOr<const ::p4::config::v1::Meter*> FindMeterPtrByName(
+      const std::string& meter_name) const;
+
   // GetSwitchStackAnnotations attempts to parse any @switchstack annotations
   // in the input object's P4Info Preamble.  If the P4 object has multiple
   // @switchstack annotations, GetSwitchStackAnnotations merges them into
@@ -191,29 +218,49 @@ class P4InfoManager {
           APPEND_STATUS_IF_ERROR(status, preamble_status);
         }
       }
+      BuildDenseIdIndex();
       return status;
     }
 
     // Attempts to find the P4 resource matching the input ID.
     ::util::StatusOr<const T> FindByID(uint32 id) const {
-      auto iter = id_to_resource_map_.find(id);
-      if (iter == id_to_resource_map_.end()) {
+      ASSIGN_OR_RETURN(const T* resource, FindPtrByID(id));
+      return *resource;
+    }
+
+    // Attempts to find the P4 resource matching the input name.
+    ::util::StatusOr<const T> FindByName(const std::string& name) const {
+      ASSIGN_OR_RETURN(const T* resource, FindPtrByName(name));
+      return *resource;
+    }
+
+    // Same as FindByID, but returns a pointer to the resource in the P4Info.
+    ::util::StatusOr<const T*> FindPtrByID(uint32 id) const {
+      const T* resource = nullptr;
+      if (!dense_id_index_.empty()) {
+        uint32 index = id - dense_id_base_;
+        if (index < dense_id_index_.size()) resource = dense_id_index_[index];
+      } else {
+        auto iter = id_to_resource_map_.find(id);
+        if (iter != id_to_resource_map_.end()) resource = iter->second;
+      }
+      if (resource == nullptr) {
         return MAKE_ERROR(ERR_INVALID_P4_INFO)
                << "P4Info " << resource_type_ << " ID " << PrintP4ObjectID(id)
                << " is not found";
       }
-      return *iter->second;
+      return resource;
     }
 
-    // Attempts to find the P4 resource matching the input name.
-    ::util::StatusOr<const T> FindByName(const std::string& name) const {
+    // Same as FindByName, but returns a pointer to the resource in the P4Info.
+    ::util::StatusOr<const T*> FindPtrByName(const std::string& name) const {
       auto iter = name_to_resource_map_.find(name);
       if (iter == name_to_resource_map_.end()) {
         return MAKE_ERROR(ERR_INVALID_P4_INFO)
                << "P4Info " << resource_type_ << " name " << name
                << " is not found";
       }
-      return *iter->second;
+      return iter->second;
     }
 
     // Outputs LOG messages with name to ID translations for all members of
@@ -247,11 +294,44 @@ class P4InfoManager {
                                  << resource_type_ << " name " << name_key;
     }
 
+    // P4 compilers assign the IDs of one resource type mostly consecutively
+    // after a common type prefix. When the IDs are compact enough, this builds
+    // a vector indexed by ID offset that replaces the hash map lookup.
+    void BuildDenseIdIndex() {
+      dense_id_index_.clear();
+      if (id_to_resource_map_.empty()) return;
+      uint32 min_id = id_to_resource_map_.begin()->first;
+      uint32 max_id = min_id;
+      for (const auto& e : id_to_resource_map_) {
+        min_id = std::min(min_id, e.first);
+        max_id = std::max(max_id, e.first);
+      }
+      // Skip sparse ID spaces, they would waste more memory than they save.
+      const uint64 span = static_cast<uint64>(max_id) - min_id + 1;
+      if (span > kMaxDenseIdIndexSlack + 2 * id_to_resource_map_.size()) {
+        return;
+      }
+      dense_id_base_ = min_id;
+      dense_id_index_.assign(span, nullptr);
+      for (const auto& e : id_to_resource_map_) {
+        dense_id_index_[e.first - min_id] = e.second;
+      }
+    }
+
+    // Upper bound for unused slots in the dense ID index beyond twice the
+    // number of resources.
+    static constexpr uint64 kMaxDenseIdIndexSlack = 1024;
+
     const std::string resource_type_;  // String used in errors and logs.
 
     // These maps facilitate lookups from P4 name/ID to resource type T.
     absl::flat_hash_map<uint32, const T*> id_to_resource_map_;
     absl::flat_hash_map<std::string, const T*> name_to_resource_map_;
+
+    // Resource pointers indexed by ID - dense_id_base_, with nullptr for
+    // unused IDs. Empty if the IDs are too sparse, see BuildDenseIdIndex.
+    uint32 dense_id_base_ = 0;
+    std::vector<const T*> dense_id_index_;
   };
 
   // Does common processing of Preamble fields embedded in any resource,
@@ -60,6 +60,36 @@ class P4InfoManagerMock : public P4InfoManager {
   MOCK_CONST_METHOD1(FindRegisterByName,
                      ::util::StatusOr<const ::p4::config::v1::Register>(
                          const std::string& register_name));
+  MOCK_CONST_METHOD1(
+      FindTablePtrByID,
+      ::util::StatusOr<const ::p4::config::v1::Table*>(uint32 table_id));
+  MOCK_CONST_METHOD1(FindTablePtrByName,
+                     ::util::StatusOr<const ::p4::config::v1::Table*>(
+                         const std::string& table_name));
+  MOCK_CONST_METHOD1(
+      FindActionPtrByID,
+      ::util::StatusOr<const ::p4::config::v1::Action*>(uint32 action_id));
+  MOCK_CONST_METHOD1(FindActionPtrByName,
+                     ::util::StatusOr<const ::p4::config::v1::Action*>(
+                         const std::string& action_name));
+  MOCK_CONST_METHOD1(FindActionProfilePtrByID,
+                     ::util::StatusOr<const ::p4::config::v1::ActionProfile*>(
+                         uint32 profile_id));
+  MOCK_CONST_METHOD1(FindActionProfilePtrByName,
+                     ::util::StatusOr<const ::p4::config::v1::ActionProfile*>(
+                         const std::string& profile_name));
+  MOCK_CONST_METHOD1(
+      FindCounterPtrByID,
+      ::util::StatusOr<const ::p4::config::v1::Counter*>(uint32 counter_id));
+  MOCK_CONST_METHOD1(FindCounterPtrByName,
+                     ::util::StatusOr<const ::p4::config::v1::Counter*>(
+                         const std::string& counter_name));
+  MOCK_CONST_METHOD1(
+      FindMeterPtrByID,
+      ::util::StatusOr<const ::p4::config::v1::Meter*>(uint32 meter_id));
+  MOCK_CONST_METHOD1(FindMeterPtrByName,
+                     ::util::StatusOr<const ::p4::config::v1::Meter*>(
+                         const std::string& meter_name));
   MOCK_CONST_METHOD1(
       GetSwitchStackAnnotations,
       ::util::StatusOr<P4Annotation>(const std::string& p4_object_name));
@@ -485,6 +485,60 @@ TEST_F(P4InfoManagerTest, TestFindTableUnknownName) {
   EXPECT_THAT(status.status().error_message(), HasSubstr("not found"));
 }
 
+// The pointer lookups should return the tables owned by the P4InfoManager.
+TEST_F(P4InfoManagerTest, TestFindTablePtr) {
+  SetUpTestP4Tables(false);
+  ASSERT_TRUE(p4_test_manager_->InitializeAndVerify().ok());
+  for (const auto& table : p4_test_manager_->p4_info().tables()) {
+    auto id_status = p4_test_manager_->FindTablePtrByID(table.preamble().id());
+    ASSERT_TRUE(id_status.ok());
+    EXPECT_EQ(&table, id_status.ValueOrDie());
+    auto name_status =
+        p4_test_manager_->FindTablePtrByName(table.preamble().name());
+    ASSERT_TRUE(name_status.ok());
+    EXPECT_EQ(&table, name_status.ValueOrDie());
+  }
+  auto status = p4_test_manager_->FindTablePtrByID(123456);
+  EXPECT_FALSE(status.ok());
+  EXPECT_EQ(ERR_INVALID_P4_INFO, status.status().error_code());
+  EXPECT_THAT(status.status().error_message(), HasSubstr("not found"));
+}
+
+// Verifies ID lookups when the IDs are too sparse for a dense ID index, and
+// for unknown IDs in between and around dense IDs.
+TEST_F(P4InfoManagerTest, TestFindCounterPtrSparseAndDenseIDs) {
+  for (uint32 id : {kFirstCounterID, kFirstCounterID + 2}) {
+    auto new_counter = p4_test_info_.add_counters();
+    new_counter->mutable_preamble()->set_id(id);
+    new_counter->mutable_preamble()->set_name(
+        absl::Substitute("Counter-$0", id));
+  }
+  auto new_meter = p4_test_info_.add_meters();
+  new_meter->mutable_preamble()->set_id(1);
+  new_meter->mutable_preamble()->set_name("Meter-low");
+  new_meter = p4_test_info_.add_meters();
+  new_meter->mutable_preamble()->set_id(0xfffffff0);
+  new_meter->mutable_preamble()->set_name("Meter-high");
+  SetUpNewP4Info();
+  ASSERT_TRUE(p4_test_manager_->InitializeAndVerify().ok());
+
+  for (const auto& counter : p4_test_manager_->p4_info().counters()) {
+    auto status = p4_test_manager_->FindCounterPtrByID(counter.preamble().id());
+    ASSERT_TRUE(status.ok());
+    EXPECT_EQ(&counter, status.ValueOrDie());
+  }
+  EXPECT_FALSE(p4_test_manager_->FindCounterPtrByID(kFirstCounterID - 1).ok());
+  EXPECT_FALSE(p4_test_manager_->FindCounterPtrByID(kFirstCounterID + 1).ok());
+  EXPECT_FALSE(p4_test_manager_->FindCounterPtrByID(kFirstCounterID + 3).ok());
+
+  for (const auto& meter : p4_test_manager_->p4_info().meters()) {
+    auto status = p4_test_manager_->FindMeterPtrByID(meter.preamble().id());
+    ASSERT_TRUE(status.ok());
+    EXPECT_EQ(&meter, status.ValueOrDie());
+  }
+  EXPECT_FALSE(p4_test_manager_->FindMeterPtrByID(2).ok());
+}
+
 // All valid actions in p4_test_info_ should have successful name/ID lookups,
 // and the returned data should match the action's original p4_test_info_ entry.
 TEST_F(P4InfoManagerTest, TestFindAction) {
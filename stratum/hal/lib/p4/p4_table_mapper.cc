@@ -317,8 +317,9 @@ P4TableMapper::~P4TableMapper() { Shutdown().IgnoreError(); }
   // The table should be recognized in the P4Info, and it must contain a
   // valid set of match fields and one action.
   int p4_table_id = table_entry.table_id();
-  ASSIGN_OR_RETURN(::p4::config::v1::Table table_p4_info,
-                   p4_info_manager_->FindTableByID(p4_table_id));
+  ASSIGN_OR_RETURN(const ::p4::config::v1::Table* table_ptr,
+                   p4_info_manager_->FindTablePtrByID(p4_table_id));
+  const ::p4::config::v1::Table& table_p4_info = *table_ptr;
   std::vector<::p4::v1::FieldMatch> all_match_fields;
   RETURN_IF_ERROR(
       PrepareMatchFields(table_p4_info, table_entry, &all_match_fields));
@@ -359,10 +360,10 @@ P4TableMapper::~P4TableMapper() { Shutdown().IgnoreError(); }
                                     << "without valid P4 configuration";
   }
   ASSIGN_OR_RETURN(
-      const ::p4::config::v1::ActionProfile& profile_p4_info,
-      p4_info_manager_->FindActionProfileByID(member.action_profile_id()));
+      const ::p4::config::v1::ActionProfile* profile_p4_info,
+      p4_info_manager_->FindActionProfilePtrByID(member.action_profile_id()));
 
-  return ProcessProfileActionFunction(profile_p4_info, member.action(),
+  return ProcessProfileActionFunction(*profile_p4_info, member.action(),
                                       mapped_action);
 }
 
@@ -378,13 +379,11 @@ P4TableMapper::~P4TableMapper() { Shutdown().IgnoreError(); }
     return MAKE_ERROR(ERR_INTERNAL)
            << "Unable to map ActionProfileGroup without valid P4 configuration";
   }
-  ASSIGN_OR_RETURN(
-      const ::p4::config::v1::ActionProfile& unused_profile_p4_info,
-      p4_info_manager_->FindActionProfileByID(group.action_profile_id()));
+  // The profile only needs to exist in the P4Info.
+  RETURN_IF_ERROR(
+      p4_info_manager_->FindActionProfilePtrByID(group.action_profile_id())
+          .status());
   mapped_action->set_type(P4_ACTION_TYPE_PROFILE_GROUP_ID);
-  // TODO(unknown): Refactor the code in P4InfoManager so that you do not
-  // need to do tricks like this to work around the "unused var" error.
-  VLOG(4) << unused_profile_p4_info.ShortDebugString();
 
   return ::util::OkStatus();
 }
@@ -523,7 +522,9 @@ namespace {
 
 ::util::Status P4TableMapper::LookupTable(
     int table_id, ::p4::config::v1::Table* table) const {
-  ASSIGN_OR_RETURN(*table, p4_info_manager_->FindTableByID(table_id));
+  ASSIGN_OR_RETURN(const ::p4::config::v1::Table* table_p4_info,
+                   p4_info_manager_->FindTablePtrByID(table_id));
+  *table = *table_p4_info;
   return ::util::OkStatus();
 }
 
@@ -918,8 +919,8 @@ P4TableMapper::P4ActionParamMapper::P4ActionParamMapper(
 ::util::Status P4TableMapper::P4ActionParamMapper::AddAction(int table_id,
                                                              int action_id) {
   // The action_id should have P4Info and a p4_global_table_map_ entry.
-  ::p4::config::v1::Action action_info;
-  ASSIGN_OR_RETURN(action_info, p4_info_manager_.FindActionByID(action_id));
+  ASSIGN_OR_RETURN(const ::p4::config::v1::Action* action_info,
+                   p4_info_manager_.FindActionPtrByID(action_id));
   auto iter = p4_global_table_map_.find(action_id);
   if (iter == p4_global_table_map_.end()) {
     return MAKE_ERROR(ERR_OPER_NOT_SUPPORTED)
@@ -933,7 +934,7 @@ P4TableMapper::P4ActionParamMapper::P4ActionParamMapper(
   // parameter when it is referenced by a table or action profile update.
   // The data comes from the action parameter's P4Info and the field descriptor
   // for any header fields affected by modify_field primitives.
-  for (const auto& param_info : action_info.params()) {
+  for (const auto& param_info : action_info->params()) {
     auto desc_status =
         FindParameterDescriptor(param_info.name(), action_descriptor);
     if (!desc_status.ok()) continue;  // TODO(unknown): Append an error.
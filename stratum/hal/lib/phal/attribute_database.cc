@@ -18,9 +18,13 @@
 #include "stratum/lib/constants.h"
 #include "stratum/lib/macros.h"
 #include "stratum/lib/utils.h"
+#include "stratum/lib/work_stealing_threadpool.h"
 
 DEFINE_string(phal_config_file, "",
               "The path to read the PhalInitConfig proto file from.");
+DEFINE_int32(phal_threadpool_size, 8,
+             "Number of threads used to update the PHAL datasources of a "
+             "query in parallel. 0 updates them serially.");
 
 namespace stratum {
 namespace hal {
@@ -186,9 +190,15 @@ AttributeDatabase::~AttributeDatabase() {
 
 ::util::StatusOr<std::unique_ptr<AttributeDatabase>>
 AttributeDatabase::MakePhalDb(std::unique_ptr<AttributeGroup> root_group) {
-  ASSIGN_OR_RETURN(
-      std::unique_ptr<AttributeDatabase> database,
-      Make(std::move(root_group), absl::make_unique<DummyThreadpool>()));
+  std::unique_ptr<ThreadpoolInterface> threadpool;
+  if (FLAGS_phal_threadpool_size > 0) {
+    threadpool =
+        absl::make_unique<WorkStealingThreadpool>(FLAGS_phal_threadpool_size);
+  } else {
+    threadpool = absl::make_unique<DummyThreadpool>();
+  }
+  ASSIGN_OR_RETURN(std::unique_ptr<AttributeDatabase> database,
+                   Make(std::move(root_group), std::move(threadpool)));
 
   // Create and run PhalDb service
   {
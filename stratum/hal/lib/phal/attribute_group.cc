@@ -404,17 +404,22 @@ void AttributeGroupQueryNode::RemoveAllFields() {
   // We can now execute our query in a threadpool.
   ::util::Status output_status;
   absl::Mutex output_status_lock;
+  // Datasources are updated in parallel, but the setters of different
+  // datasources may write to the same message, so they run one at a time.
+  absl::Mutex query_result_lock;
   {
     // We acquire our query lock to avoid messy interleaving with other calls to
     // Get().
     absl::MutexLock l(&query_lock_);
     threadpool_->Start();
-    std::vector<TaskId> task_ids(datasources.size());
+    std::vector<TaskId> task_ids;
+    task_ids.reserve(datasources.size());
     for (auto& datasource_and_attributes : datasources) {
       task_ids.push_back(threadpool_->Schedule([&]() {
         ::util::Status update_status =
             datasource_and_attributes.first->UpdateValuesAndLock();
         if (update_status.ok()) {
+          absl::MutexLock l(&query_result_lock);
           for (auto& attribute_and_setter : datasource_and_attributes.second) {
             update_status = (*attribute_and_setter.second)(
                 attribute_and_setter.first->GetValue());
@@ -4,6 +4,8 @@
 
 #include "stratum/lib/channel/channel.h"
 
+#include <algorithm>
+
 #include "absl/synchronization/mutex.h"
 
 namespace stratum {
@@ -13,36 +15,69 @@ using channel_internal::SelectData;
 
 ::util::StatusOr<SelectResult> Select(const std::vector<ChannelBase*>& channels,
                                       absl::Duration timeout) {
+  Selector selector(channels);
+  RETURN_IF_ERROR(selector.Select(timeout));
   // Create output map;
   auto ready_flags =
       absl::make_unique<std::unordered_map<ChannelBase*, bool>>();
-  // Create and initialize management object.
-  auto select_data = std::make_shared<SelectData>();
-  select_data->done = false;
+  for (size_t i = 0; i < channels.size(); ++i) {
+    (*ready_flags)[channels[i]] = selector.IsReady(i);
+  }
+  return SelectResult(std::move(ready_flags));
+}
+
+Selector::Selector(std::vector<ChannelBase*> channels)
+    : channels_(std::move(channels)),
+      ready_flags_(new bool[channels_.size()]()),
+      select_data_(std::make_shared<SelectData>()) {
+  // No Select() operation is ongoing.
+  select_data_->done = true;
+}
+
+::util::Status Selector::Select(absl::Duration timeout) {
+  // Channels only set the ready flags of an ongoing operation, so they can be
+  // reset without the lock.
+  std::fill(ready_flags_.get(), ready_flags_.get() + channels_.size(), false);
+  {
+    absl::MutexLock l(&select_data_->lock);
+    select_data_->done = false;
+  }
   // Register operation on all of the given Channels.
-  for (auto& channel : channels) {
-    bool& flag = (*ready_flags)[channel] = false;
-    channel->SelectRegister(select_data, &flag);
+  for (size_t i = 0; i < channels_.size(); ++i) {
+    channels_[i]->SelectRegister(select_data_, &ready_flags_[i]);
   }
   absl::Time deadline = absl::Now() + timeout;
-  absl::MutexLock l(&select_data->lock);
+  absl::MutexLock l(&select_data_->lock);
+  ::util::Status status;
   // Wait with timeout until one or more Channels signal data available to read.
-  while (!select_data->done) {
+  while (!select_data_->done) {
     // Check if all Channels involved have been closed, in which case there
     // would be no signal.
-    if (select_data.use_count() == 1) {
-      return MAKE_ERROR(ERR_CANCELLED) << "All Channels have been closed.";
+    if (select_data_.use_count() == 1) {
+      status = MAKE_ERROR(ERR_CANCELLED) << "All Channels have been closed.";
+      break;
     }
     bool expired =
-        select_data->cond.WaitWithDeadline(&select_data->lock, deadline);
+        select_data_->cond.WaitWithDeadline(&select_data_->lock, deadline);
     // If the timer expired without the operation completing, return failure.
-    if (expired && !select_data->done) {
-      return MAKE_ERROR(ERR_ENTRY_NOT_FOUND)
-             << "Read did not succeed within timeout due to empty "
-             << "Channel(s).";
+    if (expired && !select_data_->done) {
+      status = MAKE_ERROR(ERR_ENTRY_NOT_FOUND)
+               << "Read did not succeed within timeout due to empty "
+               << "Channel(s).";
+      break;
     }
   }
-  return SelectResult(std::move(ready_flags));
+  // Stop the Channels which are still registered from setting ready flags
+  // until the next call.
+  select_data_->done = true;
+  return status;
+}
+
+bool Selector::operator()(ChannelBase* channel) const {
+  for (size_t i = 0; i < channels_.size(); ++i) {
+    if (channels_[i] == channel) return ready_flags_[i];
+  }
+  return false;
 }
 
 }  // namespace stratum
@@ -5,8 +5,9 @@
 #ifndef STRATUM_LIB_CHANNEL_CHANNEL_H_
 #define STRATUM_LIB_CHANNEL_CHANNEL_H_
 
+#include <algorithm>
 #include <deque>
-#include <list>
+#include <iterator>
 #include <memory>
 #include <unordered_map>
 #include <utility>
@@ -140,16 +141,36 @@ namespace stratum {
 //     return nullptr;
 //   }
 //
+//   // A thread which selects on the same Channels over and over can use a
+//   // Selector instead, which does not allocate on each call:
+//   Selector selector(channels);
+//   do {
+//     ::util::Status status = selector.Select(timeout);
+//     ...
+//     if (selector(T_channel.get())) { ProcessChannel(T_reader.get()); }
+//     if (selector(U_channel.get())) { ProcessChannel(U_reader.get()); }
+//   } while (1);
+//
+// Example Batch Functions:
+//
+//   // Drain up to 64 messages per lock acquisition. The vector keeps its
+//   // capacity across calls.
+//   std::vector<T> batch;
+//   while (reader->ReadBatch(&batch, 64, timeout).ok()) {
+//     for (auto& t : batch) { ... }
+//   }
+//
 // Notes on Usage:
 //
 // 1. The Channel remains open so long as Close() has not been called. As long
 //    as a valid shared_ptr managing the original Channel instance remains in
 //    scope, more ChannelReaders or ChannelWriters may be added to the Channel.
 //
-// 2. It is recommended to only read from a given Channel from a single thread.
-//    Reading necessarily consumes data which will not be available to other
-//    threads. Additionally, Reading from multiple threads can easily cause
-//    out-of-sender-order processing of messages.
+// 2. Several threads may read from the same Channel, e.g. to spread the
+//    processing of messages over a pool of workers. Reading necessarily
+//    consumes data, so each message is delivered to exactly one reader.
+//    Messages handed to different readers may be processed out of sender
+//    order; read from a single thread if the order matters.
 
 template <typename T>
 class Channel;
@@ -203,6 +224,39 @@ class SelectResult {
     const std::vector<channel_internal::ChannelBase*>& channels,
     absl::Duration timeout);
 
+// A Selector "select"s repeatedly on a fixed set of Channels, with the same
+// semantics as Select(). Unlike Select(), it allocates its state once at
+// construction, so that Select() calls on the hot path of event loops do not
+// allocate. A Selector must only be used by one thread at a time, and the
+// Channel pointers must remain valid during each Select() call.
+class Selector {
+ public:
+  explicit Selector(std::vector<channel_internal::ChannelBase*> channels);
+
+  // Sets the ready flags of the Channels like Select() and returns the same
+  // error codes. The flags are valid until the next call.
+  ::util::Status Select(absl::Duration timeout);
+
+  // Returns the ready flag of the given Channel, false if the Selector does
+  // not select on it.
+  bool operator()(channel_internal::ChannelBase* channel) const;
+
+  // Returns the ready flag of the i-th Channel given at construction.
+  bool IsReady(size_t i) const { return ready_flags_[i]; }
+
+  // Disallow copy and assign.
+  Selector(const Selector&) = delete;
+  Selector& operator=(const Selector&) = delete;
+
+ private:
+  const std::vector<channel_internal::ChannelBase*> channels_;
+  // Ready flag of each Channel. Channels set them while select_data_ is not
+  // done, which only happens during Select().
+  std::unique_ptr<bool[]> ready_flags_;
+  // Shared with the Channels this Selector is registered on.
+  const std::shared_ptr<channel_internal::SelectData> select_data_;
+};
+
 // TODO(unknown): add support for optional en/dequeue timestamping.
 template <typename T>
 class Channel : public channel_internal::ChannelBase {
@@ -248,6 +302,15 @@ class Channel : public channel_internal::ChannelBase {
   virtual ::util::Status TryWrite(const T& t) LOCKS_EXCLUDED(queue_lock_);
   virtual ::util::Status TryWrite(T&& t) LOCKS_EXCLUDED(queue_lock_);
 
+  // Moves the elements of t_s into the Channel in order. As long as the queue
+  // has room for them, all elements are enqueued under a single lock
+  // acquisition. Blocks while the queue is full until the timeout, then
+  // returns ERR_NO_RESOURCE. Returns ERR_CANCELLED if the Channel is closed.
+  // The enqueued elements are removed from t_s, so on error t_s holds the
+  // elements which have not been written.
+  virtual ::util::Status WriteBatch(std::vector<T>* t_s, absl::Duration timeout)
+      LOCKS_EXCLUDED(queue_lock_);
+
   // Reads and pops the first element of the queue into t. Returns ERR_SUCCESS
   // on successful dequeue. Blocks if the queue is empty until the timeout, then
   // returns ERR_ENTRY_NOT_FOUND. Returns ERR_CANCELED if Channel is closed and
@@ -265,13 +328,22 @@ class Channel : public channel_internal::ChannelBase {
   virtual ::util::Status ReadAll(std::vector<T>* t_s)
       LOCKS_EXCLUDED(queue_lock_);
 
+  // Reads and pops up to max_count elements of the queue into t_s, replacing
+  // its contents, under a single lock acquisition. Blocks like Read() if the
+  // queue is empty and returns the same error codes. The capacity of t_s is
+  // kept, so reusing the vector across calls avoids allocations.
+  virtual ::util::Status ReadBatch(std::vector<T>* t_s, size_t max_count,
+                                   absl::Duration timeout)
+      LOCKS_EXCLUDED(queue_lock_);
+
   // Checks whether there are any elements enqueued in the Channel. If true,
   // sets both done and ready to true and returns ERR_SUCCESS. If the Channel
   // is closed, returns ERR_CANCELLED.
   //
   // If the queue is empty, adds the select_data object as well as the ready
-  // flag to an internal list. Once a new message is enqueued, all existing list
-  // items are notified and removed from the list.
+  // flag to an internal list, or updates the ready flag if select_data is on
+  // the list already. Once a new message is enqueued, all existing list items
+  // are notified and removed from the list.
   void SelectRegister(
       const std::shared_ptr<channel_internal::SelectData>& select_data,
       bool* ready) LOCKS_EXCLUDED(queue_lock_) override;
@@ -280,7 +352,13 @@ class Channel : public channel_internal::ChannelBase {
   // Helper function used by both variants of Write(). Checks if Channel state
   // is closed and blocks if the internal queue is full. Returns OK or the error
   // statuses described above.
-  ::util::Status CheckWriteStateAndBlock(absl::Duration timeout)
+  ::util::Status CheckWriteStateAndBlock(absl::Time deadline)
+      EXCLUSIVE_LOCKS_REQUIRED(queue_lock_);
+
+  // Helper function used by Read() and ReadBatch(). Checks if Channel state is
+  // closed and blocks if the internal queue is empty. Returns OK or the error
+  // statuses described above.
+  ::util::Status CheckReadStateAndBlock(absl::Time deadline)
       EXCLUSIVE_LOCKS_REQUIRED(queue_lock_);
 
   // Helper function used by both variants of TryWrite(). Checks Channel state
@@ -291,13 +369,16 @@ class Channel : public channel_internal::ChannelBase {
   // Helper function used by the Write()s and Close() on successful operation.
   // Pops each element on the select list, setting the corresponding done and
   // ready flags to the given value and signaling their condition variables.
+  // Select operations which are done already are left untouched.
   void ClearSelectList(bool ready) EXCLUSIVE_LOCKS_REQUIRED(queue_lock_);
 
   // Mutex to protect internal queue of the Channel and state.
   mutable absl::Mutex queue_lock_;
   std::deque<T> queue_ GUARDED_BY(queue_lock_);
   bool closed_ GUARDED_BY(queue_lock_);
-  std::list<std::pair<std::shared_ptr<channel_internal::SelectData>, bool>>
+  // A vector rather than a list, so that registering a Select operation does
+  // not allocate once the vector has grown.
+  std::vector<std::pair<std::shared_ptr<channel_internal::SelectData>, bool*>>
       select_list_ GUARDED_BY(queue_lock_);
 
   // Maximum queue depth.
@@ -335,6 +416,10 @@ class ChannelReader {
   virtual ::util::Status ReadAll(std::vector<T>* t_s) {
     return channel_->ReadAll(t_s);
   }
+  virtual ::util::Status ReadBatch(std::vector<T>* t_s, size_t max_count,
+                                   absl::Duration timeout) {
+    return channel_->ReadBatch(t_s, max_count, timeout);
+  }
   virtual bool IsClosed() { return channel_->IsClosed(); }
 
   // Disallow copy and assign.
@@ -379,6 +464,10 @@ class ChannelWriter {
   virtual ::util::Status TryWrite(T&& t) {
     return channel_->TryWrite(std::move(t));
   }
+  virtual ::util::Status WriteBatch(std::vector<T>* t_s,
+                                    absl::Duration timeout) {
+    return channel_->WriteBatch(t_s, timeout);
+  }
   virtual bool IsClosed() { return channel_->IsClosed(); }
 
   // Disallow copy and assign.
@@ -421,7 +510,7 @@ template <typename T>
 ::util::Status Channel<T>::Write(const T& t, absl::Duration timeout) {
   absl::MutexLock l(&queue_lock_);
   // Check internal state, blocking with timeout if queue is full.
-  RETURN_IF_ERROR(CheckWriteStateAndBlock(timeout));
+  RETURN_IF_ERROR(CheckWriteStateAndBlock(absl::Now() + timeout));
   // Enqueue message.
   queue_.push_back(t);
   // Signal next blocked ChannelReader.
@@ -435,7 +524,7 @@ template <typename T>
 ::util::Status Channel<T>::Write(T&& t, absl::Duration timeout) {
   absl::MutexLock l(&queue_lock_);
   // Check internal state, blocking with timeout if queue is full.
-  RETURN_IF_ERROR(CheckWriteStateAndBlock(timeout));
+  RETURN_IF_ERROR(CheckWriteStateAndBlock(absl::Now() + timeout));
   // Enqueue message.
   queue_.push_back(std::move(t));
   // Signal next blocked ChannelReader.
@@ -446,13 +535,43 @@ template <typename T>
 }
 
 template <typename T>
-::util::Status Channel<T>::CheckWriteStateAndBlock(absl::Duration timeout) {
+::util::Status Channel<T>::WriteBatch(std::vector<T>* t_s,
+                                      absl::Duration timeout) {
+  absl::MutexLock l(&queue_lock_);
+  absl::Time deadline = absl::Now() + timeout;
+  ::util::Status status;
+  size_t written = 0;
+  while (written < t_s->size()) {
+    // Check internal state, blocking with timeout if queue is full.
+    status = CheckWriteStateAndBlock(deadline);
+    if (!status.ok()) break;
+    // Enqueue as many messages as fit.
+    size_t count =
+        std::min(t_s->size() - written, max_depth_ - queue_.size());
+    auto first = t_s->begin() + written;
+    std::move(first, first + count, std::back_inserter(queue_));
+    written += count;
+    // Signal as many blocked ChannelReaders as needed to consume the
+    // messages.
+    if (count == 1) {
+      cond_not_empty_.Signal();
+    } else {
+      cond_not_empty_.SignalAll();
+    }
+    // Signal any Select()-ing threads..
+    ClearSelectList(true);
+  }
+  t_s->erase(t_s->begin(), t_s->begin() + written);
+  return status;
+}
+
+template <typename T>
+::util::Status Channel<T>::CheckWriteStateAndBlock(absl::Time deadline) {
   // Check Channel closure. If closed, there will be no signal.
   if (closed_) return MAKE_ERROR(ERR_CANCELLED) << "Channel is closed.";
   // Wait with timeout for non-full internal buffer. While is required as
   // signals may be delivered without an actual call to Signal() or
   // SignallAll().
-  absl::Time deadline = absl::Now() + timeout;
   while (queue_.size() == max_depth_) {
     bool expired = cond_not_full_.WaitWithDeadline(&queue_lock_, deadline);
     // Could have been signalled because Channel is now closed.
@@ -521,28 +640,25 @@ template <typename T>
 
 template <typename T>
 void Channel<T>::ClearSelectList(bool ready) {
-  while (!select_list_.empty()) {
-    auto& pair = select_list_.front();
-    {
-      // Set select done flag and Channel ready flag and signal Select()-ing
-      // thread.
-      pair.second = ready;
-      absl::MutexLock sel_lock(&pair.first->lock);
-      pair.first->done = ready;
-      pair.first->cond.Signal();
-    }
-    select_list_.pop_front();
+  for (auto& pair : select_list_) {
+    // Set select done flag and Channel ready flag and signal Select()-ing
+    // thread. The Select() operation may have returned already, in which case
+    // the ready flag must not be touched anymore.
+    absl::MutexLock sel_lock(&pair.first->lock);
+    if (pair.first->done) continue;
+    *pair.second = ready;
+    pair.first->done = ready;
+    pair.first->cond.Signal();
   }
+  select_list_.clear();
 }
 
 template <typename T>
-::util::Status Channel<T>::Read(T* t, absl::Duration timeout) {
-  absl::MutexLock l(&queue_lock_);
+::util::Status Channel<T>::CheckReadStateAndBlock(absl::Time deadline) {
   // Check Channel closure. If closed, will not be signaled during wait.
   if (closed_)
     return MAKE_ERROR(ERR_CANCELLED).without_logging() << "Channel is closed.";
   // Wait with timeout for non-empty internal buffer.
-  absl::Time deadline = absl::Now() + timeout;
   while (queue_.empty()) {
     bool expired = cond_not_empty_.WaitWithDeadline(&queue_lock_, deadline);
     // Could have been signalled because Channel is now closed.
@@ -555,6 +671,14 @@ template <typename T>
              << "Read did not succeed within timeout due to empty Channel.";
     }
   }
+  return ::util::OkStatus();
+}
+
+template <typename T>
+::util::Status Channel<T>::Read(T* t, absl::Duration timeout) {
+  absl::MutexLock l(&queue_lock_);
+  // Check internal state, blocking with timeout if queue is empty.
+  RETURN_IF_ERROR(CheckReadStateAndBlock(absl::Now() + timeout));
   // Dequeue message.
   *t = std::move(queue_.front());
   queue_.pop_front();
@@ -595,6 +719,29 @@ template <typename T>
   return ::util::OkStatus();
 }
 
+template <typename T>
+::util::Status Channel<T>::ReadBatch(std::vector<T>* t_s, size_t max_count,
+                                     absl::Duration timeout) {
+  if (max_count == 0) {
+    return MAKE_ERROR(ERR_INVALID_PARAM) << "max_count must be positive.";
+  }
+  absl::MutexLock l(&queue_lock_);
+  // Check internal state, blocking with timeout if queue is empty.
+  RETURN_IF_ERROR(CheckReadStateAndBlock(absl::Now() + timeout));
+  // Dequeue up to max_count messages.
+  size_t count = std::min(max_count, queue_.size());
+  t_s->clear();
+  std::move(queue_.begin(), queue_.begin() + count, std::back_inserter(*t_s));
+  queue_.erase(queue_.begin(), queue_.begin() + count);
+  // Signal as many blocked ChannelWriters as there is room for.
+  if (count == 1) {
+    cond_not_full_.Signal();
+  } else {
+    cond_not_full_.SignalAll();
+  }
+  return ::util::OkStatus();
+}
+
 template <typename T>
 void Channel<T>::SelectRegister(
     const std::shared_ptr<channel_internal::SelectData>& select_data,
@@ -607,6 +754,13 @@ void Channel<T>::SelectRegister(
   if (queue_.empty()) {
     // Only enqueue a copy of select_data if the operation is not done.
     if (!select_data->done) {
+      // A Selector stays on the list after a Select() call which timed out.
+      for (auto& pair : select_list_) {
+        if (pair.first == select_data) {
+          pair.second = ready;
+          return;
+        }
+      }
       select_list_.push_back(std::make_pair(select_data, ready));
     }
   } else {
@@ -0,0 +1,157 @@
+// Copyright 2018-present Open Networking Foundation
+// SPDX-License-Identifier: Apache-2.0
+
+// Compares the throughput of the single-element and batch Channel operations
+// and of Select() and Selector, with one producer and one consumer thread.
+
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "gflags/gflags.h"
+#include "gtest/gtest.h"
+#include "stratum/glue/integral_types.h"
+#include "stratum/glue/logging.h"
+#include "stratum/glue/status/status_test_util.h"
+#include "stratum/lib/channel/channel.h"
+
+DEFINE_int32(channel_benchmark_num_messages, 1000000,
+             "Number of messages sent through the Channel.");
+DEFINE_int32(channel_benchmark_batch_size, 64,
+             "Maximum number of messages per batch operation.");
+DEFINE_int32(channel_benchmark_max_depth, 1024,
+             "Maximum queue depth of the Channel.");
+
+namespace stratum {
+namespace {
+
+using channel_internal::ChannelBase;
+
+// Logs the throughput of a run which moved num_messages in elapsed.
+void LogThroughput(const std::string& name, int num_messages,
+                   absl::Duration elapsed) {
+  LOG(INFO) << name << ": " << num_messages << " messages in "
+            << absl::FormatDuration(elapsed) << ", "
+            << num_messages / absl::ToDoubleSeconds(elapsed)
+            << " messages/s.";
+}
+
+TEST(ChannelBenchmark, ReadWriteThroughput) {
+  const int num_messages = FLAGS_channel_benchmark_num_messages;
+  std::shared_ptr<Channel<int>> channel =
+      Channel<int>::Create(FLAGS_channel_benchmark_max_depth);
+  auto reader = ChannelReader<int>::Create(channel);
+  auto writer = ChannelWriter<int>::Create(channel);
+
+  const absl::Time start = absl::Now();
+  std::thread producer([&writer, num_messages]() {
+    for (int i = 0; i < num_messages; ++i) {
+      ASSERT_OK(writer->Write(i, absl::InfiniteDuration()));
+    }
+  });
+  int64 sum = 0;
+  for (int i = 0; i < num_messages; ++i) {
+    int value;
+    ASSERT_OK(reader->Read(&value, absl::InfiniteDuration()));
+    sum += value;
+  }
+  const absl::Duration elapsed = absl::Now() - start;
+  producer.join();
+  EXPECT_EQ(int64{num_messages} * (num_messages - 1) / 2, sum);
+  LogThroughput("Read/Write", num_messages, elapsed);
+}
+
+TEST(ChannelBenchmark, ReadBatchWriteBatchThroughput) {
+  const int num_messages = FLAGS_channel_benchmark_num_messages;
+  const int batch_size = FLAGS_channel_benchmark_batch_size;
+  std::shared_ptr<Channel<int>> channel =
+      Channel<int>::Create(FLAGS_channel_benchmark_max_depth);
+  auto reader = ChannelReader<int>::Create(channel);
+  auto writer = ChannelWriter<int>::Create(channel);
+
+  const absl::Time start = absl::Now();
+  std::thread producer([&writer, num_messages, batch_size]() {
+    std::vector<int> batch;
+    batch.reserve(batch_size);
+    for (int i = 0; i < num_messages; ++i) {
+      batch.push_back(i);
+      if (batch.size() == static_cast<size_t>(batch_size) ||
+          i == num_messages - 1) {
+        ASSERT_OK(writer->WriteBatch(&batch, absl::InfiniteDuration()));
+      }
+    }
+  });
+  int64 sum = 0;
+  int received = 0;
+  std::vector<int> batch;
+  while (received < num_messages) {
+    ASSERT_OK(
+        reader->ReadBatch(&batch, batch_size, absl::InfiniteDuration()));
+    for (int value : batch) sum += value;
+    received += batch.size();
+  }
+  const absl::Duration elapsed = absl::Now() - start;
+  producer.join();
+  EXPECT_EQ(int64{num_messages} * (num_messages - 1) / 2, sum);
+  LogThroughput("ReadBatch/WriteBatch", num_messages, elapsed);
+}
+
+// Runs an event loop which selects on two Channels, one of which never
+// receives messages, and drains the other one. select_fn selects and returns
+// whether the busy Channel is ready.
+template <typename SelectFn>
+void RunSelectLoop(const std::string& name, SelectFn select_fn,
+                   ChannelReader<int>* reader, ChannelWriter<int>* writer) {
+  const int num_messages = FLAGS_channel_benchmark_num_messages;
+  const absl::Time start = absl::Now();
+  std::thread producer([writer, num_messages]() {
+    for (int i = 0; i < num_messages; ++i) {
+      ASSERT_OK(writer->Write(i, absl::InfiniteDuration()));
+    }
+  });
+  int received = 0;
+  std::vector<int> batch;
+  while (received < num_messages) {
+    if (!select_fn()) continue;
+    ASSERT_OK(reader->ReadBatch(&batch, FLAGS_channel_benchmark_batch_size,
+                                absl::InfiniteDuration()));
+    received += batch.size();
+  }
+  const absl::Duration elapsed = absl::Now() - start;
+  producer.join();
+  LogThroughput(name, num_messages, elapsed);
+}
+
+TEST(ChannelBenchmark, SelectThroughput) {
+  std::shared_ptr<Channel<int>> channel =
+      Channel<int>::Create(FLAGS_channel_benchmark_max_depth);
+  std::shared_ptr<Channel<int>> idle_channel = Channel<int>::Create(1);
+  auto reader = ChannelReader<int>::Create(channel);
+  auto writer = ChannelWriter<int>::Create(channel);
+  const std::vector<ChannelBase*> channels = {channel.get(),
+                                              idle_channel.get()};
+
+  RunSelectLoop(
+      "Select",
+      [&channels, &channel]() {
+        auto status_or_ready = Select(channels, absl::InfiniteDuration());
+        return status_or_ready.ok() &&
+               status_or_ready.ValueOrDie()(channel.get());
+      },
+      reader.get(), writer.get());
+
+  Selector selector(channels);
+  RunSelectLoop(
+      "Selector",
+      [&selector]() {
+        return selector.Select(absl::InfiniteDuration()).ok() &&
+               selector.IsReady(0);
+      },
+      reader.get(), writer.get());
+}
+
+}  // namespace
+}  // namespace stratum
@@ -7,8 +7,11 @@
 #include <pthread.h>
 #include <unistd.h>
 
+#include <atomic>
 #include <set>
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 
 #include "absl/synchronization/mutex.h"
 #include "gmock/gmock.h"
@@ -604,4 +607,134 @@ TEST(ChannelTest, SelectStressTest) {
   EXPECT_EQ(src_copy, dst);
 }
 
+TEST(ChannelTest, ReadBatchWriteBatch) {
+  std::shared_ptr<Channel<int>> channel = Channel<int>::Create(4);
+  auto reader = ChannelReader<int>::Create(channel);
+  auto writer = ChannelWriter<int>::Create(channel);
+
+  std::vector<int> batch = {1, 2, 3};
+  EXPECT_OK(writer->WriteBatch(&batch, absl::InfiniteDuration()));
+  EXPECT_TRUE(batch.empty());
+  // Only the first element fits, the others are left in the batch.
+  batch = {4, 5, 6};
+  EXPECT_EQ(ERR_NO_RESOURCE,
+            writer->WriteBatch(&batch, absl::Milliseconds(100)).error_code());
+  EXPECT_EQ(std::vector<int>({5, 6}), batch);
+
+  EXPECT_EQ(ERR_INVALID_PARAM,
+            reader->ReadBatch(&batch, 0, absl::InfiniteDuration())
+                .error_code());
+  EXPECT_OK(reader->ReadBatch(&batch, 3, absl::InfiniteDuration()));
+  EXPECT_EQ(std::vector<int>({1, 2, 3}), batch);
+  EXPECT_OK(reader->ReadBatch(&batch, 3, absl::InfiniteDuration()));
+  EXPECT_EQ(std::vector<int>({4}), batch);
+  EXPECT_EQ(ERR_ENTRY_NOT_FOUND,
+            reader->ReadBatch(&batch, 3, absl::Milliseconds(100))
+                .error_code());
+
+  EXPECT_TRUE(channel->Close());
+  batch = {7};
+  EXPECT_EQ(ERR_CANCELLED,
+            writer->WriteBatch(&batch, absl::InfiniteDuration()).error_code());
+  EXPECT_EQ(ERR_CANCELLED,
+            reader->ReadBatch(&batch, 3, absl::InfiniteDuration())
+                .error_code());
+}
+
+// Writes batches larger than the queue depth, which block until the readers
+// make room. Several readers consume the batches concurrently and each message
+// must be read exactly once.
+TEST(ChannelTest, MultiConsumerBatchStressTest) {
+  const int kNumWriters = 2;
+  const int kNumReaders = 4;
+  const int kNumBatches = 200;
+  const int kBatchSize = 3 * kMaxDepth;
+  std::shared_ptr<Channel<int>> channel = Channel<int>::Create(kMaxDepth);
+  std::vector<std::thread> writer_threads;
+  for (int i = 0; i < kNumWriters; ++i) {
+    std::shared_ptr<ChannelWriter<int>> writer =
+        ChannelWriter<int>::Create(channel);
+    writer_threads.emplace_back([writer, i, kNumBatches, kBatchSize]() {
+      std::vector<int> batch;
+      for (int j = 0; j < kNumBatches; ++j) {
+        for (int k = 0; k < kBatchSize; ++k) {
+          batch.push_back((i * kNumBatches + j) * kBatchSize + k);
+        }
+        EXPECT_OK(writer->WriteBatch(&batch, absl::InfiniteDuration()));
+      }
+    });
+  }
+  const int kTotal = kNumWriters * kNumBatches * kBatchSize;
+  std::vector<std::vector<int>> read(kNumReaders);
+  std::atomic<int> total_read(0);
+  std::vector<std::thread> reader_threads;
+  for (int i = 0; i < kNumReaders; ++i) {
+    std::shared_ptr<ChannelReader<int>> reader =
+        ChannelReader<int>::Create(channel);
+    std::vector<int>* dst = &read[i];
+    reader_threads.emplace_back([reader, dst, &total_read]() {
+      std::vector<int> batch;
+      while (reader->ReadBatch(&batch, 7, absl::InfiniteDuration()).ok()) {
+        dst->insert(dst->end(), batch.begin(), batch.end());
+        total_read += batch.size();
+      }
+    });
+  }
+  for (auto& thread : writer_threads) thread.join();
+  while (total_read < kTotal) absl::SleepFor(absl::Milliseconds(1));
+  channel->Close();
+  for (auto& thread : reader_threads) thread.join();
+
+  std::set<int> dst;
+  for (const auto& values : read) dst.insert(values.begin(), values.end());
+  EXPECT_EQ(kTotal, total_read);
+  EXPECT_EQ(kTotal, dst.size());
+}
+
+TEST(ChannelTest, BasicSelectorTest) {
+  std::shared_ptr<Channel<int>> int_channel = Channel<int>::Create(2);
+  auto int_writer = ChannelWriter<int>::Create(int_channel);
+  auto int_reader = ChannelReader<int>::Create(int_channel);
+  std::shared_ptr<Channel<std::string>> str_channel =
+      Channel<std::string>::Create(2);
+  auto str_writer = ChannelWriter<std::string>::Create(str_channel);
+  Selector selector({int_channel.get(), str_channel.get()});
+
+  // The same Selector is used for all calls.
+  EXPECT_EQ(ERR_ENTRY_NOT_FOUND,
+            selector.Select(absl::Milliseconds(100)).error_code());
+  EXPECT_FALSE(selector(int_channel.get()));
+  EXPECT_FALSE(selector(str_channel.get()));
+  EXPECT_OK(int_writer->TryWrite(1));
+  EXPECT_OK(selector.Select(absl::InfiniteDuration()));
+  EXPECT_TRUE(selector(int_channel.get()));
+  EXPECT_TRUE(selector.IsReady(0));
+  EXPECT_FALSE(selector(str_channel.get()));
+  EXPECT_FALSE(selector.IsReady(1));
+  int dummy = 0;
+  EXPECT_OK(int_reader->TryRead(&dummy));
+
+  // A blocked Select() learns which Channel became ready.
+  std::thread writer_thread([&str_writer]() {
+    absl::SleepFor(absl::Milliseconds(50));
+    EXPECT_OK(str_writer->TryWrite("1"));
+  });
+  EXPECT_OK(selector.Select(absl::InfiniteDuration()));
+  writer_thread.join();
+  EXPECT_FALSE(selector(int_channel.get()));
+  EXPECT_TRUE(selector(str_channel.get()));
+
+  // Unknown Channels are never ready.
+  EXPECT_FALSE(selector(nullptr));
+
+  EXPECT_TRUE(str_channel->Close());
+  EXPECT_OK(int_writer->TryWrite(2));
+  EXPECT_OK(selector.Select(absl::InfiniteDuration()));
+  EXPECT_TRUE(selector(int_channel.get()));
+  EXPECT_FALSE(selector(str_channel.get()));
+  EXPECT_TRUE(int_channel->Close());
+  EXPECT_EQ(ERR_CANCELLED,
+            selector.Select(absl::InfiniteDuration()).error_code());
+}
+
 }  // namespace stratum
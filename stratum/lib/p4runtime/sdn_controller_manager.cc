@@ -5,21 +5,42 @@
 #include "stratum/lib/p4runtime/sdn_controller_manager.h"
 
 #include <algorithm>
+#include <utility>
 
 #include "absl/numeric/int128.h"
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
+#include "absl/time/clock.h"
 #include "absl/types/optional.h"
+#include "gflags/gflags.h"
 #include "glog/logging.h"
 #include "p4/v1/p4runtime.pb.h"
 #include "stratum/hal/lib/p4/utils.h"
 
+DEFINE_uint32(p4rt_stream_send_queue_size, 1024,
+              "Maximum number of PacketIns queued per P4Runtime stream "
+              "connection. 0 writes stream messages synchronously.");
+DEFINE_string(p4rt_stream_send_queue_drop_policy, "drop_oldest",
+              "PacketIn drop policy of a full P4Runtime stream send queue. "
+              "One of 'drop_oldest' or 'drop_newest'.");
+
 namespace stratum {
 namespace p4runtime {
 namespace {
 
+SendQueueDropPolicy SendQueueDropPolicyFromFlag() {
+  if (FLAGS_p4rt_stream_send_queue_drop_policy == "drop_newest") {
+    return SendQueueDropPolicy::kDropNewest;
+  }
+  LOG_IF(ERROR, FLAGS_p4rt_stream_send_queue_drop_policy != "drop_oldest")
+      << "Unknown --p4rt_stream_send_queue_drop_policy '"
+      << FLAGS_p4rt_stream_send_queue_drop_policy
+      << "', using 'drop_oldest'.";
+  return SendQueueDropPolicy::kDropOldest;
+}
+
 std::string PrettyPrintRoleName(const absl::optional<std::string>& name) {
   return (name.has_value()) ? absl::StrCat("'", *name, "'") : "<default>";
 }
@@ -303,6 +324,33 @@ grpc::Status VerifyRoleCanAccessIds(
 
 }  // namespace
 
+SdnConnection::SdnConnection(
+    grpc::ServerContext* context,
+    grpc::ServerReaderWriterInterface<p4::v1::StreamMessageResponse,
+                                      p4::v1::StreamMessageRequest>* stream)
+    : SdnConnection(context, stream, FLAGS_p4rt_stream_send_queue_size,
+                    SendQueueDropPolicyFromFlag()) {}
+
+SdnConnection::SdnConnection(
+    grpc::ServerContext* context,
+    grpc::ServerReaderWriterInterface<p4::v1::StreamMessageResponse,
+                                      p4::v1::StreamMessageRequest>* stream,
+    size_t send_queue_size, SendQueueDropPolicy drop_policy)
+    : initialized_(false),
+      grpc_context_(context),
+      grpc_stream_(stream),
+      send_queue_size_(send_queue_size),
+      drop_policy_(drop_policy),
+      queued_packet_ins_(0),
+      shutdown_(false),
+      write_in_progress_(false) {
+  if (send_queue_size_ > 0) {
+    writer_thread_ = std::thread(&SdnConnection::WriterThreadFunc, this);
+  }
+}
+
+SdnConnection::~SdnConnection() { Shutdown(); }
+
 void SdnConnection::SetElectionId(const absl::optional<absl::uint128>& id) {
   election_id_ = id;
 }
@@ -328,10 +376,124 @@ std::string SdnConnection::GetName() const {
 void SdnConnection::SendStreamMessageResponse(
     const p4::v1::StreamMessageResponse& response) {
   VLOG(2) << "Sending response: " << response.ShortDebugString();
-  if (!grpc_stream_->Write(response)) {
+  const absl::Time now = absl::Now();
+  if (send_queue_size_ == 0) {
+    absl::MutexLock w(&write_lock_);
+    {
+      absl::MutexLock l(&queue_lock_);
+      if (shutdown_) {
+        ++stats_.dropped;
+        return;
+      }
+      ++stats_.enqueued;
+      write_in_progress_ = true;
+    }
+    WriteToStream(response, now);
+    return;
+  }
+
+  absl::MutexLock l(&queue_lock_);
+  if (shutdown_) {
+    ++stats_.dropped;
+    return;
+  }
+  // Only PacketIns are ever dropped. Losing an arbitration update or any other
+  // control message would leave the controller with a wrong view of the
+  // switch, and those are rare enough to not need a bound.
+  const bool is_packet_in =
+      response.update_case() == p4::v1::StreamMessageResponse::kPacket;
+  if (is_packet_in && queued_packet_ins_ >= send_queue_size_) {
+    ++stats_.dropped;
+    LOG_EVERY_N(WARNING, 1000)
+        << "Send queue of SDN connection to gRPC context '" << grpc_context_
+        << "' is full, dropping PacketIn (" << google::COUNTER
+        << " drops so far).";
+    if (drop_policy_ == SendQueueDropPolicy::kDropNewest) return;
+    auto oldest = std::find_if(
+        send_queue_.begin(), send_queue_.end(), [](const QueuedMessage& m) {
+          return m.response.update_case() ==
+                 p4::v1::StreamMessageResponse::kPacket;
+        });
+    send_queue_.erase(oldest);
+    --queued_packet_ins_;
+  }
+  send_queue_.push_back(QueuedMessage{response, now});
+  if (is_packet_in) ++queued_packet_ins_;
+  ++stats_.enqueued;
+}
+
+void SdnConnection::Shutdown() {
+  {
+    absl::MutexLock l(&queue_lock_);
+    if (!shutdown_) {
+      shutdown_ = true;
+      stats_.dropped += send_queue_.size();
+      send_queue_.clear();
+      queued_packet_ins_ = 0;
+    }
+    // No new writes start after shutdown_ is set. A write that is still in
+    // progress can block forever on a stalled client, so cancel the RPC to
+    // make it return before waiting for it below.
+    if (write_in_progress_) CancelRpc();
+  }
+  // Wait for a write that might still be in progress.
+  { absl::MutexLock l(&write_lock_); }
+  if (writer_thread_.joinable()) writer_thread_.join();
+}
+
+void SdnConnection::CancelRpc() {
+  LOG(WARNING) << "Cancelling stream of gRPC context '" << grpc_context_
+               << "' with a pending write.";
+  grpc_context_->TryCancel();
+}
+
+SdnConnection::SendQueueStats SdnConnection::GetSendQueueStats() const {
+  absl::MutexLock l(&queue_lock_);
+  return stats_;
+}
+
+bool SdnConnection::SendQueueReadyOrShutdown() const {
+  return shutdown_ || !send_queue_.empty();
+}
+
+void SdnConnection::WriterThreadFunc() {
+  while (true) {
+    QueuedMessage message;
+    {
+      absl::MutexLock l(&queue_lock_);
+      queue_lock_.Await(
+          absl::Condition(this, &SdnConnection::SendQueueReadyOrShutdown));
+      if (shutdown_) return;
+      message = std::move(send_queue_.front());
+      send_queue_.pop_front();
+      write_in_progress_ = true;
+      if (message.response.update_case() ==
+          p4::v1::StreamMessageResponse::kPacket) {
+        --queued_packet_ins_;
+      }
+    }
+    absl::MutexLock l(&write_lock_);
+    WriteToStream(message.response, message.enqueue_time);
+  }
+}
+
+void SdnConnection::WriteToStream(const p4::v1::StreamMessageResponse& response,
+                                  absl::Time enqueue_time) {
+  const bool success = grpc_stream_->Write(response);
+  const absl::Duration latency = absl::Now() - enqueue_time;
+  if (!success) {
     LOG(ERROR) << "Could not send stream message response to gRPC context '"
                << grpc_context_ << "': " << response.ShortDebugString();
   }
+  absl::MutexLock l(&queue_lock_);
+  write_in_progress_ = false;
+  if (success) {
+    ++stats_.sent;
+  } else {
+    ++stats_.write_failures;
+  }
+  stats_.total_latency += latency;
+  stats_.max_latency = std::max(stats_.max_latency, latency);
 }
 
 grpc::Status SdnControllerManager::HandleArbitrationUpdate(
@@ -485,6 +647,7 @@ grpc::Status SdnControllerManager::HandleArbitrationUpdate(
                 << PrettyPrintElectionId(new_election_id_for_connection);
     }
   }
+  UpdatePrimaryConnections();
 
   return grpc::Status::OK;
 }
@@ -513,6 +676,9 @@ void SdnControllerManager::Disconnect(SdnConnection* connection) {
     }
   }
 
+  // Once this returns no sender holds a reference to the connection anymore.
+  UpdatePrimaryConnections();
+
   // If connection was the primary connection we need to inform all existing
   // connections.
   if (was_primary) {
@@ -735,6 +901,21 @@ bool SdnControllerManager::PrimaryConnectionExists(
   return false;
 }
 
+void SdnControllerManager::UpdatePrimaryConnections() {
+  std::vector<PrimaryConnection> primary_connections;
+  for (const auto& connection : connections_) {
+    const auto& election_id_past_for_role =
+        election_id_past_by_role_[connection->GetRoleName()];
+    if (election_id_past_for_role.has_value() &&
+        election_id_past_for_role == connection->GetElectionId()) {
+      primary_connections.push_back(
+          {connection, role_config_by_name_[connection->GetRoleName()]});
+    }
+  }
+  absl::MutexLock l(&primary_connections_lock_);
+  primary_connections_.swap(primary_connections);
+}
+
 void SdnControllerManager::SendArbitrationResponse(SdnConnection* connection) {
   p4::v1::StreamMessageResponse response;
   auto arbitration = response.mutable_arbitration();
@@ -799,24 +980,17 @@ absl::Status SdnControllerManager::SendPacketInToPrimary(
 
 absl::Status SdnControllerManager::SendStreamMessageToPrimary(
     const p4::v1::StreamMessageResponse& response) {
-  absl::MutexLock l(&lock_);
+  absl::ReaderMutexLock l(&primary_connections_lock_);
 
   bool found_at_least_one_primary = false;
 
-  for (const auto& connection : connections_) {
-    absl::optional<absl::uint128> election_id_past_for_role =
-        election_id_past_by_role_[connection->GetRoleName()];
-    if (election_id_past_for_role.has_value() &&
-        election_id_past_for_role == connection->GetElectionId()) {
-      absl::optional<P4RoleConfig> role_config =
-          role_config_by_name_[connection->GetRoleName()];
-      if (VerifyStreamMessageNotFiltered(role_config, response)) {
-        found_at_least_one_primary = true;
-        connection->SendStreamMessageResponse(response);
-      }
-      // We don't report an error for packets getting filtered as this is
-      // expected operation.
+  for (const auto& primary : primary_connections_) {
+    if (VerifyStreamMessageNotFiltered(primary.role_config, response)) {
+      found_at_least_one_primary = true;
+      primary.connection->SendStreamMessageResponse(response);
     }
+    // We don't report an error for packets getting filtered as this is
+    // expected operation.
   }
 
   if (!found_at_least_one_primary) {
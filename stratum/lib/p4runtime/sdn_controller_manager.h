@@ -5,13 +5,18 @@
 #ifndef STRATUM_LIB_P4RUNTIME_SDN_CONTROLLER_MANAGER_H_
 #define STRATUM_LIB_P4RUNTIME_SDN_CONTROLLER_MANAGER_H_
 
+#include <deque>
 #include <string>
+#include <thread>  // NOLINT
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/numeric/int128.h"
 #include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "absl/types/optional.h"
 #include "p4/v1/p4runtime.grpc.pb.h"
 #include "p4/v1/p4runtime.pb.h"
 #include "stratum/public/proto/p4_role_config.pb.h"
@@ -22,14 +27,40 @@ namespace p4runtime {
 // Named role for a SDN controller.
 constexpr char kP4RuntimeRoleSdnController[] = "sdn_controller";
 
+// What to do with a PacketIn when the send queue of a connection is full.
+enum class SendQueueDropPolicy {
+  kDropNewest,  // Discard the PacketIn that is being sent.
+  kDropOldest,  // Discard the oldest queued PacketIn to make room.
+};
+
 // A connection between a controller and p4rt server.
 class SdnConnection {
  public:
+  // Counters of the outbound stream message queue of a connection.
+  struct SendQueueStats {
+    uint64_t enqueued = 0;
+    uint64_t sent = 0;
+    uint64_t dropped = 0;
+    uint64_t write_failures = 0;
+    // Time from enqueueing a message until its write to the stream completed.
+    absl::Duration total_latency = absl::ZeroDuration();
+    absl::Duration max_latency = absl::ZeroDuration();
+  };
+
+  // Uses the send queue settings given by the --p4rt_stream_send_queue_size
+  // and --p4rt_stream_send_queue_drop_policy flags.
+  SdnConnection(
+      grpc::ServerContext* context,
+      grpc::ServerReaderWriterInterface<p4::v1::StreamMessageResponse,
+                                        p4::v1::StreamMessageRequest>* stream);
+  // A send_queue_size of 0 disables the queue and the writer thread. Stream
+  // messages are then written synchronously by the sender.
   SdnConnection(
       grpc::ServerContext* context,
       grpc::ServerReaderWriterInterface<p4::v1::StreamMessageResponse,
-                                        p4::v1::StreamMessageRequest>* stream)
-      : initialized_(false), grpc_context_(context), grpc_stream_(stream) {}
+                                        p4::v1::StreamMessageRequest>* stream,
+      size_t send_queue_size, SendQueueDropPolicy drop_policy);
+  virtual ~SdnConnection();
 
   void Initialize() { initialized_ = true; }
   bool IsInitialized() const { return initialized_; }
@@ -43,10 +74,48 @@ class SdnConnection {
   // A unique name string for the controller.
   std::string GetName() const;
 
-  // Sends back StreamMessageResponse to this controller.
-  void SendStreamMessageResponse(const p4::v1::StreamMessageResponse& response);
+  // Sends back StreamMessageResponse to this controller. With the send queue
+  // enabled the message is handed to the writer thread of this connection and
+  // the call never blocks on the stream. PacketIns are subject to the drop
+  // policy when the queue is full; all other messages are always queued.
+  void SendStreamMessageResponse(const p4::v1::StreamMessageResponse& response)
+      ABSL_LOCKS_EXCLUDED(queue_lock_, write_lock_);
+
+  // Stops the writer thread and discards all queued messages. Messages sent
+  // afterwards are dropped. A write blocked on a stalled client is aborted by
+  // cancelling the RPC. Called on destruction, must be called before the gRPC
+  // stream goes away.
+  void Shutdown() ABSL_LOCKS_EXCLUDED(queue_lock_, write_lock_);
+
+  // Returns a copy of the send queue counters of this connection.
+  SendQueueStats GetSendQueueStats() const ABSL_LOCKS_EXCLUDED(queue_lock_);
+
+ protected:
+  // Cancels the RPC of this connection, which makes a pending write to the
+  // stream return. Virtual for testing.
+  virtual void CancelRpc();
 
  private:
+  // A stream message waiting in the send queue.
+  struct QueuedMessage {
+    p4::v1::StreamMessageResponse response;
+    absl::Time enqueue_time;
+  };
+
+  // Pops messages from the send queue and writes them to the stream until the
+  // connection is shut down.
+  void WriterThreadFunc() ABSL_LOCKS_EXCLUDED(queue_lock_, write_lock_);
+
+  // Awaited by the writer thread.
+  bool SendQueueReadyOrShutdown() const
+      ABSL_SHARED_LOCKS_REQUIRED(queue_lock_);
+
+  // Writes the message to the gRPC stream and updates the counters.
+  void WriteToStream(const p4::v1::StreamMessageResponse& response,
+                     absl::Time enqueue_time)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(write_lock_)
+          ABSL_LOCKS_EXCLUDED(queue_lock_);
+
   // The SDN connection should be initialized through arbitration before it can
   // be used.
   bool initialized_;
@@ -68,6 +137,37 @@ class SdnConnection {
   grpc::ServerReaderWriterInterface<p4::v1::StreamMessageResponse,
                                     p4::v1::StreamMessageRequest>*
       grpc_stream_;  // not owned.
+
+  // Maximum number of queued PacketIns, 0 if the send queue is disabled.
+  const size_t send_queue_size_;
+
+  // Policy for PacketIns arriving at a full send queue.
+  const SendQueueDropPolicy drop_policy_;
+
+  // Lock protecting the send queue and the counters.
+  mutable absl::Mutex queue_lock_;
+
+  // Messages waiting to be written by the writer thread, in send order.
+  std::deque<QueuedMessage> send_queue_ ABSL_GUARDED_BY(queue_lock_);
+
+  // Number of PacketIns in send_queue_. Only these count against the limit.
+  size_t queued_packet_ins_ ABSL_GUARDED_BY(queue_lock_);
+
+  // Set once the connection no longer accepts messages.
+  bool shutdown_ ABSL_GUARDED_BY(queue_lock_);
+
+  // True while a message is being written to the stream.
+  bool write_in_progress_ ABSL_GUARDED_BY(queue_lock_);
+
+  SendQueueStats stats_ ABSL_GUARDED_BY(queue_lock_);
+
+  // gRPC allows only one outstanding write per stream. This lock serializes
+  // the writes when the send queue is disabled and is held for the duration of
+  // every write. Acquired before queue_lock_.
+  absl::Mutex write_lock_;
+
+  // Drains send_queue_. Not started if the send queue is disabled.
+  std::thread writer_thread_;
 };
 
 class SdnControllerManager {
@@ -102,12 +202,27 @@ class SdnControllerManager {
   absl::Status SendPacketInToPrimary(
       const p4::v1::StreamMessageResponse& response) ABSL_LOCKS_EXCLUDED(lock_);
 
+  // Hands the message to the send queue of every primary connection whose
+  // role accepts it. Does not acquire lock_, so a slow controller or a
+  // concurrent arbitration cannot stall the PacketIn path.
   absl::Status SendStreamMessageToPrimary(
-      const p4::v1::StreamMessageResponse& response) ABSL_LOCKS_EXCLUDED(lock_);
+      const p4::v1::StreamMessageResponse& response)
+      ABSL_LOCKS_EXCLUDED(lock_, primary_connections_lock_);
 
  private:
+  // A primary connection and the config of its role.
+  struct PrimaryConnection {
+    SdnConnection* connection;  // not owned.
+    absl::optional<P4RoleConfig> role_config;
+  };
+
   SdnControllerManager() : device_id_(0) {}
 
+  // Recomputes primary_connections_ from the current connections, election IDs
+  // and role configs. Must be called after any of them changed.
+  void UpdatePrimaryConnections() ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_)
+      ABSL_LOCKS_EXCLUDED(primary_connections_lock_);
+
   // Goes through the current list of active connections, and returns if one of
   // them is currently the primary.
   bool PrimaryConnectionExists(const absl::optional<std::string>& role_name)
@@ -169,6 +284,16 @@ class SdnControllerManager {
   absl::flat_hash_map<absl::optional<std::string>,
                       absl::optional<absl::uint128>>
       election_id_past_by_role_ ABSL_GUARDED_BY(lock_);
+
+  // Lock protecting primary_connections_. Always acquired after lock_. Senders
+  // hold it in shared mode while fanning out, which is cheap as the
+  // connections only queue the message. Disconnect() takes it exclusively so
+  // no sender still uses a connection after it has been removed.
+  mutable absl::Mutex primary_connections_lock_;
+
+  // The primary connections of all roles, derived from the fields above.
+  std::vector<PrimaryConnection> primary_connections_
+      ABSL_GUARDED_BY(primary_connections_lock_);
 };
 
 }  // namespace p4runtime
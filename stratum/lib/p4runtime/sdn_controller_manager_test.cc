@@ -0,0 +1,300 @@
+// Copyright 2021-present Open Networking Foundation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "stratum/lib/p4runtime/sdn_controller_manager.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/numeric/int128.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "stratum/lib/p4runtime/stream_message_reader_writer_mock.h"
+
+namespace stratum {
+namespace p4runtime {
+
+using ::testing::_;
+using ::testing::ElementsAre;
+using ::testing::Invoke;
+
+namespace {
+
+constexpr uint64_t kDeviceId = 1;
+constexpr int kSendQueueSize = 3;
+
+p4::v1::StreamMessageResponse PacketIn(int i) {
+  p4::v1::StreamMessageResponse response;
+  response.mutable_packet()->set_payload(absl::StrCat("packet", i));
+  return response;
+}
+
+p4::v1::StreamMessageResponse Arbitration() {
+  p4::v1::StreamMessageResponse response;
+  response.mutable_arbitration()->set_device_id(kDeviceId);
+  return response;
+}
+
+p4::v1::MasterArbitrationUpdate ArbitrationUpdate(uint64_t election_id) {
+  p4::v1::MasterArbitrationUpdate update;
+  update.set_device_id(kDeviceId);
+  update.mutable_election_id()->set_high(0);
+  update.mutable_election_id()->set_low(election_id);
+  return update;
+}
+
+// Returns a short name for the written message, to compare write sequences.
+std::string MessageName(const p4::v1::StreamMessageResponse& response) {
+  if (response.has_packet()) return response.packet().payload();
+  if (response.has_arbitration()) return "arbitration";
+  return "other";
+}
+
+// Connection with a fake RPC cancellation, which fails the pending write like
+// gRPC does.
+class FakeCancelSdnConnection : public SdnConnection {
+ public:
+  FakeCancelSdnConnection(
+      grpc::ServerContext* context,
+      grpc::ServerReaderWriterInterface<p4::v1::StreamMessageResponse,
+                                        p4::v1::StreamMessageRequest>* stream,
+      size_t send_queue_size, SendQueueDropPolicy drop_policy,
+      absl::Notification* cancelled)
+      : SdnConnection(context, stream, send_queue_size, drop_policy),
+        cancelled_(cancelled) {}
+  // The base class destructor would not call the overridden CancelRpc().
+  ~FakeCancelSdnConnection() override { Shutdown(); }
+
+ protected:
+  void CancelRpc() override {
+    if (!cancelled_->HasBeenNotified()) cancelled_->Notify();
+  }
+
+ private:
+  absl::Notification* cancelled_;
+};
+
+}  // namespace
+
+// Fixture with a stream whose writes block until the test releases them or
+// the RPC is cancelled.
+class SdnConnectionTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    EXPECT_CALL(stream_, Write(_, _))
+        .WillRepeatedly(Invoke([this](const p4::v1::StreamMessageResponse& r,
+                                      grpc::WriteOptions) {
+          if (!write_started_.HasBeenNotified()) write_started_.Notify();
+          while (!unblock_writes_.WaitForNotificationWithTimeout(
+              absl::Milliseconds(1))) {
+            if (cancelled_.HasBeenNotified()) return false;
+          }
+          absl::MutexLock l(&lock_);
+          written_.push_back(MessageName(r));
+          return true;
+        }));
+  }
+
+  void TearDown() override {
+    if (!unblock_writes_.HasBeenNotified()) unblock_writes_.Notify();
+    connection_.reset();
+  }
+
+  void CreateConnection(size_t send_queue_size,
+                        SendQueueDropPolicy drop_policy) {
+    connection_ = absl::make_unique<FakeCancelSdnConnection>(
+        &context_, &stream_, send_queue_size, drop_policy, &cancelled_);
+  }
+
+  // Waits until the writer thread has written the given number of messages.
+  bool WaitForSent(uint64_t num_sent) {
+    const absl::Time deadline = absl::Now() + absl::Seconds(10);
+    while (absl::Now() < deadline) {
+      if (connection_->GetSendQueueStats().sent >= num_sent) return true;
+      absl::SleepFor(absl::Milliseconds(1));
+    }
+    return false;
+  }
+
+  std::vector<std::string> Written() {
+    absl::MutexLock l(&lock_);
+    return written_;
+  }
+
+  grpc::ServerContext context_;
+  StreamMessageReaderWriterMock stream_;
+  absl::Notification write_started_;
+  absl::Notification unblock_writes_;
+  absl::Notification cancelled_;
+  absl::Mutex lock_;
+  std::vector<std::string> written_ ABSL_GUARDED_BY(lock_);
+  std::unique_ptr<SdnConnection> connection_;
+};
+
+TEST_F(SdnConnectionTest, WritesSynchronouslyWithoutSendQueue) {
+  CreateConnection(0, SendQueueDropPolicy::kDropNewest);
+  unblock_writes_.Notify();
+  connection_->SendStreamMessageResponse(PacketIn(1));
+  connection_->SendStreamMessageResponse(PacketIn(2));
+
+  EXPECT_THAT(Written(), ElementsAre("packet1", "packet2"));
+  const auto stats = connection_->GetSendQueueStats();
+  EXPECT_EQ(2, stats.enqueued);
+  EXPECT_EQ(2, stats.sent);
+  EXPECT_EQ(0, stats.dropped);
+}
+
+TEST_F(SdnConnectionTest, SendDoesNotBlockOnSlowStream) {
+  CreateConnection(kSendQueueSize, SendQueueDropPolicy::kDropNewest);
+  connection_->SendStreamMessageResponse(PacketIn(0));
+  write_started_.WaitForNotification();
+  // The stream is stuck on the first write, sending more must not block.
+  connection_->SendStreamMessageResponse(PacketIn(1));
+  connection_->SendStreamMessageResponse(PacketIn(2));
+  EXPECT_TRUE(Written().empty());
+
+  unblock_writes_.Notify();
+  ASSERT_TRUE(WaitForSent(3));
+  EXPECT_THAT(Written(), ElementsAre("packet0", "packet1", "packet2"));
+  const auto stats = connection_->GetSendQueueStats();
+  EXPECT_EQ(3, stats.enqueued);
+  EXPECT_EQ(0, stats.dropped);
+  EXPECT_EQ(0, stats.write_failures);
+  EXPECT_GE(stats.total_latency, stats.max_latency);
+  EXPECT_GT(stats.max_latency, absl::ZeroDuration());
+}
+
+TEST_F(SdnConnectionTest, FullSendQueueDropsNewestPacketIn) {
+  CreateConnection(kSendQueueSize, SendQueueDropPolicy::kDropNewest);
+  connection_->SendStreamMessageResponse(PacketIn(0));
+  write_started_.WaitForNotification();
+  for (int i = 1; i <= kSendQueueSize + 2; ++i) {
+    connection_->SendStreamMessageResponse(PacketIn(i));
+  }
+
+  unblock_writes_.Notify();
+  ASSERT_TRUE(WaitForSent(kSendQueueSize + 1));
+  EXPECT_THAT(Written(),
+              ElementsAre("packet0", "packet1", "packet2", "packet3"));
+  EXPECT_EQ(2, connection_->GetSendQueueStats().dropped);
+}
+
+TEST_F(SdnConnectionTest, FullSendQueueDropsOldestPacketIn) {
+  CreateConnection(kSendQueueSize, SendQueueDropPolicy::kDropOldest);
+  connection_->SendStreamMessageResponse(PacketIn(0));
+  write_started_.WaitForNotification();
+  for (int i = 1; i <= kSendQueueSize + 2; ++i) {
+    connection_->SendStreamMessageResponse(PacketIn(i));
+  }
+
+  unblock_writes_.Notify();
+  ASSERT_TRUE(WaitForSent(kSendQueueSize + 1));
+  EXPECT_THAT(Written(),
+              ElementsAre("packet0", "packet3", "packet4", "packet5"));
+  EXPECT_EQ(2, connection_->GetSendQueueStats().dropped);
+}
+
+TEST_F(SdnConnectionTest, ArbitrationMessagesAreNeverDropped) {
+  CreateConnection(kSendQueueSize, SendQueueDropPolicy::kDropOldest);
+  connection_->SendStreamMessageResponse(PacketIn(0));
+  write_started_.WaitForNotification();
+  connection_->SendStreamMessageResponse(Arbitration());
+  for (int i = 1; i <= kSendQueueSize + 1; ++i) {
+    connection_->SendStreamMessageResponse(PacketIn(i));
+  }
+  connection_->SendStreamMessageResponse(Arbitration());
+
+  unblock_writes_.Notify();
+  ASSERT_TRUE(WaitForSent(kSendQueueSize + 3));
+  EXPECT_THAT(Written(),
+              ElementsAre("packet0", "arbitration", "packet2", "packet3",
+                          "packet4", "arbitration"));
+  EXPECT_EQ(1, connection_->GetSendQueueStats().dropped);
+}
+
+TEST_F(SdnConnectionTest, ShutdownDiscardsQueuedMessages) {
+  CreateConnection(kSendQueueSize, SendQueueDropPolicy::kDropNewest);
+  connection_->SendStreamMessageResponse(PacketIn(0));
+  write_started_.WaitForNotification();
+  connection_->SendStreamMessageResponse(PacketIn(1));
+  unblock_writes_.Notify();
+  connection_->Shutdown();
+  connection_->SendStreamMessageResponse(PacketIn(2));
+
+  const auto stats = connection_->GetSendQueueStats();
+  EXPECT_EQ(stats.enqueued + 1, stats.sent + stats.dropped);
+  EXPECT_THAT(Written(), ::testing::Contains("packet0"));
+}
+
+TEST_F(SdnConnectionTest, ShutdownCancelsBlockedWrite) {
+  CreateConnection(kSendQueueSize, SendQueueDropPolicy::kDropNewest);
+  connection_->SendStreamMessageResponse(PacketIn(0));
+  write_started_.WaitForNotification();
+  // The client never reads, Shutdown must not wait for the write forever.
+  connection_->Shutdown();
+
+  EXPECT_TRUE(cancelled_.HasBeenNotified());
+  EXPECT_TRUE(Written().empty());
+  EXPECT_EQ(1, connection_->GetSendQueueStats().write_failures);
+}
+
+TEST_F(SdnConnectionTest, ShutdownWithoutPendingWriteDoesNotCancel) {
+  CreateConnection(kSendQueueSize, SendQueueDropPolicy::kDropNewest);
+  unblock_writes_.Notify();
+  connection_->SendStreamMessageResponse(PacketIn(0));
+  ASSERT_TRUE(WaitForSent(1));
+  connection_->Shutdown();
+
+  EXPECT_FALSE(cancelled_.HasBeenNotified());
+}
+
+TEST(SdnControllerManagerTest, SendPacketInToPrimaryOnly) {
+  grpc::ServerContext context;
+  StreamMessageReaderWriterMock primary_stream;
+  StreamMessageReaderWriterMock backup_stream;
+  std::vector<std::string> primary_written;
+  std::vector<std::string> backup_written;
+  EXPECT_CALL(primary_stream, Write(_, _))
+      .WillRepeatedly(Invoke(
+          [&primary_written](const p4::v1::StreamMessageResponse& r,
+                             grpc::WriteOptions) {
+            primary_written.push_back(MessageName(r));
+            return true;
+          }));
+  EXPECT_CALL(backup_stream, Write(_, _))
+      .WillRepeatedly(Invoke(
+          [&backup_written](const p4::v1::StreamMessageResponse& r,
+                            grpc::WriteOptions) {
+            backup_written.push_back(MessageName(r));
+            return true;
+          }));
+  SdnConnection primary(&context, &primary_stream, 0,
+                        SendQueueDropPolicy::kDropNewest);
+  SdnConnection backup(&context, &backup_stream, 0,
+                       SendQueueDropPolicy::kDropNewest);
+  SdnControllerManager manager(kDeviceId);
+
+  EXPECT_FALSE(manager.SendPacketInToPrimary(PacketIn(0)).ok());
+  ASSERT_TRUE(manager.HandleArbitrationUpdate(ArbitrationUpdate(2), &primary)
+                  .ok());
+  ASSERT_TRUE(
+      manager.HandleArbitrationUpdate(ArbitrationUpdate(1), &backup).ok());
+  EXPECT_TRUE(manager.SendPacketInToPrimary(PacketIn(1)).ok());
+  EXPECT_THAT(primary_written, ElementsAre("arbitration", "packet1"));
+  EXPECT_THAT(backup_written, ElementsAre("arbitration"));
+
+  // Without the primary, there is nobody left to receive PacketIns.
+  manager.Disconnect(&primary);
+  EXPECT_FALSE(manager.SendPacketInToPrimary(PacketIn(2)).ok());
+  EXPECT_THAT(primary_written, ElementsAre("arbitration", "packet1"));
+}
+
+}  // namespace p4runtime
+}  // namespace stratum
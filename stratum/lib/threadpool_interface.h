@@ -0,0 +1,32 @@
+// Copyright 2018 Google LLC
+// Copyright 2018-present Open Networking Foundation
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef STRATUM_LIB_THREADPOOL_INTERFACE_H_
+#define STRATUM_LIB_THREADPOOL_INTERFACE_H_
+
+#include <functional>
+#include <vector>
+
+#include "stratum/glue/integral_types.h"
+#include "stratum/glue/status/status.h"
+
+namespace stratum {
+
+typedef uint32 TaskId;
+
+class ThreadpoolInterface {
+ public:
+  virtual ~ThreadpoolInterface() {}
+  // Setup and start any internal structures (i.e. threads).
+  virtual void Start() = 0;
+  // Schedule a single task to execute, and return a TaskId for the new task.
+  virtual TaskId Schedule(std::function<void()> closure) = 0;
+  // Block until all tasks with the given TaskIds have completed. Any TaskIds
+  // that have no matching task are ignored.
+  virtual void WaitAll(const std::vector<TaskId>& tasks) = 0;
+};
+
+}  // namespace stratum
+
+#endif  // STRATUM_LIB_THREADPOOL_INTERFACE_H_
@@ -4,88 +4,252 @@
 
 #include "stratum/lib/timer_daemon.h"
 
+#include <algorithm>
+#include <utility>
+
+#include "absl/memory/memory.h"
 #include "absl/synchronization/mutex.h"
+#include "gflags/gflags.h"
+#include "stratum/glue/gtl/map_util.h"
+
+DEFINE_int32(timer_daemon_num_workers, 4,
+             "Number of threads executing the actions of due timers.");
 
 namespace stratum {
 namespace hal {
 
 namespace {
-// A function that is executed by the thread created by TimerDaemon::Start().
-// It provides a timer resolution of 1ms.
-static void* Timer(void* arg) {
+// The resolution of the timers.
+constexpr absl::Duration kTickDuration = absl::Milliseconds(1);
+// Number of slots of the timing wheel, i.e. number of ticks per round.
+constexpr int64 kNumWheelSlots = 1024;
+// A new periodic timer joins an existing group of timers with the same period
+// if the group is due at most period / kGroupingSlackDivisor after the timer.
+constexpr int64 kGroupingSlackDivisor = 16;
+}  // namespace
+
+void TimerDaemon::Descriptor::RecordExecution(absl::Time due_time,
+                                              absl::Time start_time) {
+  absl::MutexLock l(&stats_lock_);
+  const absl::Duration lateness =
+      std::max(start_time - due_time, absl::ZeroDuration());
+  ++stats_.executions;
+  stats_.last_lateness = lateness;
+  stats_.max_lateness = std::max(stats_.max_lateness, lateness);
+  stats_.total_lateness += lateness;
+  if (repeat_ && last_start_time_ != absl::InfinitePast()) {
+    const absl::Duration jitter =
+        absl::AbsDuration(start_time - last_start_time_ - period_);
+    stats_.max_jitter = std::max(stats_.max_jitter, jitter);
+  }
+  last_start_time_ = start_time;
+}
+
+void TimerDaemon::Descriptor::RecordSkipped(uint64 count) {
+  absl::MutexLock l(&stats_lock_);
+  stats_.skipped += count;
+  // The gap caused by the skipped executions is not jitter.
+  last_start_time_ = absl::InfinitePast();
+}
+
+TimerDaemon::TimerDaemon()
+    : epoch_(absl::Now()),
+      wheel_(kNumWheelSlots),
+      current_tick_(0),
+      started_(false),
+      num_running_tasks_(0),
+      stop_workers_(false) {}
+
+// The function executed by the thread created by TimerDaemon::Start(). It
+// provides a timer resolution of 1ms.
+void* TimerDaemon::TimerThread(void* arg) {
+  TimerDaemon* daemon = static_cast<TimerDaemon*>(arg);
   while (true) {
     // Sleep for 1ms.
-    absl::SleepFor(absl::Milliseconds(1));
+    absl::SleepFor(kTickDuration);
 
-    // Call the method that will process the list of timers.
-    // If the method returns 'false' it means that this thread should be
-    // terminated.
-    if (!TimerDaemon::Execute()) break;
+    // Process the timers which are due by now. If the method returns 'false'
+    // it means that this thread should be terminated.
+    if (!daemon->Tick()) break;
   }
   return nullptr;
 }
-}  // namespace
 
-bool TimerDaemon::IsStopped() {
-  absl::WriterMutexLock l(&access_lock_);
-  return !started_;
+void* TimerDaemon::WorkerThread(void* arg) {
+  static_cast<TimerDaemon*>(arg)->RunWorker();
+  return nullptr;
 }
 
-TimerDaemon::DescriptorPtr TimerDaemon::GetAction() {
-  // Once woken up check if the timer at the top of the heap is due.
-  absl::WriterMutexLock l(&access_lock_);
+int64 TimerDaemon::TickAtOrAfter(absl::Time time) const {
+  return absl::ToInt64Milliseconds(absl::Ceil(time - epoch_, kTickDuration));
+}
+
+bool TimerDaemon::Tick() {
+  std::vector<Task> tasks;
+  {
+    absl::WriterMutexLock l(&access_lock_);
+    if (!started_) return false;
 
-  if (timers_.empty()) {
-    return nullptr;
+    const absl::Time now = absl::Now();
+    const int64 now_tick =
+        absl::ToInt64Milliseconds(absl::Floor(now - epoch_, kTickDuration));
+    // After a long pause every slot is visited just once.
+    const int64 last_tick =
+        std::min(now_tick, current_tick_ + kNumWheelSlots);
+    for (int64 tick = current_tick_ + 1; tick <= last_tick; ++tick) {
+      std::vector<std::unique_ptr<TimerGroup>> groups;
+      groups.swap(wheel_[tick % kNumWheelSlots]);
+      for (auto& group : groups) {
+        if (group->due_tick > now_tick) {
+          // Due in a later round of the wheel.
+          wheel_[tick % kNumWheelSlots].push_back(std::move(group));
+        } else {
+          FireGroup(std::move(group), now, &tasks);
+        }
+      }
+    }
+    current_tick_ = std::max(current_tick_, now_tick);
   }
-  if (timers_.front().expired()) {
-    pop_heap(timers_.begin(), timers_.end(), TimerDescriptorComparator());
-    timers_.pop_back();
-    return nullptr;
+  QueueTasks(tasks);
+  return true;
+}
+
+void TimerDaemon::FireGroup(std::unique_ptr<TimerGroup> group, absl::Time now,
+                            std::vector<Task>* tasks) {
+  // Drop the canceled timers.
+  auto& timers = group->timers;
+  timers.erase(std::remove_if(timers.begin(), timers.end(),
+                              [](const DescriptorWeakPtr& timer) {
+                                return timer.expired();
+                              }),
+               timers.end());
+  for (const auto& timer : timers) {
+    tasks->push_back(Task{timer, group->due_time});
   }
-  TimerDaemon::DescriptorPtr front = DescriptorPtr(timers_.front());
-  absl::Time now = absl::Now();
-  if (front->due_time_ <= now) {
-    pop_heap(timers_.begin(), timers_.end(), TimerDescriptorComparator());
-    timers_.pop_back();
-    if (front->Repeat()) {
-      // Periodic timer. Insert it in the queue again.
-      front->due_time_ += front->Period();
-      timers_.push_back(front);
-      push_heap(timers_.begin(), timers_.end(), TimerDescriptorComparator());
+  if (!group->repeat || timers.empty()) {
+    if (group->repeat) ForgetPeriodicGroup(group.get());
+    return;
+  }
+  // Periods which have been missed entirely, e.g. because the timer thread
+  // has not been scheduled, are skipped instead of being executed in a burst.
+  // The phase of the timers is kept.
+  absl::Duration remainder;
+  const int64 missed =
+      absl::IDivDuration(now - group->due_time, group->period, &remainder);
+  if (missed > 0) {
+    for (const auto& timer : timers) {
+      if (DescriptorPtr desc = timer.lock()) desc->RecordSkipped(missed);
     }
-    return front;
   }
-  return nullptr;
+  group->due_time += (missed + 1) * group->period;
+  group->due_tick = TickAtOrAfter(group->due_time);
+  ScheduleGroup(std::move(group));
 }
 
-bool TimerDaemon::Execute() {
-  TimerDaemon* daemon = GetInstance();
+void TimerDaemon::ScheduleGroup(std::unique_ptr<TimerGroup> group) {
+  // A group which is already overdue is executed with the next tick.
+  group->due_tick = std::max(group->due_tick, current_tick_ + 1);
+  wheel_[group->due_tick % kNumWheelSlots].push_back(std::move(group));
+}
 
-  if (daemon->IsStopped()) return false;
+void TimerDaemon::ForgetPeriodicGroup(const TimerGroup* group) {
+  const int64 period_ms = absl::ToInt64Milliseconds(group->period);
+  auto* groups = gtl::FindOrNull(periodic_groups_, period_ms);
+  if (groups == nullptr) return;
+  groups->erase(std::remove(groups->begin(), groups->end(), group),
+                groups->end());
+  if (groups->empty()) periodic_groups_.erase(period_ms);
+}
 
-  auto front = daemon->GetAction();
-  if (front != nullptr) {
-    // Execute the timer's action!
-    const auto& status = front->ExecuteAction();
-    if (status.ok()) {
-      VLOG(1) << "Timer has been triggered!";
-    } else {
-      LOG(ERROR) << "Error executing action: " << status;
+void TimerDaemon::QueueTasks(const std::vector<Task>& tasks) {
+  if (tasks.empty()) return;
+  absl::MutexLock l(&task_lock_);
+  for (const auto& task : tasks) {
+    DescriptorPtr timer = task.timer.lock();
+    if (timer == nullptr) continue;
+    if (timer->busy_.exchange(true)) {
+      // The previous execution has not finished yet.
+      timer->RecordSkipped(1);
+      continue;
     }
+    tasks_.push_back(task);
+    task_available_.Signal();
   }
+}
+
+void TimerDaemon::RunWorker() {
+  while (true) {
+    Task task;
+    {
+      absl::MutexLock l(&task_lock_);
+      while (tasks_.empty() && !stop_workers_) {
+        task_available_.Wait(&task_lock_);
+      }
+      if (stop_workers_) return;
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+      ++num_running_tasks_;
+    }
+    if (DescriptorPtr timer = task.timer.lock()) {
+      const absl::Time start_time = absl::Now();
+      // Execute the timer's action!
+      const auto& status = timer->ExecuteAction();
+      if (status.ok()) {
+        VLOG(1) << "Timer has been triggered!";
+      } else {
+        LOG(ERROR) << "Error executing action: " << status;
+      }
+      timer->RecordExecution(task.due_time, start_time);
+      timer->busy_ = false;
+    }
+    {
+      absl::MutexLock l(&task_lock_);
+      if (--num_running_tasks_ == 0 && tasks_.empty()) {
+        tasks_done_.SignalAll();
+      }
+    }
+  }
+}
+
+void TimerDaemon::WaitForIdle() {
+  absl::MutexLock l(&task_lock_);
+  while (!tasks_.empty() || num_running_tasks_ > 0) {
+    tasks_done_.Wait(&task_lock_);
+  }
+}
+
+bool TimerDaemon::Execute() {
+  TimerDaemon* daemon = GetInstance();
+
+  if (!daemon->Tick()) return false;
+  daemon->WaitForIdle();
+
   return true;
 }
 
 ::util::Status TimerDaemon::Start() {
-  absl::WriterMutexLock l(&GetInstance()->access_lock_);
-  if (GetInstance()->started_ == true) {
+  TimerDaemon* daemon = GetInstance();
+  absl::WriterMutexLock l(&daemon->access_lock_);
+  if (daemon->started_ == true) {
     return ::util::OkStatus();
   }
 
-  GetInstance()->started_ = true;
+  {
+    absl::MutexLock task_lock(&daemon->task_lock_);
+    daemon->stop_workers_ = false;
+  }
+  const int num_workers = std::max(FLAGS_timer_daemon_num_workers, 1);
+  for (int i = 0; i < num_workers; ++i) {
+    pthread_t tid;
+    if (pthread_create(&tid, nullptr, &WorkerThread, daemon) != 0) {
+      return MAKE_ERROR(ERR_INTERNAL) << "Failed to create a worker thread.";
+    }
+    daemon->worker_tids_.push_back(tid);
+  }
+
+  daemon->started_ = true;
 
-  if (pthread_create(&GetInstance()->tid_, nullptr, &Timer, nullptr) != 0) {
+  if (pthread_create(&daemon->tid_, nullptr, &TimerThread, daemon) != 0) {
     return MAKE_ERROR(ERR_INTERNAL) << "Failed to create the timer thread.";
   } else {
     VLOG(1) << "The timer daemon has been started.";
@@ -94,25 +258,45 @@ bool TimerDaemon::Execute() {
 }
 
 ::util::Status TimerDaemon::Stop() {
+  TimerDaemon* daemon = GetInstance();
   {
-    absl::WriterMutexLock l(&GetInstance()->access_lock_);
-    if (GetInstance()->started_ == false) {
+    absl::WriterMutexLock l(&daemon->access_lock_);
+    if (daemon->started_ == false) {
       return ::util::OkStatus();
     }
 
-    GetInstance()->started_ = false;
+    daemon->started_ = false;
   }
 
-  if (pthread_join(GetInstance()->tid_, nullptr) != 0) {
-    return MAKE_ERROR(ERR_INTERNAL) << "Failed to join the timer thread.";
-  } else {
-    absl::WriterMutexLock l(&GetInstance()->access_lock_);
-    GetInstance()->timers_.clear();
-    GetInstance()->tid_ = 0;
-
-    VLOG(1) << "The timer daemon has been stopped.";
-    return ::util::OkStatus();
+  ::util::Status status;
+  if (pthread_join(daemon->tid_, nullptr) != 0) {
+    status = MAKE_ERROR(ERR_INTERNAL) << "Failed to join the timer thread.";
+  }
+  {
+    absl::MutexLock l(&daemon->task_lock_);
+    daemon->stop_workers_ = true;
+    for (const auto& task : daemon->tasks_) {
+      if (DescriptorPtr timer = task.timer.lock()) timer->busy_ = false;
+    }
+    daemon->tasks_.clear();
+    daemon->task_available_.SignalAll();
+    daemon->tasks_done_.SignalAll();
+  }
+  for (pthread_t tid : daemon->worker_tids_) {
+    if (pthread_join(tid, nullptr) != 0 && status.ok()) {
+      status = MAKE_ERROR(ERR_INTERNAL) << "Failed to join a worker thread.";
+    }
   }
+  daemon->worker_tids_.clear();
+  RETURN_IF_ERROR(status);
+
+  absl::WriterMutexLock l(&daemon->access_lock_);
+  for (auto& slot : daemon->wheel_) slot.clear();
+  daemon->periodic_groups_.clear();
+  daemon->tid_ = 0;
+
+  VLOG(1) << "The timer daemon has been stopped.";
+  return ::util::OkStatus();
 }
 
 ::util::Status TimerDaemon::RequestOneShotTimer(uint64 delay_ms,
@@ -140,9 +324,40 @@ bool TimerDaemon::Execute() {
   absl::Time now = absl::Now();
   *desc = std::make_shared<Descriptor>(repeat, action);
   (*desc)->due_time_ = now + absl::Milliseconds(delay_ms);
-  (*desc)->period_ = absl::Milliseconds(period_ms);
-  timers_.push_back(DescriptorWeakPtr(*desc));
-  push_heap(timers_.begin(), timers_.end(), TimerDescriptorComparator());
+  // A periodic timer is executed at most once per tick.
+  (*desc)->period_ =
+      repeat ? std::max(absl::Milliseconds(period_ms), kTickDuration)
+             : absl::Milliseconds(period_ms);
+
+  if (repeat) {
+    // Join a group with the same period which is due shortly after the
+    // requested time, so that a single wheel entry triggers all of them.
+    const absl::Duration slack = (*desc)->period_ / kGroupingSlackDivisor;
+    auto* groups = gtl::FindOrNull(
+        periodic_groups_, absl::ToInt64Milliseconds((*desc)->period_));
+    if (groups != nullptr) {
+      for (TimerGroup* group : *groups) {
+        if (group->due_time >= (*desc)->due_time_ &&
+            group->due_time <= (*desc)->due_time_ + slack) {
+          (*desc)->due_time_ = group->due_time;
+          group->timers.push_back(DescriptorWeakPtr(*desc));
+          return ::util::OkStatus();
+        }
+      }
+    }
+  }
+
+  auto group = absl::make_unique<TimerGroup>();
+  group->due_time = (*desc)->due_time_;
+  group->due_tick = TickAtOrAfter(group->due_time);
+  group->repeat = repeat;
+  group->period = (*desc)->period_;
+  group->timers.push_back(DescriptorWeakPtr(*desc));
+  if (repeat) {
+    periodic_groups_[absl::ToInt64Milliseconds(group->period)].push_back(
+        group.get());
+  }
+  ScheduleGroup(std::move(group));
 
   return ::util::OkStatus();
 }
@@ -7,11 +7,13 @@
 
 #include <pthread.h>
 
-#include <algorithm>
+#include <atomic>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
@@ -24,7 +26,34 @@
 namespace stratum {
 namespace hal {
 
+// TimerDaemon executes timer actions after a delay, once or periodically. The
+// timers are kept in a hashed timing wheel with a resolution of 1ms, so adding
+// a timer and advancing the wheel by one tick take constant time regardless of
+// the number of timers. Periodic timers with the same period are grouped, so
+// that a single wheel entry triggers all of them. Due actions are handed to a
+// fixed pool of worker threads, so a slow action (e.g. a RetrieveValue() of a
+// gNMI sample subscription) does not delay the other timers. The next due time
+// of a periodic timer is derived from its previous due time rather than from
+// the time its action ran, so the sample intervals do not drift under load.
 class TimerDaemon final {
+ public:
+  // Execution statistics of a timer.
+  struct TimerStats {
+    // Number of times the action has been executed.
+    uint64 executions = 0;
+    // Number of due executions which have been skipped, because the previous
+    // execution of the action was still pending or the daemon was not able to
+    // keep up with the period.
+    uint64 skipped = 0;
+    // Time between the due time of an execution and the start of the action.
+    absl::Duration last_lateness;
+    absl::Duration max_lateness;
+    absl::Duration total_lateness;
+    // Largest deviation of the time between the start of two consecutive
+    // executions of a periodic timer from its period.
+    absl::Duration max_jitter;
+  };
+
  private:
   using Action = std::function<::util::Status()>;
 
@@ -38,66 +67,76 @@ class TimerDaemon final {
     bool Repeat() { return repeat_; }
     absl::Duration Period() { return period_; }
     ::util::Status ExecuteAction() { return action_(); }
+    // Returns the execution statistics of this timer.
+    TimerStats GetStats() const LOCKS_EXCLUDED(stats_lock_) {
+      absl::MutexLock l(&stats_lock_);
+      return stats_;
+    }
 
     bool repeat_;
     absl::Time due_time_;
     absl::Duration period_;
 
    private:
+    // Updates the statistics after the execution that was due at 'due_time'
+    // has been started at 'start_time'.
+    void RecordExecution(absl::Time due_time, absl::Time start_time)
+        LOCKS_EXCLUDED(stats_lock_);
+    // Updates the statistics after 'count' executions have been skipped.
+    void RecordSkipped(uint64 count) LOCKS_EXCLUDED(stats_lock_);
+
     Action action_ = []() {
       ::util::Status error = MAKE_ERROR(ERR_INTERNAL) << "Noop timer action!";
       return error;
     };
+    // Set while an execution of the action is queued or running. A timer is
+    // never queued twice, so a slow action cannot pile up executions.
+    std::atomic<bool> busy_{false};
+    // A Mutex used to guard access to the statistics.
+    mutable absl::Mutex stats_lock_;
+    TimerStats stats_ GUARDED_BY(stats_lock_);
+    // Start time of the previous execution, used to calculate the jitter.
+    absl::Time last_start_time_ GUARDED_BY(stats_lock_) =
+        absl::InfinitePast();
+
+    friend class TimerDaemon;
   };
 
   using DescriptorWeakPtr = std::weak_ptr<Descriptor>;
 
-  // In order to use TimerDaemon::Descriptor as a key in heap operations a
-  // comparator functor has to be defined.
-  struct TimerDescriptorComparator {
-    bool operator()(const TimerDaemon::DescriptorWeakPtr& lhs,
-                    const TimerDaemon::DescriptorWeakPtr& rhs) const {
-      // The goal of this method is to find which timer descriptor describes a
-      // timer that should be executed earlier: lhs or rhs?
-      // If a timer is canceled then the weak pointer pointing to it will
-      // 'expire' and there is no point in keeping such pointer on the heap. As
-      // the most effective way of removing an element from a heap is to move it
-      // to the top and then delete it, expired pointers should be theated as
-      // ones that are to be executed 'now'. This approach makes them to
-      // 'bubbled up' to the top as quickly as possible and then they can be
-      // removed.
-      if (lhs.expired() && !rhs.expired()) {
-        // rhs is expired, so, it is the lowest number.
-        return true;
-      }
-      if (rhs.expired() && !lhs.expired()) {
-        // lhs is expired, so, it is the lowest number.
-        return false;
-      }
-      if (rhs.expired() && lhs.expired()) {
-        // Both are expired, so, it really does not matter what we return.
-        return false;
-      }
-      // Both elements are still valid. Compare them!
-      return std::shared_ptr<Descriptor>(lhs)->due_time_ >
-             std::shared_ptr<Descriptor>(rhs)->due_time_;
-    }
+  // Timers which are due at the same time and, if periodic, have the same
+  // period. A group is a single entry of the timing wheel.
+  struct TimerGroup {
+    absl::Time due_time;
+    // The tick of the timing wheel at which the group is due.
+    int64 due_tick;
+    bool repeat;
+    absl::Duration period;
+    // Canceled timers are removed when the group is due next time.
+    std::vector<DescriptorWeakPtr> timers;
+  };
+
+  // An execution of a timer action handed to the worker threads.
+  struct Task {
+    DescriptorWeakPtr timer;
+    absl::Time due_time;
   };
 
  public:
   using DescriptorPtr = std::shared_ptr<Descriptor>;
 
-  // Starts the timer service. Creates a thread that calls Execute() every 1ms.
-  static ::util::Status Start() LOCKS_EXCLUDED(access_lock_);
-  // Stops the timer service. Notifies the timer thread to exit and waits until
-  // it joins.
-  static ::util::Status Stop() LOCKS_EXCLUDED(access_lock_);
-  // The 'worker' of the timer service. Is called every 1ms and checks if the
-  // first timer to be executed should be executed. If so, the action is
-  // executed and then if the timer is periodic the timer is updated and
-  // re-inserted into the heap with timers. It also takes care of all expired
-  // timers.
-  static bool Execute() LOCKS_EXCLUDED(access_lock_);
+  // Starts the timer service. Creates the worker threads and a thread that
+  // advances the timing wheel every 1ms.
+  static ::util::Status Start() LOCKS_EXCLUDED(access_lock_, task_lock_);
+  // Stops the timer service. Notifies the threads to exit and waits until
+  // they join. Actions which are queued but not yet running are dropped.
+  static ::util::Status Stop() LOCKS_EXCLUDED(access_lock_, task_lock_);
+  // Advances the timing wheel to the current time, hands all due actions to
+  // the worker threads and waits until all queued and running actions have
+  // finished. Returns false if the timer service is not running. The wheel is
+  // advanced by the timer thread anyway; this method allows tests to process
+  // due timers synchronously.
+  static bool Execute() LOCKS_EXCLUDED(access_lock_, task_lock_);
 
   // Creates a one-shot timer that will execute 'action' 'delay_ms' milliseconds
   // from now.
@@ -106,41 +145,103 @@ class TimerDaemon final {
                                             DescriptorPtr* desc);
   // Creates a periodic timier that will first time execute the 'action'
   // 'delay_ms' milliseconds from now and then will execute the 'action' every
-  // 'period_ms' missilseconds.
+  // 'period_ms' missilseconds. The timer may join a group of timers with the
+  // same period which is due up to 1/16 of the period later than requested.
   static ::util::Status RequestPeriodicTimer(uint64 delay_ms, uint64 period_ms,
                                              const Action& action,
                                              DescriptorPtr* desc);
 
  private:
-  TimerDaemon() : started_(false) {}
-
-  // If there is an action to be executed at this moment of time a non-null
-  // pointer is returned.
-  DescriptorPtr GetAction();
-
-  // Returns true if the timer daemon is stopped.
-  bool IsStopped();
+  TimerDaemon();
 
   static TimerDaemon* GetInstance() {
     static TimerDaemon* singleton = new TimerDaemon();
 
     return singleton;
   }
+
+  // The functions executed by the timer thread and the worker threads.
+  static void* TimerThread(void* arg);
+  static void* WorkerThread(void* arg);
+
+  // Advances the timing wheel to the current time and queues the actions of
+  // all timers which are due. Returns false if the timer service is stopped.
+  bool Tick() LOCKS_EXCLUDED(access_lock_, task_lock_);
+
+  // Collects the tasks of a due group and reschedules it if it is periodic.
+  void FireGroup(std::unique_ptr<TimerGroup> group, absl::Time now,
+                 std::vector<Task>* tasks)
+      EXCLUSIVE_LOCKS_REQUIRED(access_lock_);
+
+  // Inserts a group into the slot of the timing wheel of its due tick.
+  void ScheduleGroup(std::unique_ptr<TimerGroup> group)
+      EXCLUSIVE_LOCKS_REQUIRED(access_lock_);
+
+  // Removes a periodic group from periodic_groups_.
+  void ForgetPeriodicGroup(const TimerGroup* group)
+      EXCLUSIVE_LOCKS_REQUIRED(access_lock_);
+
+  // Queues the tasks of timers which are not busy already.
+  void QueueTasks(const std::vector<Task>& tasks) LOCKS_EXCLUDED(task_lock_);
+
+  // Executes queued tasks until the worker threads are stopped.
+  void RunWorker() LOCKS_EXCLUDED(task_lock_);
+
+  // Waits until all queued and running tasks have finished.
+  void WaitForIdle() LOCKS_EXCLUDED(task_lock_);
+
+  // Returns the first tick of the timing wheel at or after 'time'.
+  int64 TickAtOrAfter(absl::Time time) const;
+
   // Internal method creating requested timer.
   ::util::Status RequestTimer(bool repeat, uint64 delay_ms, uint64 period_ms,
                               Action action, DescriptorPtr* desc)
       LOCKS_EXCLUDED(access_lock_);
 
-  // A Mutex used to guard access to the list of pointers to timer requests and
-  // the started_ flag.
+  // A Mutex used to guard access to the timing wheel and the started_ flag.
   mutable absl::Mutex access_lock_;
 
-  std::vector<DescriptorWeakPtr> timers_ GUARDED_BY(access_lock_);
+  // The time of tick 0 of the timing wheel.
+  const absl::Time epoch_;
+
+  // The slots of the timing wheel. A group due at tick t is kept in slot
+  // t % kNumWheelSlots; groups due in later rounds of the wheel stay in their
+  // slot until their tick has been reached.
+  std::vector<std::vector<std::unique_ptr<TimerGroup>>> wheel_
+      GUARDED_BY(access_lock_);
+
+  // The last tick which has been processed.
+  int64 current_tick_ GUARDED_BY(access_lock_);
+
+  // Map from the period in ms to the periodic groups with that period. New
+  // periodic timers join one of these groups if its due time is close enough.
+  absl::flat_hash_map<int64, std::vector<TimerGroup*>> periodic_groups_
+      GUARDED_BY(access_lock_);
 
   pthread_t tid_ = 0;  // will not be destroyed before the thread is joined.
 
   bool started_ GUARDED_BY(access_lock_);
 
+  // A Mutex used to guard access to the queue of tasks for the workers.
+  mutable absl::Mutex task_lock_;
+
+  // Signaled when a task is queued or the workers are stopped.
+  absl::CondVar task_available_;
+
+  // Signaled when the last queued or running task has finished.
+  absl::CondVar tasks_done_;
+
+  std::deque<Task> tasks_ GUARDED_BY(task_lock_);
+
+  // Number of tasks taken from the queue which are still running.
+  int num_running_tasks_ GUARDED_BY(task_lock_);
+
+  // Set to make the worker threads exit.
+  bool stop_workers_ GUARDED_BY(task_lock_);
+
+  // The worker threads; will not be destroyed before they are joined.
+  std::vector<pthread_t> worker_tids_;
+
   friend class TimerDaemonTest;
 };
 
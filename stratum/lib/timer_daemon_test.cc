@@ -5,6 +5,7 @@
 #include "stratum/lib/timer_daemon.h"
 
 #include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
 #include "gtest/gtest.h"
 #include "stratum/glue/status/status_test_util.h"
 
@@ -38,16 +39,10 @@ class TimerDaemonTest : public ::testing::Test {
 
   void TearDown() override { ASSERT_OK(TimerDaemon::Stop()); }
 
-  TimerDaemon::DescriptorPtr GetTimerDescriptorPtr(const absl::Time when) {
-    TimerDaemon::DescriptorPtr desc = std::make_shared<TimerDaemon::Descriptor>(
-        /* repeat = */ false, []() { return ::util::OkStatus(); });
-    desc->due_time_ = when;
-    return desc;
-  }
-
-  TimerDaemon::DescriptorWeakPtr GetTimerDescriptorWeakPtr(
-      const TimerDaemon::DescriptorPtr& desc) {
-    return TimerDaemon::DescriptorWeakPtr(desc);
+  // Condition for waiting until the counter has reached the given value.
+  template <int N>
+  static bool CountReached(int* count) {
+    return *count >= N;
   }
 
   // A counter used to check if timers are executed in correct order. Each timer
@@ -57,63 +52,8 @@ class TimerDaemonTest : public ::testing::Test {
   int count_ GUARDED_BY(access_lock_);
   // A Mutex used to guard access to the 'count_'.
   mutable absl::Mutex access_lock_;
-
-  // A comparator used internally by the TimerSevice to compare timestamps.
-  // This class is private, so, it is instantiated here to allow access by
-  // relevant tests.
-  TimerDaemon::TimerDescriptorComparator cmp_;
 };
 
-TEST_F(TimerDaemonTest, CompareSmallerBigger) {
-  absl::Time now = absl::Now();
-  auto desc1 = GetTimerDescriptorPtr(now);
-  auto desc2 = GetTimerDescriptorPtr(now + absl::Milliseconds(10));
-
-  auto weak1 = GetTimerDescriptorWeakPtr(desc1);
-  auto weak2 = GetTimerDescriptorWeakPtr(desc2);
-
-  // 0 > 10
-  EXPECT_FALSE(cmp_(weak1, weak2));
-
-  desc2.reset();
-  // 0 > expired 10
-  EXPECT_FALSE(cmp_(weak1, weak2));
-
-  desc1.reset();
-  // expired 0 > expired 10
-  EXPECT_FALSE(cmp_(weak1, weak2));
-
-  desc2 = GetTimerDescriptorPtr(now + absl::Milliseconds(10));
-  weak2 = GetTimerDescriptorWeakPtr(desc2);
-  // expired 0 > 10
-  EXPECT_TRUE(cmp_(weak1, weak2));
-}
-
-TEST_F(TimerDaemonTest, CompareBiggerSmaller) {
-  absl::Time now = absl::Now();
-  auto desc1 = GetTimerDescriptorPtr(now + absl::Milliseconds(10));
-  auto desc2 = GetTimerDescriptorPtr(now);
-
-  auto weak1 = GetTimerDescriptorWeakPtr(desc1);
-  auto weak2 = GetTimerDescriptorWeakPtr(desc2);
-
-  // 10 > 0
-  EXPECT_TRUE(cmp_(weak1, weak2));
-
-  desc2.reset();
-  // 10 > expired 0
-  EXPECT_FALSE(cmp_(weak1, weak2));
-
-  desc1.reset();
-  // expired 10 > expired 0
-  EXPECT_FALSE(cmp_(weak1, weak2));
-
-  desc2 = GetTimerDescriptorPtr(now);
-  weak2 = GetTimerDescriptorWeakPtr(desc2);
-  // expired 10 > 0
-  EXPECT_TRUE(cmp_(weak1, weak2));
-}
-
 TEST_F(TimerDaemonTest, CreateOneShot) {
   // This test verifies that TimerDaemon does create one-shot timer.
   TimerDaemon::DescriptorPtr desc;
@@ -152,6 +92,107 @@ TEST_F(TimerDaemonTest, CreateTwoOneShots) {
 
 TEST_F(TimerDaemonTest, CreatePeriodic) {
   // This test verifies that TimerDaemon does create periodic timer.
+  TimerDaemon::DescriptorPtr desc;
+  ASSERT_OK(TimerDaemon::RequestPeriodicTimer(
+      10, 10,
+      [&]() {
+        absl::WriterMutexLock l(&access_lock_);
+        count_++;
+        return ::util::OkStatus();
+      },
+      &desc));
+  {
+    absl::WriterMutexLock l(&access_lock_);
+    EXPECT_TRUE(access_lock_.AwaitWithTimeout(
+        absl::Condition(&CountReached<5>, &count_), absl::Seconds(10)));
+  }
+  desc.reset();
+  EXPECT_TRUE(TimerDaemon::Execute());
+}
+
+TEST_F(TimerDaemonTest, CanceledTimerIsNotExecuted) {
+  // This test verifies that releasing the descriptor cancels the timer.
+  TimerDaemon::DescriptorPtr desc;
+  ASSERT_OK(TimerDaemon::RequestOneShotTimer(
+      50,
+      [&]() {
+        absl::WriterMutexLock l(&access_lock_);
+        count_++;
+        return ::util::OkStatus();
+      },
+      &desc));
+  desc.reset();
+  usleep(100000);
+  absl::WriterMutexLock l(&access_lock_);
+  EXPECT_EQ(count_, 0);
+}
+
+TEST_F(TimerDaemonTest, SlowActionDoesNotDelayOtherTimers) {
+  // This test verifies that a blocked action neither stops other timers nor
+  // piles up executions of itself.
+  absl::Notification slow_started, release_slow;
+  TimerDaemon::DescriptorPtr slow, fast;
+  ASSERT_OK(TimerDaemon::RequestPeriodicTimer(
+      1, 10,
+      [&]() {
+        if (!slow_started.HasBeenNotified()) slow_started.Notify();
+        release_slow.WaitForNotification();
+        return ::util::OkStatus();
+      },
+      &slow));
+  ASSERT_TRUE(slow_started.WaitForNotificationWithTimeout(absl::Seconds(10)));
+  ASSERT_OK(TimerDaemon::RequestPeriodicTimer(
+      1, 10,
+      [&]() {
+        absl::WriterMutexLock l(&access_lock_);
+        count_++;
+        return ::util::OkStatus();
+      },
+      &fast));
+  {
+    absl::WriterMutexLock l(&access_lock_);
+    EXPECT_TRUE(access_lock_.AwaitWithTimeout(
+        absl::Condition(&CountReached<5>, &count_), absl::Seconds(10)));
+  }
+  // The slow timer has been due while its first execution was still blocked.
+  const auto slow_stats = slow->GetStats();
+  EXPECT_EQ(slow_stats.executions, 0);
+  EXPECT_GE(slow_stats.skipped, 1);
+  release_slow.Notify();
+  slow.reset();
+  fast.reset();
+  // Waits for the actions still running, they refer to the notifications.
+  EXPECT_TRUE(TimerDaemon::Execute());
+}
+
+TEST_F(TimerDaemonTest, TimersWithSamePeriodAreGrouped) {
+  // This test verifies that a periodic timer joins a group with the same
+  // period which is due shortly after the requested time.
+  TimerDaemon::DescriptorPtr desc1, desc2;
+  ASSERT_OK(TimerDaemon::RequestPeriodicTimer(
+      100, 160, []() { return ::util::OkStatus(); }, &desc1));
+  ASSERT_OK(TimerDaemon::RequestPeriodicTimer(
+      95, 160, []() { return ::util::OkStatus(); }, &desc2));
+  EXPECT_EQ(desc1->due_time_, desc2->due_time_);
+}
+
+TEST_F(TimerDaemonTest, ExecuteWaitsForDueActions) {
+  // This test verifies that Execute() returns once the due actions are done.
+  TimerDaemon::DescriptorPtr desc;
+  ASSERT_OK(TimerDaemon::RequestOneShotTimer(
+      1,
+      [&]() {
+        usleep(20000);
+        absl::WriterMutexLock l(&access_lock_);
+        count_++;
+        return ::util::OkStatus();
+      },
+      &desc));
+  usleep(2000);
+  EXPECT_TRUE(TimerDaemon::Execute());
+  absl::WriterMutexLock l(&access_lock_);
+  EXPECT_EQ(count_, 1);
+  EXPECT_EQ(desc->GetStats().executions, 1);
 }
 
 TEST_F(TimerDaemonTest, StartIdempotent) {
@@ -6,16 +6,21 @@
 
 #include <cxxabi.h>
 #include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <array>
 #include <cerrno>
+#include <climits>
 #include <cstdio>
 #include <cstring>
 #include <fstream>  // IWYU pragma: keep
 #include <string>
+#include <utility>
 
+#include "absl/cleanup/cleanup.h"
 #include "absl/strings/str_split.h"
 #include "absl/strings/substitute.h"
 #include "google/protobuf/message.h"
@@ -28,6 +33,56 @@ namespace stratum {
 
 using ::google::protobuf::util::MessageDifferencer;
 
+namespace {
+
+// Layout of the header of checksummed binary proto files. All integers are
+// stored in little endian byte order.
+//   [0, 8)   magic number
+//   [8, 12)  format version
+//   [12, 16) CRC32C of the payload
+//   [16, 24) payload size in bytes
+// The non-ASCII first byte keeps the file from being mistaken for text.
+constexpr char kChecksummedBinFileMagic[] = "\x89STRPB\r\n";
+constexpr size_t kChecksummedBinFileMagicSize = 8;
+constexpr uint32 kChecksummedBinFileVersion = 1;
+constexpr size_t kChecksummedBinFileHeaderSize = 24;
+
+// Computes the CRC32C (Castagnoli) checksum of the given data.
+uint32 Crc32c(const char* data, size_t size) {
+  static const std::array<uint32, 256> kTable = []() {
+    std::array<uint32, 256> table;
+    for (uint32 i = 0; i < 256; ++i) {
+      uint32 crc = i;
+      for (int j = 0; j < 8; ++j) {
+        crc = (crc >> 1) ^ ((crc & 1) ? 0x82F63B78 : 0);
+      }
+      table[i] = crc;
+    }
+    return table;
+  }();
+  uint32 crc = 0xFFFFFFFF;
+  for (size_t i = 0; i < size; ++i) {
+    crc = kTable[(crc ^ static_cast<uint8>(data[i])) & 0xFF] ^ (crc >> 8);
+  }
+  return crc ^ 0xFFFFFFFF;
+}
+
+void EncodeLittleEndian(uint64 value, size_t num_bytes, char* buffer) {
+  for (size_t i = 0; i < num_bytes; ++i) {
+    buffer[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+  }
+}
+
+uint64 DecodeLittleEndian(const char* buffer, size_t num_bytes) {
+  uint64 value = 0;
+  for (size_t i = 0; i < num_bytes; ++i) {
+    value |= static_cast<uint64>(static_cast<uint8>(buffer[i])) << (8 * i);
+  }
+  return value;
+}
+
+}  // namespace
+
 ::util::Status WriteProtoToBinFile(const ::google::protobuf::Message& message,
                                    const std::string& filename) {
   std::string buffer;
@@ -53,6 +108,139 @@ using ::google::protobuf::util::MessageDifferencer;
   return ::util::OkStatus();
 }
 
+::util::Status WriteProtoToChecksummedBinFile(
+    const ::google::protobuf::Message& message, const std::string& filename) {
+  std::string buffer(kChecksummedBinFileHeaderSize, '\0');
+  if (!message.AppendToString(&buffer)) {
+    return MAKE_ERROR(ERR_INVALID_PARAM)
+           << "Failed to convert proto to bin string buffer: "
+           << message.ShortDebugString();
+  }
+  const char* payload = buffer.data() + kChecksummedBinFileHeaderSize;
+  const size_t payload_size = buffer.size() - kChecksummedBinFileHeaderSize;
+  memcpy(&buffer[0], kChecksummedBinFileMagic, kChecksummedBinFileMagicSize);
+  EncodeLittleEndian(kChecksummedBinFileVersion, 4, &buffer[8]);
+  EncodeLittleEndian(Crc32c(payload, payload_size), 4, &buffer[12]);
+  EncodeLittleEndian(payload_size, 8, &buffer[16]);
+
+  const std::string tmp_filename = filename + ".tmp";
+  int fd = open(tmp_filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    int error = errno;
+    return MAKE_ERROR(ERR_INTERNAL) << "Error when opening " << tmp_filename
+                                    << ": " << strerror(error) << ".";
+  }
+  // Do not leave a partially written file behind.
+  auto tmp_remover =
+      absl::MakeCleanup([&tmp_filename]() { unlink(tmp_filename.c_str()); });
+  size_t written = 0;
+  while (written < buffer.size()) {
+    ssize_t ret = write(fd, buffer.data() + written, buffer.size() - written);
+    if (ret < 0 && errno == EINTR) continue;
+    if (ret < 0) {
+      int error = errno;
+      close(fd);
+      return MAKE_ERROR(ERR_INTERNAL) << "Error when writing " << tmp_filename
+                                      << ": " << strerror(error) << ".";
+    }
+    written += ret;
+  }
+  if (fsync(fd) != 0) {
+    int error = errno;
+    close(fd);
+    return MAKE_ERROR(ERR_INTERNAL) << "Error when syncing " << tmp_filename
+                                    << ": " << strerror(error) << ".";
+  }
+  if (close(fd) != 0) {
+    int error = errno;
+    return MAKE_ERROR(ERR_INTERNAL) << "Error when closing " << tmp_filename
+                                    << ": " << strerror(error) << ".";
+  }
+  if (rename(tmp_filename.c_str(), filename.c_str()) != 0) {
+    int error = errno;
+    return MAKE_ERROR(ERR_INTERNAL) << "Error when renaming " << tmp_filename
+                                    << " to " << filename << ": "
+                                    << strerror(error) << ".";
+  }
+  std::move(tmp_remover).Cancel();
+
+  return ::util::OkStatus();
+}
+
+::util::Status ReadProtoFromChecksummedBinFile(
+    const std::string& filename, ::google::protobuf::Message* message) {
+  if (!PathExists(filename)) {
+    return MAKE_ERROR(ERR_FILE_NOT_FOUND) << filename << " not found.";
+  }
+  if (IsDir(filename)) {
+    return MAKE_ERROR(ERR_FILE_NOT_FOUND) << filename << " is a dir.";
+  }
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return MAKE_ERROR(ERR_INTERNAL) << "Error when opening " << filename << ": "
+                                    << strerror(errno) << ".";
+  }
+  auto fd_closer = absl::MakeCleanup([fd]() { close(fd); });
+  struct stat stbuf;
+  if (fstat(fd, &stbuf) != 0) {
+    return MAKE_ERROR(ERR_INTERNAL) << "Error when reading the size of "
+                                    << filename << ": " << strerror(errno)
+                                    << ".";
+  }
+  const size_t file_size = stbuf.st_size;
+  if (file_size < kChecksummedBinFileHeaderSize) {
+    return MAKE_ERROR(ERR_INTERNAL)
+           << filename << " is too short to be a checksummed binary file.";
+  }
+  void* addr = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (addr == MAP_FAILED) {
+    return MAKE_ERROR(ERR_INTERNAL) << "Error when mapping " << filename << ": "
+                                    << strerror(errno) << ".";
+  }
+  auto unmapper =
+      absl::MakeCleanup([addr, file_size]() { munmap(addr, file_size); });
+  madvise(addr, file_size, MADV_SEQUENTIAL);
+  const char* data = static_cast<const char*>(addr);
+
+  if (memcmp(data, kChecksummedBinFileMagic, kChecksummedBinFileMagicSize)) {
+    return MAKE_ERROR(ERR_INTERNAL)
+           << filename << " is not a checksummed binary file.";
+  }
+  const uint64 version = DecodeLittleEndian(data + 8, 4);
+  if (version != kChecksummedBinFileVersion) {
+    return MAKE_ERROR(ERR_INTERNAL) << "Unsupported version " << version
+                                    << " of checksummed binary file "
+                                    << filename << ".";
+  }
+  const char* payload = data + kChecksummedBinFileHeaderSize;
+  const uint64 payload_size = DecodeLittleEndian(data + 16, 8);
+  if (payload_size != file_size - kChecksummedBinFileHeaderSize ||
+      payload_size > INT_MAX) {
+    return MAKE_ERROR(ERR_INTERNAL)
+           << "Payload size " << payload_size << " of " << filename
+           << " does not match the file size " << file_size << ".";
+  }
+  const uint32 checksum = DecodeLittleEndian(data + 12, 4);
+  if (Crc32c(payload, payload_size) != checksum) {
+    return MAKE_ERROR(ERR_INTERNAL) << "Checksum mismatch in " << filename
+                                    << ", the file is corrupted.";
+  }
+  if (!message->ParseFromArray(payload, static_cast<int>(payload_size))) {
+    return MAKE_ERROR(ERR_INTERNAL) << "Failed to parse the binary content of "
+                                    << filename << " to proto.";
+  }
+
+  return ::util::OkStatus();
+}
+
+bool IsChecksummedBinFile(const std::string& filename) {
+  std::ifstream infile(filename.c_str(), std::ifstream::binary);
+  if (!infile.is_open()) return false;
+  char magic[kChecksummedBinFileMagicSize];
+  if (!infile.read(magic, sizeof(magic))) return false;
+  return memcmp(magic, kChecksummedBinFileMagic, sizeof(magic)) == 0;
+}
+
 ::util::Status WriteProtoToTextFile(const ::google::protobuf::Message& message,
                                     const std::string& filename) {
   std::string text;
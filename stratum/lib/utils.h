@@ -102,6 +102,25 @@ inline std::string PrintVector(const std::vector<T>& vec,
 ::util::Status ReadProtoFromBinFile(const std::string& filename,
                                     ::google::protobuf::Message* message);
 
+// Writes a proto message in binary format to the given file path, preceded by
+// a header with a magic number, the payload size and a CRC32C checksum of the
+// payload. The data is written to a temporary file which is synced and then
+// renamed over the given path, so the file is always either the old or the new
+// version, even after a crash.
+::util::Status WriteProtoToChecksummedBinFile(
+    const ::google::protobuf::Message& message, const std::string& filename);
+
+// Reads a proto from a file written by WriteProtoToChecksummedBinFile(). The
+// file is memory-mapped and parsed in place, without copying it into a buffer.
+// Returns ERR_FILE_NOT_FOUND if there is no such file and ERR_INTERNAL if the
+// header, size or checksum do not match.
+::util::Status ReadProtoFromChecksummedBinFile(
+    const std::string& filename, ::google::protobuf::Message* message);
+
+// Returns true if the given file starts with the header written by
+// WriteProtoToChecksummedBinFile(). The rest of the file is not validated.
+bool IsChecksummedBinFile(const std::string& filename);
+
 // Writes a proto message in text format to the given file path.
 ::util::Status WriteProtoToTextFile(const ::google::protobuf::Message& message,
                                     const std::string& filename);
@@ -68,6 +68,67 @@ TEST(CommonUtilsTest, WriteProtoToBinFileThenReadProtoFromBinFile) {
   EXPECT_TRUE(ProtoEqual(expected, actual));
 }
 
+TEST(CommonUtilsTest,
+     WriteProtoToChecksummedBinFileThenReadProtoFromChecksummedBinFile) {
+  hal::ChassisConfig expected, actual;
+  expected.set_description("Test config");
+  expected.mutable_chassis()->set_platform(hal::PLT_GENERIC_TOMAHAWK);
+  expected.add_nodes()->set_id(1);
+  expected.add_nodes()->set_id(2);
+  const std::string filename(FLAGS_test_tmpdir +
+                             "/WriteProtoToChecksummedBinFile");
+  ASSERT_OK(WriteProtoToChecksummedBinFile(expected, filename));
+  EXPECT_TRUE(IsChecksummedBinFile(filename));
+  EXPECT_FALSE(PathExists(filename + ".tmp"));
+  ASSERT_OK(ReadProtoFromChecksummedBinFile(filename, &actual));
+  EXPECT_TRUE(ProtoEqual(expected, actual));
+}
+
+TEST(CommonUtilsTest, WriteProtoToChecksummedBinFileRemovesTmpFileOnError) {
+  hal::ChassisConfig config;
+  config.set_description("Test config");
+  // A non-empty directory cannot be replaced by the renamed file.
+  const std::string filename(FLAGS_test_tmpdir +
+                             "/WriteProtoToChecksummedBinFileOverDir");
+  ASSERT_OK(RecursivelyCreateDir(filename));
+  ASSERT_OK(WriteStringToFile("", filename + "/file"));
+  EXPECT_THAT(WriteProtoToChecksummedBinFile(config, filename),
+              StatusIs(_, ERR_INTERNAL, HasSubstr("Error when renaming")));
+  EXPECT_FALSE(PathExists(filename + ".tmp"));
+}
+
+TEST(CommonUtilsTest, ReadProtoFromChecksummedBinFileDetectsCorruption) {
+  hal::ChassisConfig config;
+  config.set_description("Test config");
+  const std::string filename(FLAGS_test_tmpdir +
+                             "/ReadProtoFromChecksummedBinFileCorrupted");
+  ASSERT_OK(WriteProtoToChecksummedBinFile(config, filename));
+  std::string buffer;
+  ASSERT_OK(ReadFileToString(filename, &buffer));
+  buffer.back() ^= 0x1;
+  ASSERT_OK(WriteStringToFile(buffer, filename));
+  EXPECT_THAT(ReadProtoFromChecksummedBinFile(filename, &config),
+              StatusIs(_, ERR_INTERNAL, HasSubstr("Checksum mismatch")));
+
+  // Truncated files are rejected as well.
+  buffer.pop_back();
+  ASSERT_OK(WriteStringToFile(buffer, filename));
+  EXPECT_THAT(ReadProtoFromChecksummedBinFile(filename, &config),
+              StatusIs(_, ERR_INTERNAL, HasSubstr("does not match")));
+}
+
+TEST(CommonUtilsTest, ReadProtoFromChecksummedBinFileRejectsTextFile) {
+  hal::ChassisConfig config;
+  config.set_description("Test config");
+  const std::string filename(FLAGS_test_tmpdir +
+                             "/ReadProtoFromChecksummedBinFileText");
+  ASSERT_OK(WriteProtoToTextFile(config, filename));
+  EXPECT_FALSE(IsChecksummedBinFile(filename));
+  EXPECT_FALSE(ReadProtoFromChecksummedBinFile(filename, &config).ok());
+  EXPECT_THAT(ReadProtoFromChecksummedBinFile(filename + "_missing", &config),
+              StatusIs(_, ERR_FILE_NOT_FOUND, _));
+}
+
 TEST(CommonUtilsTest, WriteProtoToTextFileThenReadProtoFromTextFile) {
   hal::ChassisConfig expected, actual;
   expected.set_description("Test config");
@@ -0,0 +1,184 @@
+// Copyright 2018-present Open Networking Foundation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "stratum/lib/work_stealing_threadpool.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "absl/time/clock.h"
+#include "stratum/glue/logging.h"
+
+namespace stratum {
+
+namespace {
+
+// The pool and queue index of the worker running on the current thread.
+thread_local const WorkStealingThreadpool* current_pool = nullptr;
+thread_local int current_worker_index = -1;
+
+}  // namespace
+
+WorkStealingThreadpool::WorkStealingThreadpool(int num_threads)
+    : next_queue_(0),
+      num_queued_(0),
+      next_task_id_(0),
+      started_(false),
+      shutdown_(false) {
+  num_threads = std::max(num_threads, 1);
+  for (int i = 0; i < num_threads; ++i) {
+    queues_.push_back(absl::make_unique<WorkerQueue>());
+  }
+}
+
+WorkStealingThreadpool::~WorkStealingThreadpool() {
+  std::vector<std::thread> workers;
+  {
+    absl::MutexLock l(&lock_);
+    shutdown_ = true;
+    work_available_.SignalAll();
+    workers.swap(workers_);
+  }
+  for (auto& worker : workers) worker.join();
+}
+
+void WorkStealingThreadpool::Start() {
+  absl::MutexLock l(&lock_);
+  if (started_ || shutdown_) return;
+  started_ = true;
+  for (int i = 0; i < NumQueues(); ++i) {
+    workers_.emplace_back(&WorkStealingThreadpool::WorkerLoop, this, i);
+  }
+}
+
+TaskId WorkStealingThreadpool::Schedule(std::function<void()> closure) {
+  TaskId id;
+  {
+    absl::MutexLock l(&lock_);
+    // Skip IDs of tasks still pending after the counter wrapped around.
+    do {
+      id = next_task_id_++;
+    } while (pending_tasks_.count(id));
+    pending_tasks_.insert(id);
+  }
+
+  int index = CurrentWorkerIndex();
+  if (index < 0) index = next_queue_.fetch_add(1) % NumQueues();
+  {
+    WorkerQueue* queue = queues_[index].get();
+    absl::MutexLock l(&queue->lock);
+    queue->tasks.push_back(Task{id, std::move(closure), absl::Now()});
+  }
+
+  absl::MutexLock l(&lock_);
+  ++num_queued_;
+  work_available_.Signal();
+  task_done_.SignalAll();
+  return id;
+}
+
+void WorkStealingThreadpool::WaitAll(const std::vector<TaskId>& tasks) {
+  const int index = std::max(CurrentWorkerIndex(), 0);
+  while (true) {
+    {
+      absl::MutexLock l(&lock_);
+      if (AllDone(tasks)) return;
+    }
+    // Rather than idling, help with whatever work is queued. This also keeps
+    // WaitAll() from deadlocking when called from within a task.
+    Task task;
+    if (PopTask(index, &task)) {
+      RunTask(&task);
+      continue;
+    }
+    absl::MutexLock l(&lock_);
+    if (AllDone(tasks)) return;
+    if (num_queued_ <= 0) task_done_.Wait(&lock_);
+  }
+}
+
+WorkStealingThreadpool::TaskStats WorkStealingThreadpool::GetTaskStats() const {
+  absl::MutexLock l(&lock_);
+  return stats_;
+}
+
+void WorkStealingThreadpool::WorkerLoop(int index) {
+  current_pool = this;
+  current_worker_index = index;
+  while (true) {
+    Task task;
+    if (PopTask(index, &task)) {
+      RunTask(&task);
+      continue;
+    }
+    absl::MutexLock l(&lock_);
+    if (shutdown_) break;
+    if (num_queued_ <= 0) work_available_.Wait(&lock_);
+    if (shutdown_) break;
+  }
+  current_pool = nullptr;
+  current_worker_index = -1;
+}
+
+bool WorkStealingThreadpool::PopTask(int index, Task* task) {
+  bool found = false;
+  {
+    // Newest task first from our own queue, it is most likely still cache hot.
+    WorkerQueue* queue = queues_[index].get();
+    absl::MutexLock l(&queue->lock);
+    if (!queue->tasks.empty()) {
+      *task = std::move(queue->tasks.back());
+      queue->tasks.pop_back();
+      found = true;
+    }
+  }
+  // Steal the oldest task from the other queues.
+  for (int i = 1; !found && i < NumQueues(); ++i) {
+    WorkerQueue* queue = queues_[(index + i) % NumQueues()].get();
+    absl::MutexLock l(&queue->lock);
+    if (!queue->tasks.empty()) {
+      *task = std::move(queue->tasks.front());
+      queue->tasks.pop_front();
+      found = true;
+    }
+  }
+  if (found) {
+    absl::MutexLock l(&lock_);
+    --num_queued_;
+  }
+  return found;
+}
+
+void WorkStealingThreadpool::RunTask(Task* task) {
+  const absl::Time start_time = absl::Now();
+  task->closure();
+  const absl::Time end_time = absl::Now();
+  const absl::Duration queue_latency = start_time - task->schedule_time;
+  const absl::Duration run_time = end_time - start_time;
+  VLOG(2) << "Threadpool task " << task->id << " waited "
+          << absl::FormatDuration(queue_latency) << " and ran for "
+          << absl::FormatDuration(run_time) << ".";
+
+  absl::MutexLock l(&lock_);
+  pending_tasks_.erase(task->id);
+  ++stats_.tasks_completed;
+  stats_.total_queue_latency += queue_latency;
+  stats_.max_queue_latency = std::max(stats_.max_queue_latency, queue_latency);
+  stats_.total_run_time += run_time;
+  stats_.max_run_time = std::max(stats_.max_run_time, run_time);
+  task_done_.SignalAll();
+}
+
+bool WorkStealingThreadpool::AllDone(const std::vector<TaskId>& tasks) const {
+  for (const auto& id : tasks) {
+    if (pending_tasks_.count(id)) return false;
+  }
+  return true;
+}
+
+int WorkStealingThreadpool::CurrentWorkerIndex() const {
+  return current_pool == this ? current_worker_index : -1;
+}
+
+}  // namespace stratum
@@ -0,0 +1,128 @@
+// Copyright 2018-present Open Networking Foundation
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef STRATUM_LIB_WORK_STEALING_THREADPOOL_H_
+#define STRATUM_LIB_WORK_STEALING_THREADPOOL_H_
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "stratum/glue/integral_types.h"
+#include "stratum/lib/threadpool_interface.h"
+
+namespace stratum {
+
+// A fixed-size threadpool. Every worker owns a task queue. Workers run their
+// own tasks newest first and steal the oldest tasks of other workers when they
+// run out of work. Threads calling WaitAll() help executing queued tasks
+// instead of just blocking, so WaitAll() may also be called from within a
+// task and tasks scheduled before Start() still complete.
+class WorkStealingThreadpool : public ThreadpoolInterface {
+ public:
+  // Latency statistics over all tasks completed so far.
+  struct TaskStats {
+    uint64 tasks_completed = 0;
+    // Time from Schedule() until a thread started running the task.
+    absl::Duration total_queue_latency = absl::ZeroDuration();
+    absl::Duration max_queue_latency = absl::ZeroDuration();
+    // Time spent running the task closure.
+    absl::Duration total_run_time = absl::ZeroDuration();
+    absl::Duration max_run_time = absl::ZeroDuration();
+  };
+
+  // Creates a threadpool with num_threads workers (at least one). No threads
+  // are started before Start() is called.
+  explicit WorkStealingThreadpool(int num_threads);
+  // Stops all workers after they ran the tasks still queued. If the pool was
+  // never started, queued tasks are discarded.
+  ~WorkStealingThreadpool() override;
+
+  // Starts the worker threads. Subsequent calls are no-ops.
+  void Start() override LOCKS_EXCLUDED(lock_);
+  TaskId Schedule(std::function<void()> closure) override
+      LOCKS_EXCLUDED(lock_);
+  void WaitAll(const std::vector<TaskId>& tasks) override LOCKS_EXCLUDED(lock_);
+
+  // Returns a copy of the task latency statistics.
+  TaskStats GetTaskStats() const LOCKS_EXCLUDED(lock_);
+
+  // WorkStealingThreadpool is neither copyable nor movable.
+  WorkStealingThreadpool(const WorkStealingThreadpool&) = delete;
+  WorkStealingThreadpool& operator=(const WorkStealingThreadpool&) = delete;
+
+ private:
+  struct Task {
+    TaskId id;
+    std::function<void()> closure;
+    absl::Time schedule_time;
+  };
+
+  // The task queue of a single worker.
+  struct WorkerQueue {
+    absl::Mutex lock;
+    std::deque<Task> tasks GUARDED_BY(lock);
+  };
+
+  // Main loop of the worker with the given index.
+  void WorkerLoop(int index) LOCKS_EXCLUDED(lock_);
+
+  // Takes a task from the queue of the given worker, or steals one from any
+  // other worker if that queue is empty. Returns false if no task was found.
+  bool PopTask(int index, Task* task) LOCKS_EXCLUDED(lock_);
+
+  // Runs the task and marks it as completed.
+  void RunTask(Task* task) LOCKS_EXCLUDED(lock_);
+
+  // Returns true if none of the given tasks is pending anymore.
+  bool AllDone(const std::vector<TaskId>& tasks) const
+      SHARED_LOCKS_REQUIRED(lock_);
+
+  // Returns the index of the queue owned by the calling thread, or -1 if the
+  // calling thread is not a worker of this pool.
+  int CurrentWorkerIndex() const;
+
+  int NumQueues() const { return static_cast<int>(queues_.size()); }
+
+  // One queue per worker, fixed after construction.
+  std::vector<std::unique_ptr<WorkerQueue>> queues_;
+
+  // Round-robin counter used to spread tasks scheduled by non-worker threads.
+  std::atomic<uint32> next_queue_;
+
+  mutable absl::Mutex lock_;
+
+  // Signalled when a task is scheduled or the pool shuts down.
+  absl::CondVar work_available_;
+
+  // Signalled when a task completes or is scheduled. WaitAll() waits on this.
+  absl::CondVar task_done_;
+
+  // Number of tasks sitting in any of the queues. Can briefly drop below zero
+  // when a task is popped before Schedule() accounted for it.
+  int64 num_queued_ GUARDED_BY(lock_);
+
+  // IDs of all scheduled tasks that have not completed yet.
+  absl::flat_hash_set<TaskId> pending_tasks_ GUARDED_BY(lock_);
+
+  // Next task ID to hand out.
+  TaskId next_task_id_ GUARDED_BY(lock_);
+
+  bool started_ GUARDED_BY(lock_);
+  bool shutdown_ GUARDED_BY(lock_);
+
+  TaskStats stats_ GUARDED_BY(lock_);
+
+  std::vector<std::thread> workers_ GUARDED_BY(lock_);
+};
+
+}  // namespace stratum
+
+#endif  // STRATUM_LIB_WORK_STEALING_THREADPOOL_H_
@@ -0,0 +1,97 @@
+// Copyright 2018-present Open Networking Foundation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "stratum/lib/work_stealing_threadpool.h"
+
+#include <atomic>
+#include <vector>
+
+#include "absl/synchronization/barrier.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace stratum {
+namespace {
+
+TEST(WorkStealingThreadpoolTest, RunsAllTasks) {
+  WorkStealingThreadpool threadpool(4);
+  threadpool.Start();
+  std::atomic<int> counter(0);
+  std::vector<TaskId> tasks;
+  for (int i = 0; i < 100; ++i) {
+    tasks.push_back(threadpool.Schedule([&counter]() { ++counter; }));
+  }
+  threadpool.WaitAll(tasks);
+  EXPECT_EQ(100, counter);
+  EXPECT_EQ(100, threadpool.GetTaskStats().tasks_completed);
+}
+
+TEST(WorkStealingThreadpoolTest, RunsTasksInParallel) {
+  constexpr int kNumThreads = 4;
+  WorkStealingThreadpool threadpool(kNumThreads);
+  threadpool.Start();
+  // Every task blocks until all of them are running, which only completes if
+  // the tasks run concurrently.
+  absl::Barrier all_running(kNumThreads);
+  std::vector<TaskId> tasks;
+  for (int i = 0; i < kNumThreads; ++i) {
+    tasks.push_back(
+        threadpool.Schedule([&all_running]() { all_running.Block(); }));
+  }
+  threadpool.WaitAll(tasks);
+}
+
+TEST(WorkStealingThreadpoolTest, WaitAllWithinTask) {
+  WorkStealingThreadpool threadpool(1);
+  threadpool.Start();
+  std::atomic<int> counter(0);
+  TaskId outer = threadpool.Schedule([&threadpool, &counter]() {
+    std::vector<TaskId> inner;
+    for (int i = 0; i < 10; ++i) {
+      inner.push_back(threadpool.Schedule([&counter]() { ++counter; }));
+    }
+    // With a single worker this would deadlock if WaitAll did not run the
+    // inner tasks itself.
+    threadpool.WaitAll(inner);
+    EXPECT_EQ(10, counter);
+  });
+  threadpool.WaitAll({outer});
+  EXPECT_EQ(10, counter);
+}
+
+TEST(WorkStealingThreadpoolTest, WaitAllRunsTasksBeforeStart) {
+  WorkStealingThreadpool threadpool(2);
+  bool done = false;
+  TaskId task = threadpool.Schedule([&done]() { done = true; });
+  threadpool.WaitAll({task});
+  EXPECT_TRUE(done);
+}
+
+TEST(WorkStealingThreadpoolTest, WaitAllIgnoresUnknownTasks) {
+  WorkStealingThreadpool threadpool(2);
+  threadpool.Start();
+  TaskId task = threadpool.Schedule([]() {});
+  threadpool.WaitAll({task, task + 1000});
+  threadpool.WaitAll({});
+}
+
+TEST(WorkStealingThreadpoolTest, TaskStats) {
+  WorkStealingThreadpool threadpool(2);
+  threadpool.Start();
+  std::vector<TaskId> tasks;
+  for (int i = 0; i < 4; ++i) {
+    tasks.push_back(
+        threadpool.Schedule([]() { absl::SleepFor(absl::Milliseconds(5)); }));
+  }
+  threadpool.WaitAll(tasks);
+  auto stats = threadpool.GetTaskStats();
+  EXPECT_EQ(4, stats.tasks_completed);
+  EXPECT_GE(stats.max_run_time, absl::Milliseconds(5));
+  EXPECT_GE(stats.total_run_time, absl::Milliseconds(20));
+  EXPECT_GE(stats.total_queue_latency, stats.max_queue_latency);
+}
+
+}  // namespace
+}  // namespace stratum
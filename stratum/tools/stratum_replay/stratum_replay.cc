@@ -101,7 +101,14 @@ using ClientStreamChannelReaderWriter =
       ::p4::v1::SetForwardingPipelineConfigRequest::VERIFY_AND_COMMIT);
 
   ::stratum::hal::ForwardingPipelineConfigs pipeline_cfg;
-  RETURN_IF_ERROR(ReadProtoFromTextFile(FLAGS_pipeline_cfg, &pipeline_cfg));
+  // The file is in binary format if saved with
+  // --binary_forwarding_pipeline_configs_file.
+  if (IsChecksummedBinFile(FLAGS_pipeline_cfg)) {
+    RETURN_IF_ERROR(
+        ReadProtoFromChecksummedBinFile(FLAGS_pipeline_cfg, &pipeline_cfg));
+  } else {
+    RETURN_IF_ERROR(ReadProtoFromTextFile(FLAGS_pipeline_cfg, &pipeline_cfg));
+  }
   const ::p4::v1::ForwardingPipelineConfig* fwd_pipe_cfg =
       gtl::FindOrNull(pipeline_cfg.node_id_to_config(), FLAGS_device_id);
   RET_CHECK(fwd_pipe_cfg);